@@ -765,7 +765,7 @@ static void print_turn_relation_osm(Relations *relations,index_t item,Segments *
  Segment *segmentp_from=LookupSegment(segments,relationp->from,1);
  Segment *segmentp_to  =LookupSegment(segments,relationp->to  ,2);
 
- double angle=TurnAngle(nodes,segmentp_from,segmentp_to,relationp->via);
+ double angle=TurnAngle(NULL,nodes,segmentp_from,segmentp_to,relationp->via);
 
  char *restriction;
 
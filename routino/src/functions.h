@@ -23,6 +23,8 @@
 #ifndef FUNCTIONS_H
 #define FUNCTIONS_H    /*+ To stop multiple inclusions. +*/
 
+#include <stddef.h>
+
 #include "types.h"
 
 #include "profiles.h"
@@ -31,24 +33,43 @@
 
 /* Functions in optimiser.c */
 
-Results *FindNormalRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,index_t start_node,index_t prev_segment,index_t finish_node);
+Results *FindNormalRoute(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,index_t start_node,index_t prev_segment,index_t finish_node);
+
+Results *FindMiddleRoute(Query *query,Nodes *supernodes,Segments *supersegments,Ways *superways,Relations *relations,Profile *profile,Results *begin,Results *end);
+
+Results *FindMiddleRoutes(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,Results *begin,Results **ends,int nends);
+int FixMiddleRoute(Nodes *nodes,Profile *profile,Results *middles,Results *end);
+
+Results *FindStartRoutes(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,index_t start_node,index_t prev_segment,index_t finish_node);
 
-Results *FindMiddleRoute(Nodes *supernodes,Segments *supersegments,Ways *superways,Relations *relations,Profile *profile,Results *begin,Results *end);
+Results *ExtendStartRoutes(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,Results *begin,index_t finish_node);
 
-Results *FindStartRoutes(Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,index_t start_node,index_t prev_segment,index_t finish_node);
+Results *FindFinishRoutes(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,index_t finish_node);
 
-Results *ExtendStartRoutes(Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,Results *begin,index_t finish_node);
+Results *CombineRoutes(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,Results *begin,Results *middle);
 
-Results *FindFinishRoutes(Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,index_t finish_node);
+Results *FindReachableNodes(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,index_t start_node,index_t prev_segment);
 
-Results *CombineRoutes(Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,Results *begin,Results *middle);
+int FindParetoRoutes(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,
+                     index_t start_node,index_t prev_segment,index_t finish_node,Results **routes,int maxroutes);
 
 void FixForwardRoute(Results *results,Result *finish_result);
 
 
 /* Functions in output.c */
 
-void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,Ways *ways,Profile *profile);
+void PrintRoute(Query *query,Results **results,int nresults,Nodes *nodes,Segments *segments,Ways *ways,Profile *profile);
+
+void SummariseRoute(Query *query,Results **results,int nresults,Segments *segments,Ways *ways,Profile *profile,
+                    distance_t *distance,duration_t *duration,double *ascent,double *descent);
+
+void PrintReachable(Query *query,Results *results,Nodes *nodes);
+
+void PrintPareto(Query *query,Results **routes,int nroutes,Nodes *nodes,Segments *segments,Ways *ways,Profile *profile);
+
+void SetOutputMemory(Query *query,int memory);
+int GetOutputMemory(Query *query,int n,const char **filename,const char **data,size_t *size);
+void FreeOutputMemory(Query *query);
 
 
 #endif /* FUNCTIONS_H */
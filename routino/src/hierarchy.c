@@ -0,0 +1,257 @@
+/***************************************
+ Contraction hierarchy data type functions.
+
+ Part of the Routino routing software.
+ ******************/ /******************
+ This file Copyright 2026 Routino contributors
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Affero General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Affero General Public License for more details.
+
+ You should have received a copy of the GNU Affero General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ***************************************/
+
+
+#include <stdlib.h>
+
+#include "types.h"
+#include "hierarchy.h"
+
+#include "files.h"
+#include "logging.h"
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Load in a contraction hierarchy from a file.
+
+  Hierarchy *LoadHierarchy Returns the contraction hierarchy.
+
+  const char *filename The name of the file to load.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+Hierarchy *LoadHierarchy(const char *filename)
+{
+ Hierarchy *hierarchy;
+
+ hierarchy=(Hierarchy*)malloc(sizeof(Hierarchy));
+
+#if !SLIM
+
+ hierarchy->data=MapFile(filename);
+
+ /* Copy the HierarchyFile header structure from the loaded data */
+
+ hierarchy->file=*((HierarchyFile*)hierarchy->data);
+
+ /* Set the pointers in the Hierarchy structure. */
+
+ hierarchy->nodes    =(index_t*)(hierarchy->data+sizeof(HierarchyFile));
+ hierarchy->firstup  =hierarchy->nodes+hierarchy->file.number;
+ hierarchy->firstdown=hierarchy->firstup+hierarchy->file.number+1;
+
+ hierarchy->upedges  =(HierarchyEdge*)(hierarchy->firstdown+hierarchy->file.number+1);
+ hierarchy->downedges=hierarchy->upedges+hierarchy->file.nupedges;
+
+#else
+
+ hierarchy->fd=ReOpenFile(filename);
+
+ /* Copy the HierarchyFile header structure from the loaded data */
+
+ ReadFile(hierarchy->fd,&hierarchy->file,sizeof(HierarchyFile));
+
+ hierarchy->nodesoffset    =sizeof(HierarchyFile);
+ hierarchy->firstupoffset  =hierarchy->nodesoffset+hierarchy->file.number*sizeof(index_t);
+ hierarchy->firstdownoffset=hierarchy->firstupoffset+(hierarchy->file.number+1)*sizeof(index_t);
+ hierarchy->upedgesoffset  =hierarchy->firstdownoffset+(hierarchy->file.number+1)*sizeof(index_t);
+ hierarchy->downedgesoffset=hierarchy->upedgesoffset+(off_t)hierarchy->file.nupedges*sizeof(HierarchyEdge);
+
+ hierarchy->ncached=0;
+ hierarchy->cached=NULL;
+
+#endif
+
+ return(hierarchy);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Check if the contraction hierarchy was created for the profile being used.
+
+  int HierarchyMatchesProfile Returns 1 if the scores in the hierarchy are the ones that the profile gives.
+
+  Hierarchy *hierarchy The contraction hierarchy to check.
+
+  Profile *profile The profile that is being used.
+
+  int quickest Set if the quickest route is being calculated instead of the shortest.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+int HierarchyMatchesProfile(Hierarchy *hierarchy,Profile *profile,int quickest)
+{
+ Profile fileprofile={0};
+ int i;
+
+ if(hierarchy->file.quickest!=quickest)
+    return(0);
+
+ /* Fill in the parts of a profile that were stored in the file */
+
+ fileprofile.allow =hierarchy->file.profile.allow;
+ fileprofile.oneway=hierarchy->file.profile.oneway;
+ fileprofile.weight=hierarchy->file.profile.weight;
+ fileprofile.height=hierarchy->file.profile.height;
+ fileprofile.width =hierarchy->file.profile.width;
+ fileprofile.length=hierarchy->file.profile.length;
+ fileprofile.hills =hierarchy->file.profile.hills;
+
+ for(i=0;i<Highway_Count;i++)
+   {
+    fileprofile.highway[i]=hierarchy->file.profile.highway[i];
+    fileprofile.speed[i]  =hierarchy->file.profile.speed[i];
+   }
+
+ for(i=0;i<Property_Count;i++)
+   {
+    fileprofile.props_yes[i]=hierarchy->file.profile.props_yes[i];
+    fileprofile.props_no[i] =hierarchy->file.profile.props_no[i];
+   }
+
+ return(SameProfileScores(&fileprofile,profile,quickest));
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Find the position of a super-node in the contraction hierarchy.
+
+  index_t FindHierarchyNode Returns the position in the list of super-nodes or NO_NODE if it is not in the hierarchy.
+
+  Hierarchy *hierarchy The contraction hierarchy to use.
+
+  index_t node The node to look for.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+index_t FindHierarchyNode(Hierarchy *hierarchy,index_t node)
+{
+ index_t start=0;
+ index_t end=hierarchy->file.number;
+
+ /* Binary search - the list is in index order */
+
+ while(start<end)
+   {
+    index_t mid=start+(end-start)/2;
+
+    if(LookupHierarchyNode(hierarchy,mid)<node)
+       start=mid+1;
+    else
+       end=mid;
+   }
+
+ if(start<hierarchy->file.number && LookupHierarchyNode(hierarchy,start)==node)
+    return(start);
+ else
+    return(NO_NODE);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Find the node index of one of the super-nodes in the contraction hierarchy.
+
+  index_t LookupHierarchyNode Returns the node index.
+
+  Hierarchy *hierarchy The contraction hierarchy to use.
+
+  index_t index The position of the super-node in the list.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+index_t LookupHierarchyNode(Hierarchy *hierarchy,index_t index)
+{
+#if !SLIM
+
+ return(hierarchy->nodes[index]);
+
+#else
+
+ index_t node;
+
+ SeekReadFile(hierarchy->fd,&node,sizeof(index_t),hierarchy->nodesoffset+(off_t)index*sizeof(index_t));
+
+ return(node);
+
+#endif
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Find the edges going up the hierarchy from a node or coming down the hierarchy to it.
+
+  HierarchyEdge *LookupHierarchyEdges Returns a pointer to the edges (in slim mode only valid until the next call).
+
+  Hierarchy *hierarchy The contraction hierarchy to use.
+
+  index_t index The position of the super-node in the list.
+
+  int down Set to get the edges coming down to the node instead of going up from it.
+
+  index_t *number Returns the number of edges.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+HierarchyEdge *LookupHierarchyEdges(Hierarchy *hierarchy,index_t index,int down,index_t *number)
+{
+#if !SLIM
+
+ if(down)
+   {
+    *number=hierarchy->firstdown[index+1]-hierarchy->firstdown[index];
+
+    return(&hierarchy->downedges[hierarchy->firstdown[index]]);
+   }
+ else
+   {
+    *number=hierarchy->firstup[index+1]-hierarchy->firstup[index];
+
+    return(&hierarchy->upedges[hierarchy->firstup[index]]);
+   }
+
+#else
+
+ index_t first[2];
+ off_t offset;
+
+ if(down)
+   {
+    SeekReadFile(hierarchy->fd,first,2*sizeof(index_t),hierarchy->firstdownoffset+(off_t)index*sizeof(index_t));
+    offset=hierarchy->downedgesoffset;
+   }
+ else
+   {
+    SeekReadFile(hierarchy->fd,first,2*sizeof(index_t),hierarchy->firstupoffset+(off_t)index*sizeof(index_t));
+    offset=hierarchy->upedgesoffset;
+   }
+
+ *number=first[1]-first[0];
+
+ if(*number>hierarchy->ncached)
+   {
+    hierarchy->ncached=*number;
+    hierarchy->cached=(HierarchyEdge*)realloc(hierarchy->cached,hierarchy->ncached*sizeof(HierarchyEdge));
+
+    logassert(hierarchy->cached,"Failed to allocate memory"); /* Check realloc() worked */
+   }
+
+ if(*number)
+    SeekReadFile(hierarchy->fd,hierarchy->cached,*number*sizeof(HierarchyEdge),offset+(off_t)first[0]*sizeof(HierarchyEdge));
+
+ return(hierarchy->cached);
+
+#endif
+}
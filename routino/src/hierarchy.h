@@ -0,0 +1,138 @@
+/***************************************
+ A header file for the contraction hierarchy.
+
+ Part of the Routino routing software.
+ ******************/ /******************
+ This file Copyright 2026 Routino contributors
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Affero General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Affero General Public License for more details.
+
+ You should have received a copy of the GNU Affero General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ***************************************/
+
+
+#ifndef HIERARCHY_H
+#define HIERARCHY_H    /*+ To stop multiple inclusions. +*/
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "types.h"
+#include "profiles.h"
+
+#include "files.h"
+
+
+/* Data structures */
+
+
+/*+ An edge in the contraction hierarchy, either a super-segment or a shortcut that replaces two edges. +*/
+typedef struct _HierarchyEdge
+{
+ index_t     node;              /*+ The other node (the position in the list of super-nodes). +*/
+
+ index_t     segment;           /*+ The super-segment (or NO_SEGMENT for a shortcut). +*/
+ index_t     via;               /*+ The node bypassed by a shortcut (the position in the list of super-nodes). +*/
+
+ score_t     score;             /*+ The score for travelling along the edge. +*/
+}
+ HierarchyEdge;
+
+
+/*+ The parts of the profile that change the scores of the edges (the ones compared by SameProfileScores()). +*/
+typedef struct _HierarchyProfile
+{
+ transports_t allow;                     /*+ The type of transport expressed as a bitmask. +*/
+
+ score_t      highway[Highway_Count];    /*+ A floating point preference for travel on the highway. +*/
+ speed_t      speed[Highway_Count];      /*+ The maximum speed on each type of highway. +*/
+
+ score_t      props_yes[Property_Count]; /*+ A floating point preference for ways with this attribute. +*/
+ score_t      props_no [Property_Count]; /*+ A floating point preference for ways without this attribute. +*/
+
+ int          oneway;                    /*+ A flag to indicate if one-way restrictions apply. +*/
+
+ weight_t     weight;                    /*+ The minimum weight of the route. +*/
+
+ height_t     height;                    /*+ The minimum height of vehicles on the route. +*/
+ width_t      width;                     /*+ The minimum width of vehicles on the route. +*/
+ length_t     length;                    /*+ The minimum length of vehicles on the route. +*/
+
+ float        hills;                     /*+ The weight given to the hills (zero if they are ignored). +*/
+}
+ HierarchyProfile;
+
+
+/*+ A structure containing the header from the file. +*/
+typedef struct _HierarchyFile
+{
+ index_t     number;            /*+ The number of super-nodes in total. +*/
+ index_t     nnodes;            /*+ The number of nodes in the database that the hierarchy was created for. +*/
+
+ index_t     nupedges;          /*+ The number of edges going up the hierarchy from each node. +*/
+ index_t     ndownedges;        /*+ The number of edges coming down the hierarchy to each node. +*/
+
+ int         quickest;          /*+ Set if the scores are for the quickest route instead of the shortest. +*/
+
+ HierarchyProfile profile;      /*+ The parts of the profile that the scores were calculated with. +*/
+}
+ HierarchyFile;
+
+
+/*+ A structure containing the contraction hierarchy (and pointers to mmap file). +*/
+struct _Hierarchy
+{
+ HierarchyFile file;            /*+ The header data from the file. +*/
+
+#if !SLIM
+
+ void          *data;           /*+ The memory mapped data. +*/
+
+ index_t       *nodes;          /*+ An array of the super-nodes (sorted by index). +*/
+
+ index_t       *firstup;        /*+ An array of the first edge going up from each node. +*/
+ index_t       *firstdown;      /*+ An array of the first edge coming down to each node. +*/
+
+ HierarchyEdge *upedges;        /*+ An array of the edges going up from each node (to a higher node). +*/
+ HierarchyEdge *downedges;      /*+ An array of the edges coming down to each node (from a higher node). +*/
+
+#else
+
+ int            fd;             /*+ The file descriptor for the file. +*/
+
+ off_t          nodesoffset;    /*+ The offset of the super-nodes in the file. +*/
+ off_t          firstupoffset;  /*+ The offset of the first up edges in the file. +*/
+ off_t          firstdownoffset;/*+ The offset of the first down edges in the file. +*/
+ off_t          upedgesoffset;  /*+ The offset of the up edges in the file. +*/
+ off_t          downedgesoffset;/*+ The offset of the down edges in the file. +*/
+
+ HierarchyEdge *cached;         /*+ The edges for one node read from the file in slim mode. +*/
+ index_t        ncached;        /*+ The number of edges allocated in the cache. +*/
+
+#endif
+};
+
+
+/* Functions in hierarchy.c */
+
+Hierarchy *LoadHierarchy(const char *filename);
+
+int HierarchyMatchesProfile(Hierarchy *hierarchy,Profile *profile,int quickest);
+
+index_t FindHierarchyNode(Hierarchy *hierarchy,index_t node);
+
+index_t LookupHierarchyNode(Hierarchy *hierarchy,index_t index);
+
+HierarchyEdge *LookupHierarchyEdges(Hierarchy *hierarchy,index_t index,int down,index_t *number);
+
+
+#endif /* HIERARCHY_H */
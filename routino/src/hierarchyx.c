@@ -0,0 +1,628 @@
+/***************************************
+ Contraction hierarchy creation functions.
+
+ Part of the Routino routing software.
+ ******************/ /******************
+ This file Copyright 2026 Routino contributors
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Affero General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Affero General Public License for more details.
+
+ You should have received a copy of the GNU Affero General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ***************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "types.h"
+#include "nodes.h"
+#include "segments.h"
+#include "ways.h"
+#include "hierarchy.h"
+
+#include "hierarchyx.h"
+
+#include "files.h"
+#include "logging.h"
+#include "results.h"
+
+
+/* Constants */
+
+/*+ The maximum number of nodes to check when looking for a path that makes a shortcut unnecessary. +*/
+#define WITNESS_NODES 500
+
+
+/* Local types */
+
+/*+ The edges going out of or coming in to one node while the hierarchy is created. +*/
+typedef struct _EdgeList
+{
+ HierarchyEdge *edges;          /*+ The edges. +*/
+
+ index_t        number;         /*+ The number of edges. +*/
+ index_t        allocated;      /*+ The number of edges allocated. +*/
+}
+ EdgeList;
+
+/*+ The state of the contraction hierarchy while it is created. +*/
+typedef struct _Contraction
+{
+ index_t   number;              /*+ The number of super-nodes. +*/
+
+ EdgeList *out;                 /*+ The edges going out of each node to the nodes not yet contracted. +*/
+ EdgeList *in;                  /*+ The edges coming in to each node from the nodes not yet contracted. +*/
+
+ Result   *results;             /*+ The results for the witness searches (one for each node). +*/
+ Queue    *queue;               /*+ The queue for the witness searches. +*/
+
+ index_t  *touched;             /*+ The nodes with a result from the current witness search. +*/
+ index_t   ntouched;            /*+ The number of nodes with a result from the current witness search. +*/
+}
+ Contraction;
+
+
+/* Local functions */
+
+static int AddEdges(Contraction *contraction,index_t node1,index_t node2,index_t segment,index_t via,score_t score);
+static void RemoveEdge(EdgeList *list,index_t node);
+
+static int ContractNode(Contraction *contraction,index_t node,int add);
+static void WitnessSearch(Contraction *contraction,index_t start,index_t avoid,score_t limit);
+
+static index_t FindSuperNodePosition(index_t *supernodes,index_t nsuper,index_t node);
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Create a contraction hierarchy of the super-nodes for one profile and save it to a file.
+
+  The super-nodes are contracted one at a time (the one that adds the fewest shortcuts compared
+  to the edges that it removes first) and a shortcut is added between each pair of neighbours
+  unless a path that does not pass through the node is found that is no worse. The scores are
+  the ones that the router uses for the super-segments with the profile.
+
+  const char *dirname The directory containing the database files.
+
+  const char *prefix The prefix of the database files.
+
+  Profile *profile The profile to calculate the scores with (not yet updated for the database).
+
+  int quickest Set to calculate the scores for the quickest route instead of the shortest.
+
+  const char *filename The name of the file to save.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+void SaveHierarchy(const char *dirname,const char *prefix,Profile *profile,int quickest,const char *filename)
+{
+ Nodes *nodes;
+ Segments *segments;
+ Ways *ways;
+ Contraction contraction;
+ HierarchyFile hierarchyfile={0};
+ index_t i,nsuper=0,ncontracted=0,nshortcuts=0,nupedges=0,ndownedges=0;
+ index_t *supernodes,*deleted;
+ Result *order,*result;
+ Queue *queue;
+ int fd;
+
+ /* Load in the database files that were written */
+
+ nodes=LoadNodeList(FileName(dirname,prefix,"nodes.mem"));
+ segments=LoadSegmentList(FileName(dirname,prefix,"segments.mem"));
+ ways=LoadWayList(FileName(dirname,prefix,"ways.mem"));
+
+ if(UpdateProfile(profile,ways))
+   {
+    fprintf(stderr,"Error: Profile is invalid or not compatible with database.\n");
+    exit(EXIT_FAILURE);
+   }
+
+ /* Print the start message */
+
+ printf_first("Contracting Super-Nodes: Nodes=0 Shortcuts=0");
+
+ /* Find the super-nodes (in index order) */
+
+ supernodes=(index_t*)malloc(nodes->file.number*sizeof(index_t));
+
+ logassert(supernodes,"Failed to allocate memory (try using slim mode?)"); /* Check malloc() worked */
+
+ for(i=0;i<nodes->file.number;i++)
+    if(IsSuperNode(LookupNode(nodes,i,1)))
+       supernodes[nsuper++]=i;
+
+ /* Allocate the memory for the contraction */
+
+ contraction.number=nsuper;
+
+ contraction.out=(EdgeList*)calloc(nsuper,sizeof(EdgeList));
+ contraction.in =(EdgeList*)calloc(nsuper,sizeof(EdgeList));
+
+ contraction.results=(Result*)calloc(nsuper,sizeof(Result));
+ contraction.touched=(index_t*)malloc(nsuper*sizeof(index_t));
+ contraction.ntouched=0;
+
+ deleted=(index_t*)calloc(nsuper,sizeof(index_t));
+ order=(Result*)calloc(nsuper,sizeof(Result));
+
+ logassert(contraction.out && contraction.in && contraction.results && contraction.touched && deleted && order,
+           "Failed to allocate memory (try using slim mode?)"); /* Check malloc() worked */
+
+ contraction.queue=NewQueueList(NULL);
+
+ for(i=0;i<nsuper;i++)
+    contraction.results[i].score=INF_SCORE;
+
+ /* Create the edges from the super-segments that the profile can use */
+
+ for(i=0;i<nsuper;i++)
+   {
+    index_t node1=supernodes[i];
+    Node *node1p=LookupNode(nodes,node1,1);
+    Segment *segmentp;
+
+    /* mode of transport must be allowed through node1 */
+    if(!(node1p->allow&profile->allow))
+       continue;
+
+    segmentp=FirstSegment(segments,node1p,1);
+
+    while(segmentp)
+      {
+       index_t node2,position2;
+       score_t segment_pref,segment_score;
+
+       /* must be a super segment */
+       if(!IsSuperSegment(segmentp))
+          goto endloop;
+
+       /* must obey one-way restrictions (unless profile allows) */
+       if(profile->oneway && IsOnewayTo(segmentp,node1))
+          goto endloop;
+
+       segment_pref=profile->way_pref[segmentp->way];
+
+       /* profile must allow this highway (transport, restrictions, highway type and properties) */
+       if(segment_pref==0)
+          goto endloop;
+
+       node2=OtherNode(segmentp,node1);
+
+       if(node2==node1)
+          goto endloop;
+
+       /* mode of transport must be allowed through node2 */
+       if(!(LookupNode(nodes,node2,2)->allow&profile->allow))
+          goto endloop;
+
+       position2=FindSuperNodePosition(supernodes,nsuper,node2);
+
+       if(position2==NO_NODE)
+          goto endloop;
+
+       if(quickest==0)
+          segment_score=(score_t)DISTANCE(segmentp->distance)/segment_pref;
+       else
+          segment_score=(score_t)Duration(segmentp,profile)/segment_pref;
+
+       AddEdges(&contraction,i,position2,IndexSegment(segments,segmentp),NO_NODE,segment_score);
+
+      endloop:
+
+       segmentp=NextSegment(segments,segmentp,node1);
+      }
+   }
+
+ /* Find the initial order to contract the nodes */
+
+ queue=NewQueueList(NULL);
+
+ for(i=0;i<nsuper;i++)
+   {
+    order[i].node=i;
+    order[i].sortby=(score_t)ContractNode(&contraction,i,0)-contraction.in[i].number-contraction.out[i].number;
+
+    InsertInQueue(queue,&order[i]);
+   }
+
+ /* Contract the nodes, updating the order of each one before it is contracted */
+
+ while((result=PopFromQueue(queue)))
+   {
+    index_t node=result->node;
+    score_t priority;
+    index_t j;
+
+    priority=(score_t)ContractNode(&contraction,node,0)-contraction.in[node].number-contraction.out[node].number+deleted[node];
+
+    if(priority>result->sortby)
+      {
+       result->sortby=priority;
+
+       InsertInQueue(queue,result);
+
+       continue;
+      }
+
+    nshortcuts+=ContractNode(&contraction,node,1);
+
+    /* Remove the node from the remaining nodes, the edges left are the ones that go up the hierarchy */
+
+    for(j=0;j<contraction.out[node].number;j++)
+      {
+       RemoveEdge(&contraction.in[contraction.out[node].edges[j].node],node);
+       deleted[contraction.out[node].edges[j].node]++;
+      }
+
+    for(j=0;j<contraction.in[node].number;j++)
+      {
+       RemoveEdge(&contraction.out[contraction.in[node].edges[j].node],node);
+       deleted[contraction.in[node].edges[j].node]++;
+      }
+
+    nupedges+=contraction.out[node].number;
+    ndownedges+=contraction.in[node].number;
+
+    ncontracted++;
+
+    if(!(ncontracted%1000))
+       printf_middle("Contracting Super-Nodes: Nodes=%"Pindex_t" Shortcuts=%"Pindex_t,ncontracted,nshortcuts);
+   }
+
+ FreeQueueList(queue);
+
+ /* Print the contraction message */
+
+ printf_last("Contracted Super-Nodes: Nodes=%"Pindex_t" Shortcuts=%"Pindex_t,ncontracted,nshortcuts);
+
+ /* Write out the file */
+
+ printf_first("Writing Hierarchy: Nodes=0");
+
+ fd=OpenFileNew(filename);
+
+ hierarchyfile.number=nsuper;
+ hierarchyfile.nnodes=nodes->file.number;
+ hierarchyfile.nupedges=nupedges;
+ hierarchyfile.ndownedges=ndownedges;
+ hierarchyfile.quickest=quickest;
+ hierarchyfile.profile.allow =profile->allow;
+ hierarchyfile.profile.oneway=profile->oneway;
+ hierarchyfile.profile.weight=profile->weight;
+ hierarchyfile.profile.height=profile->height;
+ hierarchyfile.profile.width =profile->width;
+ hierarchyfile.profile.length=profile->length;
+ hierarchyfile.profile.hills =profile->hills;
+
+ for(i=0;i<Highway_Count;i++)
+   {
+    hierarchyfile.profile.highway[i]=profile->highway[i];
+    hierarchyfile.profile.speed[i]  =profile->speed[i];
+   }
+
+ for(i=0;i<Property_Count;i++)
+   {
+    hierarchyfile.profile.props_yes[i]=profile->props_yes[i];
+    hierarchyfile.profile.props_no[i] =profile->props_no[i];
+   }
+
+ WriteFile(fd,&hierarchyfile,sizeof(HierarchyFile));
+
+ WriteFile(fd,supernodes,nsuper*sizeof(index_t));
+
+ for(i=0,nupedges=0;i<=nsuper;i++)
+   {
+    WriteFile(fd,&nupedges,sizeof(index_t));
+
+    if(i<nsuper)
+       nupedges+=contraction.out[i].number;
+   }
+
+ for(i=0,ndownedges=0;i<=nsuper;i++)
+   {
+    WriteFile(fd,&ndownedges,sizeof(index_t));
+
+    if(i<nsuper)
+       ndownedges+=contraction.in[i].number;
+   }
+
+ for(i=0;i<nsuper;i++)
+    WriteFile(fd,contraction.out[i].edges,contraction.out[i].number*sizeof(HierarchyEdge));
+
+ for(i=0;i<nsuper;i++)
+   {
+    WriteFile(fd,contraction.in[i].edges,contraction.in[i].number*sizeof(HierarchyEdge));
+
+    if(!((i+1)%10000))
+       printf_middle("Writing Hierarchy: Nodes=%"Pindex_t,i+1);
+   }
+
+ CloseFile(fd);
+
+ /* Free the memory */
+
+ for(i=0;i<nsuper;i++)
+   {
+    free(contraction.out[i].edges);
+    free(contraction.in[i].edges);
+   }
+
+ free(contraction.out);
+ free(contraction.in);
+ free(contraction.results);
+ free(contraction.touched);
+
+ FreeQueueList(contraction.queue);
+
+ free(supernodes);
+ free(deleted);
+ free(order);
+
+ ReleaseProfile(profile);
+
+ /* Print the final message */
+
+ printf_last("Wrote Hierarchy: Nodes=%"Pindex_t" Edges=%"Pindex_t,nsuper,nupedges+ndownedges);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Add an edge (or replace one with a worse score) between two nodes in the lists going out of the
+  first one and coming in to the second one.
+
+  int AddEdges Returns 1 if the edge was added or 0 if there is already one that is no worse.
+
+  Contraction *contraction The hierarchy being created.
+
+  index_t node1 The node that the edge starts at.
+
+  index_t node2 The node that the edge finishes at.
+
+  index_t segment The super-segment (or NO_SEGMENT for a shortcut).
+
+  index_t via The node that a shortcut bypasses (or NO_NODE).
+
+  score_t score The score for the edge.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static int AddEdges(Contraction *contraction,index_t node1,index_t node2,index_t segment,index_t via,score_t score)
+{
+ EdgeList *lists[2];
+ index_t others[2];
+ int l;
+
+ lists[0]=&contraction->out[node1]; others[0]=node2;
+ lists[1]=&contraction->in[node2];  others[1]=node1;
+
+ for(l=0;l<2;l++)
+   {
+    EdgeList *list=lists[l];
+    HierarchyEdge *edge=NULL;
+    index_t j;
+
+    for(j=0;j<list->number;j++)
+       if(list->edges[j].node==others[l])
+         {
+          edge=&list->edges[j];
+          break;
+         }
+
+    if(edge && edge->score<=score)
+       return(0);
+
+    if(!edge)
+      {
+       if(list->number==list->allocated)
+         {
+          list->allocated+=4;
+          list->edges=(HierarchyEdge*)realloc(list->edges,list->allocated*sizeof(HierarchyEdge));
+
+          logassert(list->edges,"Failed to allocate memory (try using slim mode?)"); /* Check realloc() worked */
+         }
+
+       edge=&list->edges[list->number++];
+      }
+
+    edge->node=others[l];
+    edge->segment=segment;
+    edge->via=via;
+    edge->score=score;
+   }
+
+ return(1);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Remove the edge to or from a node from a list of edges.
+
+  EdgeList *list The list of edges.
+
+  index_t node The node at the other end of the edge.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static void RemoveEdge(EdgeList *list,index_t node)
+{
+ index_t j;
+
+ for(j=0;j<list->number;j++)
+    if(list->edges[j].node==node)
+      {
+       list->edges[j]=list->edges[--list->number];
+       break;
+      }
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Find the shortcuts that are needed to contract a node (and add them if requested).
+
+  int ContractNode Returns the number of shortcuts.
+
+  Contraction *contraction The hierarchy being created.
+
+  index_t node The node to contract.
+
+  int add Set to add the shortcuts instead of only counting them.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static int ContractNode(Contraction *contraction,index_t node,int add)
+{
+ EdgeList *in=&contraction->in[node];
+ EdgeList *out=&contraction->out[node];
+ int shortcuts=0;
+ index_t i,j;
+
+ for(i=0;i<in->number;i++)
+   {
+    index_t node1=in->edges[i].node;
+    score_t limit=-1;
+
+    /* Find the worst score that a path must beat */
+
+    for(j=0;j<out->number;j++)
+       if(out->edges[j].node!=node1 && (in->edges[i].score+out->edges[j].score)>limit)
+          limit=in->edges[i].score+out->edges[j].score;
+
+    if(limit<0)
+       continue;
+
+    WitnessSearch(contraction,node1,node,limit);
+
+    /* A shortcut is needed unless there is a path that is no worse */
+
+    for(j=0;j<out->number;j++)
+      {
+       index_t node2=out->edges[j].node;
+       score_t score=in->edges[i].score+out->edges[j].score;
+
+       if(node2==node1)
+          continue;
+
+       if(contraction->results[node2].score>score)
+         {
+          if(add)
+             shortcuts+=AddEdges(contraction,node1,node2,NO_SEGMENT,node,score);
+          else
+             shortcuts++;
+         }
+      }
+
+    /* Reset the results for the next search */
+
+    while(PopFromQueue(contraction->queue))
+       ;
+
+    for(j=0;j<contraction->ntouched;j++)
+       contraction->results[contraction->touched[j]].score=INF_SCORE;
+
+    contraction->ntouched=0;
+   }
+
+ return(shortcuts);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Search for the best paths from a node that do not pass through the node being contracted; the
+  search is limited to a maximum score and a maximum number of nodes.
+
+  Contraction *contraction The hierarchy being created.
+
+  index_t start The node to start from.
+
+  index_t avoid The node being contracted.
+
+  score_t limit The maximum score that is needed.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static void WitnessSearch(Contraction *contraction,index_t start,index_t avoid,score_t limit)
+{
+ Result *result1;
+ int nchecked=0;
+
+ result1=&contraction->results[start];
+
+ result1->score=0;
+ result1->sortby=0;
+
+ contraction->touched[contraction->ntouched++]=start;
+
+ InsertInQueue(contraction->queue,result1);
+
+ while((result1=PopFromQueue(contraction->queue)))
+   {
+    index_t node1=result1-contraction->results;
+    EdgeList *out=&contraction->out[node1];
+    index_t j;
+
+    if(result1->score>limit || ++nchecked>WITNESS_NODES)
+       break;
+
+    for(j=0;j<out->number;j++)
+      {
+       index_t node2=out->edges[j].node;
+       Result *result2=&contraction->results[node2];
+       score_t cumulative_score=result1->score+out->edges[j].score;
+
+       if(node2==avoid)
+          continue;
+
+       if(cumulative_score<result2->score)
+         {
+          if(result2->score==INF_SCORE)
+             contraction->touched[contraction->ntouched++]=node2;
+
+          result2->score=cumulative_score;
+          result2->sortby=cumulative_score;
+
+          InsertInQueue(contraction->queue,result2);
+         }
+      }
+   }
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Find the position of a super-node in the list of super-nodes.
+
+  index_t FindSuperNodePosition Returns the position in the list or NO_NODE if it is not a super-node.
+
+  index_t *supernodes The super-nodes (in index order).
+
+  index_t nsuper The number of super-nodes.
+
+  index_t node The node to look for.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static index_t FindSuperNodePosition(index_t *supernodes,index_t nsuper,index_t node)
+{
+ index_t start=0;
+ index_t end=nsuper;
+
+ /* Binary search - the list is in index order */
+
+ while(start<end)
+   {
+    index_t mid=start+(end-start)/2;
+
+    if(supernodes[mid]<node)
+       start=mid+1;
+    else
+       end=mid;
+   }
+
+ if(start<nsuper && supernodes[start]==node)
+    return(start);
+ else
+    return(NO_NODE);
+}
@@ -0,0 +1,199 @@
+/***************************************
+ Landmark data type functions.
+
+ Part of the Routino routing software.
+ ******************/ /******************
+ This file Copyright 2026 Routino contributors
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Affero General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Affero General Public License for more details.
+
+ You should have received a copy of the GNU Affero General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ***************************************/
+
+
+#include <stdlib.h>
+
+#include "types.h"
+#include "landmarks.h"
+
+#include "files.h"
+#include "logging.h"
+
+
+/* Local functions */
+
+static index_t LookupLandmarkNode(Landmarks *landmarks,index_t index);
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Load in a landmark list from a file.
+
+  Landmarks *LoadLandmarkList Returns the landmark list.
+
+  const char *filename The name of the file to load.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+Landmarks *LoadLandmarkList(const char *filename)
+{
+ Landmarks *landmarks;
+
+ landmarks=(Landmarks*)malloc(sizeof(Landmarks));
+
+#if !SLIM
+
+ landmarks->data=MapFile(filename);
+
+ /* Copy the LandmarksFile header structure from the loaded data */
+
+ landmarks->file=*((LandmarksFile*)landmarks->data);
+
+ /* Set the pointers in the Landmarks structure. */
+
+ landmarks->landmarks=(index_t*   )(landmarks->data+sizeof(LandmarksFile));
+ landmarks->nodes    =(index_t*   )(landmarks->data+sizeof(LandmarksFile)+landmarks->file.nlandmarks*sizeof(index_t));
+ landmarks->distances=(distance_t*)(landmarks->data+sizeof(LandmarksFile)+(landmarks->file.nlandmarks+landmarks->file.number)*sizeof(index_t));
+
+#else
+
+ landmarks->fd=ReOpenFile(filename);
+
+ /* Copy the LandmarksFile header structure from the loaded data */
+
+ ReadFile(landmarks->fd,&landmarks->file,sizeof(LandmarksFile));
+
+ landmarks->landmarks=(index_t*)malloc(landmarks->file.nlandmarks*sizeof(index_t));
+
+ ReadFile(landmarks->fd,landmarks->landmarks,landmarks->file.nlandmarks*sizeof(index_t));
+
+ landmarks->nodesoffset=sizeof(LandmarksFile)+landmarks->file.nlandmarks*sizeof(index_t);
+ landmarks->distancesoffset=landmarks->nodesoffset+landmarks->file.number*sizeof(index_t);
+
+ landmarks->incache=NO_NODE;
+
+#endif
+
+ logassert(landmarks->file.nlandmarks<=MAX_LANDMARKS,"Too many landmarks in the file (increase MAX_LANDMARKS?)"); /* Only a limited amount of information cached. */
+
+ return(landmarks);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Find the distances from each of the landmarks to a super-node.
+
+  distance_t *FindLandmarkDistances Returns a pointer to the distances (NO_LANDMARK_DISTANCE if not reachable)
+                                    or NULL if the node is not a super-node with landmark distances.
+
+  Landmarks *landmarks The set of landmarks to use.
+
+  index_t node The node to look for.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+distance_t *FindLandmarkDistances(Landmarks *landmarks,index_t node)
+{
+ index_t start=0;
+ index_t end=landmarks->file.number-1;
+ index_t mid;
+ index_t match;
+
+ if(landmarks->file.number==0)
+    return(NULL);
+
+#if SLIM
+
+ /* Check the cached super-node */
+
+ if(landmarks->incache==node)
+    return(landmarks->cached);
+
+#endif
+
+ /* Binary search - search key exact match only is required.
+  *
+  *  # <- start  |  Check mid and move start or end if it doesn't match
+  *  #           |
+  *  #           |  Since an exact match is wanted we can set end=mid-1
+  *  # <- mid    |  or start=mid+1 because we know that mid doesn't match.
+  *  #           |
+  *  #           |  Eventually either end=start or end=start+1 and one of
+  *  # <- end    |  start or end is the wanted one.
+  */
+
+ do
+   {
+    index_t midnode;
+
+    mid=(start+end)/2;                 /* Choose mid point */
+
+    midnode=LookupLandmarkNode(landmarks,mid);
+
+    if(midnode<node)                   /* Mid point is too low */
+       start=mid+1;
+    else if(midnode>node)              /* Mid point is too high */
+       end=mid?(mid-1):mid;
+    else                               /* Mid point is correct */
+       break;
+   }
+ while((end-start)>1);
+
+ if(LookupLandmarkNode(landmarks,mid)==node)
+    match=mid;
+ else if(LookupLandmarkNode(landmarks,start)==node)
+    match=start;
+ else if(LookupLandmarkNode(landmarks,end)==node)
+    match=end;
+ else
+    return(NULL);
+
+#if !SLIM
+
+ return(&landmarks->distances[(off_t)match*landmarks->file.nlandmarks]);
+
+#else
+
+ SeekReadFile(landmarks->fd,landmarks->cached,landmarks->file.nlandmarks*sizeof(distance_t),
+              landmarks->distancesoffset+(off_t)match*landmarks->file.nlandmarks*sizeof(distance_t));
+
+ landmarks->incache=node;
+
+ return(landmarks->cached);
+
+#endif
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Find the node index of one of the super-nodes with landmark distances.
+
+  index_t LookupLandmarkNode Returns the node index.
+
+  Landmarks *landmarks The set of landmarks to use.
+
+  index_t index The index of the super-node in the list.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static index_t LookupLandmarkNode(Landmarks *landmarks,index_t index)
+{
+#if !SLIM
+
+ return(landmarks->nodes[index]);
+
+#else
+
+ index_t node;
+
+ SeekReadFile(landmarks->fd,&node,sizeof(index_t),landmarks->nodesoffset+(off_t)index*sizeof(index_t));
+
+ return(node);
+
+#endif
+}
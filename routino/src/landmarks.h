@@ -0,0 +1,94 @@
+/***************************************
+ A header file for the landmarks.
+
+ Part of the Routino routing software.
+ ******************/ /******************
+ This file Copyright 2026 Routino contributors
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Affero General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Affero General Public License for more details.
+
+ You should have received a copy of the GNU Affero General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ***************************************/
+
+
+#ifndef LANDMARKS_H
+#define LANDMARKS_H    /*+ To stop multiple inclusions. +*/
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "types.h"
+
+#include "files.h"
+
+
+/* Constants */
+
+/*+ The maximum number of landmarks. +*/
+#define MAX_LANDMARKS 32
+
+/*+ The landmark distance to a super-node that cannot be reached from the landmark. +*/
+#define NO_LANDMARK_DISTANCE ((distance_t)~0)
+
+
+/* Data structures */
+
+
+/*+ A structure containing the header from the file. +*/
+typedef struct _LandmarksFile
+{
+ index_t     number;            /*+ The number of super-nodes in total. +*/
+ index_t     nnodes;            /*+ The number of nodes in the database that the landmarks were chosen for. +*/
+ index_t     nlandmarks;        /*+ The number of landmarks. +*/
+}
+ LandmarksFile;
+
+
+/*+ A structure containing the landmark distances (and pointers to mmap file). +*/
+struct _Landmarks
+{
+ LandmarksFile file;            /*+ The header data from the file. +*/
+
+#if !SLIM
+
+ void       *data;              /*+ The memory mapped data. +*/
+
+ index_t    *landmarks;         /*+ An array of the landmark nodes. +*/
+
+ index_t    *nodes;             /*+ An array of the super-nodes (sorted by index). +*/
+
+ distance_t *distances;         /*+ An array of the distances from each landmark for each super-node. +*/
+
+#else
+
+ int         fd;                /*+ The file descriptor for the file. +*/
+
+ index_t    *landmarks;         /*+ An allocated array with a copy of the landmark nodes. +*/
+
+ off_t       nodesoffset;       /*+ The offset of the super-nodes in the file. +*/
+ off_t       distancesoffset;   /*+ The offset of the distances in the file. +*/
+
+ distance_t  cached[MAX_LANDMARKS]; /*+ The cached distances for one super-node read from the file in slim mode. +*/
+ index_t     incache;           /*+ The index of the cached super-node. +*/
+
+#endif
+};
+
+
+/* Functions in landmarks.c */
+
+Landmarks *LoadLandmarkList(const char *filename);
+
+distance_t *FindLandmarkDistances(Landmarks *landmarks,index_t node);
+
+
+#endif /* LANDMARKS_H */
@@ -0,0 +1,341 @@
+/***************************************
+ Landmark selection functions.
+
+ Part of the Routino routing software.
+ ******************/ /******************
+ This file Copyright 2026 Routino contributors
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Affero General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Affero General Public License for more details.
+
+ You should have received a copy of the GNU Affero General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ***************************************/
+
+
+#include <stdlib.h>
+
+#include "types.h"
+#include "segments.h"
+#include "landmarks.h"
+
+#include "typesx.h"
+#include "nodesx.h"
+#include "segmentsx.h"
+#include "landmarksx.h"
+
+#include "files.h"
+#include "logging.h"
+#include "results.h"
+
+
+/* Local functions */
+
+static void LandmarkSearch(SegmentsX *segmentsx,index_t *supernodes,index_t nsuper,index_t start,Result *results,distance_t *distances);
+
+static index_t FindSuperNodeRow(index_t *supernodes,index_t nsuper,index_t node);
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Choose the landmarks from the super-nodes and save the distances from each landmark to each
+  super-node to a file.
+
+  The landmarks are chosen to be far apart, the first one is the super-node furthest from the
+  middle of the data and each of the others is the one furthest from all of those chosen so
+  far. The distances are along the super-segments ignoring one-way and access restrictions so
+  that they are lower limits for every profile.
+
+  NodesX *nodesx The set of nodes to use.
+
+  SegmentsX *segmentsx The set of segments to use.
+
+  int nlandmarks The number of landmarks to choose.
+
+  const char *filename The name of the file to save.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+void SaveLandmarkList(NodesX *nodesx,SegmentsX *segmentsx,int nlandmarks,const char *filename)
+{
+ index_t i,nsuper=0,middle=NO_NODE;
+ index_t *supernodes;
+ index_t landmarks[MAX_LANDMARKS];
+ distance_t *distances,*mindistances,*search;
+ Result *results;
+ double lat_sum=0,lon_sum=0,middle_dist=0;
+ LandmarksFile landmarksfile={0};
+ int fd,l;
+
+ if(nlandmarks>MAX_LANDMARKS)
+    nlandmarks=MAX_LANDMARKS;
+
+ /* Print the start message */
+
+ printf_first("Choosing Landmarks: Landmarks=0");
+
+ /* Map into memory / open the files */
+
+#if !SLIM
+ nodesx->data=MapFile(nodesx->filename_tmp);
+ segmentsx->data=MapFile(segmentsx->filename_tmp);
+#else
+ nodesx->fd=ReOpenFile(nodesx->filename_tmp);
+ segmentsx->fd=ReOpenFile(segmentsx->filename_tmp);
+#endif
+
+ /* Find the super-nodes (in index order) */
+
+ supernodes=(index_t*)malloc(nodesx->number*sizeof(index_t));
+
+ logassert(supernodes,"Failed to allocate memory (try using slim mode?)"); /* Check malloc() worked */
+
+ for(i=0;i<nodesx->number;i++)
+   {
+    NodeX *nodex=LookupNodeX(nodesx,i,1);
+
+    if(nodex->flags&NODE_SUPER)
+      {
+       supernodes[nsuper++]=i;
+
+       lat_sum+=nodex->latitude;
+       lon_sum+=nodex->longitude;
+      }
+   }
+
+ /* Find the super-node closest to the middle */
+
+ for(i=0;i<nsuper;i++)
+   {
+    NodeX *nodex=LookupNodeX(nodesx,supernodes[i],1);
+    double dlat=nodex->latitude -lat_sum/nsuper;
+    double dlon=nodex->longitude-lon_sum/nsuper;
+
+    if(middle==NO_NODE || (dlat*dlat+dlon*dlon)<middle_dist)
+      {
+       middle=i;
+       middle_dist=dlat*dlat+dlon*dlon;
+      }
+   }
+
+ /* Allocate the memory for the searches */
+
+ distances=(distance_t*)malloc((size_t)nsuper*nlandmarks*sizeof(distance_t));
+ mindistances=(distance_t*)malloc(nsuper*sizeof(distance_t));
+ search=(distance_t*)malloc(nsuper*sizeof(distance_t));
+ results=(Result*)calloc(nsuper,sizeof(Result));
+
+ logassert(distances && mindistances && search && results,"Failed to allocate memory (try using slim mode?)"); /* Check malloc() worked */
+
+ /* Choose the landmarks, each one is the super-node furthest from the previous ones */
+
+ if(middle!=NO_NODE)
+   {
+    LandmarkSearch(segmentsx,supernodes,nsuper,middle,results,mindistances);
+
+    for(l=0;l<nlandmarks;l++)
+      {
+       index_t furthest=NO_NODE;
+
+       for(i=0;i<nsuper;i++)
+          if(mindistances[i]!=NO_LANDMARK_DISTANCE && (furthest==NO_NODE || mindistances[i]>mindistances[furthest]))
+             furthest=i;
+
+       /* stop if there are no more super-nodes that are not landmarks */
+       if(furthest==NO_NODE || (l>0 && mindistances[furthest]==0))
+          break;
+
+       landmarks[l]=supernodes[furthest];
+
+       LandmarkSearch(segmentsx,supernodes,nsuper,furthest,results,search);
+
+       for(i=0;i<nsuper;i++)
+         {
+          distances[(size_t)i*nlandmarks+l]=search[i];
+
+          if(l==0 || search[i]<mindistances[i])
+             mindistances[i]=search[i];
+         }
+
+       printf_middle("Choosing Landmarks: Landmarks=%d",l+1);
+      }
+   }
+ else
+    l=0;
+
+ /* Remove the unused space if there were fewer landmarks than requested */
+
+ if(l<nlandmarks)
+   {
+    int j;
+
+    for(i=0;i<nsuper;i++)
+       for(j=0;j<l;j++)
+          distances[(size_t)i*l+j]=distances[(size_t)i*nlandmarks+j];
+
+    nlandmarks=l;
+   }
+
+ /* Unmap from memory / close the files */
+
+#if !SLIM
+ nodesx->data=UnmapFile(nodesx->data);
+ segmentsx->data=UnmapFile(segmentsx->data);
+#else
+ nodesx->fd=CloseFile(nodesx->fd);
+ segmentsx->fd=CloseFile(segmentsx->fd);
+#endif
+
+ /* Write out the file */
+
+ fd=OpenFileNew(filename);
+
+ landmarksfile.number=nsuper;
+ landmarksfile.nnodes=nodesx->number;
+ landmarksfile.nlandmarks=nlandmarks;
+
+ WriteFile(fd,&landmarksfile,sizeof(LandmarksFile));
+
+ WriteFile(fd,landmarks,nlandmarks*sizeof(index_t));
+
+ WriteFile(fd,supernodes,nsuper*sizeof(index_t));
+
+ WriteFile(fd,distances,(size_t)nsuper*nlandmarks*sizeof(distance_t));
+
+ CloseFile(fd);
+
+ /* Free the memory */
+
+ free(supernodes);
+ free(distances);
+ free(mindistances);
+ free(search);
+ free(results);
+
+ /* Print the final message */
+
+ printf_last("Wrote Landmarks: Landmarks=%d Super-Nodes=%"Pindex_t,nlandmarks,nsuper);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Find the shortest distance from one super-node to all of the others.
+
+  SegmentsX *segmentsx The set of segments to use.
+
+  index_t *supernodes The super-nodes (in index order).
+
+  index_t nsuper The number of super-nodes.
+
+  index_t start The super-node to start from (the position in the list of super-nodes).
+
+  Result *results An array of results to use in the queue (one for each super-node).
+
+  distance_t *distances Returns the distance to each super-node (NO_LANDMARK_DISTANCE if not reachable).
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static void LandmarkSearch(SegmentsX *segmentsx,index_t *supernodes,index_t nsuper,index_t start,Result *results,distance_t *distances)
+{
+ Queue *queue;
+ Result *result1;
+ index_t i;
+
+ for(i=0;i<nsuper;i++)
+    distances[i]=NO_LANDMARK_DISTANCE;
+
+ /* Insert the first node into the queue */
+
+ queue=NewQueueList(NULL);
+
+ distances[start]=0;
+
+ results[start].sortby=0;
+
+ InsertInQueue(queue,&results[start]);
+
+ /* Loop across all nodes in the queue */
+
+ while((result1=PopFromQueue(queue)))
+   {
+    index_t row1,node1;
+    SegmentX *segmentx;
+
+    row1=result1-results;
+    node1=supernodes[row1];
+
+    segmentx=FirstSegmentX(segmentsx,node1,1);
+
+    while(segmentx)
+      {
+       index_t row2;
+       distance_t cumulative_distance;
+
+       /* must be a super-segment */
+       if(!IsSuperSegment(segmentx))
+          goto endloop;
+
+       row2=FindSuperNodeRow(supernodes,nsuper,OtherNode(segmentx,node1));
+
+       if(row2==NO_NODE)
+          goto endloop;
+
+       cumulative_distance=distances[row1]+DISTANCE(segmentx->distance);
+
+       if(cumulative_distance<distances[row2])
+         {
+          distances[row2]=cumulative_distance;
+
+          results[row2].sortby=(score_t)cumulative_distance;
+
+          InsertInQueue(queue,&results[row2]);
+         }
+
+      endloop:
+
+       segmentx=NextSegmentX(segmentsx,segmentx,node1);
+      }
+   }
+
+ FreeQueueList(queue);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Find the position of a super-node in the list of super-nodes.
+
+  index_t FindSuperNodeRow Returns the position in the list or NO_NODE if it is not a super-node.
+
+  index_t *supernodes The super-nodes (in index order).
+
+  index_t nsuper The number of super-nodes.
+
+  index_t node The node to look for.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static index_t FindSuperNodeRow(index_t *supernodes,index_t nsuper,index_t node)
+{
+ index_t start=0;
+ index_t end=nsuper;
+
+ /* Binary search - the list is in index order */
+
+ while(start<end)
+   {
+    index_t mid=start+(end-start)/2;
+
+    if(supernodes[mid]<node)
+       start=mid+1;
+    else
+       end=mid;
+   }
+
+ if(start<nsuper && supernodes[start]==node)
+    return(start);
+ else
+    return(NO_NODE);
+}
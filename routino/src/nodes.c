@@ -465,36 +465,9 @@ index_t FindClosestSegment(Nodes *nodes,Segments *segments,Ways *ways,double lat
 
 static int valid_segment_for_profile(Ways *ways,Segment *segmentp,Profile *profile)
 {
- Way *wayp=LookupWay(ways,segmentp->way,1);
- score_t segment_pref;
- int i;
-
- /* mode of transport must be allowed on the highway */
- if(!(wayp->allow&profile->allow))
-    return(0);
-
- /* must obey weight restriction (if exists) */
- if(wayp->weight && wayp->weight<profile->weight)
-    return(0);
-
- /* must obey height/width/length restriction (if exists) */
- if((wayp->height && wayp->height<profile->height) ||
-    (wayp->width  && wayp->width <profile->width ) ||
-    (wayp->length && wayp->length<profile->length))
-    return(0);
-
- segment_pref=profile->highway[HIGHWAY(wayp->type)];
-
- for(i=1;i<Property_Count;i++)
-    if(ways->file.props & PROPERTIES(i))
-      {
-       if(wayp->props & PROPERTIES(i))
-          segment_pref*=profile->props_yes[i];
-       else
-          segment_pref*=profile->props_no[i];
-      }
+ score_t segment_pref=profile->way_pref[segmentp->way];
 
- /* profile preferences must allow this highway */
+ /* profile must allow this highway (transport, restrictions, highway type and properties) */
  if(segment_pref==0)
     return(0);
 
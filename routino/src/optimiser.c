@@ -20,35 +20,85 @@
  ***************************************/
 
 
+#include <stdlib.h>
+
 #include "types.h"
 #include "nodes.h"
 #include "segments.h"
 #include "ways.h"
 #include "relations.h"
+#include "landmarks.h"
+#include "hierarchy.h"
+#include "partition.h"
 
 #include "logging.h"
 #include "functions.h"
 #include "fakes.h"
+#include "query.h"
 #include "results.h"
 
 
 /*+ To help when debugging +*/
 #define DEBUG 0
 
+/*+ The maximum number of labels kept for each node and segment by the Pareto route search. +*/
+#define MAX_PARETO_LABELS 64
+
+/*+ The difference in ascent that is not significant when comparing Pareto routes (in metres, the SRTM heights are whole metres). +*/
+#define PARETO_ASCENT 1
+
+/*+ The number of labels allocated at a time by the Pareto route search. +*/
+#define PARETO_BLOCK 4096
+
+
+/* Local types */
+
+/*+ The labels for the Pareto route search, the first label for each node and segment is in a list
+    of results and the others follow it using the next pointers (which are not otherwise used). +*/
+typedef struct _ParetoLabels
+{
+ Results *first;                /*+ The first label for each node and segment. +*/
+
+ Result **blocks;               /*+ The blocks of memory for the other labels (never moved once allocated). +*/
+ int      nblocks;              /*+ The number of blocks allocated. +*/
+ int      nused;                /*+ The number of labels used in the last block. +*/
+}
+ ParetoLabels;
+
 
 /* Global variables */
 
 /*+ The option not to print any progress information. +*/
 extern int option_quiet;
 
-/*+ The option to calculate the quickest route insted of the shortest. +*/
-extern int option_quickest;
-
 
 /* Local functions */
 
-static index_t FindSuperSegment(Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,index_t finish_node,index_t finish_segment);
-static Results *FindSuperRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,index_t start_node,index_t finish_node);
+static index_t FindSuperSegment(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,index_t finish_node,index_t finish_segment);
+static Results *FindSuperRoute(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,index_t start_node,index_t finish_node);
+
+static Results *FindNormalRouteBidirectional(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,index_t start_node,index_t prev_segment,index_t finish_node);
+static Results *FindMiddleRouteBidirectional(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,Results *begin,Results *end);
+static Result *JoinBidirectionalRoute(Results *results,Result *result1,Result *result2,score_t finish_score);
+static score_t LowerBoundScore(Query *query,Profile *profile,index_t node,double lat1,double lon1,double lat2,double lon2,double *limits);
+
+static int LandmarkLimits(Query *query,Nodes *nodes,Profile *profile,Results *results,double *limits);
+static distance_t LandmarkDistance(Query *query,index_t node,distance_t direct,double *limits);
+
+static Results *FindMiddleRouteHierarchy(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,Results *begin,Results *end);
+static Results *MakeMiddleRoute(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,Results *begin,Results *end,
+                                index_t prev_segment,index_t start_node,index_t *path_segments,score_t *path_scores,int npath,score_t finish_score);
+static void InsertHierarchyResult(Results *results,Queue *queue,index_t node,score_t score);
+static int HierarchySearchStep(Query *query,Hierarchy *hierarchy,Results *results,Queue *queue,Results *other,int down,score_t *finish_score,index_t *finish_node);
+static void UnpackHierarchyEdge(Hierarchy *hierarchy,index_t node1,index_t node2,index_t **segments,score_t **scores,int *number);
+static Results *FindMiddleRoutePartition(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,Results *begin,Results *end);
+static void InsertPartitionResult(Query *query,Nodes *nodes,Profile *profile,Results *results,Queue *queue,Result *prev,index_t index,score_t score,
+                                  score_t finish_score,double finish_lat,double finish_lon);
+
+static int SuperTurnAllowed(Query *query,Nodes *nodes,Relations *relations,Profile *profile,index_t node,index_t seg1,index_t seg2);
+
+static Result *InsertParetoLabel(ParetoLabels *labels,index_t node,index_t segment,score_t score,score_t bound,double ascent,double factor);
+static int ParetoDominated(Result **finishes,int nfinishes,score_t score,double ascent,double factor);
 
 
 /*++++++++++++++++++++++++++++++++++++++
@@ -56,6 +106,8 @@ static Results *FindSuperRoute(Nodes *nodes,Segments *segments,Ways *ways,Relati
 
   Results *FindNormalRoute Returns a set of results.
 
+  Query *query The query that is being calculated.
+
   Nodes *nodes The set of nodes to use.
 
   Segments *segments The set of segments to use.
@@ -73,7 +125,7 @@ static Results *FindSuperRoute(Nodes *nodes,Segments *segments,Ways *ways,Relati
   index_t finish_node The finish node.
   ++++++++++++++++++++++++++++++++++++++*/
 
-Results *FindNormalRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,index_t start_node,index_t prev_segment,index_t finish_node)
+Results *FindNormalRoute(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,index_t start_node,index_t prev_segment,index_t finish_node)
 {
  Results *results;
  Queue   *queue;
@@ -87,20 +139,25 @@ Results *FindNormalRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
  printf("  FindNormalRoute(...,start_node=%"Pindex_t" prev_segment=%"Pindex_t" finish_node=%"Pindex_t")\n",start_node,prev_segment,finish_node);
 #endif
 
+ /* Search from both ends if selected (only between real nodes, the searches from a waypoint are short) */
+
+ if(query->bidirectional && !IsFakeNode(start_node) && !IsFakeSegment(prev_segment) && !IsFakeNode(finish_node))
+    return(FindNormalRouteBidirectional(query,nodes,segments,ways,relations,profile,start_node,prev_segment,finish_node));
+
  /* Set up the finish conditions */
 
  finish_score=INF_SCORE;
  finish_result=NULL;
 
  if(IsFakeNode(finish_node))
-    GetFakeLatLong(finish_node,&finish_lat,&finish_lon);
+    GetFakeLatLong(query,finish_node,&finish_lat,&finish_lon);
  else
     GetLatLong(nodes,finish_node,&finish_lat,&finish_lon);
 
  /* Create the list of results and insert the first node into the queue */
 
- results=NewResultsList(64);
- queue=NewQueueList();
+ results=NewResultsList(query->pool,64);
+ queue=NewQueueList(query->pool);
 
  results->start_node=start_node;
  results->prev_segment=prev_segment;
@@ -132,11 +189,13 @@ Results *FindNormalRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
     if(result1->score>=finish_score)
        continue;
 
+    query->nsettled++;
+
     node1=result1->node;
     seg1=result1->segment;
 
     if(IsFakeSegment(seg1))
-       seg1r=IndexRealSegment(seg1);
+       seg1r=IndexRealSegment(query,seg1);
     else
        seg1r=seg1;
 
@@ -150,17 +209,15 @@ Results *FindNormalRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
     /* Loop across all segments */
 
     if(IsFakeNode(node1))
-       segmentp=FirstFakeSegment(node1);
+       segmentp=FirstFakeSegment(query,node1);
     else
        segmentp=FirstSegment(segments,node1p,1);
 
     while(segmentp)
       {
        Node *node2p=NULL;
-       Way *wayp;
        index_t node2,seg2,seg2r;
        score_t segment_pref,segment_score,cumulative_score;
-       int i;
 
        node2=OtherNode(segmentp,node1); /* need this here because we use node2 at the end of the loop */
 
@@ -174,8 +231,8 @@ Results *FindNormalRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
 
        if(IsFakeNode(node1) || IsFakeNode(node2))
          {
-          seg2 =IndexFakeSegment(segmentp);
-          seg2r=IndexRealSegment(seg2);
+          seg2 =IndexFakeSegment(query,segmentp);
+          seg2r=IndexRealSegment(query,seg2);
          }
        else
          {
@@ -191,7 +248,7 @@ Results *FindNormalRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
          }
        else
           /* must not perform U-turn (unless profile allows) */
-          if(profile->turns && (seg1==seg2 || seg1==seg2r || seg1r==seg2 || (seg1r==seg2r && IsFakeUTurn(seg1,seg2))))
+          if(profile->turns && (seg1==seg2 || seg1==seg2r || seg1r==seg2 || (seg1r==seg2r && IsFakeUTurn(query,seg1,seg2))))
              goto endloop;
 
        /* must obey turn relations */
@@ -205,38 +262,9 @@ Results *FindNormalRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
        if(node2!=finish_node && node2p && IsSuperNode(node2p))
           goto endloop;
 
-       wayp=LookupWay(ways,segmentp->way,1);
-
-       /* mode of transport must be allowed on the highway */
-       if(!(wayp->allow&profile->allow))
-          goto endloop;
-
-       /* must obey weight restriction (if exists) */
-       if(wayp->weight && wayp->weight<profile->weight)
-          goto endloop;
-
-       /* must obey height/width/length restriction (if exist) */
-       if((wayp->height && wayp->height<profile->height) ||
-          (wayp->width  && wayp->width <profile->width ) ||
-          (wayp->length && wayp->length<profile->length))
-          goto endloop;
-
-       segment_pref=profile->highway[HIGHWAY(wayp->type)];
-
-       /* highway preferences must allow this highway */
-       if(segment_pref==0)
-          goto endloop;
-
-       for(i=1;i<Property_Count;i++)
-          if(ways->file.props & PROPERTIES(i))
-            {
-             if(wayp->props & PROPERTIES(i))
-                segment_pref*=profile->props_yes[i];
-             else
-                segment_pref*=profile->props_no[i];
-            }
+       segment_pref=profile->way_pref[segmentp->way];
 
-       /* profile preferences must allow this highway */
+       /* profile must allow this highway (transport, restrictions, highway type and properties) */
        if(segment_pref==0)
           goto endloop;
 
@@ -244,10 +272,10 @@ Results *FindNormalRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
        if(node2p && node2!=finish_node && !(node2p->allow&profile->allow))
           goto endloop;
 
-       if(option_quickest==0)
+       if(query->quickest==0)
           segment_score=(score_t)DISTANCE(segmentp->distance)/segment_pref;
        else
-          segment_score=(score_t)Duration(segmentp,wayp,profile)/segment_pref;
+          segment_score=(score_t)Duration(segmentp,profile)/segment_pref;
 
        cumulative_score=result1->score+segment_score;
 
@@ -286,7 +314,7 @@ Results *FindNormalRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
       endloop:
 
        if(IsFakeNode(node1))
-          segmentp=NextFakeSegment(segmentp,node1);
+          segmentp=NextFakeSegment(query,segmentp,node1);
        else if(IsFakeNode(node2))
           segmentp=NULL; /* cannot call NextSegment() with a fake segment */
        else
@@ -294,7 +322,7 @@ Results *FindNormalRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
           segmentp=NextSegment(segments,segmentp,node1);
 
           if(!segmentp && IsFakeNode(finish_node))
-             segmentp=ExtraFakeSegment(node1,finish_node);
+             segmentp=ExtraFakeSegment(query,node1,finish_node);
          }
       }
    }
@@ -335,6 +363,8 @@ Results *FindNormalRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
 
   Results *FindMiddleRoute Returns a set of results.
 
+  Query *query The query that is being calculated.
+
   Nodes *nodes The set of nodes to use.
 
   Segments *segments The set of segments to use.
@@ -350,7 +380,7 @@ Results *FindNormalRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
   Results *end The final portion of the route.
   ++++++++++++++++++++++++++++++++++++++*/
 
-Results *FindMiddleRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,Results *begin,Results *end)
+Results *FindMiddleRoute(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,Results *begin,Results *end)
 {
  Results *results;
  Queue   *queue;
@@ -359,11 +389,31 @@ Results *FindMiddleRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
  double  finish_lat,finish_lon;
  Result  *result1,*result2,*result3,*result4;
  int     force_uturn=0;
+ double  limits[2*MAX_LANDMARKS],*landmarks=NULL;
 
 #if DEBUG
  printf("  FindMiddleRoute(...,[begin has %d nodes],[end has %d nodes])\n",begin->number,end->number);
 #endif
 
+ /* Search the contraction hierarchy if there is one for this profile (not with hills and a partition
+    because the hierarchy uses the ascent of the whole super-segment) */
+
+ if(query->hierarchy && HierarchyMatchesProfile(query->hierarchy,profile,query->quickest) &&
+    !(query->customisation && query->quickest && profile->hills))
+    if((results=FindMiddleRouteHierarchy(query,nodes,segments,ways,relations,profile,begin,end)))
+       return(results);
+
+ /* Search the partition if there is one */
+
+ if(query->customisation)
+    if((results=FindMiddleRoutePartition(query,nodes,segments,ways,relations,profile,begin,end)))
+       return(results);
+
+ /* Search from both ends if selected */
+
+ if(query->bidirectional)
+    return(FindMiddleRouteBidirectional(query,nodes,segments,ways,relations,profile,begin,end));
+
 #if !DEBUG
  if(!option_quiet)
     printf_first("Routing: Super-Nodes checked = 0");
@@ -375,14 +425,19 @@ Results *FindMiddleRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
  finish_result=NULL;
 
  if(IsFakeNode(end->finish_node))
-    GetFakeLatLong(end->finish_node,&finish_lat,&finish_lon);
+    GetFakeLatLong(query,end->finish_node,&finish_lat,&finish_lon);
  else
     GetLatLong(nodes,end->finish_node,&finish_lat,&finish_lon);
 
+ /* Use the landmarks (if there are any) to improve on the straight line distance to the finish */
+
+ if(LandmarkLimits(query,nodes,profile,end,limits))
+    landmarks=limits;
+
  /* Create the list of results and insert the first node into the queue */
 
- results=NewResultsList(65536);
- queue=NewQueueList();
+ results=NewResultsList(query->pool,65536);
+ queue=NewQueueList(query->pool);
 
  results->start_node=begin->start_node;
  results->prev_segment=begin->prev_segment;
@@ -393,7 +448,7 @@ Results *FindMiddleRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
        results->prev_segment=NO_SEGMENT;
     else
       {
-       index_t superseg=FindSuperSegment(nodes,segments,ways,relations,begin->start_node,begin->prev_segment);
+       index_t superseg=FindSuperSegment(query,nodes,segments,ways,relations,begin->start_node,begin->prev_segment);
 
        results->prev_segment=superseg;
       }
@@ -412,7 +467,7 @@ Results *FindMiddleRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
        !IsFakeNode(result3->node) && IsSuperNode(LookupNode(nodes,result3->node,5)))
       {
        Result *result5=result1;
-       index_t superseg=FindSuperSegment(nodes,segments,ways,relations,result3->node,result3->segment);
+       index_t superseg=FindSuperSegment(query,nodes,segments,ways,relations,result3->node,result3->segment);
 
        if(superseg!=result3->segment)
          {
@@ -464,21 +519,28 @@ Results *FindMiddleRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
    {
     Node *node1p;
     Segment *segmentp;
-    index_t node1,seg1;
+    index_t node1,seg1,seg1r;
     index_t turnrelation=NO_RELATION;
 
     /* score must be better than current best score */
     if(result1->score>=finish_score)
        continue;
 
+    query->nsettled++;
+
     node1=result1->node;
     seg1=result1->segment;
 
+    if(IsFakeSegment(seg1))
+       seg1r=IndexRealSegment(query,seg1);
+    else
+       seg1r=seg1;
+
     node1p=LookupNode(nodes,node1,1); /* node1 cannot be a fake node (must be a super-node) */
 
     /* lookup if a turn restriction applies */
     if(profile->turns && IsTurnRestrictedNode(node1p)) /* node1 cannot be a fake node (must be a super-node) */
-       turnrelation=FindFirstTurnRelation2(relations,node1,seg1);
+       turnrelation=FindFirstTurnRelation2(relations,node1,seg1r);
 
     /* Loop across all segments */
 
@@ -487,10 +549,8 @@ Results *FindMiddleRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
     while(segmentp)
       {
        Node *node2p;
-       Way *wayp;
        index_t node2,seg2;
        score_t segment_pref,segment_score,cumulative_score;
-       int i;
 
        /* must be a super segment */
        if(!IsSuperSegment(segmentp))
@@ -514,41 +574,12 @@ Results *FindMiddleRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
              goto endloop;
 
        /* must obey turn relations */
-       if(turnrelation!=NO_RELATION && !IsTurnAllowed(relations,turnrelation,node1,seg1,seg2,profile->allow))
-          goto endloop;
-
-       wayp=LookupWay(ways,segmentp->way,1);
-
-       /* mode of transport must be allowed on the highway */
-       if(!(wayp->allow&profile->allow))
-          goto endloop;
-
-       /* must obey weight restriction (if exists) */
-       if(wayp->weight && wayp->weight<profile->weight)
-          goto endloop;
-
-       /* must obey height/width/length restriction (if exist) */
-       if((wayp->height && wayp->height<profile->height) ||
-          (wayp->width  && wayp->width <profile->width ) ||
-          (wayp->length && wayp->length<profile->length))
-          goto endloop;
-
-       segment_pref=profile->highway[HIGHWAY(wayp->type)];
-
-       /* highway preferences must allow this highway */
-       if(segment_pref==0)
+       if(turnrelation!=NO_RELATION && !IsTurnAllowed(relations,turnrelation,node1,seg1r,seg2,profile->allow))
           goto endloop;
 
-       for(i=1;i<Property_Count;i++)
-          if(ways->file.props & PROPERTIES(i))
-            {
-             if(wayp->props & PROPERTIES(i))
-                segment_pref*=profile->props_yes[i];
-             else
-                segment_pref*=profile->props_no[i];
-            }
+       segment_pref=profile->way_pref[segmentp->way];
 
-       /* profile preferences must allow this highway */
+       /* profile must allow this highway (transport, restrictions, highway type and properties) */
        if(segment_pref==0)
           goto endloop;
 
@@ -560,10 +591,12 @@ Results *FindMiddleRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
        if(node2!=end->finish_node && !(node2p->allow&profile->allow))
           goto endloop;
 
-       if(option_quickest==0)
+       if(query->customisation)
+          segment_score=CustomisedScore(query->customisation,seg2);
+       else if(query->quickest==0)
           segment_score=(score_t)DISTANCE(segmentp->distance)/segment_pref;
        else
-          segment_score=(score_t)Duration(segmentp,wayp,profile)/segment_pref;
+          segment_score=(score_t)Duration(segmentp,profile)/segment_pref;
 
        cumulative_score=result1->score+segment_score;
 
@@ -604,7 +637,10 @@ Results *FindMiddleRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
 
           direct=Distance(lat,lon,finish_lat,finish_lon);
 
-          if(option_quickest==0)
+          if(landmarks)
+             direct=LandmarkDistance(query,node2,direct,landmarks);
+
+          if(query->quickest==0)
              result2->sortby=result2->score+(score_t)direct/profile->max_pref;
           else
              result2->sortby=result2->score+(score_t)distance_speed_to_duration(direct,profile->max_speed)/profile->max_pref;
@@ -673,9 +709,12 @@ Results *FindMiddleRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
 
 
 /*++++++++++++++++++++++++++++++++++++++
-  Find the super-segment that represents the route that contains a particular segment.
+  Find the optimum route between two real nodes not passing through a super-node by searching
+  forwards from the start node and backwards from the finish node at the same time.
 
-  index_t FindSuperSegment Returns the index of the super-segment.
+  Results *FindNormalRouteBidirectional Returns a set of results.
+
+  Query *query The query that is being calculated.
 
   Nodes *nodes The set of nodes to use.
 
@@ -685,205 +724,3077 @@ Results *FindMiddleRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
 
   Relations *relations The set of relations to use.
 
-  index_t finish_node The super-node that the route ends at.
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
 
-  index_t finish_segment The segment that the route ends with.
+  index_t start_node The start node (not a fake node).
+
+  index_t prev_segment The previous segment before the start node (not a fake segment).
+
+  index_t finish_node The finish node (not a fake node).
+
+  The results working backwards are stored in the same way as the ones working forwards (the node
+  and the segment that arrives at it) but the score is the score from the node to the finish.
   ++++++++++++++++++++++++++++++++++++++*/
 
-static index_t FindSuperSegment(Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,index_t finish_node,index_t finish_segment)
+static Results *FindNormalRouteBidirectional(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,index_t start_node,index_t prev_segment,index_t finish_node)
 {
- Node *supernodep;
- Segment *supersegmentp;
+ Results *results,*results2;
+ Queue   *queue,*queue2;
+ score_t finish_score,forward_score=0,backward_score=0;
+ Result  *finish_result,*finish_result2;
+ Result  *result1,*result2,*result3;
+ Node    *finishp;
+ Segment *segmentp;
+ int     force_uturn=0,backward=1;
 
- if(IsFakeSegment(finish_segment))
-    finish_segment=IndexRealSegment(finish_segment);
+#if DEBUG
+ printf("  FindNormalRouteBidirectional(...,start_node=%"Pindex_t" prev_segment=%"Pindex_t" finish_node=%"Pindex_t")\n",start_node,prev_segment,finish_node);
+#endif
 
- supernodep=LookupNode(nodes,finish_node,5); /* finish_node cannot be a fake node (must be a super-node) */
- supersegmentp=LookupSegment(segments,finish_segment,2); /* finish_segment cannot be a fake segment. */
+ /* Set up the finish conditions */
 
- if(IsSuperSegment(supersegmentp))
-    return(finish_segment);
+ finish_score=INF_SCORE;
+ finish_result=NULL;
+ finish_result2=NULL;
 
- /* Loop across all segments */
+ /* Create the list of results and insert the first node into the queue */
 
- supersegmentp=FirstSegment(segments,supernodep,3); /* supernode cannot be a fake node (must be a super-node) */
+ results=NewResultsList(query->pool,64);
+ queue=NewQueueList(query->pool);
 
- while(supersegmentp)
-   {
-    if(IsSuperSegment(supersegmentp))
-      {
-       Results *results;
-       Result *result;
-       index_t start_node;
+ results->start_node=start_node;
+ results->prev_segment=prev_segment;
 
-       start_node=OtherNode(supersegmentp,finish_node);
+ result1=InsertResult(results,results->start_node,results->prev_segment);
 
-       results=FindSuperRoute(nodes,segments,ways,relations,start_node,finish_node);
+ InsertInQueue(queue,result1);
 
-       if(!results)
-          continue;
+ /* Create the list of results working backwards and insert the finish node (arriving along each of its segments) into the queue */
 
-       result=FindResult(results,finish_node,finish_segment);
+ results2=NewResultsList(query->pool,64);
+ queue2=NewQueueList(query->pool);
 
-       if(result && (distance_t)result->score==DISTANCE(supersegmentp->distance))
-         {
-          FreeResultsList(results);
-          return(IndexSegment(segments,supersegmentp));
-         }
+ results2->finish_node=finish_node;
 
-       if(results)
-          FreeResultsList(results);
-      }
+ finishp=LookupNode(nodes,finish_node,1);
 
-    supersegmentp=NextSegment(segments,supersegmentp,finish_node); /* finish_node cannot be a fake node (must be a super-node) */
-   }
+ segmentp=FirstSegment(segments,finishp,1);
 
- return(finish_segment);
-}
+ while(segmentp)
+   {
+    result1=InsertResult(results2,finish_node,IndexSegment(segments,segmentp));
 
+    InsertInQueue(queue2,result1);
 
-/*++++++++++++++++++++++++++++++++++++++
-  Find the shortest route between two super-nodes using only normal nodes.
-  This is effectively the same function as is used in superx.c when finding super-segments initially.
+    segmentp=NextSegment(segments,segmentp,finish_node);
+   }
 
-  Results *FindSuperRoute Returns a set of results.
+ /* Check for barrier at start waypoint - must perform U-turn */
 
-  Nodes *nodes The set of nodes to use.
+ if(prev_segment!=NO_SEGMENT)
+   {
+    Node *startp=LookupNode(nodes,start_node,1);
 
-  Segments *segments The set of segments to use.
+    if(!(startp->allow&profile->allow))
+       force_uturn=1;
+   }
 
-  Ways *ways The set of ways to use.
+ /* Loop across the nodes in the two queues, taking one from each in turn */
 
-  Relations *relations The set of relations to use.
+ while(1)
+   {
+    backward=!backward;
 
-  index_t start_node The start node.
+    if(!backward)
+      {
+       Node *node1p;
+       index_t node1,seg1;
+       index_t turnrelation=NO_RELATION;
 
-  index_t finish_node The finish node.
-  ++++++++++++++++++++++++++++++++++++++*/
+       result1=PopFromQueue(queue);
 
-static Results *FindSuperRoute(Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,index_t start_node,index_t finish_node)
-{
- Results *results;
- Queue   *queue;
- Result  *result1,*result2;
+       /* stop when no route through the unchecked nodes can be better than the current best route */
+       if(!result1 || (result1->score+backward_score)>=finish_score)
+          break;
 
-#if DEBUG
- printf("    FindSuperRoute(...,start_node=%"Pindex_t" finish_node=%"Pindex_t")\n",start_node,finish_node);
-#endif
+       forward_score=result1->score;
 
- /* Create the list of results and insert the first node into the queue */
+       query->nsettled++;
 
- results=NewResultsList(64);
- queue=NewQueueList();
+       node1=result1->node;
+       seg1=result1->segment;
 
- results->start_node=start_node;
- results->prev_segment=NO_SEGMENT;
+       node1p=LookupNode(nodes,node1,1);
 
- result1=InsertResult(results,results->start_node,results->prev_segment);
+       /* lookup if a turn restriction applies */
+       if(profile->turns && IsTurnRestrictedNode(node1p))
+          turnrelation=FindFirstTurnRelation2(relations,node1,seg1);
 
- InsertInQueue(queue,result1);
+       /* Loop across all segments */
 
- /* Loop across all nodes in the queue */
+       segmentp=FirstSegment(segments,node1p,1);
 
- while((result1=PopFromQueue(queue)))
-   {
-    Node *node1p=NULL;
-    Segment *segmentp;
-    index_t node1,seg1;
+       while(segmentp)
+         {
+          Node *node2p;
+          index_t node2,seg2;
+          score_t segment_pref,segment_score,cumulative_score;
 
-    node1=result1->node;
-    seg1=result1->segment;
+          node2=OtherNode(segmentp,node1);
 
-    node1p=LookupNode(nodes,node1,1); /* node1 cannot be a fake node */
+          /* must be a normal segment */
+          if(!IsNormalSegment(segmentp))
+             goto endloop;
 
-    /* Loop across all segments */
+          /* must obey one-way restrictions (unless profile allows) */
+          if(profile->oneway && IsOnewayTo(segmentp,node1))
+             goto endloop;
 
-    segmentp=FirstSegment(segments,node1p,1); /* node1 cannot be a fake node */
+          seg2=IndexSegment(segments,segmentp); /* no fake segments (see FindNormalRoute) */
 
-    while(segmentp)
-      {
-       Node *node2p=NULL;
-       index_t node2,seg2;
-       score_t cumulative_score;
+          /* must perform U-turn in special cases */
+          if(force_uturn && node1==results->start_node)
+            {
+             if(seg2!=result1->segment)
+                goto endloop;
+            }
+          else
+             /* must not perform U-turn (unless profile allows) */
+             if(profile->turns && seg1==seg2)
+                goto endloop;
 
-       /* must be a normal segment */
-       if(!IsNormalSegment(segmentp))
-          goto endloop;
+          /* must obey turn relations */
+          if(turnrelation!=NO_RELATION && !IsTurnAllowed(relations,turnrelation,node1,seg1,seg2,profile->allow))
+             goto endloop;
 
-       /* must obey one-way restrictions */
-       if(IsOnewayTo(segmentp,node1))
-          goto endloop;
+          node2p=LookupNode(nodes,node2,2);
 
-       seg2=IndexSegment(segments,segmentp);
+          /* must not pass over super-node */
+          if(node2!=finish_node && IsSuperNode(node2p))
+             goto endloop;
 
-       /* must not perform U-turn */
-       if(seg1==seg2)
-          goto endloop;
+          segment_pref=profile->way_pref[segmentp->way];
 
-       node2=OtherNode(segmentp,node1);
+          /* profile must allow this highway (transport, restrictions, highway type and properties) */
+          if(segment_pref==0)
+             goto endloop;
 
-       node2p=LookupNode(nodes,node2,2); /* node2 cannot be a fake node */
+          /* mode of transport must be allowed through node2 unless it is the final node */
+          if(node2!=finish_node && !(node2p->allow&profile->allow))
+             goto endloop;
 
-       /* must not pass over super-node */
-       if(node2!=finish_node && IsSuperNode(node2p))
-          goto endloop;
+          if(query->quickest==0)
+             segment_score=(score_t)DISTANCE(segmentp->distance)/segment_pref;
+          else
+             segment_score=(score_t)Duration(segmentp,profile)/segment_pref;
 
-       /* Specifically looking for the shortest route to emulate superx.c */
-       cumulative_score=result1->score+(score_t)DISTANCE(segmentp->distance);
+          cumulative_score=result1->score+segment_score;
 
-       result2=FindResult(results,node2,seg2);
+          /* score must be better than current best score */
+          if(cumulative_score>=finish_score)
+             goto endloop;
 
-       if(!result2) /* New end node/segment combination */
-         {
-          result2=InsertResult(results,node2,seg2);
-          result2->prev=result1;
-          result2->score=cumulative_score;
-          result2->sortby=result2->score;
-         }
-       else if(cumulative_score<result2->score) /* New score for end node/segment combination is better */
-         {
-          result2->prev=result1;
-          result2->segment=seg2;
-          result2->score=cumulative_score;
-          result2->sortby=result2->score;
-         }
-       else goto endloop;
+          result2=FindResult(results,node2,seg2);
 
-       /* don't route beyond a super-node. */
-       if(!IsSuperNode(node2p))
-          InsertInQueue(queue,result2);
+          if(!result2) /* New end node/segment combination */
+            {
+             result2=InsertResult(results,node2,seg2);
+             result2->prev=result1;
+             result2->score=cumulative_score;
+            }
+          else if(cumulative_score<result2->score) /* New score for end node/segment combination is better */
+            {
+             result2->prev=result1;
+             result2->score=cumulative_score;
+            }
+          else
+             goto endloop;
 
-      endloop:
+          /* check if the route joins one from the finish (including the finish node itself) */
+          if((result3=FindResult(results2,node2,seg2)) && (result2->score+result3->score)<finish_score)
+            {
+             finish_score=result2->score+result3->score;
+             finish_result=result2;
+             finish_result2=result3;
+            }
 
-       segmentp=NextSegment(segments,segmentp,node1);
-      }
-   }
+          if(node2!=finish_node)
+            {
+             result2->sortby=result2->score;
+             InsertInQueue(queue,result2);
+            }
 
- FreeQueueList(queue);
+         endloop:
 
-#if DEBUG
- Result *r=FindResult(results,results->start_node,results->prev_segment);
+          segmentp=NextSegment(segments,segmentp,node1);
+         }
+      }
+    else
+      {
+       Node *node0p;
+       Segment *segment1p;
+       index_t node1,seg1,node0;
+       score_t segment_pref,segment_score,cumulative_score;
 
- while(r)
-   {
-    printf("      node=%"Pindex_t" segment=%"Pindex_t" score=%f\n",r->node,r->segment,r->score);
+       result1=PopFromQueue(queue2);
 
-    r=r->next;
-   }
-#endif
+       /* stop when no route through the unchecked nodes can be better than the current best route */
+       if(!result1 || (result1->score+forward_score)>=finish_score)
+          break;
 
- return(results);
-}
+       backward_score=result1->score;
 
+       query->nsettled++;
 
-/*++++++++++++++++++++++++++++++++++++++
-  Find all routes from a specified node to any super-node.
+       node1=result1->node;
+       seg1=result1->segment;
 
-  Results *FindStartRoutes Returns a set of results.
+       segment1p=LookupSegment(segments,seg1,2);
 
-  Nodes *nodes The set of nodes to use.
+       node0=OtherNode(segment1p,node1);
 
-  Segments *segments The set of segments to use.
+       /* must be a normal segment */
+       if(!IsNormalSegment(segment1p))
+          continue;
+
+       /* must obey one-way restrictions (unless profile allows) */
+       if(profile->oneway && IsOnewayTo(segment1p,node0))
+          continue;
+
+       segment_pref=profile->way_pref[segment1p->way];
+
+       /* profile must allow this highway (transport, restrictions, highway type and properties) */
+       if(segment_pref==0)
+          continue;
+
+       /* the segment is scored in the direction it is travelled (node0 to node1) so that any
+          difference between going uphill and downhill is the same as in the forward search */
+
+       if(query->quickest==0)
+          segment_score=(score_t)DISTANCE(segment1p->distance)/segment_pref;
+       else
+          segment_score=(score_t)Duration(segment1p,profile)/segment_pref;
+
+       cumulative_score=result1->score+segment_score;
+
+       /* score must be better than current best score */
+       if(cumulative_score>=finish_score)
+          continue;
+
+       node0p=LookupNode(nodes,node0,2);
+
+       /* check if the route joins the start of the route (obeying the same rules as the forward search) */
+       if(node0==results->start_node)
+         {
+          index_t turnrelation=NO_RELATION;
+
+          if(profile->turns && IsTurnRestrictedNode(node0p))
+             turnrelation=FindFirstTurnRelation2(relations,node0,results->prev_segment);
+
+          /* must perform U-turn in special cases or must not perform U-turn (unless profile allows) and must obey turn relations */
+          if((force_uturn?(seg1==results->prev_segment):!(profile->turns && seg1==results->prev_segment)) &&
+             (turnrelation==NO_RELATION || IsTurnAllowed(relations,turnrelation,node0,results->prev_segment,seg1,profile->allow)))
+            {
+             result2=FindResult(results2,node0,results->prev_segment);
+
+             if(!result2)
+                result2=InsertResult(results2,node0,results->prev_segment);
+
+             result2->next=result1; /* working backwards */
+             result2->score=cumulative_score;
+
+             finish_score=cumulative_score;
+             finish_result=FindResult(results,results->start_node,results->prev_segment);
+             finish_result2=result2;
+            }
+         }
+
+       /* must not pass over the finish node or a super-node */
+       if(node0==finish_node || IsSuperNode(node0p))
+          continue;
+
+       /* mode of transport must be allowed through node0 */
+       if(!(node0p->allow&profile->allow))
+          continue;
+
+       /* Loop across all segments that arrive at node0 */
+
+       segmentp=FirstSegment(segments,node0p,1);
+
+       while(segmentp)
+         {
+          index_t seg0;
+          index_t turnrelation=NO_RELATION;
+
+          /* must be a normal segment */
+          if(!IsNormalSegment(segmentp))
+             goto endloop2;
+
+          /* must obey one-way restrictions (unless profile allows) */
+          if(profile->oneway && IsOnewayFrom(segmentp,node0)) /* working backwards => disallow oneway *from* node0 */
+             goto endloop2;
+
+          seg0=IndexSegment(segments,segmentp);
+
+          /* the start node and previous segment are only the start of the route (see above) */
+          if(node0==results->start_node && seg0==results->prev_segment)
+             goto endloop2;
+
+          /* must not perform U-turn (unless profile allows) */
+          if(profile->turns && seg0==seg1)
+             goto endloop2;
+
+          /* must obey turn relations */
+          if(profile->turns && IsTurnRestrictedNode(node0p))
+             turnrelation=FindFirstTurnRelation2(relations,node0,seg0); /* working backwards => one lookup per segment */
+
+          if(turnrelation!=NO_RELATION && !IsTurnAllowed(relations,turnrelation,node0,seg0,seg1,profile->allow))
+             goto endloop2;
+
+          result2=FindResult(results2,node0,seg0);
+
+          if(!result2) /* New end node/segment combination */
+            {
+             result2=InsertResult(results2,node0,seg0);
+             result2->next=result1; /* working backwards */
+             result2->score=cumulative_score;
+            }
+          else if(cumulative_score<result2->score) /* New score for end node/segment combination is better */
+            {
+             result2->next=result1; /* working backwards */
+             result2->score=cumulative_score;
+            }
+          else
+             goto endloop2;
+
+          /* check if the route joins one from the start */
+          if((result3=FindResult(results,node0,seg0)) && (result3->score+result2->score)<finish_score)
+            {
+             finish_score=result3->score+result2->score;
+             finish_result=result3;
+             finish_result2=result2;
+            }
+
+          result2->sortby=result2->score;
+          InsertInQueue(queue2,result2);
+
+         endloop2:
+
+          segmentp=NextSegment(segments,segmentp,node0);
+         }
+      }
+   }
+
+ FreeQueueList(queue);
+ FreeQueueList(queue2);
+
+ /* Check it worked */
+
+ if(!finish_result)
+   {
+#if DEBUG
+    printf("    Failed\n");
+#endif
+
+    FreeResultsList(results);
+    FreeResultsList(results2);
+    return(NULL);
+   }
+
+ /* Join the route from the finish onto the route from the start */
+
+ finish_result=JoinBidirectionalRoute(results,finish_result,finish_result2,finish_score);
+
+ FreeResultsList(results2);
+
+ FixForwardRoute(results,finish_result);
+
+#if DEBUG
+ Result *r=FindResult(results,results->start_node,results->prev_segment);
+
+ while(r)
+   {
+    printf("    node=%"Pindex_t" segment=%"Pindex_t" score=%f\n",r->node,r->segment,r->score);
+
+    r=r->next;
+   }
+#endif
+
+ return(results);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Find the optimum route between two nodes where the start and end are a set of pre/post-routed
+  super-nodes by searching forwards from the start and backwards from the finish at the same time.
+
+  Results *FindMiddleRouteBidirectional Returns a set of results.
+
+  Query *query The query that is being calculated.
+
+  Nodes *nodes The set of nodes to use.
+
+  Segments *segments The set of segments to use.
+
+  Ways *ways The set of ways to use.
+
+  Relations *relations The set of relations to use.
+
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
+
+  Results *begin The initial portion of the route.
+
+  Results *end The final portion of the route.
+
+  Both searches are A* searches using half of the difference between the straight line scores to
+  the finish and to the start (so that the two searches are consistent with each other) and they
+  stop when the sum of the two sortby values is no better than the best route joining them.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static Results *FindMiddleRouteBidirectional(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,Results *begin,Results *end)
+{
+ Results *results,*results2;
+ Queue   *queue,*queue2;
+ Result  *finish_result,*finish_result2;
+ score_t finish_score;
+ double  finish_lat,finish_lon;
+ double  start_lat,start_lon;
+ score_t forward_sortby,backward_sortby;
+ Result  *result1,*result2,*result3,*result4;
+ int     force_uturn=0,backward=1;
+ double  finish_limits[2*MAX_LANDMARKS],*finish_landmarks=NULL;
+ double  start_limits[2*MAX_LANDMARKS],*start_landmarks=NULL;
+
+#if DEBUG
+ printf("  FindMiddleRouteBidirectional(...,[begin has %d nodes],[end has %d nodes])\n",begin->number,end->number);
+#endif
+
+#if !DEBUG
+ if(!option_quiet)
+    printf_first("Routing: Super-Nodes checked = 0");
+#endif
+
+ /* Set up the finish conditions */
+
+ finish_score=INF_SCORE;
+ finish_result=NULL;
+ finish_result2=NULL;
+
+ if(IsFakeNode(end->finish_node))
+    GetFakeLatLong(query,end->finish_node,&finish_lat,&finish_lon);
+ else
+    GetLatLong(nodes,end->finish_node,&finish_lat,&finish_lon);
+
+ if(IsFakeNode(begin->start_node))
+    GetFakeLatLong(query,begin->start_node,&start_lat,&start_lon);
+ else
+    GetLatLong(nodes,begin->start_node,&start_lat,&start_lon);
+
+ /* Use the landmarks (if there are any) to improve on the straight line distances to each end */
+
+ if(LandmarkLimits(query,nodes,profile,end,finish_limits))
+    finish_landmarks=finish_limits;
+
+ if(LandmarkLimits(query,nodes,profile,begin,start_limits))
+    start_landmarks=start_limits;
+
+ /* The lowest possible sortby values are half of the lowest possible score for the route */
+
+ forward_sortby=backward_sortby=LowerBoundScore(query,profile,NO_NODE,start_lat,start_lon,finish_lat,finish_lon,NULL)/2;
+
+ /* Create the list of results and insert the first node into the queue */
+
+ results=NewResultsList(query->pool,65536);
+ queue=NewQueueList(query->pool);
+
+ results->start_node=begin->start_node;
+ results->prev_segment=begin->prev_segment;
+
+ if(begin->number==1)
+   {
+    if(begin->prev_segment==NO_SEGMENT)
+       results->prev_segment=NO_SEGMENT;
+    else
+      {
+       index_t superseg=FindSuperSegment(query,nodes,segments,ways,relations,begin->start_node,begin->prev_segment);
+
+       results->prev_segment=superseg;
+      }
+   }
+
+ result1=InsertResult(results,results->start_node,results->prev_segment);
+
+ result1->sortby=forward_sortby;
+
+ /* Insert the finish points of the beginning part of the path into the queue,
+    translating the segments into super-segments. */
+
+ result3=FirstResult(begin);
+
+ while(result3)
+   {
+    if((results->start_node!=result3->node || results->prev_segment!=result3->segment) &&
+       !IsFakeNode(result3->node) && IsSuperNode(LookupNode(nodes,result3->node,5)))
+      {
+       Result *result5=result1;
+       index_t superseg=FindSuperSegment(query,nodes,segments,ways,relations,result3->node,result3->segment);
+
+       if(superseg!=result3->segment)
+         {
+          result5=InsertResult(results,result3->node,result3->segment);
+
+          result5->prev=result1;
+         }
+
+       if(!FindResult(results,result3->node,superseg))
+         {
+          double lat,lon;
+
+          result2=InsertResult(results,result3->node,superseg);
+          result2->prev=result5;
+
+          result2->score=result3->score;
+
+          GetLatLong(nodes,result3->node,&lat,&lon);
+
+          result2->sortby=result2->score+(LowerBoundScore(query,profile,result3->node,lat,lon,finish_lat,finish_lon,finish_landmarks)-
+                                          LowerBoundScore(query,profile,result3->node,lat,lon,start_lat,start_lon,start_landmarks))/2;
+
+          InsertInQueue(queue,result2);
+         }
+      }
+
+    result3=NextResult(begin,result3);
+   }
+
+ if(begin->number==1)
+    InsertInQueue(queue,result1);
+
+ /* Create the list of results working backwards and insert the start points of the end part of
+    the path into the queue, these are the only results working backwards with no next result. */
+
+ results2=NewResultsList(query->pool,65536);
+ queue2=NewQueueList(query->pool);
+
+ results2->finish_node=end->finish_node;
+
+ result3=FirstResult(end);
+
+ while(result3)
+   {
+    if(!IsFakeNode(result3->node) && !IsFakeSegment(result3->segment) && IsSuperNode(LookupNode(nodes,result3->node,5)))
+      {
+       double lat,lon;
+
+       result2=InsertResult(results2,result3->node,result3->segment);
+
+       result2->score=result3->score;
+
+       GetLatLong(nodes,result3->node,&lat,&lon);
+
+       result2->sortby=result2->score+(LowerBoundScore(query,profile,result3->node,lat,lon,start_lat,start_lon,start_landmarks)-
+                                       LowerBoundScore(query,profile,result3->node,lat,lon,finish_lat,finish_lon,finish_landmarks))/2;
+
+       InsertInQueue(queue2,result2);
+
+       /* check if the start of the end part of the path is already the end of the beginning part */
+       if((result4=FindResult(results,result2->node,result2->segment)) && (result4->prev || begin->number==1) &&
+          (result4->score+result2->score)<finish_score)
+         {
+          finish_score=result4->score+result2->score;
+          finish_result=result4;
+          finish_result2=result2;
+         }
+      }
+
+    result3=NextResult(end,result3);
+   }
+
+ /* Check for barrier at start waypoint - must perform U-turn */
+
+ if(begin->number==1 && results->prev_segment!=NO_SEGMENT)
+   {
+    Node *startp=LookupNode(nodes,results->start_node,1);
+
+    if(!(startp->allow&profile->allow))
+       force_uturn=1;
+   }
+
+ /* Loop across the nodes in the two queues, taking one from each in turn */
+
+ while(1)
+   {
+    backward=!backward;
+
+    if(!backward)
+      {
+       Node *node1p;
+       Segment *segmentp;
+       index_t node1,seg1;
+       index_t turnrelation=NO_RELATION;
+
+       result1=PopFromQueue(queue);
+
+       /* stop when no route through the unchecked nodes can be better than the current best route */
+       if(!result1 || (result1->sortby+backward_sortby)>=finish_score)
+          break;
+
+       forward_sortby=result1->sortby;
+
+       query->nsettled++;
+
+       node1=result1->node;
+       seg1=result1->segment;
+
+       node1p=LookupNode(nodes,node1,1); /* node1 cannot be a fake node (must be a super-node) */
+
+       /* lookup if a turn restriction applies */
+       if(profile->turns && IsTurnRestrictedNode(node1p)) /* node1 cannot be a fake node (must be a super-node) */
+          turnrelation=FindFirstTurnRelation2(relations,node1,seg1);
+
+       /* Loop across all segments */
+
+       segmentp=FirstSegment(segments,node1p,1); /* node1 cannot be a fake node (must be a super-node) */
+
+       while(segmentp)
+         {
+          Node *node2p;
+          index_t node2,seg2;
+          score_t segment_pref,segment_score,cumulative_score;
+
+          /* must be a super segment */
+          if(!IsSuperSegment(segmentp))
+             goto endloop;
+
+          /* must obey one-way restrictions (unless profile allows) */
+          if(profile->oneway && IsOnewayTo(segmentp,node1))
+             goto endloop;
+
+          seg2=IndexSegment(segments,segmentp); /* segment cannot be a fake segment (must be a super-segment) */
+
+          /* must perform U-turn in special cases */
+          if(force_uturn && node1==results->start_node)
+            {
+             if(seg2!=result1->segment)
+                goto endloop;
+            }
+          else
+             /* must not perform U-turn */
+             if(seg1==seg2) /* No fake segments, applies to all profiles */
+                goto endloop;
+
+          /* must obey turn relations */
+          if(turnrelation!=NO_RELATION && !IsTurnAllowed(relations,turnrelation,node1,seg1,seg2,profile->allow))
+             goto endloop;
+
+          segment_pref=profile->way_pref[segmentp->way];
+
+          /* profile must allow this highway (transport, restrictions, highway type and properties) */
+          if(segment_pref==0)
+             goto endloop;
+
+          node2=OtherNode(segmentp,node1);
+
+          node2p=LookupNode(nodes,node2,2); /* node2 cannot be a fake node (must be a super-node) */
+
+          /* mode of transport must be allowed through node2 unless it is the final node */
+          if(node2!=end->finish_node && !(node2p->allow&profile->allow))
+             goto endloop;
+
+          if(query->customisation)
+             segment_score=CustomisedScore(query->customisation,seg2);
+          else if(query->quickest==0)
+             segment_score=(score_t)DISTANCE(segmentp->distance)/segment_pref;
+          else
+             segment_score=(score_t)Duration(segmentp,profile)/segment_pref;
+
+          cumulative_score=result1->score+segment_score;
+
+          /* score must be better than current best score */
+          if(cumulative_score>=finish_score)
+             goto endloop;
+
+          result2=FindResult(results,node2,seg2);
+
+          if(!result2) /* New end node/segment pair */
+            {
+             result2=InsertResult(results,node2,seg2);
+             result2->prev=result1;
+             result2->score=cumulative_score;
+            }
+          else if(cumulative_score<result2->score) /* New end node/segment pair is better */
+            {
+             result2->prev=result1;
+             result2->score=cumulative_score;
+            }
+          else
+             goto endloop;
+
+          /* check if the route joins one from the finish (or the end part of the path) */
+          if((result3=FindResult(results2,node2,seg2)) && (result2->score+result3->score)<finish_score)
+            {
+             finish_score=result2->score+result3->score;
+             finish_result=result2;
+             finish_result2=result3;
+            }
+
+          /* the start points of the end part of the path are not continued (unless a better route from them was found) */
+          if(!result3 || result3->next)
+            {
+             double lat,lon;
+             score_t finish_direct,start_direct;
+
+             GetLatLong(nodes,node2,&lat,&lon); /* node2 cannot be a fake node (must be a super-node) */
+
+             finish_direct=LowerBoundScore(query,profile,node2,lat,lon,finish_lat,finish_lon,finish_landmarks);
+             start_direct =LowerBoundScore(query,profile,node2,lat,lon,start_lat,start_lon,start_landmarks);
+
+             result2->sortby=result2->score+(finish_direct-start_direct)/2;
+
+             if((result2->score+finish_direct)<finish_score)
+                InsertInQueue(queue,result2);
+            }
+
+#if !DEBUG
+          if(!option_quiet && !((results->number+results2->number)%1000))
+             printf_middle("Routing: Super-Nodes checked = %d",results->number+results2->number);
+#endif
+
+         endloop:
+
+          segmentp=NextSegment(segments,segmentp,node1); /* node1 cannot be a fake node (must be a super-node) */
+         }
+      }
+    else
+      {
+       Node *node1p,*node0p;
+       Segment *segment1p,*segmentp;
+       index_t node1,seg1,node0;
+       score_t segment_pref,segment_score,cumulative_score;
+       score_t finish_direct,start_direct;
+       double lat,lon;
+
+       result1=PopFromQueue(queue2);
+
+       /* stop when no route through the unchecked nodes can be better than the current best route */
+       if(!result1 || (result1->sortby+forward_sortby)>=finish_score)
+          break;
+
+       backward_sortby=result1->sortby;
+
+       query->nsettled++;
+
+       node1=result1->node;
+       seg1=result1->segment;
+
+       segment1p=LookupSegment(segments,seg1,2); /* segment cannot be a fake segment (must be a super-segment) */
+
+       /* must be a super segment */
+       if(!IsSuperSegment(segment1p))
+          continue;
+
+       node0=OtherNode(segment1p,node1);
+
+       /* must obey one-way restrictions (unless profile allows) */
+       if(profile->oneway && IsOnewayTo(segment1p,node0))
+          continue;
+
+       segment_pref=profile->way_pref[segment1p->way];
+
+       /* profile must allow this highway (transport, restrictions, highway type and properties) */
+       if(segment_pref==0)
+          continue;
+
+       node1p=LookupNode(nodes,node1,1); /* node1 cannot be a fake node (must be a super-node) */
+
+       /* mode of transport must be allowed through node1 unless it is the final node */
+       if(node1!=end->finish_node && !(node1p->allow&profile->allow))
+          continue;
+
+       /* the segment is scored in the direction it is travelled (node0 to node1) so that any
+          difference between going uphill and downhill is the same as in the forward search */
+
+       if(query->customisation)
+          segment_score=CustomisedScore(query->customisation,seg1);
+       else if(query->quickest==0)
+          segment_score=(score_t)DISTANCE(segment1p->distance)/segment_pref;
+       else
+          segment_score=(score_t)Duration(segment1p,profile)/segment_pref;
+
+       cumulative_score=result1->score+segment_score;
+
+       /* score must be better than current best score */
+       if(cumulative_score>=finish_score)
+          continue;
+
+       node0p=LookupNode(nodes,node0,2); /* node0 cannot be a fake node (must be a super-node) */
+
+       /* check if the route joins the start of the route (obeying the same rules as the forward search) */
+       if(begin->number==1 && node0==results->start_node)
+         {
+          index_t turnrelation=NO_RELATION;
+
+          if(profile->turns && IsTurnRestrictedNode(node0p))
+             turnrelation=FindFirstTurnRelation2(relations,node0,results->prev_segment);
+
+          /* must perform U-turn in special cases or must not perform U-turn and must obey turn relations */
+          if((force_uturn?(seg1==results->prev_segment):(seg1!=results->prev_segment)) &&
+             (turnrelation==NO_RELATION || IsTurnAllowed(relations,turnrelation,node0,results->prev_segment,seg1,profile->allow)))
+            {
+             result2=FindResult(results2,node0,results->prev_segment);
+
+             if(!result2)
+                result2=InsertResult(results2,node0,results->prev_segment);
+
+             result2->next=result1; /* working backwards */
+             result2->score=cumulative_score;
+
+             finish_score=cumulative_score;
+             finish_result=FindResult(results,results->start_node,results->prev_segment);
+             finish_result2=result2;
+            }
+         }
+
+       GetLatLong(nodes,node0,&lat,&lon); /* node0 cannot be a fake node (must be a super-node) */
+
+       finish_direct=LowerBoundScore(query,profile,node0,lat,lon,finish_lat,finish_lon,finish_landmarks);
+       start_direct =LowerBoundScore(query,profile,node0,lat,lon,start_lat,start_lon,start_landmarks);
+
+       /* Loop across all segments that arrive at node0 */
+
+       segmentp=FirstSegment(segments,node0p,1); /* node0 cannot be a fake node (must be a super-node) */
+
+       while(segmentp)
+         {
+          index_t seg0;
+          index_t turnrelation=NO_RELATION;
+
+          /* must be a super segment */
+          if(!IsSuperSegment(segmentp))
+             goto endloop2;
+
+          /* must obey one-way restrictions (unless profile allows) */
+          if(profile->oneway && IsOnewayFrom(segmentp,node0)) /* working backwards => disallow oneway *from* node0 */
+             goto endloop2;
+
+          seg0=IndexSegment(segments,segmentp); /* segment cannot be a fake segment (must be a super-segment) */
+
+          /* the start node and previous segment are only the start of the route (see above) */
+          if(node0==results->start_node && seg0==results->prev_segment)
+             goto endloop2;
+
+          /* must not perform U-turn */
+          if(seg0==seg1) /* No fake segments, applies to all profiles */
+             goto endloop2;
+
+          /* must obey turn relations */
+          if(profile->turns && IsTurnRestrictedNode(node0p))
+             turnrelation=FindFirstTurnRelation2(relations,node0,seg0); /* working backwards => one lookup per segment */
+
+          if(turnrelation!=NO_RELATION && !IsTurnAllowed(relations,turnrelation,node0,seg0,seg1,profile->allow))
+             goto endloop2;
+
+          result2=FindResult(results2,node0,seg0);
+
+          if(!result2) /* New end node/segment pair */
+            {
+             result2=InsertResult(results2,node0,seg0);
+             result2->next=result1; /* working backwards */
+             result2->score=cumulative_score;
+            }
+          else if(cumulative_score<result2->score) /* New end node/segment pair is better */
+            {
+             result2->next=result1; /* working backwards */
+             result2->score=cumulative_score;
+            }
+          else
+             goto endloop2;
+
+          /* check if the route joins one from the start (or the beginning part of the path) */
+          if((result3=FindResult(results,node0,seg0)) && (result3->score+result2->score)<finish_score)
+            {
+             finish_score=result3->score+result2->score;
+             finish_result=result3;
+             finish_result2=result2;
+            }
+
+          result2->sortby=result2->score+(start_direct-finish_direct)/2;
+
+          if((result2->score+start_direct)<finish_score)
+             InsertInQueue(queue2,result2);
+
+#if !DEBUG
+          if(!option_quiet && !((results->number+results2->number)%1000))
+             printf_middle("Routing: Super-Nodes checked = %d",results->number+results2->number);
+#endif
+
+         endloop2:
+
+          segmentp=NextSegment(segments,segmentp,node0); /* node0 cannot be a fake node (must be a super-node) */
+         }
+      }
+   }
+
+#if !DEBUG
+ if(!option_quiet)
+    printf_last("Routing: Super-Nodes checked = %d",results->number+results2->number);
+#endif
+
+ FreeQueueList(queue);
+ FreeQueueList(queue2);
+
+ /* Check it worked */
+
+ if(!finish_result)
+   {
+#if DEBUG
+    printf("    Failed\n");
+#endif
+
+    FreeResultsList(results);
+    FreeResultsList(results2);
+    return(NULL);
+   }
+
+ /* Join the route from the finish onto the route from the start */
+
+ finish_result=JoinBidirectionalRoute(results,finish_result,finish_result2,finish_score);
+
+ FreeResultsList(results2);
+
+ /* Finish off the end part of the route */
+
+ if(finish_result->node!=end->finish_node)
+   {
+    result3=InsertResult(results,end->finish_node,NO_SEGMENT);
+
+    result3->prev=finish_result;
+    result3->score=finish_score;
+
+    finish_result=result3;
+   }
+
+ FixForwardRoute(results,finish_result);
+
+#if DEBUG
+ Result *r=FindResult(results,results->start_node,results->prev_segment);
+
+ while(r)
+   {
+    printf("    node=%"Pindex_t" segment=%"Pindex_t" score=%f\n",r->node,r->segment,r->score);
+
+    r=r->next;
+   }
+#endif
+
+ return(results);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Join the route found working backwards from the finish onto the end of the route found working
+  forwards from the start.
+
+  Result *JoinBidirectionalRoute Returns the result at the end of the joined route.
+
+  Results *results The results working forwards (the rest of the route is added to them).
+
+  Result *result1 The result working forwards where the two routes meet.
+
+  Result *result2 The result working backwards where the two routes meet.
+
+  score_t finish_score The score of the joined route.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static Result *JoinBidirectionalRoute(Results *results,Result *result1,Result *result2,score_t finish_score)
+{
+ for(result2=result2->next;result2;result2=result2->next)
+   {
+    Result *result3=FindResult(results,result2->node,result2->segment);
+
+    if(!result3)
+       result3=InsertResult(results,result2->node,result2->segment);
+
+    result3->prev=result1;
+    result3->score=finish_score-result2->score;
+
+    result1=result3;
+   }
+
+ return(result1);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Calculate the lowest possible score for a route between two points (the straight line distance
+  or the landmark distance limit, as a distance or as the duration at the maximum speed, with the
+  maximum preference).
+
+  score_t LowerBoundScore Returns the score.
+
+  Query *query The query that is being calculated.
+
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
+
+  index_t node The node at the first point (only used with the landmark limits).
+
+  double lat1 The latitude of the first point.
+
+  double lon1 The longitude of the first point.
+
+  double lat2 The latitude of the second point.
+
+  double lon2 The longitude of the second point.
+
+  double *limits The landmark limits for the second point from LandmarkLimits() (or NULL for none).
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static score_t LowerBoundScore(Query *query,Profile *profile,index_t node,double lat1,double lon1,double lat2,double lon2,double *limits)
+{
+ distance_t direct=Distance(lat1,lon1,lat2,lon2);
+
+ if(limits)
+    direct=LandmarkDistance(query,node,direct,limits);
+
+ if(query->quickest==0)
+    return((score_t)direct/profile->max_pref);
+ else
+    return((score_t)distance_speed_to_duration(direct,profile->max_speed)/profile->max_pref);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Calculate the landmark limits for the routes between the super-nodes and one end of a route
+  using the partial routes at that end. The distance from a super-node to the end of the route
+  is at least the (landmark distance + score) of the nearest partial route minus the landmark
+  distance of the super-node and is at least the landmark distance of the super-node minus the
+  (landmark distance - score) of the furthest partial route. The scores are converted into
+  distances using the maximum speed and preference.
+
+  int LandmarkLimits Returns 1 if the limits can be used or 0 if not.
+
+  Query *query The query that is being calculated (containing the landmarks).
+
+  Nodes *nodes The set of nodes to use.
+
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
+
+  Results *results The partial routes at one end of the route (from FindStartRoutes() or FindFinishRoutes()).
+
+  double *limits Returns the two limits for each landmark.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static int LandmarkLimits(Query *query,Nodes *nodes,Profile *profile,Results *results,double *limits)
+{
+ Landmarks *landmarks=query->landmarks;
+ Result *result;
+ int l,found=0;
+
+ if(!landmarks || landmarks->file.nlandmarks==0)
+    return(0);
+
+ for(l=0;l<landmarks->file.nlandmarks;l++)
+   {
+    limits[2*l  ]=INF_DISTANCE;
+    limits[2*l+1]=-(double)INF_DISTANCE;
+   }
+
+ result=FirstResult(results);
+
+ while(result)
+   {
+    if(!IsFakeNode(result->node) && IsSuperNode(LookupNode(nodes,result->node,5)))
+      {
+       distance_t *distances=FindLandmarkDistances(landmarks,result->node);
+       double score;
+
+       if(query->quickest==0)
+          score=result->score*profile->max_pref;
+       else
+          score=result->score*profile->max_pref*profile->max_speed/36.0;
+
+       if(distances)
+          for(l=0;l<landmarks->file.nlandmarks;l++)
+             if(distances[l]!=NO_LANDMARK_DISTANCE)
+               {
+                if((distances[l]+score)<limits[2*l])
+                   limits[2*l]=distances[l]+score;
+                if((distances[l]-score)>limits[2*l+1])
+                   limits[2*l+1]=distances[l]-score;
+
+                found=1;
+               }
+      }
+
+    result=NextResult(results,result);
+   }
+
+ /* Landmarks that do not reach any of the partial routes give no limit */
+
+ for(l=0;l<landmarks->file.nlandmarks;l++)
+    if(limits[2*l]==INF_DISTANCE)
+      {
+       limits[2*l  ]=0;
+       limits[2*l+1]=INF_DISTANCE;
+      }
+
+ return(found);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Calculate the lowest possible distance from a super-node to one end of the route using the
+  landmark limits.
+
+  distance_t LandmarkDistance Returns the largest of the limits and the straight line distance.
+
+  Query *query The query that is being calculated (containing the landmarks).
+
+  index_t node The node to calculate the distance from.
+
+  distance_t direct The straight line distance.
+
+  double *limits The landmark limits from LandmarkLimits().
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static distance_t LandmarkDistance(Query *query,index_t node,distance_t direct,double *limits)
+{
+ Landmarks *landmarks=query->landmarks;
+ distance_t *distances;
+ double limit=direct;
+ int l;
+
+ if(IsFakeNode(node) || !(distances=FindLandmarkDistances(landmarks,node)))
+    return(direct);
+
+ for(l=0;l<landmarks->file.nlandmarks;l++)
+    if(distances[l]!=NO_LANDMARK_DISTANCE)
+      {
+       if((limits[2*l]-distances[l])>limit)
+          limit=limits[2*l]-distances[l];
+       if((distances[l]-limits[2*l+1])>limit)
+          limit=distances[l]-limits[2*l+1];
+      }
+
+ return((distance_t)limit);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Find the optimum route between two nodes where the start and end are a set of pre-routed super-nodes
+  by searching up the contraction hierarchy from both ends.
+
+  Results *FindMiddleRouteHierarchy Returns a set of results or NULL if a normal search is needed.
+
+  Query *query The query that is being calculated.
+
+  Nodes *nodes The set of nodes to use.
+
+  Segments *segments The set of segments to use.
+
+  Ways *ways The set of ways to use.
+
+  Relations *relations The set of relations to use.
+
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
+
+  Results *begin The initial portion of the route.
+
+  Results *end The final portion of the route.
+
+  The hierarchy does not know about U-turns or turn restrictions and only keeps the best score at
+  each end of the route so the route that it finds is checked; if it is not allowed or might not
+  be the best one then NULL is returned (this also happens if there is no route).
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static Results *FindMiddleRouteHierarchy(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,Results *begin,Results *end)
+{
+ Hierarchy *hierarchy=query->hierarchy;
+ Results *forward,*backward,*results=NULL;
+ Queue   *queue,*queue2;
+ Result  *result1,*result2,*result3;
+ score_t  finish_score=INF_SCORE;
+ index_t  finish_node=NO_NODE,prev_segment;
+ index_t *chnodes=NULL,*path_segments=NULL;
+ score_t *path_scores=NULL;
+ int      forward_done=0,backward_done=0,nforward=0,nchnodes=0,npath=0,i;
+
+#if DEBUG
+ printf("  FindMiddleRouteHierarchy(...,[begin has %d nodes],[end has %d nodes])\n",begin->number,end->number);
+#endif
+
+ prev_segment=begin->prev_segment;
+
+ if(begin->number==1 && begin->prev_segment!=NO_SEGMENT)
+   {
+    /* Barrier at start waypoint - must perform U-turn (not handled here) */
+
+    if(!(LookupNode(nodes,begin->start_node,1)->allow&profile->allow))
+       return(NULL);
+
+    prev_segment=FindSuperSegment(query,nodes,segments,ways,relations,begin->start_node,begin->prev_segment);
+   }
+
+ /* Insert the super-nodes at the two ends of the route into the queues */
+
+ forward=NewResultsList(query->pool,64);
+ backward=NewResultsList(query->pool,64);
+
+ queue=NewQueueList(query->pool);
+ queue2=NewQueueList(query->pool);
+
+ result3=FirstResult(begin);
+
+ while(result3)
+   {
+    if(begin->number==1 ||
+       ((begin->start_node!=result3->node || begin->prev_segment!=result3->segment) &&
+        !IsFakeNode(result3->node) && IsSuperNode(LookupNode(nodes,result3->node,5))))
+       InsertHierarchyResult(forward,queue,FindHierarchyNode(hierarchy,result3->node),begin->number==1?0:result3->score);
+
+    result3=NextResult(begin,result3);
+   }
+
+ result3=FirstResult(end);
+
+ while(result3)
+   {
+    if(!IsFakeNode(result3->node) && IsSuperNode(LookupNode(nodes,result3->node,5)))
+       InsertHierarchyResult(backward,queue2,FindHierarchyNode(hierarchy,result3->node),result3->score);
+
+    result3=NextResult(end,result3);
+   }
+
+ /* Search up the hierarchy from both ends until neither can improve on the best route */
+
+ while(!forward_done || !backward_done)
+   {
+    if(!forward_done)
+       forward_done=HierarchySearchStep(query,hierarchy,forward,queue,backward,0,&finish_score,&finish_node);
+
+    if(!backward_done)
+       backward_done=HierarchySearchStep(query,hierarchy,backward,queue2,forward,1,&finish_score,&finish_node);
+   }
+
+ FreeQueueList(queue);
+ FreeQueueList(queue2);
+
+#if !DEBUG
+ if(!option_quiet)
+    printf_last("Routing: Hierarchy-Nodes checked = %d",forward->number+backward->number);
+#endif
+
+ if(finish_node==NO_NODE)
+    goto finished;
+
+ /* Find the nodes in the hierarchy from the start to the finish */
+
+ for(result1=FindResult(forward,finish_node,NO_SEGMENT);result1;result1=result1->prev)
+    nforward++;
+
+ for(result2=FindResult(backward,finish_node,NO_SEGMENT)->prev;result2;result2=result2->prev)
+    nchnodes++;
+
+ nchnodes+=nforward;
+
+ chnodes=(index_t*)malloc(nchnodes*sizeof(index_t));
+
+ logassert(chnodes,"Failed to allocate memory"); /* Check malloc() worked */
+
+ for(i=nforward,result1=FindResult(forward,finish_node,NO_SEGMENT);result1;result1=result1->prev)
+    chnodes[--i]=result1->node;
+
+ for(i=nforward,result2=FindResult(backward,finish_node,NO_SEGMENT)->prev;result2;result2=result2->prev)
+    chnodes[i++]=result2->node;
+
+ /* Replace the shortcuts with the super-segments */
+
+ for(i=1;i<nchnodes;i++)
+    UnpackHierarchyEdge(hierarchy,chnodes[i-1],chnodes[i],&path_segments,&path_scores,&npath);
+
+ /* Check the route and create the results */
+
+ results=MakeMiddleRoute(query,nodes,segments,ways,relations,profile,begin,end,prev_segment,
+                         LookupHierarchyNode(hierarchy,chnodes[0]),path_segments,path_scores,npath,finish_score);
+
+ finished:
+
+#if DEBUG
+ if(!results)
+    printf("    Failed (using a normal search)\n");
+#endif
+
+ FreeResultsList(forward);
+ FreeResultsList(backward);
+
+ if(chnodes)
+    free(chnodes);
+
+ if(path_segments)
+   {
+    free(path_segments);
+    free(path_scores);
+   }
+
+ return(results);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Check a route across the super-segments that was found without knowing about U-turns, turn
+  restrictions or the different scores at each end of the route and create the results for it in
+  the same way as FindMiddleRoute().
+
+  Results *MakeMiddleRoute Returns a set of results or NULL if the route is not allowed or might not be the best one.
+
+  Query *query The query that is being calculated.
+
+  Nodes *nodes The set of nodes to use.
+
+  Segments *segments The set of segments to use.
+
+  Ways *ways The set of ways to use.
+
+  Relations *relations The set of relations to use.
+
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
+
+  Results *begin The initial portion of the route.
+
+  Results *end The final portion of the route.
+
+  index_t prev_segment The previous segment before the start node.
+
+  index_t start_node The super-node where the route across the super-segments starts.
+
+  index_t *path_segments The super-segments from the start node.
+
+  score_t *path_scores The scores of the super-segments.
+
+  int npath The number of super-segments.
+
+  score_t finish_score The best possible score for the whole route.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static Results *MakeMiddleRoute(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,Results *begin,Results *end,
+                                index_t prev_segment,index_t start_node,index_t *path_segments,score_t *path_scores,int npath,score_t finish_score)
+{
+ Results *results;
+ Result  *result1,*result2,*result3,*chosen=NULL;
+ score_t  total_score;
+ index_t  start_segment=NO_SEGMENT,node;
+ int      i;
+
+ /* Choose the best start that does not need a U-turn or a disallowed turn */
+
+ node=start_node;
+
+ if(begin->number==1)
+   {
+    if(npath>0 && !SuperTurnAllowed(query,nodes,relations,profile,node,prev_segment,path_segments[0]))
+       return(NULL);
+
+    start_segment=prev_segment;
+    total_score=0;
+   }
+ else
+   {
+    total_score=INF_SCORE;
+
+    result3=FirstResult(begin);
+
+    while(result3)
+      {
+       if(result3->node==node && result3->score<total_score &&
+          (begin->start_node!=result3->node || begin->prev_segment!=result3->segment))
+         {
+          index_t superseg=FindSuperSegment(query,nodes,segments,ways,relations,result3->node,result3->segment);
+
+          if(npath==0 || SuperTurnAllowed(query,nodes,relations,profile,node,superseg,path_segments[0]))
+            {
+             chosen=result3;
+             start_segment=superseg;
+             total_score=result3->score;
+            }
+         }
+
+       result3=NextResult(begin,result3);
+      }
+
+    if(!chosen)
+       return(NULL);
+   }
+
+ /* Check the turns along the route and the score to the finish */
+
+ for(i=0;i<npath;i++)
+   {
+    if(i>0 && !SuperTurnAllowed(query,nodes,relations,profile,node,path_segments[i-1],path_segments[i]))
+       return(NULL);
+
+    node=OtherNode(LookupSegment(segments,path_segments[i],1),node);
+
+    total_score+=path_scores[i];
+   }
+
+ if(!(result3=FindResult(end,node,npath?path_segments[npath-1]:start_segment)))
+    return(NULL);
+
+ total_score+=result3->score;
+
+ if(total_score>finish_score*1.00001)
+    return(NULL);
+
+ /* Create the results in the same way as FindMiddleRoute() */
+
+ results=NewResultsList(query->pool,64);
+
+ results->start_node=begin->start_node;
+ results->prev_segment=prev_segment;
+
+ result1=InsertResult(results,results->start_node,results->prev_segment);
+
+ node=start_node;
+
+ if(chosen)
+   {
+    Result *result5=result1;
+
+    if(start_segment!=chosen->segment)
+      {
+       result5=InsertResult(results,node,chosen->segment);
+
+       result5->prev=result1;
+      }
+
+    result2=InsertResult(results,node,start_segment);
+    result2->prev=result5;
+
+    result2->score=chosen->score;
+
+    result1=result2;
+   }
+
+ for(i=0;i<npath;i++)
+   {
+    node=OtherNode(LookupSegment(segments,path_segments[i],1),node);
+
+    if(FindResult(results,node,path_segments[i]))
+      {
+       FreeResultsList(results);
+       return(NULL);
+      }
+
+    result2=InsertResult(results,node,path_segments[i]);
+
+    result2->prev=result1;
+    result2->score=result1->score+path_scores[i];
+
+    result1=result2;
+   }
+
+ if(result1->node!=end->finish_node)
+   {
+    result2=InsertResult(results,end->finish_node,NO_SEGMENT);
+
+    result2->prev=result1;
+    result2->score=total_score;
+
+    result1=result2;
+   }
+
+ FixForwardRoute(results,result1);
+
+#if DEBUG
+ Result *r=FindResult(results,results->start_node,results->prev_segment);
+
+ while(r)
+   {
+    printf("    node=%"Pindex_t" segment=%"Pindex_t" score=%f\n",r->node,r->segment,r->score);
+
+    r=r->next;
+   }
+#endif
+
+
+ return(results);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Insert a node into the results and the queue for a search of the contraction hierarchy if the
+  score is better than the one that it already has.
+
+  Results *results The set of results to use.
+
+  Queue *queue The queue to use.
+
+  index_t node The position of the super-node in the hierarchy (or NO_NODE if it is not in it).
+
+  score_t score The score for the node.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static void InsertHierarchyResult(Results *results,Queue *queue,index_t node,score_t score)
+{
+ Result *result;
+
+ if(node==NO_NODE)
+    return;
+
+ result=FindResult(results,node,NO_SEGMENT);
+
+ if(!result)
+    result=InsertResult(results,node,NO_SEGMENT);
+ else if(score>=result->score)
+    return;
+
+ result->score=score;
+ result->sortby=score;
+
+ InsertInQueue(queue,result);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Take the next node from the queue for one direction of the search of the contraction hierarchy
+  and follow the edges up the hierarchy from it.
+
+  int HierarchySearchStep Returns 1 if this direction of the search has finished.
+
+  Query *query The query that is being calculated.
+
+  Hierarchy *hierarchy The contraction hierarchy to use.
+
+  Results *results The set of results for this direction.
+
+  Queue *queue The queue for this direction.
+
+  Results *other The set of results for the other direction.
+
+  int down Set for the search backwards from the finish (using the edges coming down to each node).
+
+  score_t *finish_score The score for the best route so far (updated).
+
+  index_t *finish_node The node where the best route so far meets (updated).
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static int HierarchySearchStep(Query *query,Hierarchy *hierarchy,Results *results,Queue *queue,Results *other,int down,score_t *finish_score,index_t *finish_node)
+{
+ Result *result1,*result2;
+ HierarchyEdge *edges;
+ index_t j,nedges;
+
+ result1=PopFromQueue(queue);
+
+ /* score must be better than current best score */
+ if(!result1 || result1->score>=*finish_score)
+    return(1);
+
+ query->nsettled++;
+
+ /* check if the other direction has reached this node */
+
+ if((result2=FindResult(other,result1->node,NO_SEGMENT)) && (result1->score+result2->score)<*finish_score)
+   {
+    *finish_score=result1->score+result2->score;
+    *finish_node=result1->node;
+   }
+
+ /* Loop across the edges going up the hierarchy */
+
+ edges=LookupHierarchyEdges(hierarchy,result1->node,down,&nedges);
+
+ for(j=0;j<nedges;j++)
+   {
+    score_t cumulative_score=result1->score+edges[j].score;
+
+    /* score must be better than current best score */
+    if(cumulative_score>=*finish_score)
+       continue;
+
+    result2=FindResult(results,edges[j].node,NO_SEGMENT);
+
+    if(!result2) /* New node */
+       result2=InsertResult(results,edges[j].node,NO_SEGMENT);
+    else if(cumulative_score>=result2->score) /* Not better */
+       continue;
+
+    result2->prev=result1;
+    result2->score=cumulative_score;
+    result2->sortby=cumulative_score;
+
+    InsertInQueue(queue,result2);
+   }
+
+ return(0);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Replace an edge in the contraction hierarchy with the super-segments that it is made from.
+
+  Hierarchy *hierarchy The contraction hierarchy to use.
+
+  index_t node1 The position of the super-node at the start of the edge.
+
+  index_t node2 The position of the super-node at the end of the edge.
+
+  index_t **segments The super-segments (reallocated as more are added).
+
+  score_t **scores The scores of the super-segments (reallocated as more are added).
+
+  int *number The number of super-segments (updated).
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static void UnpackHierarchyEdge(Hierarchy *hierarchy,index_t node1,index_t node2,index_t **segments,score_t **scores,int *number)
+{
+ HierarchyEdge *edges,edge;
+ index_t j,nedges;
+
+ /* The edge is going up from node1 or coming down to node2 */
+
+ edges=LookupHierarchyEdges(hierarchy,node1,0,&nedges);
+
+ for(j=0;j<nedges;j++)
+    if(edges[j].node==node2)
+       break;
+
+ if(j==nedges)
+   {
+    edges=LookupHierarchyEdges(hierarchy,node2,1,&nedges);
+
+    for(j=0;j<nedges;j++)
+       if(edges[j].node==node1)
+          break;
+   }
+
+ logassert(j<nedges,"Missing edge in the contraction hierarchy (report a bug)");
+
+ edge=edges[j];
+
+ if(edge.segment==NO_SEGMENT)
+   {
+    UnpackHierarchyEdge(hierarchy,node1,edge.via,segments,scores,number);
+    UnpackHierarchyEdge(hierarchy,edge.via,node2,segments,scores,number);
+   }
+ else
+   {
+    if(!(*number%64))
+      {
+       *segments=(index_t*)realloc(*segments,(*number+64)*sizeof(index_t));
+       *scores  =(score_t*)realloc(*scores  ,(*number+64)*sizeof(score_t));
+      }
+
+    (*segments)[*number]=edge.segment;
+    (*scores  )[*number]=edge.score;
+
+    (*number)++;
+   }
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Find the optimum route between two nodes where the start and end are a set of pre-routed super-nodes
+  by searching the partition, all of the super-segments are followed inside the cells that contain
+  the super-nodes at the ends of the route and only the scores between the boundary super-nodes
+  are used inside the other cells.
+
+  Results *FindMiddleRoutePartition Returns a set of results or NULL if a normal search is needed.
+
+  Query *query The query that is being calculated.
+
+  Nodes *nodes The set of nodes to use.
+
+  Segments *segments The set of segments to use.
+
+  Ways *ways The set of ways to use.
+
+  Relations *relations The set of relations to use.
+
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
+
+  Results *begin The initial portion of the route.
+
+  Results *end The final portion of the route.
+
+  The scores between the boundary super-nodes do not know about U-turns or turn restrictions so
+  the route that is found is checked in the same way as the one from the contraction hierarchy.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static Results *FindMiddleRoutePartition(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,Results *begin,Results *end)
+{
+ Partition *partition=query->partition;
+ Customisation *customisation=query->customisation;
+ Results *search,*finishes,*results=NULL;
+ Queue   *queue;
+ Result  *result1,*result2,*result3,*finish_result=NULL;
+ score_t  finish_score=INF_SCORE;
+ index_t  prev_segment,*path_segments=NULL,*positions=NULL;
+ score_t *path_scores=NULL;
+ double   finish_lat,finish_lon;
+ char    *marked;
+ int      npath=0,npositions=0,i;
+
+#if DEBUG
+ printf("  FindMiddleRoutePartition(...,[begin has %d nodes],[end has %d nodes])\n",begin->number,end->number);
+#endif
+
+ prev_segment=begin->prev_segment;
+
+ if(begin->number==1 && begin->prev_segment!=NO_SEGMENT)
+   {
+    /* Barrier at start waypoint - must perform U-turn (not handled here) */
+
+    if(!(LookupNode(nodes,begin->start_node,1)->allow&profile->allow))
+       return(NULL);
+
+    prev_segment=FindSuperSegment(query,nodes,segments,ways,relations,begin->start_node,begin->prev_segment);
+   }
+
+ if(IsFakeNode(end->finish_node))
+    GetFakeLatLong(query,end->finish_node,&finish_lat,&finish_lon);
+ else
+    GetLatLong(nodes,end->finish_node,&finish_lat,&finish_lon);
+
+ marked=(char*)calloc(partition->file.ncells,sizeof(char));
+
+ search=NewResultsList(query->pool,64);
+ finishes=NewResultsList(query->pool,64);
+
+ queue=NewQueueList(query->pool);
+
+ /* Find the best score from each super-node at the end of the route and mark their cells */
+
+ result3=FirstResult(end);
+
+ while(result3)
+   {
+    index_t index;
+
+    if(!IsFakeNode(result3->node) && IsSuperNode(LookupNode(nodes,result3->node,5)) &&
+       (index=FindPartitionNode(partition,result3->node))!=NO_NODE)
+      {
+       marked[LookupPartitionCell(partition,index)]=1;
+
+       result2=FindResult(finishes,index,NO_SEGMENT);
+
+       if(!result2)
+         {
+          result2=InsertResult(finishes,index,NO_SEGMENT);
+          result2->score=result3->score;
+         }
+       else if(result3->score<result2->score)
+          result2->score=result3->score;
+      }
+
+    result3=NextResult(end,result3);
+   }
+
+ /* Insert the super-nodes at the start of the route into the queue and mark their cells */
+
+ result3=FirstResult(begin);
+
+ while(result3)
+   {
+    index_t index;
+
+    if((begin->number==1 ||
+        ((begin->start_node!=result3->node || begin->prev_segment!=result3->segment) &&
+         !IsFakeNode(result3->node) && IsSuperNode(LookupNode(nodes,result3->node,5)))) &&
+       (index=FindPartitionNode(partition,result3->node))!=NO_NODE)
+      {
+       marked[LookupPartitionCell(partition,index)]=1;
+
+       InsertPartitionResult(query,nodes,profile,search,queue,NULL,index,begin->number==1?0:result3->score,finish_score,finish_lat,finish_lon);
+      }
+
+    result3=NextResult(begin,result3);
+   }
+
+ /* Loop across all nodes in the queue */
+
+ while((result1=PopFromQueue(queue)))
+   {
+    index_t index1=result1->node,node1,cell1;
+    Segment *segmentp;
+
+    /* score must be better than current best score */
+    if(result1->sortby>=finish_score)
+       break;
+
+    query->nsettled++;
+
+    /* check if the route can finish from this node */
+
+    if((result2=FindResult(finishes,index1,NO_SEGMENT)) && (result1->score+result2->score)<finish_score)
+      {
+       finish_score=result1->score+result2->score;
+       finish_result=result1;
+      }
+
+    node1=LookupPartitionNode(partition,index1);
+    cell1=LookupPartitionCell(partition,index1);
+
+    /* Follow the scores to the other boundary super-nodes (unless the cell is marked) */
+
+    if(!marked[cell1])
+      {
+       index_t position1=FindBoundaryPosition(partition,cell1,index1);
+       index_t *boundary,nboundary,j;
+
+       boundary=LookupPartitionBoundary(partition,cell1,&nboundary);
+
+       for(j=0;position1!=NO_NODE && j<nboundary;j++)
+          if(j!=position1 && CustomisedClique(customisation,cell1,nboundary,position1,j)!=INF_SCORE)
+             InsertPartitionResult(query,nodes,profile,search,queue,result1,boundary[j],
+                                   result1->score+CustomisedClique(customisation,cell1,nboundary,position1,j),
+                                   finish_score,finish_lat,finish_lon);
+      }
+
+    /* Follow the super-segments (only the ones to other cells unless the cell is marked) */
+
+    segmentp=FirstSegment(segments,LookupNode(nodes,node1,1),1);
+
+    while(segmentp)
+      {
+       index_t node2,index2,seg;
+
+       /* must be a super segment */
+       if(!IsSuperSegment(segmentp))
+          goto endloop;
+
+       /* must obey one-way restrictions (unless profile allows) */
+       if(profile->oneway && IsOnewayTo(segmentp,node1))
+          goto endloop;
+
+       seg=IndexSegment(segments,segmentp);
+
+       /* profile must allow the segments */
+       if(CustomisedScore(customisation,seg)==INF_SCORE)
+          goto endloop;
+
+       node2=OtherNode(segmentp,node1);
+
+       index2=FindPartitionNode(partition,node2);
+
+       if(index2==NO_NODE || (!marked[cell1] && LookupPartitionCell(partition,index2)==cell1))
+          goto endloop;
+
+       /* mode of transport must be allowed through node2 unless it is the final node */
+       if(node2!=end->finish_node && !(LookupNode(nodes,node2,2)->allow&profile->allow))
+          goto endloop;
+
+       InsertPartitionResult(query,nodes,profile,search,queue,result1,index2,result1->score+CustomisedScore(customisation,seg),
+                             finish_score,finish_lat,finish_lon);
+
+      endloop:
+
+       segmentp=NextSegment(segments,segmentp,node1);
+      }
+   }
+
+ FreeQueueList(queue);
+
+#if !DEBUG
+ if(!option_quiet)
+    printf_last("Routing: Partition-Nodes checked = %d",search->number);
+#endif
+
+ if(!finish_result)
+    goto finished;
+
+ /* Find the super-nodes from the start to the finish */
+
+ for(result1=finish_result;result1;result1=result1->prev)
+    npositions++;
+
+ positions=(index_t*)malloc(npositions*sizeof(index_t));
+
+ for(i=npositions,result1=finish_result;result1;result1=result1->prev)
+    positions[--i]=result1->node;
+
+ /* Replace the scores between the boundary super-nodes with the super-segments */
+
+ for(i=1;i<npositions;i++)
+   {
+    index_t cell=LookupPartitionCell(partition,positions[i-1]);
+
+    if(!marked[cell] && LookupPartitionCell(partition,positions[i])==cell)
+       UnpackCustomisedClique(partition,customisation,nodes,segments,profile,positions[i-1],positions[i],&path_segments,&path_scores,&npath);
+    else
+      {
+       if(!(npath%64))
+         {
+          path_segments=(index_t*)realloc(path_segments,(npath+64)*sizeof(index_t));
+          path_scores  =(score_t*)realloc(path_scores  ,(npath+64)*sizeof(score_t));
+         }
+
+       path_segments[npath]=FindCustomisedSegment(partition,customisation,nodes,segments,profile,positions[i-1],positions[i]);
+       path_scores[npath]=CustomisedScore(customisation,path_segments[npath]);
+
+       npath++;
+      }
+   }
+
+ /* Check the route and create the results */
+
+ results=MakeMiddleRoute(query,nodes,segments,ways,relations,profile,begin,end,prev_segment,
+                         LookupPartitionNode(partition,positions[0]),path_segments,path_scores,npath,finish_score);
+
+ finished:
+
+#if DEBUG
+ if(!results)
+    printf("    Failed (using a normal search)\n");
+#endif
+
+ FreeResultsList(search);
+ FreeResultsList(finishes);
+
+ free(marked);
+
+ if(positions)
+    free(positions);
+
+ if(path_segments)
+   {
+    free(path_segments);
+    free(path_scores);
+   }
+
+ return(results);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Insert a super-node into the results and the queue for a search of the partition if the score
+  is better than the one that it already has.
+
+  Query *query The query that is being calculated.
+
+  Nodes *nodes The set of nodes to use.
+
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
+
+  Results *results The set of results to use.
+
+  Queue *queue The queue to use.
+
+  Result *prev The result for the previous super-node (or NULL at the start).
+
+  index_t index The position of the super-node in the partition.
+
+  score_t score The score for the super-node.
+
+  score_t finish_score The score for the best route so far.
+
+  double finish_lat The latitude of the finish point.
+
+  double finish_lon The longitude of the finish point.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static void InsertPartitionResult(Query *query,Nodes *nodes,Profile *profile,Results *results,Queue *queue,Result *prev,index_t index,score_t score,
+                                  score_t finish_score,double finish_lat,double finish_lon)
+{
+ Result *result;
+ double lat,lon;
+
+ /* score must be better than current best score */
+ if(score>=finish_score)
+    return;
+
+ result=FindResult(results,index,NO_SEGMENT);
+
+ if(!result)
+    result=InsertResult(results,index,NO_SEGMENT);
+ else if(score>=result->score)
+    return;
+
+ GetLatLong(nodes,LookupPartitionNode(query->partition,index),&lat,&lon);
+
+ result->prev=prev;
+ result->score=score;
+ result->sortby=score+LowerBoundScore(query,profile,NO_NODE,lat,lon,finish_lat,finish_lon,NULL);
+
+ InsertInQueue(queue,result);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Check if the route can continue from one super-segment to another at a node.
+
+  int SuperTurnAllowed Returns 1 if the turn is allowed.
+
+  Query *query The query that is being calculated.
+
+  Nodes *nodes The set of nodes to use.
+
+  Relations *relations The set of relations to use.
+
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
+
+  index_t node The node where the super-segments join (must be a super-node).
+
+  index_t seg1 The super-segment arriving at the node (or NO_SEGMENT).
+
+  index_t seg2 The super-segment leaving the node.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static int SuperTurnAllowed(Query *query,Nodes *nodes,Relations *relations,Profile *profile,index_t node,index_t seg1,index_t seg2)
+{
+ index_t seg1r,turnrelation;
+
+ if(seg1==NO_SEGMENT)
+    return(1);
+
+ /* must not perform U-turn */
+ if(seg1==seg2)
+    return(0);
+
+ if(IsFakeSegment(seg1))
+    seg1r=IndexRealSegment(query,seg1);
+ else
+    seg1r=seg1;
+
+ /* must obey turn relations */
+ if(!profile->turns || !IsTurnRestrictedNode(LookupNode(nodes,node,1)))
+    return(1);
+
+ turnrelation=FindFirstTurnRelation2(relations,node,seg1r);
+
+ if(turnrelation!=NO_RELATION && !IsTurnAllowed(relations,turnrelation,node,seg1r,seg2,profile->allow))
+    return(0);
+
+ return(1);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Find the optimum routes from one start to several finishes using only super-nodes (one search
+  across the super-nodes that continues until the routes to all of the finishes are known).
+
+  Results *FindMiddleRoutes Returns the set of results, FixMiddleRoute() selects the route to one finish.
+
+  Query *query The query that is being calculated.
+
+  Nodes *nodes The set of nodes to use.
+
+  Segments *segments The set of segments to use.
+
+  Ways *ways The set of ways to use.
+
+  Relations *relations The set of relations to use.
+
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
+
+  Results *begin The initial portion of the routes.
+
+  Results **ends The final portions of the routes (NULL for those that are not wanted).
+
+  int nends The number of final portions of the routes.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+Results *FindMiddleRoutes(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,Results *begin,Results **ends,int nends)
+{
+ Results *results,*targets;
+ Queue   *queue;
+ Result  *result1,*result2,*result3;
+ int     nsettled=0,force_uturn=0;
+ int     i;
+
+#if DEBUG
+ printf("  FindMiddleRoutes(...,[begin has %d nodes],[%d ends])\n",begin->number,nends);
+#endif
+
+#if !DEBUG
+ if(!option_quiet)
+    printf_first("Routing: Super-Nodes checked = 0");
+#endif
+
+ /* Set up the finish conditions - the super-node/super-segment pairs that are part of any final portion */
+
+ targets=NewResultsList(query->pool,256);
+
+ for(i=0;i<nends;i++)
+    if(ends[i])
+      {
+       result3=FirstResult(ends[i]);
+
+       while(result3)
+         {
+          if(!IsFakeNode(result3->node) && IsSuperNode(LookupNode(nodes,result3->node,5)))
+             if(!FindResult(targets,result3->node,result3->segment))
+                InsertResult(targets,result3->node,result3->segment);
+
+          result3=NextResult(ends[i],result3);
+         }
+      }
+
+ /* Create the list of results and insert the first node into the queue */
+
+ results=NewResultsList(query->pool,65536);
+ queue=NewQueueList(query->pool);
+
+ results->start_node=begin->start_node;
+ results->prev_segment=begin->prev_segment;
+
+ if(begin->number==1)
+   {
+    if(begin->prev_segment==NO_SEGMENT)
+       results->prev_segment=NO_SEGMENT;
+    else
+      {
+       index_t superseg=FindSuperSegment(query,nodes,segments,ways,relations,begin->start_node,begin->prev_segment);
+
+       results->prev_segment=superseg;
+      }
+   }
+
+ result1=InsertResult(results,results->start_node,results->prev_segment);
+
+ /* Insert the finish points of the beginning part of the path into the queue,
+    translating the segments into super-segments. */
+
+ result3=FirstResult(begin);
+
+ while(result3)
+   {
+    if((results->start_node!=result3->node || results->prev_segment!=result3->segment) &&
+       !IsFakeNode(result3->node) && IsSuperNode(LookupNode(nodes,result3->node,5)))
+      {
+       Result *result5=result1;
+       index_t superseg=FindSuperSegment(query,nodes,segments,ways,relations,result3->node,result3->segment);
+
+       if(superseg!=result3->segment)
+         {
+          result5=InsertResult(results,result3->node,result3->segment);
+
+          result5->prev=result1;
+         }
+
+       if(!FindResult(results,result3->node,superseg))
+         {
+          result2=InsertResult(results,result3->node,superseg);
+          result2->prev=result5;
+
+          result2->score=result3->score;
+          result2->sortby=result3->score;
+
+          InsertInQueue(queue,result2);
+         }
+      }
+
+    result3=NextResult(begin,result3);
+   }
+
+ if(begin->number==1)
+    InsertInQueue(queue,result1);
+
+ /* Check for barrier at start waypoint - must perform U-turn */
+
+ if(begin->number==1 && results->prev_segment!=NO_SEGMENT)
+   {
+    Node *startp=LookupNode(nodes,result1->node,1);
+
+    if(!(startp->allow&profile->allow))
+       force_uturn=1;
+   }
+
+ /* Loop across all nodes in the queue (no heuristic, the score is final when a result is removed) */
+
+ while(nsettled<targets->number && (result1=PopFromQueue(queue)))
+   {
+    Node *node1p;
+    Segment *segmentp;
+    index_t node1,seg1,seg1r;
+    index_t turnrelation=NO_RELATION;
+
+    node1=result1->node;
+    seg1=result1->segment;
+
+    if((result3=FindResult(targets,node1,seg1)) && !result3->prev)
+      {
+       result3->prev=result1;
+       nsettled++;
+      }
+
+    if(IsFakeSegment(seg1))
+       seg1r=IndexRealSegment(query,seg1);
+    else
+       seg1r=seg1;
+
+    node1p=LookupNode(nodes,node1,1); /* node1 cannot be a fake node (must be a super-node) */
+
+    /* must not pass through a barrier (only reached because it is one of the finish nodes) */
+    if(node1!=results->start_node && !(node1p->allow&profile->allow))
+       continue;
+
+    /* lookup if a turn restriction applies */
+    if(profile->turns && IsTurnRestrictedNode(node1p)) /* node1 cannot be a fake node (must be a super-node) */
+       turnrelation=FindFirstTurnRelation2(relations,node1,seg1r);
+
+    /* Loop across all segments */
+
+    segmentp=FirstSegment(segments,node1p,1); /* node1 cannot be a fake node (must be a super-node) */
+
+    while(segmentp)
+      {
+       Node *node2p;
+       index_t node2,seg2;
+       score_t segment_pref,segment_score,cumulative_score;
+
+       /* must be a super segment */
+       if(!IsSuperSegment(segmentp))
+          goto endloop;
+
+       /* must obey one-way restrictions (unless profile allows) */
+       if(profile->oneway && IsOnewayTo(segmentp,node1))
+          goto endloop;
+
+       seg2=IndexSegment(segments,segmentp); /* segment cannot be a fake segment (must be a super-segment) */
+
+       /* must perform U-turn in special cases */
+       if(force_uturn && node1==results->start_node)
+         {
+          if(seg2!=result1->segment)
+             goto endloop;
+         }
+       else
+          /* must not perform U-turn */
+          if(seg1==seg2) /* No fake segments, applies to all profiles */
+             goto endloop;
+
+       /* must obey turn relations */
+       if(turnrelation!=NO_RELATION && !IsTurnAllowed(relations,turnrelation,node1,seg1r,seg2,profile->allow))
+          goto endloop;
+
+       segment_pref=profile->way_pref[segmentp->way];
+
+       /* profile must allow this highway (transport, restrictions, highway type and properties) */
+       if(segment_pref==0)
+          goto endloop;
+
+       node2=OtherNode(segmentp,node1);
+
+       node2p=LookupNode(nodes,node2,2); /* node2 cannot be a fake node (must be a super-node) */
+
+       /* mode of transport must be allowed through node2 unless it is one of the final nodes */
+       if(!(node2p->allow&profile->allow))
+         {
+          for(i=0;i<nends;i++)
+             if(ends[i] && node2==ends[i]->finish_node)
+                break;
+
+          if(i==nends)
+             goto endloop;
+         }
+
+       if(query->customisation)
+          segment_score=CustomisedScore(query->customisation,seg2);
+       else if(query->quickest==0)
+          segment_score=(score_t)DISTANCE(segmentp->distance)/segment_pref;
+       else
+          segment_score=(score_t)Duration(segmentp,profile)/segment_pref;
+
+       cumulative_score=result1->score+segment_score;
+
+       result2=FindResult(results,node2,seg2);
+
+       if(!result2) /* New end node/segment pair */
+         {
+          result2=InsertResult(results,node2,seg2);
+          result2->prev=result1;
+          result2->score=cumulative_score;
+         }
+       else if(cumulative_score<result2->score) /* New end node/segment pair is better */
+         {
+          result2->prev=result1;
+          result2->score=cumulative_score;
+         }
+       else
+          goto endloop;
+
+       result2->sortby=result2->score;
+
+       InsertInQueue(queue,result2);
+
+#if !DEBUG
+       if(!option_quiet && !(results->number%1000))
+          printf_middle("Routing: Super-Nodes checked = %d",results->number);
+#endif
+
+      endloop:
+
+       segmentp=NextSegment(segments,segmentp,node1); /* node1 cannot be a fake node (must be a super-node) */
+      }
+   }
+
+#if !DEBUG
+ if(!option_quiet)
+    printf_last("Routing: Super-Nodes checked = %d",results->number);
+#endif
+
+ FreeQueueList(queue);
+
+ FreeResultsList(targets);
+
+ return(results);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Select the optimum route to one finish from the results of FindMiddleRoutes() and set it up
+  in the same way as the result of FindMiddleRoute().
+
+  int FixMiddleRoute Returns 1 if there is a route to the finish or 0 if there is not.
+
+  Nodes *nodes The set of nodes to use.
+
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
+
+  Results *middles The set of results from FindMiddleRoutes() (modified to hold the route).
+
+  Results *end The final portion of the route (one of those passed to FindMiddleRoutes()).
+  ++++++++++++++++++++++++++++++++++++++*/
+
+int FixMiddleRoute(Nodes *nodes,Profile *profile,Results *middles,Results *end)
+{
+ Result *finish_result=NULL,*result2,*result3;
+ score_t finish_score=INF_SCORE;
+
+ /* Find the best combination of a super-node route and a final portion */
+
+ result3=FirstResult(end);
+
+ while(result3)
+   {
+    if(!IsFakeNode(result3->node) && (result2=FindResult(middles,result3->node,result3->segment)))
+      {
+       Node *nodep=LookupNode(nodes,result3->node,1);
+
+       /* must not pass through a barrier (unless it is the final node) */
+       if(result3->node==end->finish_node || result3->node==middles->start_node || (nodep->allow&profile->allow))
+          if((result2->score+result3->score)<finish_score)
+            {
+             finish_score=result2->score+result3->score;
+             finish_result=result2;
+            }
+      }
+
+    result3=NextResult(end,result3);
+   }
+
+ if(!finish_result)
+    return(0);
+
+ /* Finish off the end part of the route */
+
+ if(finish_result->node!=end->finish_node)
+   {
+    result3=FindResult(middles,end->finish_node,NO_SEGMENT);
+
+    if(!result3)
+       result3=InsertResult(middles,end->finish_node,NO_SEGMENT);
+
+    result3->prev=finish_result;
+    result3->score=finish_score;
+
+    finish_result=result3;
+   }
+
+ FixForwardRoute(middles,finish_result);
+
+ return(1);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Find the super-segment that represents the route that contains a particular segment.
+
+  index_t FindSuperSegment Returns the index of the super-segment.
+
+  Query *query The query that is being calculated.
+
+  Nodes *nodes The set of nodes to use.
+
+  Segments *segments The set of segments to use.
+
+  Ways *ways The set of ways to use.
+
+  Relations *relations The set of relations to use.
+
+  index_t finish_node The super-node that the route ends at.
+
+  index_t finish_segment The segment that the route ends with.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static index_t FindSuperSegment(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,index_t finish_node,index_t finish_segment)
+{
+ Node *supernodep;
+ Segment *supersegmentp;
+
+ if(IsFakeSegment(finish_segment))
+    finish_segment=IndexRealSegment(query,finish_segment);
+
+ supernodep=LookupNode(nodes,finish_node,5); /* finish_node cannot be a fake node (must be a super-node) */
+ supersegmentp=LookupSegment(segments,finish_segment,2); /* finish_segment cannot be a fake segment. */
+
+ if(IsSuperSegment(supersegmentp))
+    return(finish_segment);
+
+ /* Loop across all segments */
+
+ supersegmentp=FirstSegment(segments,supernodep,3); /* supernode cannot be a fake node (must be a super-node) */
+
+ while(supersegmentp)
+   {
+    if(IsSuperSegment(supersegmentp))
+      {
+       Results *results;
+       Result *result;
+       index_t start_node;
+
+       start_node=OtherNode(supersegmentp,finish_node);
+
+       results=FindSuperRoute(query,nodes,segments,ways,relations,start_node,finish_node);
+
+       if(!results)
+          continue;
+
+       result=FindResult(results,finish_node,finish_segment);
+
+       if(result && (distance_t)result->score==DISTANCE(supersegmentp->distance))
+         {
+          FreeResultsList(results);
+          return(IndexSegment(segments,supersegmentp));
+         }
+
+       if(results)
+          FreeResultsList(results);
+      }
+
+    supersegmentp=NextSegment(segments,supersegmentp,finish_node); /* finish_node cannot be a fake node (must be a super-node) */
+   }
+
+ return(finish_segment);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Find the shortest route between two super-nodes using only normal nodes.
+  This is effectively the same function as is used in superx.c when finding super-segments initially.
+
+  Results *FindSuperRoute Returns a set of results.
+
+  Query *query The query that is being calculated.
+
+  Nodes *nodes The set of nodes to use.
+
+  Segments *segments The set of segments to use.
+
+  Ways *ways The set of ways to use.
+
+  Relations *relations The set of relations to use.
+
+  index_t start_node The start node.
+
+  index_t finish_node The finish node.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static Results *FindSuperRoute(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,index_t start_node,index_t finish_node)
+{
+ Results *results;
+ Queue   *queue;
+ Result  *result1,*result2;
+
+#if DEBUG
+ printf("    FindSuperRoute(...,start_node=%"Pindex_t" finish_node=%"Pindex_t")\n",start_node,finish_node);
+#endif
+
+ /* Create the list of results and insert the first node into the queue */
+
+ results=NewResultsList(query->pool,64);
+ queue=NewQueueList(query->pool);
+
+ results->start_node=start_node;
+ results->prev_segment=NO_SEGMENT;
+
+ result1=InsertResult(results,results->start_node,results->prev_segment);
+
+ InsertInQueue(queue,result1);
+
+ /* Loop across all nodes in the queue */
+
+ while((result1=PopFromQueue(queue)))
+   {
+    Node *node1p=NULL;
+    Segment *segmentp;
+    index_t node1,seg1;
+
+    node1=result1->node;
+    seg1=result1->segment;
+
+    node1p=LookupNode(nodes,node1,1); /* node1 cannot be a fake node */
+
+    /* Loop across all segments */
+
+    segmentp=FirstSegment(segments,node1p,1); /* node1 cannot be a fake node */
+
+    while(segmentp)
+      {
+       Node *node2p=NULL;
+       index_t node2,seg2;
+       score_t cumulative_score;
+
+       /* must be a normal segment */
+       if(!IsNormalSegment(segmentp))
+          goto endloop;
+
+       /* must obey one-way restrictions */
+       if(IsOnewayTo(segmentp,node1))
+          goto endloop;
+
+       seg2=IndexSegment(segments,segmentp);
+
+       /* must not perform U-turn */
+       if(seg1==seg2)
+          goto endloop;
+
+       node2=OtherNode(segmentp,node1);
+
+       node2p=LookupNode(nodes,node2,2); /* node2 cannot be a fake node */
+
+       /* must not pass over super-node */
+       if(node2!=finish_node && IsSuperNode(node2p))
+          goto endloop;
+
+       /* Specifically looking for the shortest route to emulate superx.c */
+       cumulative_score=result1->score+(score_t)DISTANCE(segmentp->distance);
+
+       result2=FindResult(results,node2,seg2);
+
+       if(!result2) /* New end node/segment combination */
+         {
+          result2=InsertResult(results,node2,seg2);
+          result2->prev=result1;
+          result2->score=cumulative_score;
+          result2->sortby=result2->score;
+         }
+       else if(cumulative_score<result2->score) /* New score for end node/segment combination is better */
+         {
+          result2->prev=result1;
+          result2->segment=seg2;
+          result2->score=cumulative_score;
+          result2->sortby=result2->score;
+         }
+       else goto endloop;
+
+       /* don't route beyond a super-node. */
+       if(!IsSuperNode(node2p))
+          InsertInQueue(queue,result2);
+
+      endloop:
+
+       segmentp=NextSegment(segments,segmentp,node1);
+      }
+   }
+
+ FreeQueueList(queue);
+
+#if DEBUG
+ Result *r=FindResult(results,results->start_node,results->prev_segment);
+
+ while(r)
+   {
+    printf("      node=%"Pindex_t" segment=%"Pindex_t" score=%f\n",r->node,r->segment,r->score);
+
+    r=r->next;
+   }
+#endif
+
+ return(results);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Find all routes from a specified node to any super-node.
+
+  Results *FindStartRoutes Returns a set of results.
+
+  Query *query The query that is being calculated.
+
+  Nodes *nodes The set of nodes to use.
+
+  Segments *segments The set of segments to use.
+
+  Ways *ways The set of ways to use.
+
+  Relations *relations The set of relations to use.
+
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
+
+  index_t start_node The start node.
+
+  index_t prev_segment The previous segment before the start node.
+
+  index_t finish_node The finish node.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+Results *FindStartRoutes(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,index_t start_node,index_t prev_segment,index_t finish_node)
+{
+ Results *results;
+ Queue   *queue;
+ Result  *result1,*result2;
+ int     nsuper=0,force_uturn=0;
+
+#if DEBUG
+ printf("  FindStartRoutes(...,start_node=%"Pindex_t" prev_segment=%"Pindex_t" finish_node=%"Pindex_t")\n",start_node,prev_segment,finish_node);
+#endif
+
+ /* Create the list of results and insert the first node into the queue */
+
+ results=NewResultsList(query->pool,64);
+ queue=NewQueueList(query->pool);
+
+ results->start_node=start_node;
+ results->prev_segment=prev_segment;
+
+ result1=InsertResult(results,results->start_node,results->prev_segment);
+
+ InsertInQueue(queue,result1);
+
+ /* Check for barrier at start waypoint - must perform U-turn */
+
+ if(prev_segment!=NO_SEGMENT && !IsFakeNode(start_node))
+   {
+    Node *startp=LookupNode(nodes,start_node,1);
+
+    if(!(startp->allow&profile->allow))
+       force_uturn=1;
+   }
+
+ /* Loop across all nodes in the queue */
+
+ while((result1=PopFromQueue(queue)))
+   {
+    Node *node1p=NULL;
+    Segment *segmentp;
+    index_t node1,seg1,seg1r;
+    index_t turnrelation=NO_RELATION;
+
+    node1=result1->node;
+    seg1=result1->segment;
+
+    if(IsFakeSegment(seg1))
+       seg1r=IndexRealSegment(query,seg1);
+    else
+       seg1r=seg1;
+
+    if(!IsFakeNode(node1))
+       node1p=LookupNode(nodes,node1,1);
+
+    /* lookup if a turn restriction applies */
+    if(profile->turns && node1p && IsTurnRestrictedNode(node1p))
+       turnrelation=FindFirstTurnRelation2(relations,node1,seg1r);
+
+    /* Loop across all segments */
+
+    if(IsFakeNode(node1))
+       segmentp=FirstFakeSegment(query,node1);
+    else
+       segmentp=FirstSegment(segments,node1p,1);
+
+    while(segmentp)
+      {
+       Node *node2p=NULL;
+       index_t node2,seg2,seg2r;
+       score_t segment_pref,segment_score,cumulative_score;
+
+       node2=OtherNode(segmentp,node1); /* need this here because we use node2 at the end of the loop */
+
+       /* must be a normal segment */
+       if(!IsNormalSegment(segmentp))
+          goto endloop;
+
+       /* must obey one-way restrictions (unless profile allows) */
+       if(profile->oneway && IsOnewayTo(segmentp,node1))
+          goto endloop;
+
+       if(IsFakeNode(node1) || IsFakeNode(node2))
+         {
+          seg2 =IndexFakeSegment(query,segmentp);
+          seg2r=IndexRealSegment(query,seg2);
+         }
+       else
+         {
+          seg2 =IndexSegment(segments,segmentp);
+          seg2r=seg2;
+         }
+
+       /* must perform U-turn in special cases */
+       if(node1==start_node && force_uturn)
+         {
+          if(seg2r!=result1->segment)
+             goto endloop;
+         }
+       else
+          /* must not perform U-turn (unless profile allows) */
+          if(profile->turns && (seg1==seg2 || seg1==seg2r || seg1r==seg2 || (seg1r==seg2r && IsFakeUTurn(query,seg1,seg2))))
+             goto endloop;
+
+       /* must obey turn relations */
+       if(turnrelation!=NO_RELATION && !IsTurnAllowed(relations,turnrelation,node1,seg1r,seg2r,profile->allow))
+          goto endloop;
+
+       segment_pref=profile->way_pref[segmentp->way];
+
+       /* profile must allow this highway (transport, restrictions, highway type and properties) */
+       if(segment_pref==0)
+          goto endloop;
+
+       if(!IsFakeNode(node2))
+          node2p=LookupNode(nodes,node2,2);
+
+       /* mode of transport must be allowed through node2 unless it is the final node */
+       if(node2p && node2!=finish_node && !(node2p->allow&profile->allow))
+          goto endloop;
+
+       if(query->quickest==0)
+          segment_score=(score_t)DISTANCE(segmentp->distance)/segment_pref;
+       else
+          segment_score=(score_t)Duration(segmentp,profile)/segment_pref;
+
+       cumulative_score=result1->score+segment_score;
+
+       result2=FindResult(results,node2,seg2);
+
+       if(!result2) /* New end node/segment combination */
+         {
+          result2=InsertResult(results,node2,seg2);
+          result2->prev=result1;
+          result2->score=cumulative_score;
+
+          if(node2p && IsSuperNode(node2p))
+             nsuper++;
+
+          if(node2==finish_node)
+             nsuper++;
+         }
+       else if(cumulative_score<result2->score) /* New score for end node/segment combination is better */
+         {
+          result2->prev=result1;
+          result2->score=cumulative_score;
+         }
+       else
+          goto endloop;
+
+       if(node2p && !IsSuperNode(node2p))
+         {
+          result2->sortby=result2->score;
+          InsertInQueue(queue,result2);
+         }
+
+      endloop:
+
+       if(IsFakeNode(node1))
+          segmentp=NextFakeSegment(query,segmentp,node1);
+       else if(IsFakeNode(node2))
+          segmentp=NULL; /* cannot call NextSegment() with a fake segment */
+       else
+         {
+          segmentp=NextSegment(segments,segmentp,node1);
+
+          if(!segmentp && IsFakeNode(finish_node))
+             segmentp=ExtraFakeSegment(query,node1,finish_node);
+         }
+      }
+   }
+
+ FreeQueueList(queue);
+
+ /* Check it worked */
+
+ if(results->number==1 || nsuper==0)
+   {
+#if DEBUG
+    printf("    Failed (%d results, %d super)\n",results->number,nsuper);
+#endif
+
+    FreeResultsList(results);
+    return(NULL);
+   }
+
+#if DEBUG
+ Result *s=FirstResult(results);
+
+ while(s)
+   {
+    if(s->node==finish_node)
+      {
+       Result *r=FindResult(results,s->node,s->segment);
+
+       printf("    -------- route to finish node\n");
+
+       while(r)
+         {
+          printf("    node=%"Pindex_t" segment=%"Pindex_t" score=%f\n",r->node,r->segment,r->score);
+
+          r=r->prev;
+         }
+      }
+
+    if(!IsFakeNode(s->node))
+      {
+       Node *n=LookupNode(nodes,s->node,1);
+
+       if(IsSuperNode(n))
+         {
+          Result *r=FindResult(results,s->node,s->segment);
+
+          printf("    -------- route to super node\n");
+
+          while(r)
+            {
+             printf("    node=%"Pindex_t" segment=%"Pindex_t" score=%f\n",r->node,r->segment,r->score);
+
+             r=r->prev;
+            }
+         }
+      }
+
+    s=NextResult(results,s);
+   }
+#endif
+
+ return(results);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Continue finding routes from a set of super-nodes to a finish point.
+
+  Results *ExtendStartRoutes Returns the set of results that were passed in.
+
+  Query *query The query that is being calculated.
+
+  Nodes *nodes The set of nodes to use.
+
+  Segments *segments The set of segments to use.
+
+  Ways *ways The set of ways to use.
+
+  Relations *relations The set of relations to use.
+
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
+
+  Results *being The partial set of routes already computed.
+
+  index_t finish_node The finish node.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+Results *ExtendStartRoutes(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,Results *begin,index_t finish_node)
+{
+ Results *results=begin;
+ Queue   *queue;
+ Result  *result1,*result2,*result3;
+ Result  *finish_result=NULL;
+ score_t finish_score=INF_SCORE;
+
+#if DEBUG
+ printf("  ExtendStartRoutes(...,[begin has %d nodes],finish_node=%"Pindex_t")\n",begin->number,finish_node);
+#endif
+
+ /* Check the list of results and insert the super nodes into the queue */
+
+ queue=NewQueueList(query->pool);
+
+ result3=FirstResult(begin);
+
+ while(result3)
+   {
+    if(result3->node==finish_node)
+       if(result3->score<finish_score)
+         {
+          finish_score=result3->score;
+          finish_result=result3;
+         }
+
+    if(!IsFakeNode(result3->node))
+       if(IsSuperNode(LookupNode(nodes,result3->node,5)))
+          InsertInQueue(queue,result3);
+
+    result3=NextResult(results,result3);
+   }
+
+ /* Loop across all nodes in the queue */
+
+ while((result1=PopFromQueue(queue)))
+   {
+    Node *node1p=NULL;
+    Segment *segmentp;
+    index_t node1,seg1,seg1r;
+    index_t turnrelation=NO_RELATION;
+
+    /* score must be better than current best score */
+    if(result1->score>=finish_score)
+       continue;
+
+    node1=result1->node;
+    seg1=result1->segment;
+
+    if(IsFakeSegment(seg1))
+       seg1r=IndexRealSegment(query,seg1);
+    else
+       seg1r=seg1;
+
+    if(!IsFakeNode(node1))
+       node1p=LookupNode(nodes,node1,1);
+
+    /* lookup if a turn restriction applies */
+    if(profile->turns && node1p && IsTurnRestrictedNode(node1p))
+       turnrelation=FindFirstTurnRelation2(relations,node1,seg1r);
+
+    /* Loop across all segments */
+
+    if(IsFakeNode(node1))
+       segmentp=FirstFakeSegment(query,node1);
+    else
+       segmentp=FirstSegment(segments,node1p,1);
+
+    while(segmentp)
+      {
+       Node *node2p=NULL;
+       index_t node2,seg2,seg2r;
+       score_t segment_pref,segment_score,cumulative_score;
+
+       node2=OtherNode(segmentp,node1); /* need this here because we use node2 at the end of the loop */
+
+       /* must be a normal segment */
+       if(!IsNormalSegment(segmentp))
+          goto endloop;
+
+       /* must obey one-way restrictions (unless profile allows) */
+       if(profile->oneway && IsOnewayTo(segmentp,node1))
+          goto endloop;
+
+       if(IsFakeNode(node1) || IsFakeNode(node2))
+         {
+          seg2 =IndexFakeSegment(query,segmentp);
+          seg2r=IndexRealSegment(query,seg2);
+         }
+       else
+         {
+          seg2 =IndexSegment(segments,segmentp);
+          seg2r=seg2;
+         }
+
+       /* must not perform U-turn (unless profile allows) */
+       if(profile->turns && (seg1==seg2 || seg1==seg2r || seg1r==seg2 || (seg1r==seg2r && IsFakeUTurn(query,seg1,seg2))))
+          goto endloop;
+
+       /* must obey turn relations */
+       if(turnrelation!=NO_RELATION && !IsTurnAllowed(relations,turnrelation,node1,seg1r,seg2r,profile->allow))
+          goto endloop;
+
+       segment_pref=profile->way_pref[segmentp->way];
+
+       /* profile must allow this highway (transport, restrictions, highway type and properties) */
+       if(segment_pref==0)
+          goto endloop;
+
+       if(!IsFakeNode(node2))
+          node2p=LookupNode(nodes,node2,2);
+
+       /* mode of transport must be allowed through node2 unless it is the final node */
+       if(node2p && node2!=finish_node && !(node2p->allow&profile->allow))
+          goto endloop;
+
+       if(query->quickest==0)
+          segment_score=(score_t)DISTANCE(segmentp->distance)/segment_pref;
+       else
+          segment_score=(score_t)Duration(segmentp,profile)/segment_pref;
+
+       cumulative_score=result1->score+segment_score;
+
+       /* score must be better than current best score */
+       if(cumulative_score>=finish_score)
+          goto endloop;
+
+       result2=FindResult(results,node2,seg2);
+
+       if(!result2) /* New end node/segment combination */
+         {
+          result2=InsertResult(results,node2,seg2);
+          result2->prev=result1;
+          result2->score=cumulative_score;
+         }
+       else if(cumulative_score<result2->score) /* New score for end node/segment combination is better */
+         {
+          result2->prev=result1;
+          result2->score=cumulative_score;
+         }
+       else
+          goto endloop;
+
+       if(node2==finish_node)
+         {
+          if(cumulative_score<finish_score)
+            {
+             finish_score=cumulative_score;
+             finish_result=result2;
+            }
+         }
+       else
+         {
+          result2->sortby=result2->score;
+          InsertInQueue(queue,result2);
+         }
+
+      endloop:
+
+       if(IsFakeNode(node1))
+          segmentp=NextFakeSegment(query,segmentp,node1);
+       else if(IsFakeNode(node2))
+          segmentp=NULL; /* cannot call NextSegment() with a fake segment */
+       else
+         {
+          segmentp=NextSegment(segments,segmentp,node1);
+
+          if(!segmentp && IsFakeNode(finish_node))
+             segmentp=ExtraFakeSegment(query,node1,finish_node);
+         }
+      }
+   }
+
+ FreeQueueList(queue);
+
+ FixForwardRoute(results,finish_result);
+
+#if DEBUG
+ Result *r=FindResult(results,results->start_node,results->prev_segment);
+
+ while(r)
+   {
+    printf("    node=%"Pindex_t" segment=%"Pindex_t" score=%f\n",r->node,r->segment,r->score);
+
+    r=r->next;
+   }
+#endif
+
+ return(results);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Find all routes from any super-node to a specific node (by working backwards from the specific node to all super-nodes).
+
+  Results *FindFinishRoutes Returns a set of results.
+
+  Query *query The query that is being calculated.
+
+  Nodes *nodes The set of nodes to use.
+
+  Segments *segments The set of segments to use.
 
   Ways *ways The set of ways to use.
 
@@ -891,46 +3802,30 @@ static Results *FindSuperRoute(Nodes *nodes,Segments *segments,Ways *ways,Relati
 
   Profile *profile The profile containing the transport type, speeds and allowed highways.
 
-  index_t start_node The start node.
-
-  index_t prev_segment The previous segment before the start node.
-
-  index_t finish_node The finish node.
+  index_t finish_node The finishing node.
   ++++++++++++++++++++++++++++++++++++++*/
 
-Results *FindStartRoutes(Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,index_t start_node,index_t prev_segment,index_t finish_node)
+Results *FindFinishRoutes(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,index_t finish_node)
 {
- Results *results;
+ Results *results,*results2;
  Queue   *queue;
- Result  *result1,*result2;
- int     nsuper=0,force_uturn=0;
+ Result  *result1,*result2,*result3;
 
 #if DEBUG
- printf("  FindStartRoutes(...,start_node=%"Pindex_t" prev_segment=%"Pindex_t" finish_node=%"Pindex_t")\n",start_node,prev_segment,finish_node);
+ printf("  FindFinishRoutes(...,finish_node=%"Pindex_t")\n",finish_node);
 #endif
 
- /* Create the list of results and insert the first node into the queue */
+ /* Create the results and insert the finish node into the queue */
 
- results=NewResultsList(64);
- queue=NewQueueList();
+ results=NewResultsList(query->pool,64);
+ queue=NewQueueList(query->pool);
 
- results->start_node=start_node;
- results->prev_segment=prev_segment;
+ results->finish_node=finish_node;
 
- result1=InsertResult(results,results->start_node,results->prev_segment);
+ result1=InsertResult(results,finish_node,NO_SEGMENT);
 
  InsertInQueue(queue,result1);
 
- /* Check for barrier at start waypoint - must perform U-turn */
-
- if(prev_segment!=NO_SEGMENT && !IsFakeNode(start_node))
-   {
-    Node *startp=LookupNode(nodes,start_node,1);
-
-    if(!(startp->allow&profile->allow))
-       force_uturn=1;
-   }
-
  /* Loop across all nodes in the queue */
 
  while((result1=PopFromQueue(queue)))
@@ -944,7 +3839,7 @@ Results *FindStartRoutes(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
     seg1=result1->segment;
 
     if(IsFakeSegment(seg1))
-       seg1r=IndexRealSegment(seg1);
+       seg1r=IndexRealSegment(query,seg1);
     else
        seg1r=seg1;
 
@@ -953,37 +3848,39 @@ Results *FindStartRoutes(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
 
     /* lookup if a turn restriction applies */
     if(profile->turns && node1p && IsTurnRestrictedNode(node1p))
-       turnrelation=FindFirstTurnRelation2(relations,node1,seg1r);
+       turnrelation=FindFirstTurnRelation1(relations,node1); /* working backwards => turn relation sort order doesn't help */
 
     /* Loop across all segments */
 
     if(IsFakeNode(node1))
-       segmentp=FirstFakeSegment(node1);
+       segmentp=FirstFakeSegment(query,node1);
     else
        segmentp=FirstSegment(segments,node1p,1);
 
     while(segmentp)
       {
        Node *node2p=NULL;
-       Way *wayp;
        index_t node2,seg2,seg2r;
        score_t segment_pref,segment_score,cumulative_score;
-       int i;
 
-       node2=OtherNode(segmentp,node1); /* need this here because we use node2 at the end of the loop */
+       /* must be a normal segment unless node1 is a super-node (see below). */
+       if((IsFakeNode(node1) || !IsSuperNode(node1p)) && !IsNormalSegment(segmentp))
+          goto endloop;
 
-       /* must be a normal segment */
-       if(!IsNormalSegment(segmentp))
+       /* must be a super segment if node1 is a super-node to give starting super-segment for finding middle route. */
+       if((!IsFakeNode(node1) && IsSuperNode(node1p)) && !IsSuperSegment(segmentp))
           goto endloop;
 
        /* must obey one-way restrictions (unless profile allows) */
-       if(profile->oneway && IsOnewayTo(segmentp,node1))
+       if(profile->oneway && IsOnewayFrom(segmentp,node1)) /* working backwards => disallow oneway *from* node1 */
           goto endloop;
 
+       node2=OtherNode(segmentp,node1);
+
        if(IsFakeNode(node1) || IsFakeNode(node2))
          {
-          seg2 =IndexFakeSegment(segmentp);
-          seg2r=IndexRealSegment(seg2);
+          seg2 =IndexFakeSegment(query,segmentp);
+          seg2r=IndexRealSegment(query,seg2);
          }
        else
          {
@@ -991,93 +3888,56 @@ Results *FindStartRoutes(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
           seg2r=seg2;
          }
 
-       /* must perform U-turn in special cases */
-       if(node1==start_node && force_uturn)
-         {
-          if(seg2r!=result1->segment)
-             goto endloop;
-         }
-       else
-          /* must not perform U-turn (unless profile allows) */
-          if(profile->turns && (seg1==seg2 || seg1==seg2r || seg1r==seg2 || (seg1r==seg2r && IsFakeUTurn(seg1,seg2))))
-             goto endloop;
-
-       /* must obey turn relations */
-       if(turnrelation!=NO_RELATION && !IsTurnAllowed(relations,turnrelation,node1,seg1r,seg2r,profile->allow))
-          goto endloop;
-
-       wayp=LookupWay(ways,segmentp->way,1);
-
-       /* mode of transport must be allowed on the highway */
-       if(!(wayp->allow&profile->allow))
-          goto endloop;
-
-       /* must obey weight restriction (if exists) */
-       if(wayp->weight && wayp->weight<profile->weight)
-          goto endloop;
-
-       /* must obey height/width/length restriction (if exists) */
-       if((wayp->height && wayp->height<profile->height) ||
-          (wayp->width  && wayp->width <profile->width ) ||
-          (wayp->length && wayp->length<profile->length))
+       /* must not perform U-turn (unless profile allows) */
+       if(profile->turns && (seg1==seg2 || seg1==seg2r || seg1r==seg2 || (seg1r==seg2r && IsFakeUTurn(query,seg1,seg2))))
           goto endloop;
 
-       segment_pref=profile->highway[HIGHWAY(wayp->type)];
+       /* must obey turn relations */
+       if(turnrelation!=NO_RELATION)
+         {
+          index_t turnrelation2=FindFirstTurnRelation2(relations,node1,seg2r); /* node2 -> node1 -> result1->next->node */
 
-       /* highway preferences must allow this highway */
-       if(segment_pref==0)
-          goto endloop;
+          if(turnrelation2!=NO_RELATION && !IsTurnAllowed(relations,turnrelation2,node1,seg2r,seg1r,profile->allow))
+             goto endloop;
+         }
 
-       for(i=1;i<Property_Count;i++)
-          if(ways->file.props & PROPERTIES(i))
-            {
-             if(wayp->props & PROPERTIES(i))
-                segment_pref*=profile->props_yes[i];
-             else
-                segment_pref*=profile->props_no[i];
-            }
+       segment_pref=profile->way_pref[segmentp->way];
 
-       /* profile preferences must allow this highway */
+       /* profile must allow this highway (transport, restrictions, highway type and properties) */
        if(segment_pref==0)
           goto endloop;
 
        if(!IsFakeNode(node2))
           node2p=LookupNode(nodes,node2,2);
 
-       /* mode of transport must be allowed through node2 unless it is the final node */
-       if(node2p && node2!=finish_node && !(node2p->allow&profile->allow))
+       /* mode of transport must be allowed through node2 */
+       if(node2p && !(node2p->allow&profile->allow))
           goto endloop;
 
-       if(option_quickest==0)
+       if(query->quickest==0)
           segment_score=(score_t)DISTANCE(segmentp->distance)/segment_pref;
        else
-          segment_score=(score_t)Duration(segmentp,wayp,profile)/segment_pref;
+          segment_score=(score_t)Duration(segmentp,profile)/segment_pref;
 
        cumulative_score=result1->score+segment_score;
 
        result2=FindResult(results,node2,seg2);
 
-       if(!result2) /* New end node/segment combination */
+       if(!result2) /* New end node */
          {
           result2=InsertResult(results,node2,seg2);
-          result2->prev=result1;
+          result2->next=result1;   /* working backwards */
           result2->score=cumulative_score;
-
-          if(node2p && IsSuperNode(node2p))
-             nsuper++;
-
-          if(node2==finish_node)
-             nsuper++;
          }
-       else if(cumulative_score<result2->score) /* New score for end node/segment combination is better */
+       else if(cumulative_score<result2->score) /* New end node is better */
          {
-          result2->prev=result1;
+          result2->next=result1; /* working backwards */
           result2->score=cumulative_score;
          }
        else
           goto endloop;
 
-       if(node2p && !IsSuperNode(node2p))
+       if(IsFakeNode(node1) || !IsSuperNode(node1p))
          {
           result2->sortby=result2->score;
           InsertInQueue(queue,result2);
@@ -1086,83 +3946,251 @@ Results *FindStartRoutes(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
       endloop:
 
        if(IsFakeNode(node1))
-          segmentp=NextFakeSegment(segmentp,node1);
-       else if(IsFakeNode(node2))
-          segmentp=NULL; /* cannot call NextSegment() with a fake segment */
+          segmentp=NextFakeSegment(query,segmentp,node1);
        else
-         {
           segmentp=NextSegment(segments,segmentp,node1);
+      }
+   }
 
-          if(!segmentp && IsFakeNode(finish_node))
-             segmentp=ExtraFakeSegment(node1,finish_node);
+ FreeQueueList(queue);
+
+ /* Check it worked */
+
+ if(results->number==1)
+   {
+#if DEBUG
+    printf("    Failed\n");
+#endif
+
+    FreeResultsList(results);
+    return(NULL);
+   }
+
+ /* Create a results structure with the node at the end of the segment opposite the start */
+
+ results2=NewResultsList(query->pool,64);
+
+ results2->finish_node=results->finish_node;
+
+ result3=FirstResult(results);
+
+ while(result3)
+   {
+    if(result3->next)
+      {
+       result2=InsertResult(results2,result3->next->node,result3->segment);
+
+       result2->score=result3->next->score;
+      }
+
+    result3=NextResult(results,result3);
+   }
+
+ /* Fix up the result->next pointers */
+
+ result3=FirstResult(results);
+
+ while(result3)
+   {
+    if(result3->next && result3->next->next)
+      {
+       result1=FindResult(results2,result3->next->node,result3->segment);
+       result2=FindResult(results2,result3->next->next->node,result3->next->segment);
+
+       result1->next=result2;
+      }
+
+    result3=NextResult(results,result3);
+   }
+
+ FreeResultsList(results);
+
+#if DEBUG
+ Result *s=FirstResult(results2);
+
+ while(s)
+   {
+    if(!IsFakeNode(s->node))
+      {
+       Node *n=LookupNode(nodes,s->node,1);
+
+       if(IsSuperNode(n))
+         {
+          Result *r=FindResult(results2,s->node,s->segment);
+
+          printf("    --------\n");
+
+          while(r)
+            {
+             printf("    node=%"Pindex_t" segment=%"Pindex_t" score=%f\n",r->node,r->segment,r->score);
+
+             r=r->next;
+            }
          }
       }
+
+    s=NextResult(results2,s);
    }
+#endif
+
+ return(results2);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Create an optimum route given the set of super-nodes to follow.
+
+  Results *CombineRoutes Returns the results from joining the super-nodes.
+
+  Query *query The query that is being calculated.
+
+  Nodes *nodes The set of nodes to use.
+
+  Segments *segments The set of segments to use.
+
+  Ways *ways The set of ways to use.
+
+  Relations *relations The set of relations to use.
+
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
+
+  Results *begin The set of results for the start of the route.
+
+  Results *middle The set of results from the super-node route.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+Results *CombineRoutes(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,Results *begin,Results *middle)
+{
+ Result *midres,*comres1;
+ Results *combined;
+
+#if DEBUG
+ printf("  CombineRoutes(...,[begin has %d nodes],[middle has %d nodes])\n",begin->number,middle->number);
+#endif
+
+ combined=NewResultsList(query->pool,256);
+
+ combined->start_node=begin->start_node;
+ combined->prev_segment=begin->prev_segment;
+
+ /* Insert the start point */
+
+ midres=FindResult(middle,middle->start_node,middle->prev_segment);
+
+ comres1=InsertResult(combined,combined->start_node,combined->prev_segment);
+
+ /* Insert the start of the route */
+
+ if(begin->number>1 && midres->next)
+   {
+    Result *begres;
+
+    midres=FindResult(middle,midres->next->node,midres->next->segment);
+
+    begres=FindResult(begin,midres->node,midres->segment);
+
+    FixForwardRoute(begin,begres);
+
+    if(midres->next && midres->next->node==midres->node)
+       midres=midres->next;
+
+    begres=FindResult(begin,begin->start_node,begin->prev_segment);
+
+    begres=begres->next;
 
- FreeQueueList(queue);
+    do
+      {
+       Result *comres2;
 
- /* Check it worked */
+       comres2=InsertResult(combined,begres->node,begres->segment);
 
- if(results->number==1 || nsuper==0)
-   {
-#if DEBUG
-    printf("    Failed (%d results, %d super)\n",results->number,nsuper);
-#endif
+       comres2->score=begres->score;
+       comres2->prev=comres1;
 
-    FreeResultsList(results);
-    return(NULL);
+       begres=begres->next;
+
+       comres1=comres2;
+      }
+    while(begres);
    }
 
-#if DEBUG
- Result *s=FirstResult(results);
+ /* Sort out the combined route */
 
- while(s)
+ do
    {
-    if(s->node==finish_node)
+    Result *result;
+
+    if(midres->next)
       {
-       Result *r=FindResult(results,s->node,s->segment);
+       Results *results=FindNormalRoute(query,nodes,segments,ways,relations,profile,comres1->node,comres1->segment,midres->next->node);
 
-       printf("    -------- route to finish node\n");
+       if(!results)
+          return(NULL);
 
-       while(r)
-         {
-          printf("    node=%"Pindex_t" segment=%"Pindex_t" score=%f\n",r->node,r->segment,r->score);
+       result=FindResult(results,midres->node,comres1->segment);
 
-          r=r->prev;
-         }
-      }
+       result=result->next;
 
-    if(!IsFakeNode(s->node))
-      {
-       Node *n=LookupNode(nodes,s->node,1);
+       /*
+        *      midres                          midres->next
+        *         =                                  =
+        *      ---*----------------------------------*  = middle
+        *
+        *      ---*----.----.----.----.----.----.----*  = results
+        *              =
+        *             result
+        *
+        *      ---*----.----.----.----.----.----.----*  = combined
+        *         =    =
+        *   comres1  comres2
+        */
 
-       if(IsSuperNode(n))
+       do
          {
-          Result *r=FindResult(results,s->node,s->segment);
+          Result *comres2;
 
-          printf("    -------- route to super node\n");
+          comres2=InsertResult(combined,result->node,result->segment);
 
-          while(r)
-            {
-             printf("    node=%"Pindex_t" segment=%"Pindex_t" score=%f\n",r->node,r->segment,r->score);
+          comres2->score=midres->score+result->score;
+          comres2->prev=comres1;
 
-             r=r->prev;
-            }
+          result=result->next;
+
+          comres1=comres2;
          }
+       while(result);
+
+       FreeResultsList(results);
       }
 
-    s=NextResult(results,s);
+    midres=midres->next;
+   }
+ while(midres);
+
+ FixForwardRoute(combined,comres1);
+
+#if DEBUG
+ Result *r=FindResult(combined,combined->start_node,combined->prev_segment);
+
+ while(r)
+   {
+    printf("    node=%"Pindex_t" segment=%"Pindex_t" score=%f\n",r->node,r->segment,r->score);
+
+    r=r->next;
    }
 #endif
 
- return(results);
+ return(combined);
 }
 
 
 /*++++++++++++++++++++++++++++++++++++++
-  Continue finding routes from a set of super-nodes to a finish point.
+  Find all of the nodes that can be reached from a start node within a limit on the duration (or
+  distance) and optionally also on the total ascent.
 
-  Results *ExtendStartRoutes Returns the set of results that were passed in.
+  Results *FindReachableNodes Returns a set of results, those beyond the limits are the first nodes that cannot be reached.
+
+  Query *query The query that is being calculated (holding the limits).
 
   Nodes *nodes The set of nodes to use.
 
@@ -1174,43 +4202,56 @@ Results *FindStartRoutes(Nodes *nodes,Segments *segments,Ways *ways,Relations *r
 
   Profile *profile The profile containing the transport type, speeds and allowed highways.
 
-  Results *being The partial set of routes already computed.
+  index_t start_node The start node.
 
-  index_t finish_node The finish node.
+  index_t prev_segment The previous segment before the start node.
   ++++++++++++++++++++++++++++++++++++++*/
 
-Results *ExtendStartRoutes(Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,Results *begin,index_t finish_node)
+Results *FindReachableNodes(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,index_t start_node,index_t prev_segment)
 {
- Results *results=begin;
+ Results *results;
  Queue   *queue;
- Result  *result1,*result2,*result3;
- Result  *finish_result=NULL;
- score_t finish_score=INF_SCORE;
+ score_t max_score;
+ double  max_ascent;
+ Result  *result1,*result2;
+ int     force_uturn=0;
 
 #if DEBUG
- printf("  ExtendStartRoutes(...,[begin has %d nodes],finish_node=%"Pindex_t")\n",begin->number,finish_node);
+ printf("  FindReachableNodes(...,start_node=%"Pindex_t" prev_segment=%"Pindex_t")\n",start_node,prev_segment);
 #endif
 
- /* Check the list of results and insert the super nodes into the queue */
+ /* Set up the limits (the score is the real duration or distance, the preferences are not used) */
 
- queue=NewQueueList();
+ if(query->reach_duration)
+    max_score=(score_t)query->reach_duration;
+ else
+    max_score=(score_t)query->reach_distance;
 
- result3=FirstResult(begin);
+ if(query->reach_ascent>0)
+    max_ascent=query->reach_ascent;
+ else
+    max_ascent=INF_SCORE;
 
- while(result3)
-   {
-    if(result3->node==finish_node)
-       if(result3->score<finish_score)
-         {
-          finish_score=result3->score;
-          finish_result=result3;
-         }
+ /* Create the list of results and insert the first node into the queue */
 
-    if(!IsFakeNode(result3->node))
-       if(IsSuperNode(LookupNode(nodes,result3->node,5)))
-          InsertInQueue(queue,result3);
+ results=NewResultsList(query->pool,1024);
+ queue=NewQueueList(query->pool);
 
-    result3=NextResult(results,result3);
+ results->start_node=start_node;
+ results->prev_segment=prev_segment;
+
+ result1=InsertResult(results,results->start_node,results->prev_segment);
+
+ InsertInQueue(queue,result1);
+
+ /* Check for barrier at start waypoint - must perform U-turn */
+
+ if(prev_segment!=NO_SEGMENT && !IsFakeNode(start_node))
+   {
+    Node *startp=LookupNode(nodes,start_node,1);
+
+    if(!(startp->allow&profile->allow))
+       force_uturn=1;
    }
 
  /* Loop across all nodes in the queue */
@@ -1222,15 +4263,11 @@ Results *ExtendStartRoutes(Nodes *nodes,Segments *segments,Ways *ways,Relations
     index_t node1,seg1,seg1r;
     index_t turnrelation=NO_RELATION;
 
-    /* score must be better than current best score */
-    if(result1->score>=finish_score)
-       continue;
-
     node1=result1->node;
     seg1=result1->segment;
 
     if(IsFakeSegment(seg1))
-       seg1r=IndexRealSegment(seg1);
+       seg1r=IndexRealSegment(query,seg1);
     else
        seg1r=seg1;
 
@@ -1244,17 +4281,16 @@ Results *ExtendStartRoutes(Nodes *nodes,Segments *segments,Ways *ways,Relations
     /* Loop across all segments */
 
     if(IsFakeNode(node1))
-       segmentp=FirstFakeSegment(node1);
+       segmentp=FirstFakeSegment(query,node1);
     else
        segmentp=FirstSegment(segments,node1p,1);
 
     while(segmentp)
       {
        Node *node2p=NULL;
-       Way *wayp;
        index_t node2,seg2,seg2r;
        score_t segment_pref,segment_score,cumulative_score;
-       int i;
+       double cumulative_ascent;
 
        node2=OtherNode(segmentp,node1); /* need this here because we use node2 at the end of the loop */
 
@@ -1268,8 +4304,8 @@ Results *ExtendStartRoutes(Nodes *nodes,Segments *segments,Ways *ways,Relations
 
        if(IsFakeNode(node1) || IsFakeNode(node2))
          {
-          seg2 =IndexFakeSegment(segmentp);
-          seg2r=IndexRealSegment(seg2);
+          seg2 =IndexFakeSegment(query,segmentp);
+          seg2r=IndexRealSegment(query,seg2);
          }
        else
          {
@@ -1277,66 +4313,45 @@ Results *ExtendStartRoutes(Nodes *nodes,Segments *segments,Ways *ways,Relations
           seg2r=seg2;
          }
 
-       /* must not perform U-turn (unless profile allows) */
-       if(profile->turns && (seg1==seg2 || seg1==seg2r || seg1r==seg2 || (seg1r==seg2r && IsFakeUTurn(seg1,seg2))))
-          goto endloop;
+       /* must perform U-turn in special cases */
+       if(force_uturn && node1==results->start_node)
+         {
+          if(seg2r!=result1->segment)
+             goto endloop;
+         }
+       else
+          /* must not perform U-turn (unless profile allows) */
+          if(profile->turns && (seg1==seg2 || seg1==seg2r || seg1r==seg2 || (seg1r==seg2r && IsFakeUTurn(query,seg1,seg2))))
+             goto endloop;
 
        /* must obey turn relations */
        if(turnrelation!=NO_RELATION && !IsTurnAllowed(relations,turnrelation,node1,seg1r,seg2r,profile->allow))
           goto endloop;
 
-       wayp=LookupWay(ways,segmentp->way,1);
-
-       /* mode of transport must be allowed on the highway */
-       if(!(wayp->allow&profile->allow))
-          goto endloop;
-
-       /* must obey weight restriction (if exists) */
-       if(wayp->weight && wayp->weight<profile->weight)
-          goto endloop;
-
-       /* must obey height/width/length restriction (if exists) */
-       if((wayp->height && wayp->height<profile->height) ||
-          (wayp->width  && wayp->width <profile->width ) ||
-          (wayp->length && wayp->length<profile->length))
-          goto endloop;
-
-       segment_pref=profile->highway[HIGHWAY(wayp->type)];
-
-       /* highway preferences must allow this highway */
-       if(segment_pref==0)
-          goto endloop;
+       if(!IsFakeNode(node2))
+          node2p=LookupNode(nodes,node2,2);
 
-       for(i=1;i<Property_Count;i++)
-          if(ways->file.props & PROPERTIES(i))
-            {
-             if(wayp->props & PROPERTIES(i))
-                segment_pref*=profile->props_yes[i];
-             else
-                segment_pref*=profile->props_no[i];
-            }
+       segment_pref=profile->way_pref[segmentp->way];
 
-       /* profile preferences must allow this highway */
+       /* profile must allow this highway (transport, restrictions, highway type and properties) */
        if(segment_pref==0)
           goto endloop;
 
-       if(!IsFakeNode(node2))
-          node2p=LookupNode(nodes,node2,2);
-
-       /* mode of transport must be allowed through node2 unless it is the final node */
-       if(node2p && node2!=finish_node && !(node2p->allow&profile->allow))
+       /* mode of transport must be allowed through node2 */
+       if(node2p && !(node2p->allow&profile->allow))
           goto endloop;
 
-       if(option_quickest==0)
-          segment_score=(score_t)DISTANCE(segmentp->distance)/segment_pref;
+       if(query->reach_duration)
+          segment_score=(score_t)Duration(segmentp,profile);
        else
-          segment_score=(score_t)Duration(segmentp,wayp,profile)/segment_pref;
+          segment_score=(score_t)DISTANCE(segmentp->distance);
 
        cumulative_score=result1->score+segment_score;
 
-       /* score must be better than current best score */
-       if(cumulative_score>=finish_score)
-          goto endloop;
+       if(node2==segmentp->node2)
+          cumulative_ascent=result1->ascent+SegmentAscent(segmentp);
+       else
+          cumulative_ascent=result1->ascent+SegmentDescent(segmentp);
 
        result2=FindResult(results,node2,seg2);
 
@@ -1345,24 +4360,22 @@ Results *ExtendStartRoutes(Nodes *nodes,Segments *segments,Ways *ways,Relations
           result2=InsertResult(results,node2,seg2);
           result2->prev=result1;
           result2->score=cumulative_score;
+          result2->ascent=cumulative_ascent;
          }
-       else if(cumulative_score<result2->score) /* New score for end node/segment combination is better */
+       else if(cumulative_score<=max_score && cumulative_ascent<=max_ascent ?
+               (cumulative_score<result2->score || result2->score>max_score || result2->ascent>max_ascent) :
+               (cumulative_score<result2->score && (result2->score>max_score || result2->ascent>max_ascent)))
          {
+          /* New score for end node/segment combination is better (or it is within the limits and the old one was not) */
           result2->prev=result1;
           result2->score=cumulative_score;
+          result2->ascent=cumulative_ascent;
          }
        else
           goto endloop;
 
-       if(node2==finish_node)
-         {
-          if(cumulative_score<finish_score)
-            {
-             finish_score=cumulative_score;
-             finish_result=result2;
-            }
-         }
-       else
+       /* results beyond the limits are kept (to find the boundary) but not followed */
+       if(cumulative_score<=max_score && cumulative_ascent<=max_ascent)
          {
           result2->sortby=result2->score;
           InsertInQueue(queue,result2);
@@ -1371,32 +4384,18 @@ Results *ExtendStartRoutes(Nodes *nodes,Segments *segments,Ways *ways,Relations
       endloop:
 
        if(IsFakeNode(node1))
-          segmentp=NextFakeSegment(segmentp,node1);
+          segmentp=NextFakeSegment(query,segmentp,node1);
        else if(IsFakeNode(node2))
           segmentp=NULL; /* cannot call NextSegment() with a fake segment */
        else
-         {
           segmentp=NextSegment(segments,segmentp,node1);
-
-          if(!segmentp && IsFakeNode(finish_node))
-             segmentp=ExtraFakeSegment(node1,finish_node);
-         }
       }
    }
 
  FreeQueueList(queue);
 
- FixForwardRoute(results,finish_result);
-
 #if DEBUG
- Result *r=FindResult(results,results->start_node,results->prev_segment);
-
- while(r)
-   {
-    printf("    node=%"Pindex_t" segment=%"Pindex_t" score=%f\n",r->node,r->segment,r->score);
-
-    r=r->next;
-   }
+ printf("    %d results\n",results->number);
 #endif
 
  return(results);
@@ -1404,9 +4403,17 @@ Results *ExtendStartRoutes(Nodes *nodes,Segments *segments,Ways *ways,Relations
 
 
 /*++++++++++++++++++++++++++++++++++++++
-  Find all routes from any super-node to a specific node (by working backwards from the specific node to all super-nodes).
+  Find the set of routes between two nodes that trade off the duration against the total ascent
+  (the Pareto set, none of them is both quicker and flatter than another one).
 
-  Results *FindFinishRoutes Returns a set of results.
+  Each node and segment keeps a set of labels (duration score and ascent) instead of a single
+  result and a label is only kept if no other label is better in both (to within the epsilon
+  factor in the query). The search is ordered by duration plus a lower bound to the finish so
+  labels can be dropped as soon as they cannot lead to a new route.
+
+  int FindParetoRoutes Returns the number of routes found (sorted by duration).
+
+  Query *query The query that is being calculated (holding the epsilon factor).
 
   Nodes *nodes The set of nodes to use.
 
@@ -1418,31 +4425,68 @@ Results *ExtendStartRoutes(Nodes *nodes,Segments *segments,Ways *ways,Relations
 
   Profile *profile The profile containing the transport type, speeds and allowed highways.
 
-  index_t finish_node The finishing node.
+  index_t start_node The start node.
+
+  index_t prev_segment The previous segment before the start node.
+
+  index_t finish_node The finish node.
+
+  Results **routes Returns the routes (routes[1] to routes[n] like the results for waypoints).
+
+  int maxroutes The maximum number of routes to find.
   ++++++++++++++++++++++++++++++++++++++*/
 
-Results *FindFinishRoutes(Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,index_t finish_node)
+int FindParetoRoutes(Query *query,Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,
+                     index_t start_node,index_t prev_segment,index_t finish_node,Results **routes,int maxroutes)
 {
- Results *results,*results2;
+ ParetoLabels labels;
+ Result **finishes;
  Queue   *queue;
- Result  *result1,*result2,*result3;
+ double  finish_lat,finish_lon;
+ double  factor=1+query->pareto_epsilon;
+ Result  *result1,*result2;
+ int     nfinishes=0,force_uturn=0;
+ int     i,j;
 
 #if DEBUG
- printf("  FindFinishRoutes(...,finish_node=%"Pindex_t")\n",finish_node);
+ printf("  FindParetoRoutes(...,start_node=%"Pindex_t" prev_segment=%"Pindex_t" finish_node=%"Pindex_t")\n",start_node,prev_segment,finish_node);
 #endif
 
- /* Create the results and insert the finish node into the queue */
+ /* Set up the finish conditions */
 
- results=NewResultsList(64);
- queue=NewQueueList();
+ finishes=(Result**)malloc(maxroutes*sizeof(Result*));
 
- results->finish_node=finish_node;
+ logassert(finishes,"Failed to allocate memory"); /* Check malloc() worked */
 
- result1=InsertResult(results,finish_node,NO_SEGMENT);
+ if(IsFakeNode(finish_node))
+    GetFakeLatLong(query,finish_node,&finish_lat,&finish_lon);
+ else
+    GetLatLong(nodes,finish_node,&finish_lat,&finish_lon);
+
+ /* Create the list of labels and insert the first node into the queue */
+
+ labels.first=NewResultsList(query->pool,1024);
+ labels.blocks=NULL;
+ labels.nblocks=0;
+ labels.nused=PARETO_BLOCK;
+
+ queue=NewQueueList(query->pool);
+
+ result1=InsertResult(labels.first,start_node,prev_segment);
 
  InsertInQueue(queue,result1);
 
- /* Loop across all nodes in the queue */
+ /* Check for barrier at start waypoint - must perform U-turn */
+
+ if(prev_segment!=NO_SEGMENT && !IsFakeNode(start_node))
+   {
+    Node *startp=LookupNode(nodes,start_node,1);
+
+    if(!(startp->allow&profile->allow))
+       force_uturn=1;
+   }
+
+ /* Loop across all labels in the queue */
 
  while((result1=PopFromQueue(queue)))
    {
@@ -1451,11 +4495,21 @@ Results *FindFinishRoutes(Nodes *nodes,Segments *segments,Ways *ways,Relations *
     index_t node1,seg1,seg1r;
     index_t turnrelation=NO_RELATION;
 
+    /* labels that were replaced by a better one cannot be removed from the queue */
+    if(result1->score==INF_SCORE)
+       continue;
+
+    /* must not be dominated by a route already found */
+    if(ParetoDominated(finishes,nfinishes,result1->sortby,result1->ascent,factor))
+       continue;
+
+    query->nsettled++;
+
     node1=result1->node;
     seg1=result1->segment;
 
     if(IsFakeSegment(seg1))
-       seg1r=IndexRealSegment(seg1);
+       seg1r=IndexRealSegment(query,seg1);
     else
        seg1r=seg1;
 
@@ -1464,41 +4518,36 @@ Results *FindFinishRoutes(Nodes *nodes,Segments *segments,Ways *ways,Relations *
 
     /* lookup if a turn restriction applies */
     if(profile->turns && node1p && IsTurnRestrictedNode(node1p))
-       turnrelation=FindFirstTurnRelation1(relations,node1); /* working backwards => turn relation sort order doesn't help */
+       turnrelation=FindFirstTurnRelation2(relations,node1,seg1r);
 
     /* Loop across all segments */
 
     if(IsFakeNode(node1))
-       segmentp=FirstFakeSegment(node1);
+       segmentp=FirstFakeSegment(query,node1);
     else
        segmentp=FirstSegment(segments,node1p,1);
 
     while(segmentp)
       {
        Node *node2p=NULL;
-       Way *wayp;
        index_t node2,seg2,seg2r;
-       score_t segment_pref,segment_score,cumulative_score;
-       int i;
+       score_t segment_pref,segment_score,cumulative_score,sortby;
+       double cumulative_ascent;
 
-       /* must be a normal segment unless node1 is a super-node (see below). */
-       if((IsFakeNode(node1) || !IsSuperNode(node1p)) && !IsNormalSegment(segmentp))
-          goto endloop;
+       node2=OtherNode(segmentp,node1); /* need this here because we use node2 at the end of the loop */
 
-       /* must be a super segment if node1 is a super-node to give starting super-segment for finding middle route. */
-       if((!IsFakeNode(node1) && IsSuperNode(node1p)) && !IsSuperSegment(segmentp))
+       /* must be a normal segment */
+       if(!IsNormalSegment(segmentp))
           goto endloop;
 
        /* must obey one-way restrictions (unless profile allows) */
-       if(profile->oneway && IsOnewayFrom(segmentp,node1)) /* working backwards => disallow oneway *from* node1 */
+       if(profile->oneway && IsOnewayTo(segmentp,node1))
           goto endloop;
 
-       node2=OtherNode(segmentp,node1);
-
        if(IsFakeNode(node1) || IsFakeNode(node2))
          {
-          seg2 =IndexFakeSegment(segmentp);
-          seg2r=IndexRealSegment(seg2);
+          seg2 =IndexFakeSegment(query,segmentp);
+          seg2r=IndexRealSegment(query,seg2);
          }
        else
          {
@@ -1506,326 +4555,304 @@ Results *FindFinishRoutes(Nodes *nodes,Segments *segments,Ways *ways,Relations *
           seg2r=seg2;
          }
 
-       /* must not perform U-turn (unless profile allows) */
-       if(profile->turns && (seg1==seg2 || seg1==seg2r || seg1r==seg2 || (seg1r==seg2r && IsFakeUTurn(seg1,seg2))))
-          goto endloop;
-
-       /* must obey turn relations */
-       if(turnrelation!=NO_RELATION)
+       /* must perform U-turn in special cases */
+       if(force_uturn && node1==start_node)
          {
-          index_t turnrelation2=FindFirstTurnRelation2(relations,node1,seg2r); /* node2 -> node1 -> result1->next->node */
-
-          if(turnrelation2!=NO_RELATION && !IsTurnAllowed(relations,turnrelation2,node1,seg2r,seg1r,profile->allow))
+          if(seg2r!=result1->segment)
              goto endloop;
          }
+       else
+          /* must not perform U-turn (unless profile allows) */
+          if(profile->turns && (seg1==seg2 || seg1==seg2r || seg1r==seg2 || (seg1r==seg2r && IsFakeUTurn(query,seg1,seg2))))
+             goto endloop;
 
-       wayp=LookupWay(ways,segmentp->way,1);
-
-       /* mode of transport must be allowed on the highway */
-       if(!(wayp->allow&profile->allow))
-          goto endloop;
-
-       /* must obey weight restriction (if exists) */
-       if(wayp->weight && wayp->weight<profile->weight)
+       /* must obey turn relations */
+       if(turnrelation!=NO_RELATION && !IsTurnAllowed(relations,turnrelation,node1,seg1r,seg2r,profile->allow))
           goto endloop;
 
-       /* must obey height/width/length restriction (if exist) */
-       if((wayp->height && wayp->height<profile->height) ||
-          (wayp->width  && wayp->width <profile->width ) ||
-          (wayp->length && wayp->length<profile->length))
-          goto endloop;
+       if(!IsFakeNode(node2))
+          node2p=LookupNode(nodes,node2,2);
 
-       segment_pref=profile->highway[HIGHWAY(wayp->type)];
+       segment_pref=profile->way_pref[segmentp->way];
 
-       /* highway preferences must allow this highway */
+       /* profile must allow this highway (transport, restrictions, highway type and properties) */
        if(segment_pref==0)
           goto endloop;
 
-       for(i=1;i<Property_Count;i++)
-          if(ways->file.props & PROPERTIES(i))
-            {
-             if(wayp->props & PROPERTIES(i))
-                segment_pref*=profile->props_yes[i];
-             else
-                segment_pref*=profile->props_no[i];
-            }
-
-       /* profile preferences must allow this highway */
-       if(segment_pref==0)
+       /* mode of transport must be allowed through node2 unless it is the final node */
+       if(node2p && node2!=finish_node && !(node2p->allow&profile->allow))
           goto endloop;
 
-       if(!IsFakeNode(node2))
-          node2p=LookupNode(nodes,node2,2);
-
-       /* mode of transport must be allowed through node2 */
-       if(node2p && !(node2p->allow&profile->allow))
-          goto endloop;
+       /* the score is the real duration (the preferences only choose the highways that are allowed) */
 
-       if(option_quickest==0)
-          segment_score=(score_t)DISTANCE(segmentp->distance)/segment_pref;
-       else
-          segment_score=(score_t)Duration(segmentp,wayp,profile)/segment_pref;
+       segment_score=(score_t)Duration(segmentp,profile);
 
        cumulative_score=result1->score+segment_score;
 
-       result2=FindResult(results,node2,seg2);
+       if(node2==segmentp->node2)
+          cumulative_ascent=result1->ascent+SegmentAscent(segmentp);
+       else
+          cumulative_ascent=result1->ascent+SegmentDescent(segmentp);
 
-       if(!result2) /* New end node */
-         {
-          result2=InsertResult(results,node2,seg2);
-          result2->next=result1;   /* working backwards */
-          result2->score=cumulative_score;
-         }
-       else if(cumulative_score<result2->score) /* New end node is better */
+       if(node2==finish_node)
+          sortby=cumulative_score;
+       else
          {
-          result2->next=result1; /* working backwards */
-          result2->score=cumulative_score;
+          double lat,lon;
+          distance_t direct;
+
+          if(IsFakeNode(node2))
+             GetFakeLatLong(query,node2,&lat,&lon);
+          else
+             GetLatLong(nodes,node2,&lat,&lon);
+
+          direct=Distance(lat,lon,finish_lat,finish_lon);
+
+          sortby=cumulative_score+(score_t)distance_speed_to_duration(direct,profile->max_speed);
          }
-       else
+
+       /* must not be dominated by a route already found */
+       if(ParetoDominated(finishes,nfinishes,sortby,cumulative_ascent,factor))
           goto endloop;
 
-       if(IsFakeNode(node1) || !IsSuperNode(node1p))
+       /* must not be dominated by another label for the same node and segment */
+       result2=InsertParetoLabel(&labels,node2,seg2,cumulative_score,sortby-cumulative_score,cumulative_ascent,factor);
+
+       if(!result2)
+          goto endloop;
+
+       result2->prev=result1;
+       result2->sortby=sortby;
+
+       if(node2==finish_node)
          {
-          result2->sortby=result2->score;
-          InsertInQueue(queue,result2);
+          /* Remove the routes that the new one is better than */
+
+          for(i=0,j=0;i<nfinishes;i++)
+             if(!(cumulative_score<=finishes[i]->score && cumulative_ascent<=finishes[i]->ascent))
+                finishes[j++]=finishes[i];
+
+          nfinishes=j;
+
+          if(nfinishes<maxroutes)
+             finishes[nfinishes++]=result2;
          }
+       else
+          InsertInQueue(queue,result2);
 
       endloop:
 
        if(IsFakeNode(node1))
-          segmentp=NextFakeSegment(segmentp,node1);
+          segmentp=NextFakeSegment(query,segmentp,node1);
+       else if(IsFakeNode(node2))
+          segmentp=NULL; /* cannot call NextSegment() with a fake segment */
        else
+         {
           segmentp=NextSegment(segments,segmentp,node1);
+
+          if(!segmentp && IsFakeNode(finish_node))
+             segmentp=ExtraFakeSegment(query,node1,finish_node);
+         }
       }
    }
 
  FreeQueueList(queue);
 
- /* Check it worked */
+ /* Sort the routes by duration (insertion sort, there are only a few) */
 
- if(results->number==1)
+ for(i=1;i<nfinishes;i++)
    {
-#if DEBUG
-    printf("    Failed\n");
-#endif
-
-    FreeResultsList(results);
-    return(NULL);
-   }
-
- /* Create a results structure with the node at the end of the segment opposite the start */
+    Result *temp=finishes[i];
 
- results2=NewResultsList(64);
+    for(j=i;j>0 && finishes[j-1]->score>temp->score;j--)
+       finishes[j]=finishes[j-1];
 
- results2->finish_node=results->finish_node;
+    finishes[j]=temp;
+   }
 
- result3=FirstResult(results);
+ /* Copy each route into its own set of results */
 
- while(result3)
+ for(i=0;i<nfinishes;i++)
    {
-    if(result3->next)
-      {
-       result2=InsertResult(results2,result3->next->node,result3->segment);
+    Result *result,*prev=NULL;
+    Result **path;
+    int npath=0;
 
-       result2->score=result3->next->score;
-      }
+    for(result=finishes[i];result;result=result->prev)
+       npath++;
 
-    result3=NextResult(results,result3);
-   }
+    path=(Result**)malloc(npath*sizeof(Result*));
 
- /* Fix up the result->next pointers */
+    for(j=npath,result=finishes[i];result;result=result->prev)
+       path[--j]=result;
 
- result3=FirstResult(results);
+    routes[i+1]=NewResultsList(query->pool,64);
 
- while(result3)
-   {
-    if(result3->next && result3->next->next)
-      {
-       result1=FindResult(results2,result3->next->node,result3->segment);
-       result2=FindResult(results2,result3->next->next->node,result3->next->segment);
+    routes[i+1]->start_node=start_node;
+    routes[i+1]->prev_segment=prev_segment;
 
-       result1->next=result2;
-      }
+    for(j=0;j<npath;j++)
+      {
+       result=InsertResult(routes[i+1],path[j]->node,path[j]->segment);
 
-    result3=NextResult(results,result3);
-   }
+       result->prev=prev;
+       result->score=path[j]->score;
+       result->ascent=path[j]->ascent;
 
- FreeResultsList(results);
+       prev=result;
+      }
 
-#if DEBUG
- Result *s=FirstResult(results2);
+    FixForwardRoute(routes[i+1],prev);
 
- while(s)
-   {
-    if(!IsFakeNode(s->node))
-      {
-       Node *n=LookupNode(nodes,s->node,1);
+    free(path);
+   }
 
-       if(IsSuperNode(n))
-         {
-          Result *r=FindResult(results2,s->node,s->segment);
+ FreeResultsList(labels.first);
 
-          printf("    --------\n");
+ for(i=0;i<labels.nblocks;i++)
+    free(labels.blocks[i]);
 
-          while(r)
-            {
-             printf("    node=%"Pindex_t" segment=%"Pindex_t" score=%f\n",r->node,r->segment,r->score);
+ free(labels.blocks);
 
-             r=r->next;
-            }
-         }
-      }
+ free(finishes);
 
-    s=NextResult(results2,s);
-   }
+#if DEBUG
+ printf("    %d routes\n",nfinishes);
 #endif
 
- return(results2);
+ return(nfinishes);
 }
 
 
 /*++++++++++++++++++++++++++++++++++++++
-  Create an optimum route given the set of super-nodes to follow.
+  Add a label to the set of labels for a node and segment unless one of the others is better.
 
-  Results *CombineRoutes Returns the results from joining the super-nodes.
+  Result *InsertParetoLabel Returns the new label or NULL if it is not needed.
 
-  Nodes *nodes The set of nodes to use.
+  ParetoLabels *labels The labels for all of the nodes and segments.
 
-  Segments *segments The set of segments to use.
+  index_t node The node that the label is for.
 
-  Ways *ways The set of ways to use.
+  index_t segment The segment that the label is for.
 
-  Relations *relations The set of relations to use.
+  score_t score The score for the new label.
 
-  Profile *profile The profile containing the transport type, speeds and allowed highways.
+  score_t bound The lower bound of the score from the node to the finish (the labels are compared
+                using the lower bound of the score for the whole route).
 
-  Results *begin The set of results for the start of the route.
+  double ascent The ascent for the new label.
 
-  Results *middle The set of results from the super-node route.
+  double factor The epsilon factor for comparing the labels.
   ++++++++++++++++++++++++++++++++++++++*/
 
-Results *CombineRoutes(Nodes *nodes,Segments *segments,Ways *ways,Relations *relations,Profile *profile,Results *begin,Results *middle)
+static Result *InsertParetoLabel(ParetoLabels *labels,index_t node,index_t segment,score_t score,score_t bound,double ascent,double factor)
 {
- Result *midres,*comres1;
- Results *combined;
-
-#if DEBUG
- printf("  CombineRoutes(...,[begin has %d nodes],[middle has %d nodes])\n",begin->number,middle->number);
-#endif
-
- combined=NewResultsList(256);
+ Result *first,*label,*last=NULL,*replace=NULL,*unused=NULL;
+ int number=0;
 
- combined->start_node=begin->start_node;
- combined->prev_segment=begin->prev_segment;
-
- /* Insert the start point */
-
- midres=FindResult(middle,middle->start_node,middle->prev_segment);
-
- comres1=InsertResult(combined,combined->start_node,combined->prev_segment);
+ first=FindResult(labels->first,node,segment);
 
- /* Insert the start of the route */
-
- if(begin->number>1 && midres->next)
+ if(!first)
    {
-    Result *begres;
-
-    midres=FindResult(middle,midres->next->node,midres->next->segment);
-
-    begres=FindResult(begin,midres->node,midres->segment);
+    label=InsertResult(labels->first,node,segment);
 
-    FixForwardRoute(begin,begres);
-
-    if(midres->next && midres->next->node==midres->node)
-       midres=midres->next;
+    label->score=score;
+    label->ascent=ascent;
 
-    begres=FindResult(begin,begin->start_node,begin->prev_segment);
-
-    begres=begres->next;
+    return(label);
+   }
 
-    do
+ for(label=first;label;label=label->next)
+   {
+    if(label->score==INF_SCORE)
       {
-       Result *comres2;
+       /* a label that was replaced can be used again once it has left the queue */
+       if(label->queued==NOT_QUEUED && !unused)
+          unused=label;
+      }
+    else if(label->score+bound<=(score+bound)*factor && label->ascent<=ascent*factor+PARETO_ASCENT)
+       return(NULL);
+    else if(score<=label->score && ascent<=label->ascent && label->queued!=NOT_QUEUED)
+      {
+       /* a label that has not been used yet can be replaced by a better one */
+       if(!replace)
+          replace=label;
+       else
+          label->score=INF_SCORE;
+      }
 
-       comres2=InsertResult(combined,begres->node,begres->segment);
+    last=label;
+    number++;
+   }
 
-       comres2->score=begres->score;
-       comres2->prev=comres1;
+ if(replace)
+    label=replace;
+ else if(unused)
+    label=unused;
+ else if(number<MAX_PARETO_LABELS)
+   {
+    if(labels->nused==PARETO_BLOCK)
+      {
+       labels->nblocks++;
+       labels->blocks=(Result**)realloc((void*)labels->blocks,labels->nblocks*sizeof(Result*));
+       labels->blocks[labels->nblocks-1]=(Result*)malloc(PARETO_BLOCK*sizeof(Result));
 
-       begres=begres->next;
+       logassert(labels->blocks[labels->nblocks-1],"Failed to allocate memory"); /* Check malloc() worked */
 
-       comres1=comres2;
+       labels->nused=0;
       }
-    while(begres);
-   }
 
- /* Sort out the combined route */
+    label=&labels->blocks[labels->nblocks-1][labels->nused++];
 
- do
-   {
-    Result *result;
+    label->node=node;
+    label->segment=segment;
 
-    if(midres->next)
-      {
-       Results *results=FindNormalRoute(nodes,segments,ways,relations,profile,comres1->node,comres1->segment,midres->next->node);
+    label->prev=NULL;
+    label->next=NULL;
 
-       if(!results)
-          return(NULL);
+    label->descent=0;
+    label->ascentOn=0;
+    label->descentOn=0;
 
-       result=FindResult(results,midres->node,comres1->segment);
+    label->queued=NOT_QUEUED;
 
-       result=result->next;
+    last->next=label;
+   }
+ else
+    return(NULL);
 
-       /*
-        *      midres                          midres->next
-        *         =                                  =
-        *      ---*----------------------------------*  = middle
-        *
-        *      ---*----.----.----.----.----.----.----*  = results
-        *              =
-        *             result
-        *
-        *      ---*----.----.----.----.----.----.----*  = combined
-        *         =    =
-        *   comres1  comres2
-        */
+ label->score=score;
+ label->ascent=ascent;
 
-       do
-         {
-          Result *comres2;
+ return(label);
+}
 
-          comres2=InsertResult(combined,result->node,result->segment);
 
-          comres2->score=midres->score+result->score;
-          comres2->prev=comres1;
+/*++++++++++++++++++++++++++++++++++++++
+  Check if a label is dominated by one of the routes already found.
 
-          result=result->next;
+  int ParetoDominated Returns true if one of the routes is better (to within the epsilon factor).
 
-          comres1=comres2;
-         }
-       while(result);
+  Result **finishes The labels at the finish node for the routes already found.
 
-       FreeResultsList(results);
-      }
+  int nfinishes The number of routes already found.
 
-    midres=midres->next;
-   }
- while(midres);
+  score_t score The score for the label (including the lower bound to the finish).
 
- FixForwardRoute(combined,comres1);
+  double ascent The ascent for the label.
 
-#if DEBUG
- Result *r=FindResult(combined,combined->start_node,combined->prev_segment);
+  double factor The epsilon factor for comparing the labels.
+  ++++++++++++++++++++++++++++++++++++++*/
 
- while(r)
-   {
-    printf("    node=%"Pindex_t" segment=%"Pindex_t" score=%f\n",r->node,r->segment,r->score);
+static int ParetoDominated(Result **finishes,int nfinishes,score_t score,double ascent,double factor)
+{
+ int i;
 
-    r=r->next;
-   }
-#endif
+ for(i=0;i<nfinishes;i++)
+    if(finishes[i]->score<=score*factor && finishes[i]->ascent<=ascent*factor+PARETO_ASCENT)
+       return(1);
 
- return(combined);
+ return(0);
 }
 
 
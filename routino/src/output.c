@@ -35,6 +35,7 @@
 
 #include "functions.h"
 #include "fakes.h"
+#include "query.h"
 #include "translations.h"
 #include "results.h"
 #include "xmlparse.h"
@@ -54,14 +55,8 @@
 #define IMP_UTURN        8      /*+ The location of a U-turn. +*/
 #define IMP_WAYPOINT     9      /*+ A waypoint. +*/
 
-
-/* Global variables */
-
-/*+ The option to calculate the quickest route insted of the shortest. +*/
-extern int option_quickest;
-
-/*+ The options to select the format of the output. +*/
-extern int option_html,option_gpx_track,option_gpx_route,option_text,option_text_all;
+/*+ The number of directions to find the furthest reachable point in for the boundary. +*/
+#define NSECTORS        72
 
 
 /* Local variables */
@@ -85,9 +80,16 @@ static char junction_other_way[Highway_Count][Highway_Count]=
  };
 
 
+/* Local functions */
+
+static FILE *open_output(Query *query,const char *filename);
+
+
 /*++++++++++++++++++++++++++++++++++++++
   Print the optimum route between two nodes.
 
+  Query *query The query that has been calculated (the options and translations to use).
+
   Results **results The set of results to print (some may be NULL - ignore them).
 
   int nresults The number of results in the list.
@@ -101,8 +103,9 @@ static char junction_other_way[Highway_Count][Highway_Count]=
   Profile *profile The profile containing the transport type, speeds and allowed highways.
   ++++++++++++++++++++++++++++++++++++++*/
 
-void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,Ways *ways,Profile *profile)
+void PrintRoute(Query *query,Results **results,int nresults,Nodes *nodes,Segments *segments,Ways *ways,Profile *profile)
 {
+ const Translation *translation=query->translation;
  FILE *htmlfile=NULL,*gpxtrackfile=NULL,*gpxroutefile=NULL,*textfile=NULL,*textallfile=NULL;
 
  char *prev_bearing=NULL,*prev_wayname=NULL;
@@ -116,57 +119,35 @@ void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,W
 
  /* Open the files */
 
- if(option_quickest==0)
+ if(query->quickest==0)
    {
     /* Print the result for the shortest route */
 
-    if(option_html)
-       htmlfile    =fopen("shortest.html","w");
-    if(option_gpx_track)
-       gpxtrackfile=fopen("shortest-track.gpx","w");
-    if(option_gpx_route)
-       gpxroutefile=fopen("shortest-route.gpx","w");
-    if(option_text)
-       textfile    =fopen("shortest.txt","w");
-    if(option_text_all)
-       textallfile =fopen("shortest-all.txt","w");
-
-    if(option_html && !htmlfile)
-       fprintf(stderr,"Warning: Cannot open file 'shortest.html' for writing [%s].\n",strerror(errno));
-    if(option_gpx_track && !gpxtrackfile)
-       fprintf(stderr,"Warning: Cannot open file 'shortest-track.gpx' for writing [%s].\n",strerror(errno));
-    if(option_gpx_route && !gpxroutefile)
-       fprintf(stderr,"Warning: Cannot open file 'shortest-route.gpx' for writing [%s].\n",strerror(errno));
-    if(option_text && !textfile)
-       fprintf(stderr,"Warning: Cannot open file 'shortest.txt' for writing [%s].\n",strerror(errno));
-    if(option_text_all && !textallfile)
-       fprintf(stderr,"Warning: Cannot open file 'shortest-all.txt' for writing [%s].\n",strerror(errno));
+    if(query->html)
+       htmlfile    =open_output(query,"shortest.html");
+    if(query->gpx_track)
+       gpxtrackfile=open_output(query,"shortest-track.gpx");
+    if(query->gpx_route)
+       gpxroutefile=open_output(query,"shortest-route.gpx");
+    if(query->text)
+       textfile    =open_output(query,"shortest.txt");
+    if(query->text_all)
+       textallfile =open_output(query,"shortest-all.txt");
    }
  else
    {
     /* Print the result for the quickest route */
 
-    if(option_html)
-       htmlfile    =fopen("quickest.html","w");
-    if(option_gpx_track)
-       gpxtrackfile=fopen("quickest-track.gpx","w");
-    if(option_gpx_route)
-       gpxroutefile=fopen("quickest-route.gpx","w");
-    if(option_text)
-       textfile    =fopen("quickest.txt","w");
-    if(option_text_all)
-       textallfile =fopen("quickest-all.txt","w");
-
-    if(option_html && !htmlfile)
-       fprintf(stderr,"Warning: Cannot open file 'quickest.html' for writing [%s].\n",strerror(errno));
-    if(option_gpx_track && !gpxtrackfile)
-       fprintf(stderr,"Warning: Cannot open file 'quickest-track.gpx' for writing [%s].\n",strerror(errno));
-    if(option_gpx_route && !gpxroutefile)
-       fprintf(stderr,"Warning: Cannot open file 'quickest-route.gpx' for writing [%s].\n",strerror(errno));
-    if(option_text && !textfile)
-       fprintf(stderr,"Warning: Cannot open file 'quickest.txt' for writing [%s].\n",strerror(errno));
-    if(option_text_all && !textallfile)
-       fprintf(stderr,"Warning: Cannot open file 'quickest-all.txt' for writing [%s].\n",strerror(errno));
+    if(query->html)
+       htmlfile    =open_output(query,"quickest.html");
+    if(query->gpx_track)
+       gpxtrackfile=open_output(query,"quickest-track.gpx");
+    if(query->gpx_route)
+       gpxroutefile=open_output(query,"quickest-route.gpx");
+    if(query->text)
+       textfile    =open_output(query,"quickest.txt");
+    if(query->text_all)
+       textallfile =open_output(query,"quickest-all.txt");
    }
 
  /* Print the head of the files */
@@ -175,15 +156,15 @@ void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,W
    {
     fprintf(htmlfile,"<!DOCTYPE HTML PUBLIC \"-//W3C//DTD HTML 4.01 Transitional//EN\" \"http://www.w3.org/TR/html4/loose.dtd\">\n");
     fprintf(htmlfile,"<HTML>\n");
-    if(translate_xml_copyright_creator[0] && translate_xml_copyright_creator[1])
-       fprintf(htmlfile,"<!-- %s : %s -->\n",translate_xml_copyright_creator[0],translate_xml_copyright_creator[1]);
-    if(translate_xml_copyright_source[0] && translate_xml_copyright_source[1])
-       fprintf(htmlfile,"<!-- %s : %s -->\n",translate_xml_copyright_source[0],translate_xml_copyright_source[1]);
-    if(translate_xml_copyright_license[0] && translate_xml_copyright_license[1])
-       fprintf(htmlfile,"<!-- %s : %s -->\n",translate_xml_copyright_license[0],translate_xml_copyright_license[1]);
+    if(translation->xml_copyright_creator[0] && translation->xml_copyright_creator[1])
+       fprintf(htmlfile,"<!-- %s : %s -->\n",translation->xml_copyright_creator[0],translation->xml_copyright_creator[1]);
+    if(translation->xml_copyright_source[0] && translation->xml_copyright_source[1])
+       fprintf(htmlfile,"<!-- %s : %s -->\n",translation->xml_copyright_source[0],translation->xml_copyright_source[1]);
+    if(translation->xml_copyright_license[0] && translation->xml_copyright_license[1])
+       fprintf(htmlfile,"<!-- %s : %s -->\n",translation->xml_copyright_license[0],translation->xml_copyright_license[1]);
     fprintf(htmlfile,"<HEAD>\n");
     fprintf(htmlfile,"<TITLE>");
-    fprintf(htmlfile,translate_html_title,option_quickest?translate_xml_route_quickest:translate_xml_route_shortest);
+    fprintf(htmlfile,translation->html_title,query->quickest?translation->xml_route_quickest:translation->xml_route_shortest);
     fprintf(htmlfile,"</TITLE>\n");
     fprintf(htmlfile,"<META http-equiv=\"Content-Type\" content=\"text/html; charset=UTF-8\">\n");
     fprintf(htmlfile,"<STYLE type=\"text/css\">\n");
@@ -208,7 +189,7 @@ void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,W
     fprintf(htmlfile,"</HEAD>\n");
     fprintf(htmlfile,"<BODY>\n");
     fprintf(htmlfile,"<H1>");
-    fprintf(htmlfile,translate_html_title,option_quickest?translate_xml_route_quickest:translate_xml_route_shortest);
+    fprintf(htmlfile,translation->html_title,query->quickest?translation->xml_route_quickest:translation->xml_route_shortest);
     fprintf(htmlfile,"</H1>\n");
     fprintf(htmlfile,"<table>\n");
    }
@@ -219,13 +200,13 @@ void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,W
     fprintf(gpxtrackfile,"<gpx version=\"1.1\" creator=\"Routino\" xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" xmlns=\"http://www.topografix.com/GPX/1/1\" xsi:schemaLocation=\"http://www.topografix.com/GPX/1/1 http://www.topografix.com/GPX/1/1/gpx.xsd\">\n");
 
     fprintf(gpxtrackfile,"<metadata>\n");
-    fprintf(gpxtrackfile,"<desc>%s : %s</desc>\n",translate_xml_copyright_creator[0],translate_xml_copyright_creator[1]);
-    if(translate_xml_copyright_source[1])
+    fprintf(gpxtrackfile,"<desc>%s : %s</desc>\n",translation->xml_copyright_creator[0],translation->xml_copyright_creator[1]);
+    if(translation->xml_copyright_source[1])
       {
-       fprintf(gpxtrackfile,"<copyright author=\"%s\">\n",translate_xml_copyright_source[1]);
+       fprintf(gpxtrackfile,"<copyright author=\"%s\">\n",translation->xml_copyright_source[1]);
 
-       if(translate_xml_copyright_license[1])
-          fprintf(gpxtrackfile,"<license>%s</license>\n",translate_xml_copyright_license[1]);
+       if(translation->xml_copyright_license[1])
+          fprintf(gpxtrackfile,"<license>%s</license>\n",translation->xml_copyright_license[1]);
 
        fprintf(gpxtrackfile,"</copyright>\n");
       }
@@ -233,10 +214,10 @@ void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,W
 
     fprintf(gpxtrackfile,"<trk>\n");
     fprintf(gpxtrackfile,"<name>");
-    fprintf(gpxtrackfile,translate_gpx_name,option_quickest?translate_xml_route_quickest:translate_xml_route_shortest);
+    fprintf(gpxtrackfile,translation->gpx_name,query->quickest?translation->xml_route_quickest:translation->xml_route_shortest);
     fprintf(gpxtrackfile,"</name>\n");
     fprintf(gpxtrackfile,"<desc>");
-    fprintf(gpxtrackfile,translate_gpx_desc,option_quickest?translate_xml_route_quickest:translate_xml_route_shortest);
+    fprintf(gpxtrackfile,translation->gpx_desc,query->quickest?translation->xml_route_quickest:translation->xml_route_shortest);
     fprintf(gpxtrackfile,"</desc>\n");
    }
 
@@ -246,13 +227,13 @@ void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,W
     fprintf(gpxroutefile,"<gpx version=\"1.1\" creator=\"Routino\" xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" xmlns=\"http://www.topografix.com/GPX/1/1\" xsi:schemaLocation=\"http://www.topografix.com/GPX/1/1 http://www.topografix.com/GPX/1/1/gpx.xsd\">\n");
 
     fprintf(gpxroutefile,"<metadata>\n");
-    fprintf(gpxroutefile,"<desc>%s : %s</desc>\n",translate_xml_copyright_creator[0],translate_xml_copyright_creator[1]);
-    if(translate_xml_copyright_source[1])
+    fprintf(gpxroutefile,"<desc>%s : %s</desc>\n",translation->xml_copyright_creator[0],translation->xml_copyright_creator[1]);
+    if(translation->xml_copyright_source[1])
       {
-       fprintf(gpxroutefile,"<copyright author=\"%s\">\n",translate_xml_copyright_source[1]);
+       fprintf(gpxroutefile,"<copyright author=\"%s\">\n",translation->xml_copyright_source[1]);
 
-       if(translate_xml_copyright_license[1])
-          fprintf(gpxroutefile,"<license>%s</license>\n",translate_xml_copyright_license[1]);
+       if(translation->xml_copyright_license[1])
+          fprintf(gpxroutefile,"<license>%s</license>\n",translation->xml_copyright_license[1]);
 
        fprintf(gpxroutefile,"</copyright>\n");
       }
@@ -260,24 +241,24 @@ void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,W
 
     fprintf(gpxroutefile,"<rte>\n");
     fprintf(gpxroutefile,"<name>");
-    fprintf(gpxroutefile,translate_gpx_name,option_quickest?translate_xml_route_quickest:translate_xml_route_shortest);
+    fprintf(gpxroutefile,translation->gpx_name,query->quickest?translation->xml_route_quickest:translation->xml_route_shortest);
     fprintf(gpxroutefile,"</name>\n");
     fprintf(gpxroutefile,"<desc>");
-    fprintf(gpxroutefile,translate_gpx_desc,option_quickest?translate_xml_route_quickest:translate_xml_route_shortest);
+    fprintf(gpxroutefile,translation->gpx_desc,query->quickest?translation->xml_route_quickest:translation->xml_route_shortest);
     fprintf(gpxroutefile,"</desc>\n");
    }
 
  if(textfile)
    {
-    if(translate_raw_copyright_creator[0] && translate_raw_copyright_creator[1])
-       fprintf(textfile,"# %s : %s\n",translate_raw_copyright_creator[0],translate_raw_copyright_creator[1]);
-    if(translate_raw_copyright_source[0] && translate_raw_copyright_source[1])
-       fprintf(textfile,"# %s : %s\n",translate_raw_copyright_source[0],translate_raw_copyright_source[1]);
-    if(translate_raw_copyright_license[0] && translate_raw_copyright_license[1])
-       fprintf(textfile,"# %s : %s\n",translate_raw_copyright_license[0],translate_raw_copyright_license[1]);
-    if((translate_raw_copyright_creator[0] && translate_raw_copyright_creator[1]) ||
-       (translate_raw_copyright_source[0]  && translate_raw_copyright_source[1]) ||
-       (translate_raw_copyright_license[0] && translate_raw_copyright_license[1]))
+    if(translation->raw_copyright_creator[0] && translation->raw_copyright_creator[1])
+       fprintf(textfile,"# %s : %s\n",translation->raw_copyright_creator[0],translation->raw_copyright_creator[1]);
+    if(translation->raw_copyright_source[0] && translation->raw_copyright_source[1])
+       fprintf(textfile,"# %s : %s\n",translation->raw_copyright_source[0],translation->raw_copyright_source[1]);
+    if(translation->raw_copyright_license[0] && translation->raw_copyright_license[1])
+       fprintf(textfile,"# %s : %s\n",translation->raw_copyright_license[0],translation->raw_copyright_license[1]);
+    if((translation->raw_copyright_creator[0] && translation->raw_copyright_creator[1]) ||
+       (translation->raw_copyright_source[0]  && translation->raw_copyright_source[1]) ||
+       (translation->raw_copyright_license[0] && translation->raw_copyright_license[1]))
        fprintf(textfile,"#\n");
 
     fprintf(textfile,"#Latitude\tLongitude\tSection \tSection \tTotal   \tTotal   \tPoint\tTurn\tBearing\tHighway\n");
@@ -287,15 +268,15 @@ void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,W
 
  if(textallfile)
    {
-    if(translate_raw_copyright_creator[0] && translate_raw_copyright_creator[1])
-       fprintf(textallfile,"# %s : %s\n",translate_raw_copyright_creator[0],translate_raw_copyright_creator[1]);
-    if(translate_raw_copyright_source[0] && translate_raw_copyright_source[1])
-       fprintf(textallfile,"# %s : %s\n",translate_raw_copyright_source[0],translate_raw_copyright_source[1]);
-    if(translate_raw_copyright_license[0] && translate_raw_copyright_license[1])
-       fprintf(textallfile,"# %s : %s\n",translate_raw_copyright_license[0],translate_raw_copyright_license[1]);
-    if((translate_raw_copyright_creator[0] && translate_raw_copyright_creator[1]) ||
-       (translate_raw_copyright_source[0]  && translate_raw_copyright_source[1]) ||
-       (translate_raw_copyright_license[0] && translate_raw_copyright_license[1]))
+    if(translation->raw_copyright_creator[0] && translation->raw_copyright_creator[1])
+       fprintf(textallfile,"# %s : %s\n",translation->raw_copyright_creator[0],translation->raw_copyright_creator[1]);
+    if(translation->raw_copyright_source[0] && translation->raw_copyright_source[1])
+       fprintf(textallfile,"# %s : %s\n",translation->raw_copyright_source[0],translation->raw_copyright_source[1]);
+    if(translation->raw_copyright_license[0] && translation->raw_copyright_license[1])
+       fprintf(textallfile,"# %s : %s\n",translation->raw_copyright_license[0],translation->raw_copyright_license[1]);
+    if((translation->raw_copyright_creator[0] && translation->raw_copyright_creator[1]) ||
+       (translation->raw_copyright_source[0]  && translation->raw_copyright_source[1]) ||
+       (translation->raw_copyright_license[0] && translation->raw_copyright_license[1]))
        fprintf(textallfile,"#\n");
 
     fprintf(textallfile,"#Latitude\tLongitude\t    Node\tType\tSegment\tSegment\tTotal\tTotal  \tSpeed\tBearing\tHighway\n");
@@ -344,7 +325,7 @@ void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,W
        /* Calculate the information about this point */
 
        if(IsFakeNode(result->node))
-          GetFakeLatLong(result->node,&latitude,&longitude);
+          GetFakeLatLong(query,result->node,&latitude,&longitude);
        else
           GetLatLong(nodes,result->node,&latitude,&longitude);
 
@@ -370,8 +351,8 @@ void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,W
          {
           if(IsFakeSegment(result->segment))
             {
-             resultsegmentp=LookupFakeSegment(result->segment);
-             realsegment=IndexRealSegment(result->segment);
+             resultsegmentp=LookupFakeSegment(query,result->segment);
+             realsegment=IndexRealSegment(query,result->segment);
             }
           else
             {
@@ -382,7 +363,7 @@ void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,W
           resultwayp=LookupWay(ways,resultsegmentp->way,1);
 
           seg_distance+=DISTANCE(resultsegmentp->distance);
-          seg_duration+=Duration(resultsegmentp,resultwayp,profile);
+          seg_duration+=Duration(resultsegmentp,profile);
 
           /* Calculate the cumulative distance/duration */
 
@@ -398,8 +379,8 @@ void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,W
          {
           if(IsFakeSegment(next_result->segment))
             {
-             next_resultsegmentp=LookupFakeSegment(next_result->segment);
-             next_realsegment=IndexRealSegment(next_result->segment);
+             next_resultsegmentp=LookupFakeSegment(query,next_result->segment);
+             next_realsegment=IndexRealSegment(query,next_result->segment);
             }
           else
             {
@@ -510,9 +491,9 @@ void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,W
          {
           waynameraw=WayName(ways,resultwayp);
           if(!*waynameraw)
-             waynameraw=translate_raw_highway[HIGHWAY(resultwayp->type)];
+             waynameraw=translation->raw_highway[HIGHWAY(resultwayp->type)];
 
-          bearing_int=(int)BearingAngle(nodes,resultsegmentp,result->node);
+          bearing_int=(int)BearingAngle(query,nodes,resultsegmentp,result->node);
 
           seg_speed=profile->speed[HIGHWAY(resultwayp->type)];
          }
@@ -521,23 +502,23 @@ void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,W
          {
           if(resultsegmentp && (htmlfile || textfile))
             {
-             turn_int=(int)TurnAngle(nodes,resultsegmentp,next_resultsegmentp,result->node);
-             turn=translate_xml_turn[((202+turn_int)/45)%8];
+             turn_int=(int)TurnAngle(query,nodes,resultsegmentp,next_resultsegmentp,result->node);
+             turn=translation->xml_turn[((202+turn_int)/45)%8];
             }
 
           if(gpxroutefile || htmlfile)
             {
              next_waynameraw=WayName(ways,next_resultwayp);
              if(!*next_waynameraw)
-                next_waynameraw=translate_raw_highway[HIGHWAY(next_resultwayp->type)];
+                next_waynameraw=translation->raw_highway[HIGHWAY(next_resultwayp->type)];
 
              next_wayname=ParseXML_Encode_Safe_XML(next_waynameraw);
             }
 
           if(htmlfile || gpxroutefile || textfile)
             {
-             next_bearing_int=(int)BearingAngle(nodes,next_resultsegmentp,next_result->node);
-             next_bearing=translate_xml_heading[(4+(22+next_bearing_int)/45)%8];
+             next_bearing_int=(int)BearingAngle(query,nodes,next_resultsegmentp,next_result->node);
+             next_bearing=translation->xml_heading[(4+(22+next_bearing_int)/45)%8];
             }
          }
 
@@ -550,21 +531,21 @@ void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,W
              char *type;
 
              if(important==IMP_WAYPOINT)
-                type=translate_html_waypoint;
+                type=translation->html_waypoint;
              else if(important==IMP_MINI_RB)
-                type=translate_html_roundabout;
+                type=translation->html_roundabout;
              else
-                type=translate_html_junction;
+                type=translation->html_junction;
 
              if(point_count>0)  /* not the first point */
                {
                 /* <tr class='s'><td class='l'>Follow:<td class='r'><span class='h'>*highway name*</span> for <span class='d'>*distance* km, *time* min</span> [<span class='j'>*distance* km, *time* minutes</span>] */
-                fprintf(htmlfile,"<tr class='s'><td class='l'>%s:<td class='r'>",translate_html_segment[0]);
-                fprintf(htmlfile,translate_html_segment[1],
-                                 (roundabout>1?translate_html_roundabout:prev_wayname),
+                fprintf(htmlfile,"<tr class='s'><td class='l'>%s:<td class='r'>",translation->html_segment[0]);
+                fprintf(htmlfile,translation->html_segment[1],
+                                 (roundabout>1?translation->html_roundabout:prev_wayname),
                                  distance_to_km(junc_distance),duration_to_minutes(junc_duration));
                 fprintf(htmlfile," [<span class='j'>");
-                fprintf(htmlfile,translate_html_total[1],
+                fprintf(htmlfile,translation->html_total[1],
                                  distance_to_km(cum_distance),duration_to_minutes(cum_duration));
                 fprintf(htmlfile,"</span>]\n");
                }
@@ -577,9 +558,9 @@ void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,W
              if(point_count==0) /* first point */
                {
                 /* <tr class='n'><td class='l'>Start:<td class='r'>At <span class='w'>Waypoint</span>, head <span class='b'>*heading*</span> */
-                fprintf(htmlfile,"<tr class='n'><td class='l'>%s:<td class='r'>",translate_html_start[0]);
-                fprintf(htmlfile,translate_html_start[1],
-                                 translate_html_waypoint,
+                fprintf(htmlfile,"<tr class='n'><td class='l'>%s:<td class='r'>",translation->html_start[0]);
+                fprintf(htmlfile,translation->html_start[1],
+                                 translation->html_waypoint,
                                  next_bearing);
                 fprintf(htmlfile,"\n");
                }
@@ -588,18 +569,18 @@ void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,W
                 if(roundabout>1)
                   {
                    /* <tr class='n'><td class='l'>At:<td class='r'>Roundabout, take <span class='t'>the *Nth* exit</span> heading <span class='b'>*heading*</span> */
-                   fprintf(htmlfile,"<tr class='n'><td class='l'>%s:<td class='r'>",translate_html_rbnode[0]);
-                   fprintf(htmlfile,translate_html_rbnode[1],
-                                    translate_html_roundabout,
-                                    translate_xml_ordinal[roundabout-2],
+                   fprintf(htmlfile,"<tr class='n'><td class='l'>%s:<td class='r'>",translation->html_rbnode[0]);
+                   fprintf(htmlfile,translation->html_rbnode[1],
+                                    translation->html_roundabout,
+                                    translation->xml_ordinal[roundabout-2],
                                     next_bearing);
                    fprintf(htmlfile,"\n");
                   }
                 else
                   {
                    /* <tr class='n'><td class='l'>At:<td class='r'>Junction, go <span class='t'>*direction*</span> heading <span class='b'>*heading*</span> */
-                   fprintf(htmlfile,"<tr class='n'><td class='l'>%s:<td class='r'>",translate_html_node[0]);
-                   fprintf(htmlfile,translate_html_node[1],
+                   fprintf(htmlfile,"<tr class='n'><td class='l'>%s:<td class='r'>",translation->html_node[0]);
+                   fprintf(htmlfile,translation->html_node[1],
                                     type,
                                     turn,
                                     next_bearing);
@@ -609,14 +590,14 @@ void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,W
              else            /* end point */
                {
                 /* <tr class='n'><td class='l'>Stop:<td class='r'>At <span class='w'>Waypoint</span> */
-                fprintf(htmlfile,"<tr class='n'><td class='l'>%s:<td class='r'>",translate_html_stop[0]);
-                fprintf(htmlfile,translate_html_stop[1],
-                                 translate_html_waypoint);
+                fprintf(htmlfile,"<tr class='n'><td class='l'>%s:<td class='r'>",translation->html_stop[0]);
+                fprintf(htmlfile,translation->html_stop[1],
+                                 translation->html_waypoint);
                 fprintf(htmlfile,"\n");
 
                 /* <tr class='t'><td class='l'>Total:<td class='r'><span class='j'>*distance* km, *time* minutes</span> */
-                fprintf(htmlfile,"<tr class='t'><td class='l'>%s:<td class='r'><span class='j'>",translate_html_total[0]);
-                fprintf(htmlfile,translate_html_total[1],
+                fprintf(htmlfile,"<tr class='t'><td class='l'>%s:<td class='r'><span class='j'>",translation->html_total[0]);
+                fprintf(htmlfile,translation->html_total[1],
                                  distance_to_km(cum_distance),duration_to_minutes(cum_duration));
                 fprintf(htmlfile,"</span>\n");
                }
@@ -627,7 +608,7 @@ void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,W
              if(point_count>0) /* not first point */
                {
                 fprintf(gpxroutefile,"<desc>");
-                fprintf(gpxroutefile,translate_gpx_step,
+                fprintf(gpxroutefile,translation->gpx_step,
                                      prev_bearing,
                                      prev_wayname,
                                      distance_to_km(junc_distance),duration_to_minutes(junc_duration));
@@ -638,15 +619,15 @@ void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,W
                {
                 fprintf(gpxroutefile,"<rtept lat=\"%.6f\" lon=\"%.6f\"><name>%s</name>\n",
                                      radians_to_degrees(latitude),radians_to_degrees(longitude),
-                                     translate_gpx_start);
+                                     translation->gpx_start);
                }
              else if(!next_result) /* end point */
                {
                 fprintf(gpxroutefile,"<rtept lat=\"%.6f\" lon=\"%.6f\"><name>%s</name>\n",
                                      radians_to_degrees(latitude),radians_to_degrees(longitude),
-                                     translate_gpx_finish);
+                                     translation->gpx_finish);
                 fprintf(gpxroutefile,"<desc>");
-                fprintf(gpxroutefile,translate_gpx_final,
+                fprintf(gpxroutefile,translation->gpx_final,
                                      distance_to_km(cum_distance),duration_to_minutes(cum_duration));
                 fprintf(gpxroutefile,"</desc></rtept>\n");
                }
@@ -655,11 +636,11 @@ void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,W
                 if(important==IMP_WAYPOINT)
                    fprintf(gpxroutefile,"<rtept lat=\"%.6f\" lon=\"%.6f\"><name>%s%d</name>\n",
                                         radians_to_degrees(latitude),radians_to_degrees(longitude),
-                                        translate_gpx_inter,++segment_count);
+                                        translation->gpx_inter,++segment_count);
                 else
                    fprintf(gpxroutefile,"<rtept lat=\"%.6f\" lon=\"%.6f\"><name>%s%03d</name>\n",
                                         radians_to_degrees(latitude),radians_to_degrees(longitude),
-                                        translate_gpx_trip,++route_count);
+                                        translation->gpx_trip,++route_count);
                }
             }
 
@@ -800,18 +781,18 @@ void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,W
    {
     fprintf(htmlfile,"</table>\n");
 
-    if((translate_xml_copyright_creator[0] && translate_xml_copyright_creator[1]) ||
-       (translate_xml_copyright_source[0]  && translate_xml_copyright_source[1]) ||
-       (translate_xml_copyright_license[0] && translate_xml_copyright_license[1]))
+    if((translation->xml_copyright_creator[0] && translation->xml_copyright_creator[1]) ||
+       (translation->xml_copyright_source[0]  && translation->xml_copyright_source[1]) ||
+       (translation->xml_copyright_license[0] && translation->xml_copyright_license[1]))
       {
        fprintf(htmlfile,"<p>\n");
        fprintf(htmlfile,"<table class='c'>\n");
-       if(translate_xml_copyright_creator[0] && translate_xml_copyright_creator[1])
-          fprintf(htmlfile,"<tr><td class='l'>%s:<td class='r'>%s\n",translate_xml_copyright_creator[0],translate_xml_copyright_creator[1]);
-       if(translate_xml_copyright_source[0] && translate_xml_copyright_source[1])
-          fprintf(htmlfile,"<tr><td class='l'>%s:<td class='r'>%s\n",translate_xml_copyright_source[0],translate_xml_copyright_source[1]);
-       if(translate_xml_copyright_license[0] && translate_xml_copyright_license[1])
-          fprintf(htmlfile,"<tr><td class='l'>%s:<td class='r'>%s\n",translate_xml_copyright_license[0],translate_xml_copyright_license[1]);
+       if(translation->xml_copyright_creator[0] && translation->xml_copyright_creator[1])
+          fprintf(htmlfile,"<tr><td class='l'>%s:<td class='r'>%s\n",translation->xml_copyright_creator[0],translation->xml_copyright_creator[1]);
+       if(translation->xml_copyright_source[0] && translation->xml_copyright_source[1])
+          fprintf(htmlfile,"<tr><td class='l'>%s:<td class='r'>%s\n",translation->xml_copyright_source[0],translation->xml_copyright_source[1]);
+       if(translation->xml_copyright_license[0] && translation->xml_copyright_license[1])
+          fprintf(htmlfile,"<tr><td class='l'>%s:<td class='r'>%s\n",translation->xml_copyright_license[0],translation->xml_copyright_license[1]);
        fprintf(htmlfile,"</table>\n");
       }
 
@@ -844,3 +825,553 @@ void PrintRoute(Results **results,int nresults,Nodes *nodes,Segments *segments,W
  if(textallfile)
     fclose(textallfile);
 }
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Calculate the totals for the optimum route between two nodes (without printing it).
+
+  Query *query The query that has been calculated.
+
+  Results **results The set of results to add up (some may be NULL - ignore them).
+
+  int nresults The number of results in the list.
+
+  Segments *segments The set of segments to use.
+
+  Ways *ways The set of ways to use.
+
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
+
+  distance_t *distance Returns the total distance.
+
+  duration_t *duration Returns the total duration.
+
+  double *ascent Returns the total ascent (in metres).
+
+  double *descent Returns the total descent (in metres).
+  ++++++++++++++++++++++++++++++++++++++*/
+
+void SummariseRoute(Query *query,Results **results,int nresults,Segments *segments,Ways *ways,Profile *profile,
+                    distance_t *distance,duration_t *duration,double *ascent,double *descent)
+{
+ int point;
+
+ *distance=0;
+ *duration=0;
+ *ascent=0;
+ *descent=0;
+
+ for(point=1;point<=nresults;point++)
+   {
+    Result *result;
+
+    if(!results[point])
+       continue;
+
+    result=FindResult(results[point],results[point]->start_node,results[point]->prev_segment);
+
+    for(result=result->next;result;result=result->next)
+      {
+       Segment *segmentp;
+
+       if(IsFakeSegment(result->segment))
+          segmentp=LookupFakeSegment(query,result->segment);
+       else
+          segmentp=LookupSegment(segments,result->segment,1);
+
+       *distance+=DISTANCE(segmentp->distance);
+       *duration+=Duration(segmentp,profile);
+
+       if(result->node==segmentp->node2)
+         {
+          *ascent +=SegmentAscent(segmentp);
+          *descent+=SegmentDescent(segmentp);
+         }
+       else
+         {
+          *ascent +=SegmentDescent(segmentp);
+          *descent+=SegmentAscent(segmentp);
+         }
+      }
+   }
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Print the nodes that can be reached from a start node and the boundary around them.
+
+  Query *query The query that has been calculated (the options, limits and translations to use).
+
+  Results *results The set of results from FindReachableNodes().
+
+  Nodes *nodes The set of nodes to use.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+void PrintReachable(Query *query,Results *results,Nodes *nodes)
+{
+ const Translation *translation=query->translation;
+ FILE *textfile=NULL,*textallfile=NULL;
+ Results *reached;
+ Result *result;
+ score_t max_score;
+ double max_ascent;
+ double start_lat,start_lon,coslat;
+ double sector_lat[NSECTORS],sector_lon[NSECTORS],sector_dist[NSECTORS];
+ int sector;
+
+ /* Open the files */
+
+ if(query->text)
+    textfile   =open_output(query,"reachable.txt");
+ if(query->text_all)
+    textallfile=open_output(query,"reachable-all.txt");
+
+ if(!textfile && !textallfile)
+    return;
+
+ /* Set up the limits in the same way as FindReachableNodes() */
+
+ if(query->reach_duration)
+    max_score=(score_t)query->reach_duration;
+ else
+    max_score=(score_t)query->reach_distance;
+
+ if(query->reach_ascent>0)
+    max_ascent=query->reach_ascent;
+ else
+    max_ascent=INF_SCORE;
+
+ if(IsFakeNode(results->start_node))
+    GetFakeLatLong(query,results->start_node,&start_lat,&start_lon);
+ else
+    GetLatLong(nodes,results->start_node,&start_lat,&start_lon);
+
+ coslat=cos(start_lat);
+
+ for(sector=0;sector<NSECTORS;sector++)
+    sector_dist[sector]=-1;
+
+ /* Find the best result for each node and the furthest point in each direction */
+
+ reached=NewResultsList(query->pool,1024);
+
+ result=FirstResult(results);
+
+ while(result)
+   {
+    double latitude,longitude,dlat,dlon,dist;
+
+    if(IsFakeNode(result->node))
+       GetFakeLatLong(query,result->node,&latitude,&longitude);
+    else
+       GetLatLong(nodes,result->node,&latitude,&longitude);
+
+    if(result->score<=max_score && result->ascent<=max_ascent)
+      {
+       Result *node=FindResult(reached,result->node,NO_SEGMENT);
+
+       if(!node)
+         {
+          node=InsertResult(reached,result->node,NO_SEGMENT);
+          node->score=result->score;
+          node->ascent=result->ascent;
+         }
+       else if(result->score<node->score)
+         {
+          node->score=result->score;
+          node->ascent=result->ascent;
+         }
+      }
+    else if(result->prev)
+      {
+       /* The limit was reached part of the way along the segment from the previous node */
+
+       Result *prev=result->prev;
+       double prev_lat,prev_lon,fraction=1;
+
+       if(IsFakeNode(prev->node))
+          GetFakeLatLong(query,prev->node,&prev_lat,&prev_lon);
+       else
+          GetLatLong(nodes,prev->node,&prev_lat,&prev_lon);
+
+       if(result->score>max_score)
+          fraction=(max_score-prev->score)/(result->score-prev->score);
+
+       if(result->ascent>max_ascent && (max_ascent-prev->ascent)/(result->ascent-prev->ascent)<fraction)
+          fraction=(max_ascent-prev->ascent)/(result->ascent-prev->ascent);
+
+       latitude =prev_lat+(latitude -prev_lat)*fraction;
+       longitude=prev_lon+(longitude-prev_lon)*fraction;
+      }
+
+    dlat=latitude-start_lat;
+    dlon=(longitude-start_lon)*coslat;
+
+    dist=dlat*dlat+dlon*dlon;
+
+    sector=(int)((atan2(dlon,dlat)+M_PI)*NSECTORS/(2*M_PI))%NSECTORS;
+
+    if(dist>sector_dist[sector])
+      {
+       sector_dist[sector]=dist;
+       sector_lat[sector]=latitude;
+       sector_lon[sector]=longitude;
+      }
+
+    result=NextResult(results,result);
+   }
+
+ /* Print the head of the files */
+
+ if(textfile)
+   {
+    if(translation->raw_copyright_creator[0] && translation->raw_copyright_creator[1])
+       fprintf(textfile,"# %s : %s\n",translation->raw_copyright_creator[0],translation->raw_copyright_creator[1]);
+    if(translation->raw_copyright_source[0] && translation->raw_copyright_source[1])
+       fprintf(textfile,"# %s : %s\n",translation->raw_copyright_source[0],translation->raw_copyright_source[1]);
+    if(translation->raw_copyright_license[0] && translation->raw_copyright_license[1])
+       fprintf(textfile,"# %s : %s\n",translation->raw_copyright_license[0],translation->raw_copyright_license[1]);
+    if((translation->raw_copyright_creator[0] && translation->raw_copyright_creator[1]) ||
+       (translation->raw_copyright_source[0]  && translation->raw_copyright_source[1]) ||
+       (translation->raw_copyright_license[0] && translation->raw_copyright_license[1]))
+       fprintf(textfile,"#\n");
+
+    fprintf(textfile,"#Latitude\tLongitude\n");
+                     /* "%10.6f\t%11.6f\n" */
+   }
+
+ if(textallfile)
+   {
+    if(translation->raw_copyright_creator[0] && translation->raw_copyright_creator[1])
+       fprintf(textallfile,"# %s : %s\n",translation->raw_copyright_creator[0],translation->raw_copyright_creator[1]);
+    if(translation->raw_copyright_source[0] && translation->raw_copyright_source[1])
+       fprintf(textallfile,"# %s : %s\n",translation->raw_copyright_source[0],translation->raw_copyright_source[1]);
+    if(translation->raw_copyright_license[0] && translation->raw_copyright_license[1])
+       fprintf(textallfile,"# %s : %s\n",translation->raw_copyright_license[0],translation->raw_copyright_license[1]);
+    if((translation->raw_copyright_creator[0] && translation->raw_copyright_creator[1]) ||
+       (translation->raw_copyright_source[0]  && translation->raw_copyright_source[1]) ||
+       (translation->raw_copyright_license[0] && translation->raw_copyright_license[1]))
+       fprintf(textallfile,"#\n");
+
+    if(query->reach_duration)
+      {
+       fprintf(textallfile,"#Latitude\tLongitude\t    Node\tDuration\tAscent\n");
+       fprintf(textallfile,"#        \t         \t        \t(min)   \t(m)\n");
+      }
+    else
+      {
+       fprintf(textallfile,"#Latitude\tLongitude\t    Node\tDistance\tAscent\n");
+       fprintf(textallfile,"#        \t         \t        \t(km)    \t(m)\n");
+      }
+                        /* "%10.6f\t%11.6f\t%8d%c\t%5.3f\t%5.1f\n" */
+   }
+
+ /* Print the boundary, the furthest point in each direction as a closed polygon */
+
+ if(textfile)
+   {
+    int first=-1;
+
+    for(sector=0;sector<NSECTORS;sector++)
+       if(sector_dist[sector]>0)
+         {
+          fprintf(textfile,"%10.6f\t%11.6f\n",radians_to_degrees(sector_lat[sector]),radians_to_degrees(sector_lon[sector]));
+
+          if(first<0)
+             first=sector;
+         }
+
+    if(first>=0)
+       fprintf(textfile,"%10.6f\t%11.6f\n",radians_to_degrees(sector_lat[first]),radians_to_degrees(sector_lon[first]));
+   }
+
+ /* Print the reachable nodes */
+
+ if(textallfile)
+   {
+    result=FirstResult(reached);
+
+    while(result)
+      {
+       double latitude,longitude;
+       Node *resultnodep=NULL;
+
+       if(IsFakeNode(result->node))
+          GetFakeLatLong(query,result->node,&latitude,&longitude);
+       else
+         {
+          resultnodep=LookupNode(nodes,result->node,1);
+
+          GetLatLong(nodes,result->node,&latitude,&longitude);
+         }
+
+       fprintf(textallfile,"%10.6f\t%11.6f\t%8d%c\t%5.3f\t%5.1f\n",
+                           radians_to_degrees(latitude),radians_to_degrees(longitude),
+                           IsFakeNode(result->node)?(NODE_FAKE-result->node):result->node,
+                           (resultnodep && IsSuperNode(resultnodep))?'*':' ',
+                           query->reach_duration?duration_to_minutes(result->score):distance_to_km(result->score),
+                           result->ascent);
+
+       result=NextResult(reached,result);
+      }
+   }
+
+ FreeResultsList(reached);
+
+ /* Close the files */
+
+ if(textfile)
+    fclose(textfile);
+ if(textallfile)
+    fclose(textallfile);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Print the routes that trade off the duration against the ascent, a summary of each route and
+  all of the points along them.
+
+  Query *query The query that has been calculated (the options and translations to use).
+
+  Results **routes The routes from FindParetoRoutes() (routes[1] to routes[n]).
+
+  int nroutes The number of routes.
+
+  Nodes *nodes The set of nodes to use.
+
+  Segments *segments The set of segments to use.
+
+  Ways *ways The set of ways to use.
+
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+void PrintPareto(Query *query,Results **routes,int nroutes,Nodes *nodes,Segments *segments,Ways *ways,Profile *profile)
+{
+ const Translation *translation=query->translation;
+ FILE *textfile=NULL,*textallfile=NULL;
+ int route;
+
+ /* Open the files */
+
+ if(query->text)
+    textfile   =open_output(query,"pareto.txt");
+ if(query->text_all)
+    textallfile=open_output(query,"pareto-all.txt");
+
+ if(!textfile && !textallfile)
+    return;
+
+ /* Print the head of the files */
+
+ if(textfile)
+   {
+    if(translation->raw_copyright_creator[0] && translation->raw_copyright_creator[1])
+       fprintf(textfile,"# %s : %s\n",translation->raw_copyright_creator[0],translation->raw_copyright_creator[1]);
+    if(translation->raw_copyright_source[0] && translation->raw_copyright_source[1])
+       fprintf(textfile,"# %s : %s\n",translation->raw_copyright_source[0],translation->raw_copyright_source[1]);
+    if(translation->raw_copyright_license[0] && translation->raw_copyright_license[1])
+       fprintf(textfile,"# %s : %s\n",translation->raw_copyright_license[0],translation->raw_copyright_license[1]);
+    if((translation->raw_copyright_creator[0] && translation->raw_copyright_creator[1]) ||
+       (translation->raw_copyright_source[0]  && translation->raw_copyright_source[1]) ||
+       (translation->raw_copyright_license[0] && translation->raw_copyright_license[1]))
+       fprintf(textfile,"#\n");
+
+    fprintf(textfile,"#Route\tDistance\tDuration\tAscent\tDescent\n");
+    fprintf(textfile,"#     \t(km)    \t(min)   \t(m)   \t(m)\n");
+                     /* "%d\t%.3f\t%.2f\t%.1f\t%.1f\n" */
+   }
+
+ if(textallfile)
+   {
+    if(translation->raw_copyright_creator[0] && translation->raw_copyright_creator[1])
+       fprintf(textallfile,"# %s : %s\n",translation->raw_copyright_creator[0],translation->raw_copyright_creator[1]);
+    if(translation->raw_copyright_source[0] && translation->raw_copyright_source[1])
+       fprintf(textallfile,"# %s : %s\n",translation->raw_copyright_source[0],translation->raw_copyright_source[1]);
+    if(translation->raw_copyright_license[0] && translation->raw_copyright_license[1])
+       fprintf(textallfile,"# %s : %s\n",translation->raw_copyright_license[0],translation->raw_copyright_license[1]);
+    if((translation->raw_copyright_creator[0] && translation->raw_copyright_creator[1]) ||
+       (translation->raw_copyright_source[0]  && translation->raw_copyright_source[1]) ||
+       (translation->raw_copyright_license[0] && translation->raw_copyright_license[1]))
+       fprintf(textallfile,"#\n");
+
+    fprintf(textallfile,"#Route\tLatitude\tLongitude\t    Node\tDistance\tDuration\tAscent\n");
+    fprintf(textallfile,"#     \t        \t         \t        \t(km)    \t(min)   \t(m)\n");
+                        /* "%d\t%10.6f\t%11.6f\t%8d%c\t%5.3f\t%5.2f\t%5.1f\n" */
+   }
+
+ /* Print each of the routes */
+
+ for(route=1;route<=nroutes;route++)
+   {
+    Result *first=FindResult(routes[route],routes[route]->start_node,routes[route]->prev_segment);
+    Result *result;
+    distance_t distance=0;
+    duration_t duration=0;
+    double ascent=0,descent=0;
+
+    for(result=first;result;result=result->next)
+      {
+       if(result!=first)
+         {
+          Segment *segmentp;
+
+          if(IsFakeSegment(result->segment))
+             segmentp=LookupFakeSegment(query,result->segment);
+          else
+             segmentp=LookupSegment(segments,result->segment,1);
+
+          distance+=DISTANCE(segmentp->distance);
+          duration+=Duration(segmentp,profile);
+
+          if(result->node==segmentp->node2)
+            {
+             ascent +=SegmentAscent(segmentp);
+             descent+=SegmentDescent(segmentp);
+            }
+          else
+            {
+             ascent +=SegmentDescent(segmentp);
+             descent+=SegmentAscent(segmentp);
+            }
+         }
+
+       if(textallfile)
+         {
+          double latitude,longitude;
+          Node *resultnodep=NULL;
+
+          if(IsFakeNode(result->node))
+             GetFakeLatLong(query,result->node,&latitude,&longitude);
+          else
+            {
+             resultnodep=LookupNode(nodes,result->node,1);
+
+             GetLatLong(nodes,result->node,&latitude,&longitude);
+            }
+
+          fprintf(textallfile,"%d\t%10.6f\t%11.6f\t%8d%c\t%5.3f\t%5.2f\t%5.1f\n",
+                              route,radians_to_degrees(latitude),radians_to_degrees(longitude),
+                              IsFakeNode(result->node)?(NODE_FAKE-result->node):result->node,
+                              (resultnodep && IsSuperNode(resultnodep))?'*':' ',
+                              distance_to_km(distance),duration_to_minutes(duration),ascent);
+         }
+      }
+
+    if(textfile)
+       fprintf(textfile,"%d\t%.3f\t%.2f\t%.1f\t%.1f\n",
+                        route,distance_to_km(distance),duration_to_minutes(duration),ascent,descent);
+   }
+
+ /* Close the files */
+
+ if(textfile)
+    fclose(textfile);
+ if(textallfile)
+    fclose(textallfile);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Open one of the output files (or a memory buffer for it).
+
+  FILE *open_output Returns the opened file or NULL in case of error.
+
+  Query *query The query that the output belongs to.
+
+  const char *filename The name of the file.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static FILE *open_output(Query *query,const char *filename)
+{
+ FILE *file;
+
+ if(query->memory)
+   {
+    if(query->noutputs==NOUTPUTS)
+       return(NULL);
+
+    query->output_name[query->noutputs]=strcpy((char*)malloc(strlen(filename)+1),filename);
+    query->output_data[query->noutputs]=NULL;
+    query->output_size[query->noutputs]=0;
+
+    file=open_memstream(&query->output_data[query->noutputs],&query->output_size[query->noutputs]);
+
+    if(file)
+       query->noutputs++;
+    else
+       free(query->output_name[query->noutputs]);
+   }
+ else
+    file=fopen(filename,"w");
+
+ if(!file)
+    fprintf(stderr,"Warning: Cannot open file '%s' for writing [%s].\n",filename,strerror(errno));
+
+ return(file);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Select if the output is kept in memory instead of being written to files.
+
+  Query *query The query that the output belongs to.
+
+  int memory True to keep the output in memory (see GetOutputMemory()).
+  ++++++++++++++++++++++++++++++++++++++*/
+
+void SetOutputMemory(Query *query,int memory)
+{
+ FreeOutputMemory(query);
+
+ query->memory=memory;
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Get one of the outputs kept in memory by the last call to PrintRoute().
+
+  int GetOutputMemory Returns true if there is such an output.
+
+  Query *query The query that the output belongs to.
+
+  int n The number of the output (starting at 0).
+
+  const char **filename Returns the name of the file that would have been written.
+
+  const char **data Returns the contents of the output.
+
+  size_t *size Returns the size of the output.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+int GetOutputMemory(Query *query,int n,const char **filename,const char **data,size_t *size)
+{
+ if(n<0 || n>=query->noutputs)
+    return(0);
+
+ *filename=query->output_name[n];
+ *data=query->output_data[n];
+ *size=query->output_size[n];
+
+ return(1);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Free the outputs kept in memory.
+
+  Query *query The query that the output belongs to.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+void FreeOutputMemory(Query *query)
+{
+ int n;
+
+ for(n=0;n<query->noutputs;n++)
+   {
+    free(query->output_name[n]);
+    free(query->output_data[n]);
+   }
+
+ query->noutputs=0;
+}
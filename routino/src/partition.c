@@ -0,0 +1,831 @@
+/***************************************
+ Partition data type and customisation functions.
+
+ Part of the Routino routing software.
+ ******************/ /******************
+ This file Copyright 2026 Routino contributors
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Affero General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Affero General Public License for more details.
+
+ You should have received a copy of the GNU Affero General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ***************************************/
+
+
+#include <stdlib.h>
+
+#if defined(USE_PTHREADS) && USE_PTHREADS
+#include <pthread.h>
+#endif
+
+#include "types.h"
+#include "nodes.h"
+#include "segments.h"
+#include "ways.h"
+#include "partition.h"
+
+#include "files.h"
+#include "logging.h"
+#include "results.h"
+
+
+/* Global variables */
+
+/*+ Set to only print the errors. +*/
+extern int option_quiet;
+
+
+/* Local functions */
+
+static score_t SegmentScore(Ways *ways,Segment *segmentp,Profile *profile,int quickest);
+static score_t ChainScore(Nodes *nodes,Segments *segments,Ways *ways,Profile *profile,int quickest,index_t node1,index_t node2);
+
+static Results *CellSearch(Partition *partition,Customisation *customisation,Nodes *nodes,Segments *segments,Profile *profile,
+                           index_t start,index_t finish);
+
+static void release_customisation(Customisation *customisation);
+
+
+/* Local variables */
+
+#if defined(USE_PTHREADS) && USE_PTHREADS
+
+/*+ The mutex for the scores (routes can be calculated in several threads). +*/
+static pthread_mutex_t customised_mutex=PTHREAD_MUTEX_INITIALIZER;
+
+#endif
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Load in a partition from a file.
+
+  Partition *LoadPartition Returns the partition.
+
+  const char *filename The name of the file to load.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+Partition *LoadPartition(const char *filename)
+{
+ Partition *partition;
+ int i;
+
+ partition=(Partition*)malloc(sizeof(Partition));
+
+#if !SLIM
+
+ partition->data=MapFile(filename);
+
+ /* Copy the PartitionFile header structure from the loaded data */
+
+ partition->file=*((PartitionFile*)partition->data);
+
+ /* Set the pointers in the Partition structure. */
+
+ partition->nodes        =(index_t*)(partition->data+sizeof(PartitionFile));
+ partition->cells        =partition->nodes+partition->file.number;
+ partition->firstboundary=partition->cells+partition->file.number;
+ partition->boundary     =partition->firstboundary+partition->file.ncells+1;
+
+#else
+
+ partition->fd=ReOpenFile(filename);
+
+ /* Copy the PartitionFile header structure from the loaded data */
+
+ ReadFile(partition->fd,&partition->file,sizeof(PartitionFile));
+
+ /* The super-nodes and cells are used at every step of the searches so read them into memory */
+
+ partition->nodes=(index_t*)malloc(partition->file.number*sizeof(index_t));
+ partition->cells=(index_t*)malloc(partition->file.number*sizeof(index_t));
+
+ logassert(partition->nodes && partition->cells,"Failed to allocate memory"); /* Check malloc() worked */
+
+ ReadFile(partition->fd,partition->nodes,partition->file.number*sizeof(index_t));
+ ReadFile(partition->fd,partition->cells,partition->file.number*sizeof(index_t));
+
+ partition->firstoffset   =sizeof(PartitionFile)+2*partition->file.number*sizeof(index_t);
+ partition->boundaryoffset=partition->firstoffset+(partition->file.ncells+1)*sizeof(index_t);
+
+ partition->ncached=0;
+ partition->cached=NULL;
+
+#endif
+
+ for(i=0;i<CUSTOMISATIONS;i++)
+    partition->customised[i]=NULL;
+
+ partition->customised_clock=0;
+
+ return(partition);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Find the position of a super-node in the partition.
+
+  index_t FindPartitionNode Returns the position in the list of super-nodes or NO_NODE if it is not in the partition.
+
+  Partition *partition The partition to use.
+
+  index_t node The node to look for.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+index_t FindPartitionNode(Partition *partition,index_t node)
+{
+ index_t start=0;
+ index_t end=partition->file.number;
+
+ /* Binary search - the list is in index order */
+
+ while(start<end)
+   {
+    index_t mid=start+(end-start)/2;
+
+    if(LookupPartitionNode(partition,mid)<node)
+       start=mid+1;
+    else
+       end=mid;
+   }
+
+ if(start<partition->file.number && LookupPartitionNode(partition,start)==node)
+    return(start);
+ else
+    return(NO_NODE);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Find the super-nodes on the boundary of a cell (those with a super-segment to another cell).
+
+  index_t *LookupPartitionBoundary Returns a pointer to the positions of the super-nodes (in slim mode only valid until the next call).
+
+  Partition *partition The partition to use.
+
+  index_t cell The cell.
+
+  index_t *number Returns the number of super-nodes.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+index_t *LookupPartitionBoundary(Partition *partition,index_t cell,index_t *number)
+{
+#if !SLIM
+
+ *number=partition->firstboundary[cell+1]-partition->firstboundary[cell];
+
+ return(&partition->boundary[partition->firstboundary[cell]]);
+
+#else
+
+ index_t first[2];
+
+ SeekReadFile(partition->fd,first,2*sizeof(index_t),partition->firstoffset+(off_t)cell*sizeof(index_t));
+
+ *number=first[1]-first[0];
+
+ if(*number>partition->ncached)
+   {
+    partition->ncached=*number;
+    partition->cached=(index_t*)realloc(partition->cached,partition->ncached*sizeof(index_t));
+
+    logassert(partition->cached,"Failed to allocate memory"); /* Check realloc() worked */
+   }
+
+ if(*number)
+    SeekReadFile(partition->fd,partition->cached,*number*sizeof(index_t),partition->boundaryoffset+(off_t)first[0]*sizeof(index_t));
+
+ return(partition->cached);
+
+#endif
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Find the position of a super-node in the list of boundary super-nodes of its cell.
+
+  index_t FindBoundaryPosition Returns the position in the list or NO_NODE if it is not on the boundary.
+
+  Partition *partition The partition to use.
+
+  index_t cell The cell that the super-node is in.
+
+  index_t index The position of the super-node in the list of all super-nodes.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+index_t FindBoundaryPosition(Partition *partition,index_t cell,index_t index)
+{
+ index_t *boundary,number;
+ index_t start=0,end;
+
+ boundary=LookupPartitionBoundary(partition,cell,&number);
+
+ end=number;
+
+ /* Binary search - the list is in position order */
+
+ while(start<end)
+   {
+    index_t mid=start+(end-start)/2;
+
+    if(boundary[mid]<index)
+       start=mid+1;
+    else
+       end=mid;
+   }
+
+ if(start<number && boundary[start]==index)
+    return(start);
+ else
+    return(NO_NODE);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Calculate the scores for a profile (or find the ones already calculated), the score for each
+  super-segment is the sum of the scores of the segments that it replaces and the scores between
+  the boundary super-nodes of each cell are from a search of the super-segments inside the cell.
+
+  Customisation *CustomisePartition Returns the scores for the profile.
+
+  Partition *partition The partition to use.
+
+  Nodes *nodes The set of nodes to use.
+
+  Segments *segments The set of segments to use.
+
+  Ways *ways The set of ways to use.
+
+  Profile *profile The profile to calculate the scores for (already updated).
+
+  int quickest Set to calculate the scores for the quickest route instead of the shortest.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+Customisation *CustomisePartition(Partition *partition,Nodes *nodes,Segments *segments,Ways *ways,Profile *profile,int quickest)
+{
+ Customisation *customisation,**replace;
+ index_t i,j,k,ncliques=0;
+ int c;
+
+ /* Use the scores that were calculated before if they are still kept */
+
+#if defined(USE_PTHREADS) && USE_PTHREADS
+ pthread_mutex_lock(&customised_mutex);
+#endif
+
+ for(c=0;c<CUSTOMISATIONS;c++)
+    if(partition->customised[c] && partition->customised[c]->quickest==quickest &&
+       SameProfileScores(&partition->customised[c]->profile,profile,quickest))
+      {
+       customisation=partition->customised[c];
+
+       customisation->users++;
+       customisation->used=++partition->customised_clock;
+
+#if defined(USE_PTHREADS) && USE_PTHREADS
+       pthread_mutex_unlock(&customised_mutex);
+#endif
+
+       return(customisation);
+      }
+
+ if(!option_quiet)
+    printf_first("Customising Partition: Super-Nodes=0");
+
+ customisation=(Customisation*)malloc(sizeof(Customisation));
+
+ logassert(customisation,"Failed to allocate memory"); /* Check malloc() worked */
+
+ customisation->profile=*profile;
+ customisation->profile.name=NULL;
+ customisation->quickest=quickest;
+
+ /* The scores of the super-segments */
+
+ customisation->scores=(score_t*)malloc(segments->file.number*sizeof(score_t));
+
+ logassert(customisation->scores,"Failed to allocate memory (try using slim mode?)"); /* Check malloc() worked */
+
+ for(i=0;i<segments->file.number;i++)
+    customisation->scores[i]=INF_SCORE;
+
+ for(i=0;i<partition->file.number;i++)
+   {
+    index_t node1=LookupPartitionNode(partition,i);
+    Segment *segmentp=FirstSegment(segments,LookupNode(nodes,node1,1),1);
+
+    while(segmentp)
+      {
+       if(IsSuperSegment(segmentp) && segmentp->node1==node1)
+         {
+          index_t seg=IndexSegment(segments,segmentp);
+
+          /* the scores are the same in both directions so use the one that is allowed */
+
+          if(IsNormalSegment(segmentp))
+             customisation->scores[seg]=SegmentScore(ways,segmentp,profile,quickest);
+          else if(IsOnewayTo(segmentp,node1))
+             customisation->scores[seg]=ChainScore(nodes,segments,ways,profile,quickest,segmentp->node2,node1);
+          else
+             customisation->scores[seg]=ChainScore(nodes,segments,ways,profile,quickest,node1,segmentp->node2);
+         }
+
+       segmentp=NextSegment(segments,segmentp,node1);
+      }
+
+    if(!option_quiet && !((i+1)%10000))
+       printf_middle("Customising Partition: Super-Nodes=%"Pindex_t,i+1);
+   }
+
+ /* The scores between the boundary super-nodes of each cell */
+
+ customisation->firstclique=(index_t*)malloc((partition->file.ncells+1)*sizeof(index_t));
+
+ logassert(customisation->firstclique,"Failed to allocate memory (try using slim mode?)"); /* Check malloc() worked */
+
+ for(i=0;i<partition->file.ncells;i++)
+   {
+    index_t nboundary;
+
+    LookupPartitionBoundary(partition,i,&nboundary);
+
+    customisation->firstclique[i]=ncliques;
+
+    ncliques+=nboundary*nboundary;
+   }
+
+ customisation->firstclique[partition->file.ncells]=ncliques;
+
+ customisation->cliques=(score_t*)malloc((ncliques+1)*sizeof(score_t));
+
+ logassert(customisation->cliques,"Failed to allocate memory (try using slim mode?)"); /* Check malloc() worked */
+
+ for(i=0;i<partition->file.ncells;i++)
+   {
+    index_t *boundary,nboundary;
+
+    LookupPartitionBoundary(partition,i,&nboundary);
+
+    for(j=0;j<nboundary;j++)
+      {
+       Results *results;
+       index_t start;
+
+       boundary=LookupPartitionBoundary(partition,i,&nboundary);
+
+       start=boundary[j];
+
+       results=CellSearch(partition,customisation,nodes,segments,profile,start,NO_NODE);
+
+       boundary=LookupPartitionBoundary(partition,i,&nboundary);
+
+       for(k=0;k<nboundary;k++)
+         {
+          Result *result=FindResult(results,boundary[k],NO_SEGMENT);
+
+          CustomisedClique(customisation,i,nboundary,j,k)=result?result->score:INF_SCORE;
+         }
+
+       FreeResultsList(results);
+      }
+   }
+
+ /* Keep the scores in place of an unused slot or the least recently used scores */
+
+ customisation->users=2;
+ customisation->used=++partition->customised_clock;
+
+ replace=&partition->customised[0];
+
+ for(c=0;c<CUSTOMISATIONS;c++)
+    if(!partition->customised[c] || (*replace && partition->customised[c]->used<(*replace)->used))
+       replace=&partition->customised[c];
+
+ if(*replace)
+    release_customisation(*replace);
+
+ *replace=customisation;
+
+#if defined(USE_PTHREADS) && USE_PTHREADS
+ pthread_mutex_unlock(&customised_mutex);
+#endif
+
+ if(!option_quiet)
+    printf_last("Customised Partition: Super-Nodes=%"Pindex_t" Cells=%"Pindex_t,partition->file.number,partition->file.ncells);
+
+ return(customisation);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Release the scores that were returned by CustomisePartition() (they are freed when no route uses
+  them and they are no longer kept for the next route with the same profile).
+
+  Customisation *customisation The scores to release.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+void ReleaseCustomisation(Customisation *customisation)
+{
+ if(!customisation)
+    return;
+
+#if defined(USE_PTHREADS) && USE_PTHREADS
+ pthread_mutex_lock(&customised_mutex);
+#endif
+
+ release_customisation(customisation);
+
+#if defined(USE_PTHREADS) && USE_PTHREADS
+ pthread_mutex_unlock(&customised_mutex);
+#endif
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Stop using a set of scores and free them if they are not used any more (the mutex must be held).
+
+  Customisation *customisation The scores to release.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static void release_customisation(Customisation *customisation)
+{
+ if(--customisation->users>0)
+    return;
+
+ free(customisation->scores);
+ free(customisation->firstclique);
+ free(customisation->cliques);
+
+ free(customisation);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Find the super-segment with the best score that goes from one super-node to another.
+
+  index_t FindCustomisedSegment Returns the super-segment or NO_SEGMENT if there is none that can be used.
+
+  Partition *partition The partition to use.
+
+  Customisation *customisation The scores for the profile.
+
+  Nodes *nodes The set of nodes to use.
+
+  Segments *segments The set of segments to use.
+
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
+
+  index_t index1 The position of the super-node at the start.
+
+  index_t index2 The position of the super-node at the end.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+index_t FindCustomisedSegment(Partition *partition,Customisation *customisation,Nodes *nodes,Segments *segments,Profile *profile,
+                              index_t index1,index_t index2)
+{
+ index_t node1=LookupPartitionNode(partition,index1);
+ index_t node2=LookupPartitionNode(partition,index2);
+ index_t best=NO_SEGMENT;
+ Segment *segmentp;
+
+ segmentp=FirstSegment(segments,LookupNode(nodes,node1,1),1);
+
+ while(segmentp)
+   {
+    if(IsSuperSegment(segmentp) && OtherNode(segmentp,node1)==node2 &&
+       !(profile->oneway && IsOnewayTo(segmentp,node1)))
+      {
+       index_t seg=IndexSegment(segments,segmentp);
+
+       if(CustomisedScore(customisation,seg)!=INF_SCORE &&
+          (best==NO_SEGMENT || CustomisedScore(customisation,seg)<CustomisedScore(customisation,best)))
+          best=seg;
+      }
+
+    segmentp=NextSegment(segments,segmentp,node1);
+   }
+
+ return(best);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Replace the score between two boundary super-nodes of a cell with the super-segments inside the
+  cell that it was calculated from.
+
+  Partition *partition The partition to use.
+
+  Customisation *customisation The scores for the profile.
+
+  Nodes *nodes The set of nodes to use.
+
+  Segments *segments The set of segments to use.
+
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
+
+  index_t index1 The position of the super-node at the start.
+
+  index_t index2 The position of the super-node at the end.
+
+  index_t **path The super-segments (reallocated as more are added).
+
+  score_t **scores The scores of the super-segments (reallocated as more are added).
+
+  int *number The number of super-segments (updated).
+  ++++++++++++++++++++++++++++++++++++++*/
+
+void UnpackCustomisedClique(Partition *partition,Customisation *customisation,Nodes *nodes,Segments *segments,Profile *profile,
+                            index_t index1,index_t index2,index_t **path,score_t **scores,int *number)
+{
+ Results *results;
+ Result *result;
+ int n=0,i;
+
+ results=CellSearch(partition,customisation,nodes,segments,profile,index1,index2);
+
+ result=FindResult(results,index2,NO_SEGMENT);
+
+ logassert(result,"Missing route inside a cell of the partition (report a bug)");
+
+ /* Count the super-segments and then fill them in backwards from the end */
+
+ for(;result->prev;result=result->prev)
+    n++;
+
+ if(((*number+63)/64)*64<*number+n)
+   {
+    *path  =(index_t*)realloc(*path  ,((*number+n+63)/64)*64*sizeof(index_t));
+    *scores=(score_t*)realloc(*scores,((*number+n+63)/64)*64*sizeof(score_t));
+   }
+
+ for(i=n-1,result=FindResult(results,index2,NO_SEGMENT);result->prev;result=result->prev,i--)
+   {
+    index_t seg=FindCustomisedSegment(partition,customisation,nodes,segments,profile,result->prev->node,result->node);
+
+    (*path  )[*number+i]=seg;
+    (*scores)[*number+i]=CustomisedScore(customisation,seg);
+   }
+
+ *number+=n;
+
+ FreeResultsList(results);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Calculate the score of a segment for a profile.
+
+  score_t SegmentScore Returns the score or INF_SCORE if the profile cannot use the segment.
+
+  Ways *ways The set of ways to use.
+
+  Segment *segmentp The segment.
+
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
+
+  int quickest Set to calculate the score for the quickest route instead of the shortest.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static score_t SegmentScore(Ways *ways,Segment *segmentp,Profile *profile,int quickest)
+{
+ score_t segment_pref=profile->way_pref[segmentp->way];
+
+ /* profile must allow this highway (transport, restrictions, highway type and properties) */
+ if(segment_pref==0)
+    return(INF_SCORE);
+
+ if(quickest==0)
+    return((score_t)DISTANCE(segmentp->distance)/segment_pref);
+ else
+    return((score_t)Duration(segmentp,profile)/segment_pref);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Calculate the score of a super-segment from the segments that it replaces, these are found in
+  the same way as the router does when it replaces the super-segments in a route.
+
+  score_t ChainScore Returns the score or INF_SCORE if the profile cannot use one of the segments.
+
+  Nodes *nodes The set of nodes to use.
+
+  Segments *segments The set of segments to use.
+
+  Ways *ways The set of ways to use.
+
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
+
+  int quickest Set to calculate the score for the quickest route instead of the shortest.
+
+  index_t node1 The super-node at the start of the super-segment.
+
+  index_t node2 The super-node at the end of the super-segment.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static score_t ChainScore(Nodes *nodes,Segments *segments,Ways *ways,Profile *profile,int quickest,index_t node1,index_t node2)
+{
+ Results *results;
+ Queue   *queue;
+ Result  *result1,*result2,*best=NULL;
+ score_t  score=0;
+
+ /* The shortest route using only normal segments and not passing any other super-nodes (the
+    segment lookups use position 2 because the caller is using position 1) */
+
+ results=NewResultsList(NULL,8);
+ queue=NewQueueList(NULL);
+
+ result1=InsertResult(results,node1,NO_SEGMENT);
+
+ InsertInQueue(queue,result1);
+
+ while((result1=PopFromQueue(queue)))
+   {
+    Segment *segmentp;
+
+    if(result1->node==node2)
+      {
+       best=result1;
+       break;
+      }
+
+    segmentp=FirstSegment(segments,LookupNode(nodes,result1->node,2),2);
+
+    while(segmentp)
+      {
+       index_t othernode,seg;
+       score_t cumulative_score;
+
+       if(!IsNormalSegment(segmentp) || IsOnewayTo(segmentp,result1->node))
+          goto endloop;
+
+       seg=IndexSegment(segments,segmentp);
+
+       if(seg==result1->segment)
+          goto endloop;
+
+       othernode=OtherNode(segmentp,result1->node);
+
+       if(othernode!=node2 && IsSuperNode(LookupNode(nodes,othernode,3)))
+          goto endloop;
+
+       cumulative_score=result1->score+(score_t)DISTANCE(segmentp->distance);
+
+       result2=FindResult(results,othernode,seg);
+
+       if(!result2)
+          result2=InsertResult(results,othernode,seg);
+       else if(cumulative_score>=result2->score)
+          goto endloop;
+
+       result2->prev=result1;
+       result2->score=cumulative_score;
+       result2->sortby=cumulative_score;
+
+       InsertInQueue(queue,result2);
+
+      endloop:
+
+       segmentp=NextSegment(segments,segmentp,result1->node);
+      }
+   }
+
+ FreeQueueList(queue);
+
+ if(!best)
+    score=INF_SCORE;
+
+ /* Add up the scores of the segments */
+
+ for(;best && best->prev;best=best->prev)
+   {
+    score_t segment_score=SegmentScore(ways,LookupSegment(segments,best->segment,2),profile,quickest);
+
+    if(segment_score==INF_SCORE)
+      {
+       score=INF_SCORE;
+       break;
+      }
+
+    score+=segment_score;
+   }
+
+ FreeResultsList(results);
+
+ return(score);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Search the super-segments inside the cell that a super-node is in.
+
+  Results *CellSearch Returns the results (using the positions of the super-nodes and NO_SEGMENT).
+
+  Partition *partition The partition to use.
+
+  Customisation *customisation The scores for the profile.
+
+  Nodes *nodes The set of nodes to use.
+
+  Segments *segments The set of segments to use.
+
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
+
+  index_t start The position of the super-node to start at.
+
+  index_t finish The position of the super-node to stop at (or NO_NODE to search the whole cell).
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static Results *CellSearch(Partition *partition,Customisation *customisation,Nodes *nodes,Segments *segments,Profile *profile,
+                           index_t start,index_t finish)
+{
+ Results *results;
+ Queue   *queue;
+ Result  *result1,*result2;
+ index_t  cell=LookupPartitionCell(partition,start);
+
+ results=NewResultsList(NULL,64);
+ queue=NewQueueList(NULL);
+
+ result1=InsertResult(results,start,NO_SEGMENT);
+
+ /* mode of transport must be allowed through the start node */
+ if(LookupNode(nodes,LookupPartitionNode(partition,start),1)->allow&profile->allow)
+    InsertInQueue(queue,result1);
+
+ while((result1=PopFromQueue(queue)))
+   {
+    index_t node1=LookupPartitionNode(partition,result1->node);
+    Segment *segmentp;
+
+    if(result1->node==finish)
+       break;
+
+    segmentp=FirstSegment(segments,LookupNode(nodes,node1,1),1);
+
+    while(segmentp)
+      {
+       index_t node2,index2,seg;
+       score_t cumulative_score;
+
+       /* must be a super segment */
+       if(!IsSuperSegment(segmentp))
+          goto endloop;
+
+       /* must obey one-way restrictions (unless profile allows) */
+       if(profile->oneway && IsOnewayTo(segmentp,node1))
+          goto endloop;
+
+       seg=IndexSegment(segments,segmentp);
+
+       /* profile must allow the segments */
+       if(CustomisedScore(customisation,seg)==INF_SCORE)
+          goto endloop;
+
+       node2=OtherNode(segmentp,node1);
+
+       if(node2==node1)
+          goto endloop;
+
+       index2=FindPartitionNode(partition,node2);
+
+       /* must stay inside the cell */
+       if(index2==NO_NODE || LookupPartitionCell(partition,index2)!=cell)
+          goto endloop;
+
+       /* mode of transport must be allowed through node2 */
+       if(!(LookupNode(nodes,node2,2)->allow&profile->allow))
+          goto endloop;
+
+       cumulative_score=result1->score+CustomisedScore(customisation,seg);
+
+       result2=FindResult(results,index2,NO_SEGMENT);
+
+       if(!result2)
+          result2=InsertResult(results,index2,NO_SEGMENT);
+       else if(cumulative_score>=result2->score)
+          goto endloop;
+
+       result2->prev=result1;
+       result2->score=cumulative_score;
+       result2->sortby=cumulative_score;
+
+       InsertInQueue(queue,result2);
+
+      endloop:
+
+       segmentp=NextSegment(segments,segmentp,node1);
+      }
+   }
+
+ FreeQueueList(queue);
+
+ return(results);
+}
@@ -0,0 +1,138 @@
+/***************************************
+ A header file for the partition of the super-nodes into cells.
+
+ Part of the Routino routing software.
+ ******************/ /******************
+ This file Copyright 2026 Routino contributors
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Affero General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Affero General Public License for more details.
+
+ You should have received a copy of the GNU Affero General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ***************************************/
+
+
+#ifndef PARTITION_H
+#define PARTITION_H    /*+ To stop multiple inclusions. +*/
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "types.h"
+#include "profiles.h"
+
+#include "files.h"
+
+
+/* Constants */
+
+/*+ The number of sets of scores for different profiles that are kept. +*/
+#define CUSTOMISATIONS 8
+
+
+/* Data structures */
+
+
+/*+ A structure containing the header from the file. +*/
+typedef struct _PartitionFile
+{
+ index_t     number;            /*+ The number of super-nodes in total. +*/
+ index_t     nnodes;            /*+ The number of nodes in the database that the partition was created for. +*/
+
+ index_t     ncells;            /*+ The number of cells. +*/
+ index_t     nboundary;         /*+ The number of super-nodes on the boundary of a cell. +*/
+}
+ PartitionFile;
+
+
+/*+ The scores for one profile that are calculated from the partition by the router. +*/
+struct _Customisation
+{
+ Profile        profile;        /*+ The profile that the scores were calculated with. +*/
+ int            quickest;       /*+ Set if the scores are for the quickest route instead of the shortest. +*/
+
+ score_t       *scores;         /*+ The score for each super-segment (the sum of the scores of its segments). +*/
+
+ index_t       *firstclique;    /*+ The first score between the boundary super-nodes for each cell. +*/
+ score_t       *cliques;        /*+ The scores between each pair of boundary super-nodes within a cell. +*/
+
+ int            users;          /*+ The number of routes using the scores (plus one while they are kept). +*/
+ unsigned long  used;           /*+ When the scores were last used (the least recently used are replaced). +*/
+};
+
+
+/*+ A structure containing the partition (and pointers to mmap file). +*/
+struct _Partition
+{
+ PartitionFile  file;           /*+ The header data from the file. +*/
+
+#if !SLIM
+
+ void          *data;           /*+ The memory mapped data. +*/
+
+ index_t       *firstboundary;  /*+ An array of the first boundary super-node of each cell. +*/
+ index_t       *boundary;       /*+ An array of the boundary super-nodes (sorted by cell and position). +*/
+
+#else
+
+ int            fd;             /*+ The file descriptor for the file. +*/
+
+ off_t          firstoffset;    /*+ The offset of the first boundary super-nodes in the file. +*/
+ off_t          boundaryoffset; /*+ The offset of the boundary super-nodes in the file. +*/
+
+ index_t       *cached;         /*+ The boundary super-nodes for one cell read from the file in slim mode. +*/
+ index_t        ncached;        /*+ The number of boundary super-nodes allocated in the cache. +*/
+
+#endif
+
+ index_t       *nodes;          /*+ An array of the super-nodes (sorted by index, read into memory in slim mode). +*/
+ index_t       *cells;          /*+ An array of the cell that each super-node is in (read into memory in slim mode). +*/
+
+ Customisation *customised[CUSTOMISATIONS]; /*+ The scores that have been calculated for the most recent profiles. +*/
+ unsigned long  customised_clock; /*+ The counter of the uses of the scores. +*/
+};
+
+
+/* Functions in partition.c */
+
+Partition *LoadPartition(const char *filename);
+
+index_t FindPartitionNode(Partition *partition,index_t node);
+
+index_t *LookupPartitionBoundary(Partition *partition,index_t cell,index_t *number);
+index_t FindBoundaryPosition(Partition *partition,index_t cell,index_t index);
+
+Customisation *CustomisePartition(Partition *partition,Nodes *nodes,Segments *segments,Ways *ways,Profile *profile,int quickest);
+void ReleaseCustomisation(Customisation *customisation);
+
+index_t FindCustomisedSegment(Partition *partition,Customisation *customisation,Nodes *nodes,Segments *segments,Profile *profile,
+                              index_t index1,index_t index2);
+
+void UnpackCustomisedClique(Partition *partition,Customisation *customisation,Nodes *nodes,Segments *segments,Profile *profile,
+                            index_t index1,index_t index2,index_t **path,score_t **scores,int *number);
+
+
+/* Macros */
+
+/*+ Return the node index of one of the super-nodes in the partition (using its position in the list). +*/
+#define LookupPartitionNode(xxx,yyy) ((xxx)->nodes[yyy])
+
+/*+ Return the cell that one of the super-nodes in the partition is in (using its position in the list). +*/
+#define LookupPartitionCell(xxx,yyy) ((xxx)->cells[yyy])
+
+/*+ Return the score of a super-segment for the profile that the scores were calculated for. +*/
+#define CustomisedScore(xxx,yyy) ((xxx)->scores[yyy])
+
+/*+ Return the score between two boundary super-nodes of a cell (using their positions in the list of boundary super-nodes). +*/
+#define CustomisedClique(xxx,yyy,nnn,iii,jjj) ((xxx)->cliques[(xxx)->firstclique[yyy]+(iii)*(nnn)+(jjj)])
+
+
+#endif /* PARTITION_H */
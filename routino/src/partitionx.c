@@ -0,0 +1,261 @@
+/***************************************
+ Partition creation functions.
+
+ Part of the Routino routing software.
+ ******************/ /******************
+ This file Copyright 2026 Routino contributors
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Affero General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Affero General Public License for more details.
+
+ You should have received a copy of the GNU Affero General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ***************************************/
+
+
+#include <stdlib.h>
+
+#include "types.h"
+#include "nodes.h"
+#include "segments.h"
+#include "partition.h"
+
+#include "partitionx.h"
+
+#include "files.h"
+#include "logging.h"
+
+
+/* Local functions */
+
+static index_t GrowCell(Nodes *nodes,Segments *segments,index_t *supernodes,index_t *positions,index_t *cells,index_t *list,
+                        index_t start,index_t cell,index_t cellsize);
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Divide the super-nodes into cells and save the partition to a file.
+
+  The cells are grown outwards from the lowest numbered super-node that is not yet in a cell
+  (the nodes are sorted geographically so these are close together) following the super-segments
+  until they contain the requested number of super-nodes. The partition does not depend on the
+  profile, the router calculates the scores for each profile when it is used.
+
+  const char *dirname The directory containing the database files.
+
+  const char *prefix The prefix of the database files.
+
+  index_t cellsize The maximum number of super-nodes in each cell.
+
+  const char *filename The name of the file to save.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+void SavePartition(const char *dirname,const char *prefix,index_t cellsize,const char *filename)
+{
+ Nodes *nodes;
+ Segments *segments;
+ PartitionFile partitionfile={0};
+ index_t i,nsuper=0,ncells=0,nboundary=0;
+ index_t *supernodes,*positions,*cells,*list,*firstboundary,*boundary;
+ int fd;
+
+ /* Load in the database files that were written */
+
+ nodes=LoadNodeList(FileName(dirname,prefix,"nodes.mem"));
+ segments=LoadSegmentList(FileName(dirname,prefix,"segments.mem"));
+
+ /* Print the start message */
+
+ printf_first("Partitioning Super-Nodes: Nodes=0 Cells=0");
+
+ /* Find the super-nodes (in index order) and their positions */
+
+ supernodes=(index_t*)malloc(nodes->file.number*sizeof(index_t));
+ positions =(index_t*)malloc(nodes->file.number*sizeof(index_t));
+
+ logassert(supernodes && positions,"Failed to allocate memory (try using slim mode?)"); /* Check malloc() worked */
+
+ for(i=0;i<nodes->file.number;i++)
+    if(IsSuperNode(LookupNode(nodes,i,1)))
+      {
+       positions[i]=nsuper;
+       supernodes[nsuper++]=i;
+      }
+    else
+       positions[i]=NO_NODE;
+
+ /* Grow the cells */
+
+ cells=(index_t*)malloc(nsuper*sizeof(index_t));
+ list =(index_t*)malloc(nsuper*sizeof(index_t));
+
+ logassert(cells && list,"Failed to allocate memory (try using slim mode?)"); /* Check malloc() worked */
+
+ for(i=0;i<nsuper;i++)
+    cells[i]=NO_NODE;
+
+ for(i=0;i<nsuper;i++)
+   {
+    if(cells[i]!=NO_NODE)
+       continue;
+
+    GrowCell(nodes,segments,supernodes,positions,cells,list,i,ncells,cellsize);
+
+    ncells++;
+
+    if(!(ncells%100))
+       printf_middle("Partitioning Super-Nodes: Nodes=%"Pindex_t" Cells=%"Pindex_t,i+1,ncells);
+   }
+
+ /* Find the super-nodes that have a super-segment to a different cell */
+
+ firstboundary=(index_t*)calloc(ncells+1,sizeof(index_t));
+
+ logassert(firstboundary,"Failed to allocate memory (try using slim mode?)"); /* Check calloc() worked */
+
+ for(i=0;i<nsuper;i++)
+   {
+    Node *nodep=LookupNode(nodes,supernodes[i],1);
+    Segment *segmentp=FirstSegment(segments,nodep,1);
+
+    list[i]=0;
+
+    while(segmentp)
+      {
+       if(IsSuperSegment(segmentp))
+         {
+          index_t position2=positions[OtherNode(segmentp,supernodes[i])];
+
+          if(position2!=NO_NODE && cells[position2]!=cells[i])
+            {
+             list[i]=1;
+             firstboundary[cells[i]+1]++;
+             nboundary++;
+             break;
+            }
+         }
+
+       segmentp=NextSegment(segments,segmentp,supernodes[i]);
+      }
+   }
+
+ for(i=0;i<ncells;i++)
+    firstboundary[i+1]+=firstboundary[i];
+
+ boundary=(index_t*)malloc((nboundary+1)*sizeof(index_t));
+
+ logassert(boundary,"Failed to allocate memory (try using slim mode?)"); /* Check malloc() worked */
+
+ for(i=0;i<nsuper;i++)
+    if(list[i])
+       boundary[firstboundary[cells[i]]++]=i;
+
+ /* The loop above moved each one to the start of the next cell */
+
+ for(i=ncells;i>0;i--)
+    firstboundary[i]=firstboundary[i-1];
+
+ firstboundary[0]=0;
+
+ /* Print the partition message */
+
+ printf_last("Partitioned Super-Nodes: Nodes=%"Pindex_t" Cells=%"Pindex_t" Boundary=%"Pindex_t,nsuper,ncells,nboundary);
+
+ /* Write out the file */
+
+ printf_first("Writing Partition: Nodes=0");
+
+ fd=OpenFileNew(filename);
+
+ partitionfile.number=nsuper;
+ partitionfile.nnodes=nodes->file.number;
+ partitionfile.ncells=ncells;
+ partitionfile.nboundary=nboundary;
+
+ WriteFile(fd,&partitionfile,sizeof(PartitionFile));
+
+ WriteFile(fd,supernodes,nsuper*sizeof(index_t));
+ WriteFile(fd,cells,nsuper*sizeof(index_t));
+ WriteFile(fd,firstboundary,(ncells+1)*sizeof(index_t));
+ WriteFile(fd,boundary,nboundary*sizeof(index_t));
+
+ CloseFile(fd);
+
+ /* Free the memory */
+
+ free(supernodes);
+ free(positions);
+ free(cells);
+ free(list);
+ free(firstboundary);
+ free(boundary);
+
+ /* Print the final message */
+
+ printf_last("Wrote Partition: Nodes=%"Pindex_t" Cells=%"Pindex_t,nsuper,ncells);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Grow one cell outwards from a super-node (breadth first) following the super-segments in both
+  directions (ignoring one-way restrictions) until it is full or there are no more super-nodes.
+
+  index_t GrowCell Returns the number of super-nodes in the cell.
+
+  Nodes *nodes The set of nodes to use.
+
+  Segments *segments The set of segments to use.
+
+  index_t *supernodes The super-nodes (in index order).
+
+  index_t *positions The position of each node in the list of super-nodes (or NO_NODE).
+
+  index_t *cells The cell for each super-node (updated).
+
+  index_t *list Temporary space for the list of super-nodes in the cell.
+
+  index_t start The position of the super-node to start from.
+
+  index_t cell The number of the cell.
+
+  index_t cellsize The maximum number of super-nodes in the cell.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static index_t GrowCell(Nodes *nodes,Segments *segments,index_t *supernodes,index_t *positions,index_t *cells,index_t *list,
+                        index_t start,index_t cell,index_t cellsize)
+{
+ index_t first=0,number=0;
+
+ cells[start]=cell;
+ list[number++]=start;
+
+ while(first<number && number<cellsize)
+   {
+    index_t node1=supernodes[list[first++]];
+    Segment *segmentp=FirstSegment(segments,LookupNode(nodes,node1,1),1);
+
+    while(segmentp && number<cellsize)
+      {
+       if(IsSuperSegment(segmentp))
+         {
+          index_t position2=positions[OtherNode(segmentp,node1)];
+
+          if(position2!=NO_NODE && cells[position2]==NO_NODE)
+            {
+             cells[position2]=cell;
+             list[number++]=position2;
+            }
+         }
+
+       segmentp=NextSegment(segments,segmentp,node1);
+      }
+   }
+
+ return(number);
+}
@@ -0,0 +1,34 @@
+/***************************************
+ A header file for the partition creation.
+
+ Part of the Routino routing software.
+ ******************/ /******************
+ This file Copyright 2026 Routino contributors
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Affero General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Affero General Public License for more details.
+
+ You should have received a copy of the GNU Affero General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ***************************************/
+
+
+#ifndef PARTITIONX_H
+#define PARTITIONX_H    /*+ To stop multiple inclusions. +*/
+
+#include "types.h"
+
+
+/* Functions in partitionx.c */
+
+void SavePartition(const char *dirname,const char *prefix,index_t cellsize,const char *filename);
+
+
+#endif /* PARTITIONX_H */
@@ -37,6 +37,11 @@
 #include "relationsx.h"
 #include "superx.h"
 #include "prunex.h"
+#include "landmarksx.h"
+#include "landmarks.h"
+#include "hierarchyx.h"
+#include "partitionx.h"
+#include "profiles.h"
 
 #include "files.h"
 #include "logging.h"
@@ -44,6 +49,7 @@
 #include "osmparser.h"
 #include "tagging.h"
 #include "uncompress.h"
+#include "srtmHgtReader.h"
 
 
 /* Global variables */
@@ -57,6 +63,9 @@ size_t option_filesort_ramsize=0;
 /*+ The number of threads to use for filesorting. +*/
 int option_filesort_threads=1;
 
+/*+ Measure the nodes and segments sorted by SRTM tile. +*/
+int option_srtm_sort=0;
+
 
 /* Local functions */
 
@@ -81,6 +90,11 @@ int main(int argc,char** argv)
  int         option_append=0,option_keep=0,option_changes=0;
  int         option_filenames=0;
  int         option_prune_isolated=500,option_prune_short=5,option_prune_straight=3;
+ int         option_landmarks=0;
+ char       *option_hierarchy=NULL,*profiles=NULL;
+ int         option_hierarchy_quickest=0;
+ int         option_partition=0;
+ Profile    *profile=NULL;
  int         arg;
 
  gettimeofday(&start_time,NULL);
@@ -125,6 +139,10 @@ int main(int argc,char** argv)
        option_changes=1;
     else if(!strncmp(argv[arg],"--max-iterations=",17))
        max_iterations=atoi(&argv[arg][17]);
+    else if(!strncmp(argv[arg],"--srtm-cache=",13))
+       srtmSetCacheSize(atoi(&argv[arg][13]));
+    else if(!strcmp(argv[arg],"--srtm-sort"))
+       option_srtm_sort=1;
     else if(!strncmp(argv[arg],"--prune",7))
       {
        if(!strcmp(&argv[arg][7],"-none"))
@@ -138,6 +156,16 @@ int main(int argc,char** argv)
        else
           print_usage(0,argv[arg],NULL);
       }
+    else if(!strncmp(argv[arg],"--landmarks=",12))
+       option_landmarks=atoi(&argv[arg][12]);
+    else if(!strncmp(argv[arg],"--hierarchy=",12))
+       option_hierarchy=&argv[arg][12];
+    else if(!strcmp(argv[arg],"--hierarchy-quickest"))
+       option_hierarchy_quickest=1;
+    else if(!strncmp(argv[arg],"--partition=",12))
+       option_partition=atoi(&argv[arg][12]);
+    else if(!strncmp(argv[arg],"--profiles=",11))
+       profiles=&argv[arg][11];
     else if(argv[arg][0]=='-' && argv[arg][1]=='-')
        print_usage(0,argv[arg],NULL);
     else
@@ -158,6 +186,15 @@ int main(int argc,char** argv)
  if(!option_filenames && !option_process_only)
     print_usage(0,NULL,"File names must be specified unless using '--process-only'");
 
+ if(option_landmarks<0 || option_landmarks>MAX_LANDMARKS)
+    print_usage(0,NULL,"The number of landmarks must be between 0 and 32.");
+
+ if(option_hierarchy_quickest && !option_hierarchy)
+    print_usage(0,NULL,"Cannot use '--hierarchy-quickest' without '--hierarchy'.");
+
+ if(option_partition<0 || option_partition==1)
+    print_usage(0,NULL,"The number of super-nodes in each cell must be at least 2.");
+
  if(!option_filesort_ramsize)
    {
 #if SLIM
@@ -207,6 +244,46 @@ int main(int argc,char** argv)
       }
    }
 
+ /* Load in the profile for the contraction hierarchy */
+
+ if(option_hierarchy)
+   {
+    if(profiles)
+      {
+       if(!ExistsFile(profiles))
+         {
+          fprintf(stderr,"Error: The '--profiles' option specifies a file that does not exist.\n");
+          return(1);
+         }
+      }
+    else
+      {
+       if(ExistsFile(FileName(dirname,prefix,"profiles.xml")))
+          profiles=FileName(dirname,prefix,"profiles.xml");
+       else if(ExistsFile(FileName(DATADIR,NULL,"profiles.xml")))
+          profiles=FileName(DATADIR,NULL,"profiles.xml");
+       else
+         {
+          fprintf(stderr,"Error: The '--profiles' option was not used and the default 'profiles.xml' does not exist.\n");
+          return(1);
+         }
+      }
+
+    if(ParseXMLProfiles(profiles))
+      {
+       fprintf(stderr,"Error: Cannot read the profiles in the file '%s'.\n",profiles);
+       return(1);
+      }
+
+    profile=GetProfile(option_hierarchy);
+
+    if(!profile)
+      {
+       fprintf(stderr,"Error: Cannot find a profile called '%s' in '%s'.\n",option_hierarchy,profiles);
+       return(1);
+      }
+   }
+
  /* Create new node, segment, way and relation variables */
 
  Nodes=NewNodeList(option_append||option_changes,option_process_only);
@@ -534,6 +611,13 @@ if(!option_process_only)
  printf("\nWrite Out Database Files\n========================\n\n");
  fflush(stdout);
 
+ /* Write out the landmarks (before the nodes and segments are freed) */
+
+ if(option_landmarks)
+    SaveLandmarkList(Nodes,Segments,option_landmarks,FileName(dirname,prefix,"landmarks.mem"));
+ else if(ExistsFile(FileName(dirname,prefix,"landmarks.mem")))
+    DeleteFile(FileName(dirname,prefix,"landmarks.mem"));
+
  /* Write out the nodes */
 
  SaveNodeList(Nodes,FileName(dirname,prefix,"nodes.mem"),Segments);
@@ -558,6 +642,20 @@ if(!option_process_only)
 
  FreeRelationList(Relations,0);
 
+ /* Write out the contraction hierarchy (using the files that were just written) */
+
+ if(option_hierarchy)
+    SaveHierarchy(dirname,prefix,profile,option_hierarchy_quickest,FileName(dirname,prefix,"hierarchy.mem"));
+ else if(ExistsFile(FileName(dirname,prefix,"hierarchy.mem")))
+    DeleteFile(FileName(dirname,prefix,"hierarchy.mem"));
+
+ /* Write out the partition (using the files that were just written) */
+
+ if(option_partition)
+    SavePartition(dirname,prefix,option_partition,FileName(dirname,prefix,"partition.mem"));
+ else if(ExistsFile(FileName(dirname,prefix,"partition.mem")))
+    DeleteFile(FileName(dirname,prefix,"partition.mem"));
+
  /* Close the error log file */
 
  if(errorlog)
@@ -604,10 +702,15 @@ static void print_usage(int detail,const char *argerr,const char *err)
          "                      [--parse-only | --process-only]\n"
          "                      [--append] [--keep] [--changes]\n"
          "                      [--max-iterations=<number>]\n"
+         "                      [--srtm-cache=<number>] [--srtm-sort]\n"
          "                      [--prune-none]\n"
          "                      [--prune-isolated=<len>]\n"
          "                      [--prune-short=<len>]\n"
          "                      [--prune-straight=<len>]\n"
+         "                      [--landmarks=<number>]\n"
+         "                      [--hierarchy=<name> [--hierarchy-quickest]\n"
+         "                       [--profiles=<filename>]]\n"
+         "                      [--partition=<number>]\n"
          "                      [<filename.osm> ... | <filename.osc> ...\n"
          "                       | <filename.pbf> ...\n"
          "                       | <filename.osm> ... | <filename.osc> ..."
@@ -644,7 +747,8 @@ static void print_usage(int detail,const char *argerr,const char *err)
             "                          (defaults to 256MB otherwise.)\n"
 #endif
 #if defined(USE_PTHREADS) && USE_PTHREADS
-            "--sort-threads=<number>   The number of threads to use for data sorting.\n"
+            "--sort-threads=<number>   The number of threads to use for data sorting\n"
+            "                          and for measuring the segment elevations.\n"
 #endif
             "\n"
             "--tmpdir=<dirname>        The directory name for temporary files.\n"
@@ -669,6 +773,11 @@ static void print_usage(int detail,const char *argerr,const char *err)
             "--max-iterations=<number> The number of iterations for finding super-nodes\n"
             "                          (defaults to 5).\n"
             "\n"
+            "--srtm-cache=<number>     The number of SRTM elevation tiles to keep in memory\n"
+            "                          (defaults to 8).\n"
+            "--srtm-sort               Look up the elevations sorted by SRTM tile, fewer\n"
+            "                          tiles are loaded with a small '--srtm-cache'.\n"
+            "\n"
             "--prune-none              Disable the prune options below, they are re-enabled\n"
             "                          by adding them to the command line after this option.\n"
             "--prune-isolated=<len>    Remove access from small disconnected segment groups\n"
@@ -678,6 +787,20 @@ static void print_usage(int detail,const char *argerr,const char *err)
             "--prune-straight=<len>    Remove nodes in almost straight highways (defaults to\n"
             "                          removing nodes up to 3m offset from a straight line).\n"
             "\n"
+            "--landmarks=<number>      Choose this many landmarks (up to 32) and save the\n"
+            "                          distances from them to speed up the router searches\n"
+            "                          (defaults to 0, no landmarks file).\n"
+            "--hierarchy=<name>        Create a contraction hierarchy of the super-nodes for\n"
+            "                          the named profile to speed up the router searches.\n"
+            "--hierarchy-quickest      Create it for the quickest route (default shortest).\n"
+            "--profiles=<filename>     The name of the XML file containing the profiles\n"
+            "                          (defaults to 'profiles.xml' with '--dir' and\n"
+            "                           '--prefix' options or the file installed in\n"
+            "                           '" DATADIR "').\n"
+            "--partition=<number>      Divide the super-nodes into cells of this size so that\n"
+            "                          the router can calculate exact scores (with hills)\n"
+            "                          for any profile quickly (defaults to 0, no file).\n"
+            "\n"
             "<filename.osm>, <filename.osc>, <filename.pbf>, <filename.o5m>, <filename.o5c>\n"
             "                          The name(s) of the file(s) to read and parse.\n"
             "                          Filenames ending '.pbf' read as PBF, filenames ending\n"
@@ -25,14 +25,46 @@
 #include <stdlib.h>
 #include <math.h>
 
+#if defined(USE_PTHREADS) && USE_PTHREADS
+#include <pthread.h>
+#endif
+
 #include "types.h"
 #include "ways.h"
 
 #include "files.h"
+#include "logging.h"
 #include "profiles.h"
 #include "xmlparse.h"
 
 
+/* Constants */
+
+/*+ The number of sets of tables that are kept for profiles with the same scores. +*/
+#define COMPILED_PROFILES 8
+
+
+/* Local types */
+
+/*+ The tables of way preferences, way speeds and hill speeds that have been filled in for a profile. +*/
+typedef struct _CompiledProfile
+{
+ Profile  profile;              /*+ The profile (containing the tables). +*/
+ Ways    *ways;                 /*+ The set of ways that the tables are for. +*/
+
+ int      users;                /*+ The number of profiles using the tables (plus one while they are kept). +*/
+ unsigned long used;            /*+ When the tables were last used (the least recently used are replaced). +*/
+}
+ CompiledProfile;
+
+
+/* Local functions */
+
+static void compile_profile(Profile *profile,Ways *ways);
+static void compile_hills(Profile *profile);
+static void release_compiled(CompiledProfile *compiled);
+
+
 /* Local variables */
 
 /*+ The profiles that have been loaded from file. +*/
@@ -41,6 +73,19 @@ static Profile **loaded_profiles=NULL;
 /*+ The number of profiles that have been loaded from file. +*/
 static int nloaded_profiles=0;
 
+/*+ The tables for the profiles that have been updated most recently. +*/
+static CompiledProfile *compiled_profiles[COMPILED_PROFILES];
+
+/*+ The counter of the uses of the tables. +*/
+static unsigned long compiled_clock=0;
+
+#if defined(USE_PTHREADS) && USE_PTHREADS
+
+/*+ The mutex for the tables (profiles can be updated in several threads). +*/
+static pthread_mutex_t compiled_mutex=PTHREAD_MUTEX_INITIALIZER;
+
+#endif
+
 
 /* The XML tag processing function prototypes */
 
@@ -687,7 +732,8 @@ Profile *GetProfile(const char *name)
 
 
 /*++++++++++++++++++++++++++++++++++++++
-  Update a profile with the highway preference scaling factors.
+  Update a profile with the highway preference scaling factors and fill in the preference and
+  speed for each way and the speed for each grade of hill.
 
   int UpdateProfile Returns 1 in case of a problem.
 
@@ -781,10 +827,280 @@ int UpdateProfile(Profile *profile,Ways *ways)
           profile->max_pref*=profile->props_no[i];
       }
 
+ /* Fill in the preference and speed for each way and the speed for each grade of hill */
+
+ compile_profile(profile,ways);
+
  return(0);
 }
 
 
+/*++++++++++++++++++++++++++++++++++++++
+  Release the tables that were filled in for a profile by UpdateProfile() (they are freed when no
+  profile uses them and they are no longer kept for the next profile with the same scores).
+
+  Profile *profile The profile to release the tables of.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+void ReleaseProfile(Profile *profile)
+{
+ if(!profile->compiled)
+    return;
+
+#if defined(USE_PTHREADS) && USE_PTHREADS
+ pthread_mutex_lock(&compiled_mutex);
+#endif
+
+ release_compiled(profile->compiled);
+
+#if defined(USE_PTHREADS) && USE_PTHREADS
+ pthread_mutex_unlock(&compiled_mutex);
+#endif
+
+ profile->way_pref=NULL;
+ profile->way_speed=NULL;
+ profile->hill_speed=NULL;
+ profile->compiled=NULL;
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Fill in the tables of the preference and speed for each way and the speed for each grade of hill
+  so that the router only needs to look them up. The most recently used tables are kept and shared
+  by profiles with the same scores.
+
+  Profile *profile The profile to fill in the tables for.
+
+  Ways *ways The set of ways to use.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static void compile_profile(Profile *profile,Ways *ways)
+{
+ CompiledProfile *compiled,**replace;
+ index_t i;
+ int j;
+
+#if defined(USE_PTHREADS) && USE_PTHREADS
+ pthread_mutex_lock(&compiled_mutex);
+#endif
+
+ for(j=0;j<COMPILED_PROFILES;j++)
+    if(compiled_profiles[j] && compiled_profiles[j]->ways==ways && SameProfileScores(&compiled_profiles[j]->profile,profile,1))
+      {
+       compiled=compiled_profiles[j];
+
+       compiled->users++;
+       compiled->used=++compiled_clock;
+
+       profile->way_pref  =compiled->profile.way_pref;
+       profile->way_speed =compiled->profile.way_speed;
+       profile->hill_speed=compiled->profile.hill_speed;
+       profile->compiled  =compiled;
+
+#if defined(USE_PTHREADS) && USE_PTHREADS
+       pthread_mutex_unlock(&compiled_mutex);
+#endif
+
+       return;
+      }
+
+ profile->way_pref =(score_t*)malloc(ways->file.number*sizeof(score_t));
+ profile->way_speed=(speed_t*)malloc(ways->file.number*sizeof(speed_t));
+
+ logassert(profile->way_pref && profile->way_speed,"Failed to allocate memory (try using slim mode?)"); /* Check malloc() worked */
+
+ for(i=0;i<ways->file.number;i++)
+   {
+    Way *wayp=LookupWay(ways,i,1);
+    speed_t speed=profile->speed[HIGHWAY(wayp->type)];
+    score_t pref=profile->highway[HIGHWAY(wayp->type)];
+
+    /* The slower of the way's speed limit and the profile's speed (a zero speed is unknown) */
+
+    if(wayp->speed && (speed==0 || wayp->speed<speed))
+       speed=wayp->speed;
+
+    profile->way_speed[i]=speed;
+
+    /* mode of transport must be allowed on the highway */
+    if(!(wayp->allow&profile->allow))
+       pref=0;
+
+    /* must obey weight restriction (if exists) */
+    if(wayp->weight && wayp->weight<profile->weight)
+       pref=0;
+
+    /* must obey height/width/length restriction (if exist) */
+    if((wayp->height && wayp->height<profile->height) ||
+       (wayp->width  && wayp->width <profile->width ) ||
+       (wayp->length && wayp->length<profile->length))
+       pref=0;
+
+    for(j=1;j<Property_Count;j++)
+       if(ways->file.props & PROPERTIES(j))
+         {
+          if(wayp->props & PROPERTIES(j))
+             pref*=profile->props_yes[j];
+          else
+             pref*=profile->props_no[j];
+         }
+
+    profile->way_pref[i]=pref;
+   }
+
+ compile_hills(profile);
+
+ /* Keep the tables in place of an unused slot or the least recently used tables */
+
+ compiled=(CompiledProfile*)malloc(sizeof(CompiledProfile));
+
+ logassert(compiled,"Failed to allocate memory"); /* Check malloc() worked */
+
+ profile->compiled=compiled;
+
+ compiled->profile=*profile;
+ compiled->profile.name=NULL;
+ compiled->ways=ways;
+ compiled->users=2;
+ compiled->used=++compiled_clock;
+
+ replace=&compiled_profiles[0];
+
+ for(j=0;j<COMPILED_PROFILES;j++)
+    if(!compiled_profiles[j] || (*replace && compiled_profiles[j]->used<(*replace)->used))
+       replace=&compiled_profiles[j];
+
+ if(*replace)
+    release_compiled(*replace);
+
+ *replace=compiled;
+
+#if defined(USE_PTHREADS) && USE_PTHREADS
+ pthread_mutex_unlock(&compiled_mutex);
+#endif
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Stop using a set of tables and free them if they are not used any more (the mutex must be held).
+
+  CompiledProfile *compiled The tables to release.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static void release_compiled(CompiledProfile *compiled)
+{
+ if(--compiled->users>0)
+    return;
+
+ free(compiled->profile.way_pref);
+ free(compiled->profile.way_speed);
+
+ if(compiled->profile.hill_speed)
+    free(compiled->profile.hill_speed);
+
+ free(compiled);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Fill in the table of the speed for each grade of hill. A hills value of 100 or more selects
+  fixed speeds for the steeper grades, a smaller value is the speed on a 10% grade and the speed
+  changes linearly with the grade from the speed on the flat (but is never below 3 km/hr).
+
+  Profile *profile The profile to fill in the table for.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static void compile_hills(Profile *profile)
+{
+ int grade;
+
+ if(profile->hills==0)
+   {
+    profile->hill_speed=NULL;
+    return;
+   }
+
+ profile->hill_speed=(HillSpeed*)malloc(HILL_GRADES*sizeof(HillSpeed));
+
+ logassert(profile->hill_speed,"Failed to allocate memory"); /* Check malloc() worked */
+
+ for(grade=0;grade<HILL_GRADES;grade++)
+   {
+    HillSpeed *hill=&profile->hill_speed[grade];
+    float percent=(float)grade/10;
+
+    if(profile->hills>=100)
+      {
+       hill->offset=0;
+       hill->factor=1;
+       hill->minimum=0;
+
+       if(percent>2)  hill->offset=15;
+       if(percent>4)  hill->offset=10;
+       if(percent>7)  hill->offset=8;
+       if(percent>9)  hill->offset=6;
+       if(percent>15) hill->offset=3;
+
+       if(hill->offset)
+          hill->factor=0;
+      }
+    else
+      {
+       hill->offset=profile->hills*percent/10;
+       hill->factor=1-percent/10;
+       hill->minimum=3;
+      }
+   }
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Check if two profiles give the same scores for every segment.
+
+  int SameProfileScores Returns 1 if the scores are the same.
+
+  const Profile *profile1 The first profile (already updated).
+
+  const Profile *profile2 The second profile (already updated).
+
+  int quickest Set if the scores are for the quickest route instead of the shortest.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+int SameProfileScores(const Profile *profile1,const Profile *profile2,int quickest)
+{
+ int i;
+
+ if(profile1->allow!=profile2->allow || profile1->oneway!=profile2->oneway)
+    return(0);
+
+ if(profile1->weight!=profile2->weight || profile1->height!=profile2->height ||
+    profile1->width!=profile2->width || profile1->length!=profile2->length)
+    return(0);
+
+ for(i=1;i<Highway_Count;i++)
+    if(profile1->highway[i]!=profile2->highway[i])
+       return(0);
+
+ for(i=1;i<Property_Count;i++)
+    if(profile1->props_yes[i]!=profile2->props_yes[i] || profile1->props_no[i]!=profile2->props_no[i])
+       return(0);
+
+ /* The speeds and hills only change the scores for the quickest route */
+
+ if(quickest)
+   {
+    for(i=1;i<Highway_Count;i++)
+       if(profile1->speed[i]!=profile2->speed[i])
+          return(0);
+
+    if(profile1->hills!=profile2->hills)
+       return(0);
+   }
+
+ return(1);
+}
+
+
 /*++++++++++++++++++++++++++++++++++++++
   Print out a profile.
 
@@ -26,8 +26,23 @@
 #include "types.h"
 
 
+/* Constants */
+
+/*+ The number of grades (in steps of 1/10 percent) in the table of hill speeds, any steeper grade uses the last one. +*/
+#define HILL_GRADES 1024
+
+
 /* Data structures */
 
+/*+ A data structure to hold the speed on one grade of hill (calculated from the speed on the flat). +*/
+typedef struct _HillSpeed
+{
+ float        offset;                    /*+ The speed that is added. +*/
+ float        factor;                    /*+ The factor that multiplies the speed on the flat. +*/
+ float        minimum;                   /*+ The minimum speed. +*/
+}
+ HillSpeed;
+
 /*+ A data structure to hold a transport type profile. +*/
 typedef struct _Profile
 {
@@ -56,6 +71,12 @@ typedef struct _Profile
  length_t     length;                    /*+ The minimum length of vehicles on the route. +*/
  
  float      hills;
+
+ score_t     *way_pref;                  /*+ The preference for each way (zero if not allowed), filled in by UpdateProfile(). +*/
+ speed_t     *way_speed;                 /*+ The speed on each way (zero if unknown), filled in by UpdateProfile(). +*/
+ HillSpeed   *hill_speed;                /*+ The speed for each grade of hill (NULL if no hills), filled in by UpdateProfile(). +*/
+
+ struct _CompiledProfile *compiled;      /*+ The shared tables that hold the ones above, released by ReleaseProfile(). +*/
 }
  Profile;
 
@@ -67,6 +88,9 @@ int ParseXMLProfiles(const char *filename);
 Profile *GetProfile(const char *name);
 
 int UpdateProfile(Profile *profile,Ways *ways);
+void ReleaseProfile(Profile *profile);
+
+int SameProfileScores(const Profile *profile1,const Profile *profile2,int quickest);
 
 void PrintProfile(const Profile *profile);
 
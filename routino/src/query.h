@@ -0,0 +1,90 @@
+/***************************************
+ Header file for the data structure holding the state of one route query.
+
+ Part of the Routino routing software.
+ ******************/ /******************
+ This file Copyright 2026 Routino contributors
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Affero General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Affero General Public License for more details.
+
+ You should have received a copy of the GNU Affero General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ***************************************/
+
+
+#ifndef QUERY_H
+#define QUERY_H    /*+ To stop multiple inclusions. +*/
+
+#include <stddef.h>
+
+#include "types.h"
+
+#include "segments.h"
+#include "results.h"
+#include "translations.h"
+
+
+/* Constants */
+
+/*+ The maximum number of outputs that can be kept in memory. +*/
+#define NOUTPUTS 5
+
+
+/* Data structures */
+
+/*+ The state of one route query, everything that is not shared between queries (several queries
+    can be calculated at the same time using the non-slim data, the slim data lookups are not thread-safe). +*/
+struct _Query
+{
+ int      quickest;                      /*+ Set to calculate the quickest route instead of the shortest. +*/
+ int      bidirectional;                 /*+ Set to search from both ends of the route at the same time. +*/
+
+ distance_t reach_distance;              /*+ The distance limit for finding the reachable nodes (or 0). +*/
+ duration_t reach_duration;              /*+ The duration limit for finding the reachable nodes (or 0). +*/
+ double   reach_ascent;                  /*+ The total ascent limit for finding the reachable nodes (or 0 for none). +*/
+
+ int      pareto;                        /*+ Set to find the routes that trade off the duration against the ascent. +*/
+ double   pareto_epsilon;                /*+ The fraction by which one Pareto route must be better than another to keep both. +*/
+
+ int      html;                          /*+ Set to create the HTML output. +*/
+ int      gpx_track;                     /*+ Set to create the GPX track output. +*/
+ int      gpx_route;                     /*+ Set to create the GPX route output. +*/
+ int      text;                          /*+ Set to create the text output. +*/
+ int      text_all;                      /*+ Set to create the text output with all points. +*/
+
+ const Translation *translation;         /*+ The translated strings for the outputs. +*/
+
+ Landmarks *landmarks;                   /*+ The landmark distances for the super-node searches (or NULL). +*/
+ Hierarchy *hierarchy;                   /*+ The contraction hierarchy for the super-node searches (or NULL). +*/
+ Partition *partition;                   /*+ The partition for the super-node searches (or NULL). +*/
+ Customisation *customisation;           /*+ The scores from the partition for the profile being used (or NULL). +*/
+
+ int      memory;                        /*+ Set to keep the outputs in memory instead of writing files. +*/
+ int      noutputs;                      /*+ The number of outputs kept in memory. +*/
+ char    *output_name[NOUTPUTS];         /*+ The names of the files that would have been written. +*/
+ char    *output_data[NOUTPUTS];         /*+ The contents of the outputs kept in memory. +*/
+ size_t   output_size[NOUTPUTS];         /*+ The sizes of the outputs kept in memory. +*/
+
+ Segment  fake_segments[4*NWAYPOINTS+1]; /*+ The fake segments to allow start/finish in the middle of a segment. +*/
+ index_t  real_segments[4*NWAYPOINTS+1]; /*+ The real segments underlying the fake segments. +*/
+ double   fake_lon[NWAYPOINTS+1];        /*+ The fake node longitudes. +*/
+ double   fake_lat[NWAYPOINTS+1];        /*+ The fake node latitudes. +*/
+ int      prevpoint;                     /*+ The previous waypoint. +*/
+
+ unsigned long nsettled;                 /*+ The number of nodes taken from the queues by the route searches. +*/
+
+ ResultsPool *pool;                      /*+ The results lists and queues kept between searches (or NULL). +*/
+
+ char     error[80];                     /*+ The message for an error that stopped the query. +*/
+};
+
+
+#endif /* QUERY_H */
@@ -23,12 +23,32 @@
 #include <string.h>
 #include <stdlib.h>
 
+#if QUEUE_TRACE
+#include <stdio.h>
+#endif
+
 #include "results.h"
 
 
 /*+ The size of the increment to the allocated memory. +*/
 #define QUEUE_INCREMENT 1024
 
+#if !QUEUE_BINARY
+
+/*+ The number of children of each item in the heap. +*/
+#define QUEUE_ARITY 4
+
+/*+ An item in the queue, the sort key is a copy of the one in the result so
+    that the heap can be re-ordered without reading the results. +*/
+typedef struct _QueueItem
+{
+ score_t  sortby;               /*+ The sortby value of the result when it was queued. +*/
+ Result  *result;               /*+ The result. +*/
+}
+ QueueItem;
+
+#endif
+
 
 /*+ A queue of results. +*/
 struct _Queue
@@ -36,45 +56,116 @@ struct _Queue
  int      nallocated;           /*+ The number of entries allocated. +*/
  int      noccupied;            /*+ The number of entries occupied. +*/
 
+ ResultsPool *pool;             /*+ The pool that the queue is returned to when it is freed (or NULL). +*/
+
+#if QUEUE_BINARY
  Result **data;                 /*+ The queue of pointers to results. +*/
+#else
+ QueueItem *data;               /*+ The queue of sort keys and pointers to results. +*/
+#endif
 };
 
 
+#if QUEUE_TRACE
+
+/*+ The file that the queue operations are written to. +*/
+static FILE *trace=NULL;
+
+#endif
+
+
 /*++++++++++++++++++++++++++++++++++++++
-  Allocate a new queue.
+  Allocate a new queue or re-use one from the pool.
 
   Queue *NewQueueList Returns the queue.
+
+  ResultsPool *pool The pool to take the queue from and return it to (or NULL).
   ++++++++++++++++++++++++++++++++++++++*/
 
-Queue *NewQueueList(void)
+Queue *NewQueueList(ResultsPool *pool)
 {
  Queue *queue;
+#if !QUEUE_BINARY
+ int i;
+#endif
+
+ if(pool && pool->nqueues>0)
+   {
+    queue=pool->queues[--pool->nqueues];
 
- queue=(Queue*)malloc(sizeof(Queue));
+    queue->pool=pool;
+   }
+ else
+   {
+    queue=(Queue*)malloc(sizeof(Queue));
+
+    queue->nallocated=QUEUE_INCREMENT;
+    queue->noccupied=0;
+
+#if QUEUE_BINARY
+    queue->data=(Result**)malloc(queue->nallocated*sizeof(Result*));
+#else
+    queue->data=(QueueItem*)malloc(queue->nallocated*sizeof(QueueItem));
+
+    for(i=0;i<queue->nallocated;i++)
+       queue->data[i].sortby=INF_SCORE;
+#endif
+
+    queue->pool=pool;
+   }
 
- queue->nallocated=QUEUE_INCREMENT;
- queue->noccupied=0;
+#if QUEUE_TRACE
+ if(!trace)
+    trace=fopen("queue.trace","w");
 
- queue->data=(Result**)malloc(queue->nallocated*sizeof(Result*));
+ fprintf(trace,"N %p\n",(void*)queue);
+#endif
 
  return(queue);
 }
 
 
 /*++++++++++++++++++++++++++++++++++++++
-  Free a queue.
+  Free a queue or return it to its pool.
 
   Queue *queue The queue to be freed.
   ++++++++++++++++++++++++++++++++++++++*/
 
 void FreeQueueList(Queue *queue)
 {
+#if QUEUE_TRACE
+ fprintf(trace,"F %p\n",(void*)queue);
+#endif
+
+ if(queue->pool && queue->pool->nqueues<POOL_SIZE)
+   {
+    ResultsPool *pool=queue->pool;
+
+#if !QUEUE_BINARY
+    int i;
+
+    /* The items that are still in the queue must have an infinite sortby when it is re-used */
+
+    for(i=0;i<queue->noccupied;i++)
+       queue->data[i].sortby=INF_SCORE;
+#endif
+
+    queue->noccupied=0;
+
+    queue->pool=NULL;
+
+    pool->queues[pool->nqueues++]=queue;
+    return;
+   }
+
  free(queue->data);
 
  free(queue);
 }
 
 
+#if QUEUE_BINARY
+
 /*++++++++++++++++++++++++++++++++++++++
   Insert a new item into the queue in the right place.
 
@@ -90,6 +181,10 @@ void InsertInQueue(Queue *queue,Result *result)
 {
  int index;
 
+#if QUEUE_TRACE
+ fprintf(trace,"I %p %p %.9g\n",(void*)queue,(void*)result,result->sortby);
+#endif
+
  if(result->queued==NOT_QUEUED)
    {
     queue->noccupied++;
@@ -153,6 +248,10 @@ Result *PopFromQueue(Queue *queue)
  retval=queue->data[1];
  retval->queued=NOT_QUEUED;
 
+#if QUEUE_TRACE
+ fprintf(trace,"P %p %p %.9g\n",(void*)queue,(void*)retval,retval->sortby);
+#endif
+
  index=1;
 
  queue->data[index]=queue->data[queue->noccupied];
@@ -200,3 +299,141 @@ Result *PopFromQueue(Queue *queue)
 
  return(retval);
 }
+
+
+#else /* !QUEUE_BINARY */
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Insert a new item into the queue in the right place.
+
+  The data is stored in a 4-ary heap (each item has four children that are
+  next to each other in memory) and this operation is adding an item to the
+  heap or moving an item that is already in it towards the top.
+
+  Queue *queue The queue to insert the result into.
+
+  Result *result The result to insert into the queue.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+void InsertInQueue(Queue *queue,Result *result)
+{
+ score_t sortby=result->sortby;
+ int index;
+
+#if QUEUE_TRACE
+ fprintf(trace,"I %p %p %.9g\n",(void*)queue,(void*)result,result->sortby);
+#endif
+
+ if(result->queued==NOT_QUEUED)
+   {
+    if((queue->noccupied+QUEUE_ARITY)>=queue->nallocated)
+      {
+       int i;
+
+       queue->data=(QueueItem*)realloc((void*)queue->data,(queue->nallocated+QUEUE_INCREMENT)*sizeof(QueueItem));
+
+       for(i=queue->nallocated;i<queue->nallocated+QUEUE_INCREMENT;i++)
+          queue->data[i].sortby=INF_SCORE;
+
+       queue->nallocated=queue->nallocated+QUEUE_INCREMENT;
+      }
+
+    index=queue->noccupied++;
+   }
+ else
+    index=result->queued-1;
+
+ /* Move the parents down until the place for the new value is found */
+
+ while(index>0)
+   {
+    int parent=(index-1)/QUEUE_ARITY;
+
+    if(queue->data[parent].sortby<=sortby)
+       break;
+
+    queue->data[index]=queue->data[parent];
+    queue->data[index].result->queued=index+1;
+
+    index=parent;
+   }
+
+ queue->data[index].sortby=sortby;
+ queue->data[index].result=result;
+ result->queued=index+1;
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Pop an item from the front of the queue.
+
+  The data is stored in a 4-ary heap and this operation is deleting the root
+  item from the heap.
+
+  Result *PopFromQueue Returns the top item.
+
+  Queue *queue The queue to remove the result from.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+Result *PopFromQueue(Queue *queue)
+{
+ QueueItem last;
+ int index;
+ Result *retval;
+
+ if(queue->noccupied==0)
+    return(NULL);
+
+ retval=queue->data[0].result;
+ retval->queued=NOT_QUEUED;
+
+#if QUEUE_TRACE
+ fprintf(trace,"P %p %p %.9g\n",(void*)queue,(void*)retval,retval->sortby);
+#endif
+
+ queue->noccupied--;
+
+ if(queue->noccupied==0)
+    return(retval);
+
+ last=queue->data[queue->noccupied];
+
+ queue->data[queue->noccupied].sortby=INF_SCORE;
+
+ /* Move the smallest children up until the place for the last value is found */
+
+ index=0;
+
+ while(1)
+   {
+    int first=QUEUE_ARITY*index+1;
+    QueueItem *children=&queue->data[first];
+    int smallest,a,b;
+
+    if(first>=queue->noccupied)
+       break;
+
+    /* The unoccupied items have an infinite sortby so that all four children can be compared */
+
+    a=  (children[1].sortby<children[0].sortby);
+    b=2+(children[3].sortby<children[2].sortby);
+
+    smallest=first+((children[b].sortby<children[a].sortby)?b:a);
+
+    if(queue->data[smallest].sortby>=last.sortby)
+       break;
+
+    queue->data[index]=queue->data[smallest];
+    queue->data[index].result->queued=index+1;
+
+    index=smallest;
+   }
+
+ queue->data[index]=last;
+ last.result->queued=index+1;
+
+ return(retval);
+}
+
+#endif /* QUEUE_BINARY */
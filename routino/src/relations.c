@@ -24,7 +24,6 @@
 
 #include "types.h"
 #include "relations.h"
-#include "fakes.h"
 
 #include "files.h"
 
@@ -212,7 +211,7 @@ index_t FindNextTurnRelation1(Relations *relations,index_t current)
 
   index_t via The node that the route is going via.
 
-  index_t from The segment that the route is coming from.
+  index_t from The segment that the route is coming from (a real segment, not a fake one).
   ++++++++++++++++++++++++++++++++++++++*/
 
 index_t FindFirstTurnRelation2(Relations *relations,index_t via,index_t from)
@@ -223,9 +222,6 @@ index_t FindFirstTurnRelation2(Relations *relations,index_t via,index_t from)
  index_t mid;
  index_t match=-1;
 
- if(IsFakeSegment(from))
-    from=IndexRealSegment(from);
-
  /* Binary search - search key first match is required.
   *
   *  # <- start  |  Check mid and move start or end if it doesn't match
@@ -340,21 +336,15 @@ index_t FindNextTurnRelation2(Relations *relations,index_t current)
 
   index_t via The via node.
 
-  index_t from The from segment.
+  index_t from The from segment (a real segment, not a fake one).
 
-  index_t to The to segment.
+  index_t to The to segment (a real segment, not a fake one).
 
   transports_t transport The type of transport that is being routed.
   ++++++++++++++++++++++++++++++++++++++*/
 
 int IsTurnAllowed(Relations *relations,index_t index,index_t via,index_t from,index_t to,transports_t transport)
 {
- if(IsFakeSegment(from))
-    from=IndexRealSegment(from);
-
- if(IsFakeSegment(to))
-    to=IndexRealSegment(to);
-
  while(index<relations->file.trnumber)
    {
     TurnRelation *relation=LookupTurnRelation(relations,index,1);
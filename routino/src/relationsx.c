@@ -81,8 +81,8 @@ RelationsX *NewRelationList(int append,int readonly)
 
  /* Route Relations */
 
- relationsx->rfilename    =(char*)malloc(strlen(option_tmpdirname)+32);
- relationsx->rfilename_tmp=(char*)malloc(strlen(option_tmpdirname)+32);
+ relationsx->rfilename    =(char*)malloc(strlen(option_tmpdirname)+64);
+ relationsx->rfilename_tmp=(char*)malloc(strlen(option_tmpdirname)+64);
 
  sprintf(relationsx->rfilename    ,"%s/relationsx.route.parsed.mem",option_tmpdirname);
  sprintf(relationsx->rfilename_tmp,"%s/relationsx.route.%p.tmp"    ,option_tmpdirname,(void*)relationsx);
@@ -122,8 +122,8 @@ RelationsX *NewRelationList(int append,int readonly)
 
  /* Turn Restriction Relations */
 
- relationsx->trfilename    =(char*)malloc(strlen(option_tmpdirname)+32);
- relationsx->trfilename_tmp=(char*)malloc(strlen(option_tmpdirname)+32);
+ relationsx->trfilename    =(char*)malloc(strlen(option_tmpdirname)+64);
+ relationsx->trfilename_tmp=(char*)malloc(strlen(option_tmpdirname)+64);
 
  sprintf(relationsx->trfilename    ,"%s/relationsx.turn.parsed.mem",option_tmpdirname);
  sprintf(relationsx->trfilename_tmp,"%s/relationsx.turn.%p.tmp"    ,option_tmpdirname,(void*)relationsx);
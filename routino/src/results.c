@@ -25,49 +25,132 @@
 
 #include "results.h"
 
-#include "logging.h"
 
+/*+ The hash function for the slots (all of the results for a node start at the same slot). +*/
+#define HASH_NODE(node) ((((uint32_t)(node))*2654435761U)^(((uint32_t)(node))>>16))
+
+
+/* Local functions */
+
+static void resize_slots(Results *results);
 
-/*+ The maximum number of collisions in a bin for the Results 'point' arrays before worrying. +*/
-#define MAX_COLLISIONS 32
- 
 
 /*++++++++++++++++++++++++++++++++++++++
-  Allocate a new results list.
+  Allocate a new pool for the results lists and queues of one worker.
 
-  Results *NewResultsList Returns the results list.
+  ResultsPool *NewResultsPool Returns the pool.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+ResultsPool *NewResultsPool(void)
+{
+ ResultsPool *pool;
+
+ pool=(ResultsPool*)malloc(sizeof(ResultsPool));
+
+ pool->nresults=0;
+ pool->nqueues=0;
+
+ return(pool);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Free a pool and the results lists and queues that are in it.
 
-  int nbins The initial number of bins in the results array.
+  ResultsPool *pool The pool to be freed.
   ++++++++++++++++++++++++++++++++++++++*/
 
-Results *NewResultsList(int nbins)
+void FreeResultsPool(ResultsPool *pool)
 {
- Results *results;
+ /* The lists and queues in the pool are not linked to it so they are really freed */
 
- results=(Results*)malloc(sizeof(Results));
+ while(pool->nresults>0)
+    FreeResultsList(pool->results[--pool->nresults]);
 
- results->nbins=1;
- results->mask=~0;
+ while(pool->nqueues>0)
+    FreeQueueList(pool->queues[--pool->nqueues]);
+
+ free(pool);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Allocate a new results list or re-use one from the pool.
+
+  Results *NewResultsList Returns the results list.
+
+  ResultsPool *pool The pool to take the results list from and return it to (or NULL).
+
+  int nbins The initial number of results that can be stored without resizing.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+Results *NewResultsList(ResultsPool *pool,int nbins)
+{
+ Results *results=NULL;
+ uint32_t nslots=2,shift=0;
+
+ /* The hash table is kept no more than half full */
 
  while(nbins>>=1)
    {
-    results->mask<<=1;
-    results->nbins<<=1;
+    nslots<<=1;
+    shift++;
+   }
+
+ /* Re-use the smallest list from the pool that has big enough arrays (the size of the arrays cannot change) */
+
+ if(pool)
+   {
+    int i,best=-1;
+
+    for(i=0;i<pool->nresults;i++)
+       if(pool->results[i]->ndata2>=nslots/2 && (best<0 || pool->results[i]->ndata2<pool->results[best]->ndata2))
+          best=i;
+
+    if(best>=0)
+      {
+       results=pool->results[best];
+
+       pool->results[best]=pool->results[--pool->nresults];
+      }
+   }
+
+ if(results)
+   {
+    results->pool=pool;
+
+    /* Empty the hash table by starting a new epoch, the memory is kept */
+
+    if(++results->epoch==0)
+      {
+       memset(results->slots,0,results->nslots*sizeof(ResultSlot));
+
+       results->epoch=1;
+      }
+
+    results->number=0;
    }
+ else
+   {
+    results=(Results*)malloc(sizeof(Results));
 
- results->mask=~results->mask;
+    results->nslots=nslots;
+    results->mask=results->nslots-1;
 
- results->number=0;
+    results->number=0;
 
- results->npoint1=0;
+    results->epoch=1;
 
- results->count=(uint8_t*)calloc(results->nbins,sizeof(uint8_t));
- results->point=(Result***)malloc(MAX_COLLISIONS*sizeof(Result**));
+    results->slots=(ResultSlot*)calloc(results->nslots,sizeof(ResultSlot));
 
- results->ndata1=0;
- results->ndata2=results->nbins;
+    results->ndata1=0;
+    results->ndata2=results->nslots/2;
+    results->shift=shift;
 
- results->data=NULL;
+    results->data=NULL;
+
+    results->pool=pool;
+   }
 
  results->start_node=NO_NODE;
  results->prev_segment=NO_SEGMENT;
@@ -80,7 +163,7 @@ Results *NewResultsList(int nbins)
 
 
 /*++++++++++++++++++++++++++++++++++++++
-  Free a results list.
+  Free a results list or return it to its pool.
 
   Results *results The results list to be destroyed.
   ++++++++++++++++++++++++++++++++++++++*/
@@ -89,17 +172,22 @@ void FreeResultsList(Results *results)
 {
  int i;
 
+ if(results->pool && results->pool->nresults<POOL_SIZE)
+   {
+    ResultsPool *pool=results->pool;
+
+    results->pool=NULL;
+
+    pool->results[pool->nresults++]=results;
+    return;
+   }
+
  for(i=0;i<results->ndata1;i++)
     free(results->data[i]);
 
  free(results->data);
 
- for(i=0;i<results->npoint1;i++)
-    free(results->point[i]);
-
- free(results->point);
-
- free(results->count);
+ free(results->slots);
 
  free(results);
 }
@@ -120,85 +208,46 @@ void FreeResultsList(Results *results)
 Result *InsertResult(Results *results,index_t node,index_t segment)
 {
  Result *result;
- int bin=node&results->mask;
+ uint32_t slot,index;
 
- /* Check if we have hit the limit on the number of collisions per bin */
+ /* Check that the hash table will not be more than half full */
 
- if(results->count[bin]>MAX_COLLISIONS && results->count[bin]==results->npoint1)
-   {
-    int i,j,k;
+ if(2*(results->number+1)>results->nslots)
+    resize_slots(results);
 
-    results->nbins<<=1;
-    results->mask=(results->mask<<1)|1;
+ /* Check that the arrays have enough space or allocate more (the arrays from an earlier epoch are re-used). */
 
-    results->count=(uint8_t*)realloc((void*)results->count,results->nbins*sizeof(uint8_t));
-
-    for(i=0;i<results->npoint1;i++)
-       results->point[i]=(Result**)realloc((void*)results->point[i],results->nbins*sizeof(Result*));
-
-    for(i=0;i<results->nbins/2;i++)
-      {
-       int c=results->count[i];
-
-       results->count[i+results->nbins/2]=0;
-
-       for(j=0,k=0;j<c;j++)
-         {
-          int newbin=results->point[j][i]->node&results->mask;
-
-          if(newbin==i)
-            {
-             if(k!=j)
-                results->point[k][i]=results->point[j][i];
-             k++;
-            }
-          else
-            {
-             results->point[results->count[newbin]][newbin]=results->point[j][i];
-
-             results->count[newbin]++;
-             results->count[i]--;
-            }
-         }
-      }
+ if((results->number>>results->shift)==results->ndata1)
+   {
+    results->ndata1++;
 
-    bin=node&results->mask;
+    results->data=(Result**)realloc((void*)results->data,results->ndata1*sizeof(Result*));
+    results->data[results->ndata1-1]=(Result*)malloc(results->ndata2*sizeof(Result));
    }
 
- /* Check that the arrays have enough space or allocate more. */
-
- if(results->count[bin]==results->npoint1)
-   {
-    logassert(results->npoint1<255,"Results are more numerous than expected (report a bug)");
+ index=results->number++;
 
-    results->npoint1++;
+ result=&results->data[index>>results->shift][index&(results->ndata2-1)];
 
-    if(results->npoint1>MAX_COLLISIONS)
-       results->point=(Result***)realloc((void*)results->point,results->npoint1*sizeof(Result**));
+ /* Insert the new entry, replacing an existing one with the same node and segment */
 
-    results->point[results->npoint1-1]=(Result**)malloc(results->nbins*sizeof(Result*));
-   }
+ slot=HASH_NODE(node)&results->mask;
 
- if((results->number%results->ndata2)==0)
+ while(results->slots[slot].epoch==results->epoch)
    {
-    results->ndata1++;
+    if(results->slots[slot].node==node && results->slots[slot].segment==segment)
+       break;
 
-    results->data=(Result**)realloc((void*)results->data,results->ndata1*sizeof(Result*));
-    results->data[results->ndata1-1]=(Result*)malloc(results->ndata2*sizeof(Result));
+    slot=(slot+1)&results->mask;
    }
 
- /* Insert the new entry */
-
- results->point[results->count[bin]][bin]=&results->data[results->ndata1-1][results->number%results->ndata2];
-
- results->number++;
-
- results->count[bin]++;
+ results->slots[slot].node=node;
+ results->slots[slot].segment=segment;
+ results->slots[slot].epoch=results->epoch;
+ results->slots[slot].index=index;
 
  /* Initialise the result */
 
- result=results->point[results->count[bin]-1][bin];
-
  result->node=node;
  result->segment=segment;
 
@@ -232,18 +281,27 @@ Result *InsertResult(Results *results,index_t node,index_t segment)
 
 Result *FindResult1(Results *results,index_t node)
 {
- int bin=node&results->mask;
+ uint32_t slot=HASH_NODE(node)&results->mask;
  score_t best_score=INF_SCORE;
  Result *best_result=NULL;
- int i;
 
- for(i=results->count[bin]-1;i>=0;i--)
-    if(results->point[i][bin]->node==node && results->point[i][bin]->score<best_score)
+ while(results->slots[slot].epoch==results->epoch)
+   {
+    if(results->slots[slot].node==node)
       {
-       best_score=results->point[i][bin]->score;
-       best_result=results->point[i][bin];
+       uint32_t index=results->slots[slot].index;
+       Result *result=&results->data[index>>results->shift][index&(results->ndata2-1)];
+
+       if(result->score<best_score)
+         {
+          best_score=result->score;
+          best_result=result;
+         }
       }
 
+    slot=(slot+1)&results->mask;
+   }
+
  return(best_result);
 }
 
@@ -262,12 +320,19 @@ Result *FindResult1(Results *results,index_t node)
 
 Result *FindResult(Results *results,index_t node,index_t segment)
 {
- int bin=node&results->mask;
- int i;
+ uint32_t slot=HASH_NODE(node)&results->mask;
+
+ while(results->slots[slot].epoch==results->epoch)
+   {
+    if(results->slots[slot].node==node && results->slots[slot].segment==segment)
+      {
+       uint32_t index=results->slots[slot].index;
+
+       return(&results->data[index>>results->shift][index&(results->ndata2-1)]);
+      }
 
- for(i=results->count[bin]-1;i>=0;i--)
-    if(results->point[i][bin]->segment==segment && results->point[i][bin]->node==node)
-       return(results->point[i][bin]);
+    slot=(slot+1)&results->mask;
+   }
 
  return(NULL);
 }
@@ -283,6 +348,9 @@ Result *FindResult(Results *results,index_t node,index_t segment)
 
 Result *FirstResult(Results *results)
 {
+ if(results->number==0)
+    return(NULL);
+
  return(&results->data[0][0]);
 }
 
@@ -317,3 +385,34 @@ Result *NextResult(Results *results,Result *result)
 
  return(&results->data[i][j]);
 }
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Double the size of the hash table of results.
+
+  Results *results The results structure to resize.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static void resize_slots(Results *results)
+{
+ ResultSlot *oldslots=results->slots;
+ uint32_t i,noldslots=results->nslots;
+
+ results->nslots<<=1;
+ results->mask=results->nslots-1;
+
+ results->slots=(ResultSlot*)calloc(results->nslots,sizeof(ResultSlot));
+
+ for(i=0;i<noldslots;i++)
+    if(oldslots[i].epoch==results->epoch)
+      {
+       uint32_t slot=HASH_NODE(oldslots[i].node)&results->mask;
+
+       while(results->slots[slot].epoch==results->epoch)
+          slot=(slot+1)&results->mask;
+
+       results->slots[slot]=oldslots[i];
+      }
+
+ free(oldslots);
+}
@@ -33,11 +33,18 @@
 /*+ A result is not currently queued. +*/
 #define NOT_QUEUED (uint32_t)(0)
 
+/*+ The maximum number of results lists and of queues kept in a pool. +*/
+#define POOL_SIZE 16
+
 
 /* Data structures */
 
 typedef struct _Result Result;
 
+typedef struct _ResultsPool ResultsPool;
+
+typedef struct _Queue Queue;
+
 /*+ The result for a node. +*/
 struct _Result
 {
@@ -58,22 +65,32 @@ struct _Result
  uint32_t  queued;              /*+ The position of this result in the queue. +*/
 };
 
+/*+ A slot in the hash table of results. +*/
+typedef struct _ResultSlot
+{
+ index_t   node;                /*+ The node of the result in this slot. +*/
+ index_t   segment;             /*+ The segment of the result in this slot. +*/
+
+ uint32_t  epoch;               /*+ The epoch of the results list when the slot was filled (empty if not the current one). +*/
+ uint32_t  index;               /*+ The index of the result in the 'data' arrays. +*/
+}
+ ResultSlot;
+
 /*+ A list of results. +*/
 typedef struct _Results
 {
- uint32_t  nbins;               /*+ The number of bins. +*/
- uint32_t  mask;                /*+ A bit mask to select the bottom 'nbins' bits. +*/
+ uint32_t  nslots;              /*+ The number of slots in the hash table. +*/
+ uint32_t  mask;                /*+ A bit mask to select the bottom 'nslots' bits. +*/
 
  uint32_t  number;              /*+ The total number of occupied results. +*/
 
- uint8_t   npoint1;             /*+ The amount of space allocated for results
-                                    (the first dimension of the 'point' array). +*/
+ uint32_t  epoch;               /*+ The current epoch (incremented to empty the hash table when the list is re-used). +*/
 
- uint8_t  *count;               /*+ An array of nbins counters of results in each array. +*/
- Result ***point;               /*+ An array of nbins arrays of pointers to actual results. +*/
+ ResultSlot *slots;             /*+ The hash table of results (open addressing with linear probing). +*/
 
  uint32_t  ndata1;              /*+ The size of the first dimension of the 'data' array. +*/
- uint32_t  ndata2;              /*+ The size of the second dimension of the 'data' array. +*/
+ uint32_t  ndata2;              /*+ The size of the second dimension of the 'data' array (a power of 2). +*/
+ uint32_t  shift;               /*+ The number of bits to shift an index by to get the first dimension. +*/
 
  Result  **data;                /*+ An array of arrays containing the actual results, the first
                                     dimension is reallocated but the second dimension is not.
@@ -85,18 +102,28 @@ typedef struct _Results
 
  index_t finish_node;           /*+ The finish node. +*/
  index_t last_segment;          /*+ The last segment (to arrive at the finish node). +*/
+
+ ResultsPool *pool;             /*+ The pool that the list is returned to when it is freed (or NULL). +*/
 }
  Results;
 
+/*+ The results lists and queues that one worker keeps between searches instead of freeing them. +*/
+struct _ResultsPool
+{
+ int      nresults;             /*+ The number of results lists in the pool. +*/
+ Results *results[POOL_SIZE];   /*+ The results lists that are not in use. +*/
 
-/* Forward definition for opaque type */
-
-typedef struct _Queue Queue;
+ int      nqueues;              /*+ The number of queues in the pool. +*/
+ Queue   *queues[POOL_SIZE];    /*+ The queues that are not in use. +*/
+};
 
 
 /* Results functions in results.c */
 
-Results *NewResultsList(int nbins);
+ResultsPool *NewResultsPool(void);
+void FreeResultsPool(ResultsPool *pool);
+
+Results *NewResultsList(ResultsPool *pool,int nbins);
 void FreeResultsList(Results *results);
 
 Result *InsertResult(Results *results,index_t node,index_t segment);
@@ -110,7 +137,7 @@ Result *NextResult(Results *results,Result *result);
 
 /* Queue functions in queue.c */
 
-Queue *NewQueueList(void);
+Queue *NewQueueList(ResultsPool *pool);
 void FreeQueueList(Queue *queue);
 
 void InsertInQueue(Queue *queue,Result *result);
@@ -24,17 +24,26 @@
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <unistd.h>
+
+#if defined(USE_PTHREADS) && USE_PTHREADS
+#include <pthread.h>
+#endif
 
 #include "types.h"
 #include "nodes.h"
 #include "segments.h"
 #include "ways.h"
 #include "relations.h"
+#include "landmarks.h"
+#include "hierarchy.h"
+#include "partition.h"
 
 #include "files.h"
 #include "logging.h"
 #include "functions.h"
 #include "fakes.h"
+#include "query.h"
 #include "translations.h"
 #include "profiles.h"
 
@@ -46,20 +55,107 @@
 #define MAXSEARCH  1
 
 
+/*+ The maximum number of options in one request in server mode. +*/
+#define MAXARGS 256
+
+/*+ The default epsilon factor for the Pareto routes (in percent). +*/
+#define PARETO_EPSILON 5
+
+/*+ The maximum number of Pareto routes to find (they are stored like the routes between waypoints so must be less than NWAYPOINTS). +*/
+#define MAX_PARETO_ROUTES 32
+
+
+/* Local types */
+
+/*+ The waypoints and the options for finding them. +*/
+typedef struct _Waypoints
+{
+ int    point_used[NWAYPOINTS+1];  /*+ The parts of the waypoints given (1 = longitude, 2 = latitude). +*/
+ double point_lon[NWAYPOINTS+1];   /*+ The longitudes of the waypoints. +*/
+ double point_lat[NWAYPOINTS+1];   /*+ The latitudes of the waypoints. +*/
+ double heading;                   /*+ The initial heading at the first waypoint (or -999). +*/
+ int    exactnodes;                /*+ Set if only routing between nodes. +*/
+}
+ Waypoints;
+
+/*+ The data shared by the threads that route a batch of waypoints. +*/
+typedef struct _Batch
+{
+ Nodes     *OSMNodes;              /*+ The set of nodes to use. +*/
+ Segments  *OSMSegments;           /*+ The set of segments to use. +*/
+ Ways      *OSMWays;               /*+ The set of ways to use. +*/
+ Relations *OSMRelations;          /*+ The set of relations to use. +*/
+
+ Profile   *profile;               /*+ The profile to use (already updated). +*/
+ Query     *defquery;              /*+ The query holding the routing options (copied by each thread). +*/
+ int        exactnodes;            /*+ Set if only routing between nodes. +*/
+
+ FILE      *input;                 /*+ The file to read the waypoints from. +*/
+ FILE      *output;                /*+ The file to write the records to. +*/
+ unsigned long line;               /*+ The number of lines read from the input. +*/
+ unsigned long nsettled;           /*+ The total number of nodes settled by the route searches. +*/
+
+#if defined(USE_PTHREADS) && USE_PTHREADS
+ pthread_mutex_t mutex;            /*+ The mutex for reading the input and writing the output. +*/
+#endif
+}
+ Batch;
+
+
+/*+ The route between one source and one target of a matrix. +*/
+typedef struct _MatrixCell
+{
+ score_t    score;                 /*+ The score of the route (weighted distance or duration). +*/
+ distance_t distance;              /*+ The distance of the route. +*/
+ duration_t duration;              /*+ The duration of the route. +*/
+ double     ascent;                /*+ The total ascent of the route (in metres). +*/
+
+ char       error[80];             /*+ The message if there is no route (or empty). +*/
+}
+ MatrixCell;
+
+
 /* Global variables */
 
 /*+ The option not to print any progress information. +*/
 int option_quiet=0;
 
-/*+ The options to select the format of the output. +*/
-int option_html=0,option_gpx_track=0,option_gpx_route=0,option_text=0,option_text_all=0,option_none=0;
-
-/*+ The option to calculate the quickest route insted of the shortest. +*/
-int option_quickest=0;
 
 
 /* Local functions */
 
+static int parse_routing_options(int argc,char **argv,Query *query,Profile *profile,Waypoints *waypoints);
+
+static const char *calculate_route(Query *query,Nodes *OSMNodes,Segments *OSMSegments,Ways *OSMWays,Relations *OSMRelations,
+                                   Profile *profile,Waypoints *waypoints,Results **results);
+
+static const char *calculate_reachable(Query *query,Nodes *OSMNodes,Segments *OSMSegments,Ways *OSMWays,Relations *OSMRelations,
+                                       Profile *profile,Waypoints *waypoints,Results **results);
+
+static const char *calculate_pareto(Query *query,Nodes *OSMNodes,Segments *OSMSegments,Ways *OSMWays,Relations *OSMRelations,
+                                    Profile *profile,Waypoints *waypoints,Results **routes,int *nroutes);
+
+static int server(Nodes *OSMNodes,Segments *OSMSegments,Ways *OSMWays,Relations *OSMRelations,Landmarks *OSMLandmarks,Hierarchy *OSMHierarchy,Partition *OSMPartition,
+                  Profile *profile,int exactnodes);
+static const char *server_request(Query *query,Nodes *OSMNodes,Segments *OSMSegments,Ways *OSMWays,Relations *OSMRelations,
+                                  Profile *defprofile,int exactnodes,int argc,char **argv);
+
+static int batch(Nodes *OSMNodes,Segments *OSMSegments,Ways *OSMWays,Relations *OSMRelations,Profile *profile,
+                 Query *defquery,int exactnodes,const char *filename,int nthreads);
+static void *batch_thread(Batch *batch);
+static int batch_request(Batch *batch,Query *query,char *line,unsigned long number,char *record);
+
+static int matrix(Nodes *OSMNodes,Segments *OSMSegments,Ways *OSMWays,Relations *OSMRelations,Profile *profile,
+                  Query *query,int exactnodes,const char *filename);
+static void calculate_matrix(Query *query,Nodes *OSMNodes,Segments *OSMSegments,Ways *OSMWays,Relations *OSMRelations,
+                             Profile *profile,int exactnodes,
+                             int nsources,double *source_lat,double *source_lon,
+                             int ntargets,double *target_lat,double *target_lon,
+                             MatrixCell *cells);
+static index_t matrix_point(Query *query,Nodes *OSMNodes,Segments *OSMSegments,Ways *OSMWays,Profile *profile,
+                            int exactnodes,int point,double lat,double lon);
+static int matrix_local(Query *query,Nodes *OSMNodes,Results *begin,Results *end);
+
 static void print_usage(int detail,const char *argerr,const char *err);
 
 
@@ -74,26 +170,27 @@ int main(int argc,char** argv)
  Ways     *OSMWays;
  Relations*OSMRelations;
  Results  *results[NWAYPOINTS+1]={NULL};
- int       point_used[NWAYPOINTS+1]={0};
- double    point_lon[NWAYPOINTS+1],point_lat[NWAYPOINTS+1];
- double    heading=-999;
+ Waypoints waypoints;
+ Query     query;
  int       help_profile=0,help_profile_xml=0,help_profile_json=0,help_profile_pl=0;
  char     *dirname=NULL,*prefix=NULL;
  char     *profiles=NULL,*profilename=NULL;
  char     *translations=NULL,*language=NULL;
- int       exactnodes=0;
+ char     *batchfile=NULL,*matrixfile=NULL;
+ int       exactnodes=0,serve=0,option_none=0,nolandmarks=0,nohierarchy=0,nopartition=0;
+ int       nthreads=0;
  Transport transport=Transport_None;
  Profile  *profile=NULL;
- index_t   start_node=NO_NODE,finish_node=NO_NODE;
- index_t   join_segment=NO_SEGMENT;
- int       arg,point;
- float     hills = 0;
+ const char *error;
+ int       arg;
 
  /* Parse the command line arguments */
 
  if(argc<2)
     print_usage(0,NULL,NULL);
 
+ memset(&query,0,sizeof(Query));
+
  /* Get the non-routing, general program options */
 
  for(arg=1;arg<argc;arg++)
@@ -118,20 +215,34 @@ int main(int argc,char** argv)
        translations=&argv[arg][15];
     else if(!strcmp(argv[arg],"--exact-nodes-only"))
        exactnodes=1;
+    else if(!strcmp(argv[arg],"--no-landmarks"))
+       nolandmarks=1;
+    else if(!strcmp(argv[arg],"--no-hierarchy"))
+       nohierarchy=1;
+    else if(!strcmp(argv[arg],"--no-partition"))
+       nopartition=1;
+    else if(!strcmp(argv[arg],"--server"))
+       serve=1;
+    else if(!strncmp(argv[arg],"--batch=",8))
+       batchfile=&argv[arg][8];
+    else if(!strncmp(argv[arg],"--threads=",10))
+       nthreads=atoi(&argv[arg][10]);
+    else if(!strncmp(argv[arg],"--matrix=",9))
+       matrixfile=&argv[arg][9];
     else if(!strcmp(argv[arg],"--quiet"))
        option_quiet=1;
     else if(!strcmp(argv[arg],"--loggable"))
        option_loggable=1;
     else if(!strcmp(argv[arg],"--output-html"))
-       option_html=1;
+       query.html=1;
     else if(!strcmp(argv[arg],"--output-gpx-track"))
-       option_gpx_track=1;
+       query.gpx_track=1;
     else if(!strcmp(argv[arg],"--output-gpx-route"))
-       option_gpx_route=1;
+       query.gpx_route=1;
     else if(!strcmp(argv[arg],"--output-text"))
-       option_text=1;
+       query.text=1;
     else if(!strcmp(argv[arg],"--output-text-all"))
-       option_text_all=1;
+       query.text_all=1;
     else if(!strcmp(argv[arg],"--output-none"))
        option_none=1;
     else if(!strncmp(argv[arg],"--profile=",10))
@@ -206,29 +317,277 @@ int main(int argc,char** argv)
 
  /* Parse the other command line arguments */
 
+ arg=parse_routing_options(argc,argv,&query,profile,&waypoints);
+
+ if(arg>0)
+    print_usage(0,argv[arg],NULL);
+ else if(arg<0)
+    print_usage(0,NULL,"All waypoints must have latitude and longitude.");
+
+ waypoints.exactnodes=exactnodes;
+
+ /* Print one of the profiles if requested */
+
+ if(help_profile)
+   {
+    PrintProfile(profile);
+
+    return(0);
+   }
+ else if(help_profile_xml)
+   {
+    PrintProfilesXML();
+
+    return(0);
+   }
+ else if(help_profile_json)
+   {
+    PrintProfilesJSON();
+
+    return(0);
+   }
+ else if(help_profile_pl)
+   {
+    PrintProfilesPerl();
+
+    return(0);
+   }
+
+ /* Load in the translations */
+
+ if(query.html==0 && query.gpx_track==0 && query.gpx_route==0 && query.text==0 && query.text_all==0 && option_none==0)
+    query.html=query.gpx_track=query.gpx_route=query.text=query.text_all=1;
+
+ if(serve || (!batchfile && !matrixfile && (query.html || query.gpx_route || query.gpx_track)))
+   {
+    if(translations)
+      {
+       if(!ExistsFile(translations))
+         {
+          fprintf(stderr,"Error: The '--translations' option specifies a file that does not exist.\n");
+          return(1);
+         }
+      }
+    else
+      {
+       if(ExistsFile(FileName(dirname,prefix,"translations.xml")))
+          translations=FileName(dirname,prefix,"translations.xml");
+       else if(ExistsFile(FileName(DATADIR,NULL,"translations.xml")))
+          translations=FileName(DATADIR,NULL,"translations.xml");
+       else
+         {
+          fprintf(stderr,"Error: The '--translations' option was not used and the default 'translations.xml' does not exist.\n");
+          return(1);
+         }
+      }
+
+    if(ParseXMLTranslations(translations,language))
+      {
+       fprintf(stderr,"Error: Cannot read the translations in the file '%s'.\n",translations);
+       return(1);
+      }
+   }
+
+ query.translation=GetTranslation();
+
+ /* Load in the data - Note: No error checking because Load*List() will call exit() in case of an error. */
+
+ OSMNodes=LoadNodeList(FileName(dirname,prefix,"nodes.mem"));
+
+ OSMSegments=LoadSegmentList(FileName(dirname,prefix,"segments.mem"));
+
+ OSMWays=LoadWayList(FileName(dirname,prefix,"ways.mem"));
+
+ OSMRelations=LoadRelationList(FileName(dirname,prefix,"relations.mem"));
+
+ /* The landmarks are optional (planetsplitter only creates them if asked) */
+
+ if(!nolandmarks && ExistsFile(FileName(dirname,prefix,"landmarks.mem")))
+   {
+    query.landmarks=LoadLandmarkList(FileName(dirname,prefix,"landmarks.mem"));
+
+    if(query.landmarks->file.nnodes!=OSMNodes->file.number)
+      {
+       fprintf(stderr,"Error: The landmarks file does not match the nodes file.\n");
+       return(1);
+      }
+   }
+
+ /* The contraction hierarchy is optional (planetsplitter only creates it if asked) */
+
+ if(!nohierarchy && ExistsFile(FileName(dirname,prefix,"hierarchy.mem")))
+   {
+    query.hierarchy=LoadHierarchy(FileName(dirname,prefix,"hierarchy.mem"));
+
+    if(query.hierarchy->file.nnodes!=OSMNodes->file.number)
+      {
+       fprintf(stderr,"Error: The hierarchy file does not match the nodes file.\n");
+       return(1);
+      }
+   }
+
+ /* The partition is optional (planetsplitter only creates it if asked) */
+
+ if(!nopartition && ExistsFile(FileName(dirname,prefix,"partition.mem")))
+   {
+    query.partition=LoadPartition(FileName(dirname,prefix,"partition.mem"));
+
+    if(query.partition->file.nnodes!=OSMNodes->file.number)
+      {
+       fprintf(stderr,"Error: The partition file does not match the nodes file.\n");
+       return(1);
+      }
+   }
+
+ /* Run as a server if requested */
+
+ if(serve)
+    return(server(OSMNodes,OSMSegments,OSMWays,OSMRelations,query.landmarks,query.hierarchy,query.partition,profile,exactnodes));
+
+ if(UpdateProfile(profile,OSMWays))
+   {
+    fprintf(stderr,"Error: Profile is invalid or not compatible with database.\n");
+    return(1);
+   }
+
+ /* Calculate the scores for the partition (in the batch and matrix modes after stdout is used for the records) */
+
+ if(query.partition && !batchfile && !matrixfile)
+    query.customisation=CustomisePartition(query.partition,OSMNodes,OSMSegments,OSMWays,profile,query.quickest);
+
+ /* Keep the results lists and queues between the searches (each batch thread has its own) */
+
+ query.pool=NewResultsPool();
+
+ /* Route a batch of waypoints if requested */
+
+ if(batchfile)
+    return(batch(OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,&query,exactnodes,batchfile,nthreads));
+
+ /* Calculate a matrix of routes if requested */
+
+ if(matrixfile)
+    return(matrix(OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,&query,exactnodes,matrixfile));
+
+ /* Find the reachable nodes if requested */
+
+ if(query.reach_duration || query.reach_distance)
+   {
+    error=calculate_reachable(&query,OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,&waypoints,&results[0]);
+
+    if(error)
+      {
+       fprintf(stderr,"Error: %s\n",error);
+       return(1);
+      }
+
+    if(!option_none)
+       PrintReachable(&query,results[0],OSMNodes);
+
+    return(0);
+   }
+
+ /* Find the Pareto routes if requested */
+
+ if(query.pareto)
+   {
+    int nroutes;
+
+    error=calculate_pareto(&query,OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,&waypoints,results,&nroutes);
+
+    if(error)
+      {
+       fprintf(stderr,"Error: %s\n",error);
+       return(1);
+      }
+
+    if(!option_quiet)
+      {
+       printf("Routed OK (%d routes, %lu labels settled)\n",nroutes,query.nsettled);
+       fflush(stdout);
+      }
+
+    if(!option_none)
+       PrintPareto(&query,results,nroutes,OSMNodes,OSMSegments,OSMWays,profile);
+
+    return(0);
+   }
+
+ /* Calculate the route */
+
+ error=calculate_route(&query,OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,&waypoints,results);
+
+ if(error)
+   {
+    fprintf(stderr,"Error: %s\n",error);
+    return(1);
+   }
+
+ if(!option_quiet)
+   {
+    printf("Routed OK (%lu nodes settled)\n",query.nsettled);
+    fflush(stdout);
+   }
+
+ /* Print out the combined route */
+
+ if(!option_none)
+    PrintRoute(&query,results,NWAYPOINTS,OSMNodes,OSMSegments,OSMWays,profile);
+
+ return(0);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Parse the routing options (the waypoints and the modifications to the profile).
+
+  int parse_routing_options Returns 0 if OK, the index of the invalid option or -1 if a waypoint is incomplete.
+
+  int argc The number of options.
+
+  char **argv The options (those already used are NULL).
+
+  Query *query The query to set the routing options in.
+
+  Profile *profile The profile to modify.
+
+  Waypoints *waypoints Returns the waypoints.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static int parse_routing_options(int argc,char **argv,Query *query,Profile *profile,Waypoints *waypoints)
+{
+ int arg,point;
+
+ for(point=0;point<=NWAYPOINTS;point++)
+    waypoints->point_used[point]=0;
+
+ waypoints->heading=-999;
+
  for(arg=1;arg<argc;arg++)
    {
     if(!argv[arg])
        continue;
     else if(!strcmp(argv[arg],"--shortest"))
-       option_quickest=0;
+       query->quickest=0;
     else if(!strcmp(argv[arg],"--quickest"))
-       option_quickest=1;
+       query->quickest=1;
+    else if(!strcmp(argv[arg],"--bidirectional"))
+       query->bidirectional=1;
     else if(isdigit(argv[arg][0]) ||
        ((argv[arg][0]=='-' || argv[arg][0]=='+') && isdigit(argv[arg][1])))
       {
        for(point=1;point<=NWAYPOINTS;point++)
-          if(point_used[point]!=3)
+          if(waypoints->point_used[point]!=3)
             {
-             if(point_used[point]==0)
+             if(waypoints->point_used[point]==0)
                {
-                point_lon[point]=degrees_to_radians(atof(argv[arg]));
-                point_used[point]=1;
+                waypoints->point_lon[point]=degrees_to_radians(atof(argv[arg]));
+                waypoints->point_used[point]=1;
                }
-             else /* if(point_used[point]==1) */
+             else /* if(waypoints->point_used[point]==1) */
                {
-                point_lat[point]=degrees_to_radians(atof(argv[arg]));
-                point_used[point]=3;
+                waypoints->point_lat[point]=degrees_to_radians(atof(argv[arg]));
+                waypoints->point_used[point]=3;
                }
              break;
             }
@@ -238,28 +597,28 @@ int main(int argc,char** argv)
         char *p=&argv[arg][6];
         while(isdigit(*p)) p++;
         if(*p++!='=')
-           print_usage(0,argv[arg],NULL);
+           return(arg);
  
         point=atoi(&argv[arg][5]);
-        if(point>NWAYPOINTS || point_used[point]&1)
-           print_usage(0,argv[arg],NULL);
+        if(point>NWAYPOINTS || waypoints->point_used[point]&1)
+           return(arg);
  
-       point_lon[point]=degrees_to_radians(atof(p));
-       point_used[point]+=1;
+       waypoints->point_lon[point]=degrees_to_radians(atof(p));
+       waypoints->point_used[point]+=1;
       }
      else if(!strncmp(argv[arg],"--lat",5) && isdigit(argv[arg][5]))
        {
         char *p=&argv[arg][6];
         while(isdigit(*p)) p++;
         if(*p++!='=')
-           print_usage(0,argv[arg],NULL);
+           return(arg);
  
         point=atoi(&argv[arg][5]);
-        if(point>NWAYPOINTS || point_used[point]&2)
-           print_usage(0,argv[arg],NULL);
+        if(point>NWAYPOINTS || waypoints->point_used[point]&2)
+           return(arg);
  
-       point_lat[point]=degrees_to_radians(atof(p));
-       point_used[point]+=2;
+       waypoints->point_lat[point]=degrees_to_radians(atof(p));
+       waypoints->point_used[point]+=2;
       }
     else if(!strncmp(argv[arg],"--heading=",10))
       {
@@ -267,9 +626,9 @@ int main(int argc,char** argv)
 
        if(h>=-360 && h<=360)
          {
-          heading=h;
+          waypoints->heading=h;
 
-          if(heading<0) heading+=360;
+          if(waypoints->heading<0) waypoints->heading+=360;
          }
       }
     else if(!strncmp(argv[arg],"--transport=",12))
@@ -281,19 +640,19 @@ int main(int argc,char** argv)
        char *string;
 
        if(!equal)
-           print_usage(0,argv[arg],NULL);
+           return(arg);
 
        string=strcpy((char*)malloc(strlen(argv[arg])),argv[arg]+10);
        string[equal-argv[arg]-10]=0;
 
        highway=HighwayType(string);
 
+       free(string);
+
        if(highway==Highway_None)
-          print_usage(0,argv[arg],NULL);
+          return(arg);
 
        profile->highway[highway]=atof(equal+1);
-
-       free(string);
       }
     else if(!strncmp(argv[arg],"--speed-",8))
       {
@@ -302,19 +661,19 @@ int main(int argc,char** argv)
        char *string;
 
        if(!equal)
-          print_usage(0,argv[arg],NULL);
+          return(arg);
 
        string=strcpy((char*)malloc(strlen(argv[arg])),argv[arg]+8);
        string[equal-argv[arg]-8]=0;
 
        highway=HighwayType(string);
 
+       free(string);
+
        if(highway==Highway_None)
-          print_usage(0,argv[arg],NULL);
+          return(arg);
 
        profile->speed[highway]=kph_to_speed(atof(equal+1));
-
-       free(string);
       }
     else if(!strncmp(argv[arg],"--property-",11))
       {
@@ -323,19 +682,19 @@ int main(int argc,char** argv)
        char *string;
 
        if(!equal)
-          print_usage(0,argv[arg],NULL);
+          return(arg);
 
        string=strcpy((char*)malloc(strlen(argv[arg])),argv[arg]+11);
        string[equal-argv[arg]-11]=0;
 
        property=PropertyType(string);
 
+       free(string);
+
        if(property==Property_None)
-          print_usage(0,argv[arg],NULL);
+          return(arg);
 
        profile->props_yes[property]=atof(equal+1);
-
-       free(string);
       }
     else if(!strncmp(argv[arg],"--oneway=",9))
        profile->oneway=!!atoi(&argv[arg][9]);
@@ -347,280 +706,1403 @@ int main(int argc,char** argv)
        profile->height=metres_to_height(atof(&argv[arg][9]));
     else if(!strncmp(argv[arg],"--width=",8))
        profile->width=metres_to_width(atof(&argv[arg][8]));
-    else if(!strncmp(argv[arg],"--length=",9)) //hills supplied via length parameter
-       hills=atof(&argv[arg][9]);
-       //profile->length=metres_to_length(atof(&argv[arg][9]));
+    else if(!strncmp(argv[arg],"--length=",9)) /* the web page sends the hills as the length */
+       profile->hills=atof(&argv[arg][9]);
     else if(!strncmp(argv[arg],"--hills=",8))
-       hills=atof(&argv[arg][8]);
+       profile->hills=atof(&argv[arg][8]);
+    else if(!strncmp(argv[arg],"--reach-duration=",17))
+       query->reach_duration=minutes_to_duration(atof(&argv[arg][17]));
+    else if(!strncmp(argv[arg],"--reach-distance=",17))
+       query->reach_distance=km_to_distance(atof(&argv[arg][17]));
+    else if(!strncmp(argv[arg],"--reach-ascent=",15))
+       query->reach_ascent=atof(&argv[arg][15]);
+    else if(!strcmp(argv[arg],"--pareto"))
+      {
+       query->pareto=1;
+       query->pareto_epsilon=(double)PARETO_EPSILON/100;
+      }
+    else if(!strncmp(argv[arg],"--pareto=",9))
+      {
+       query->pareto=1;
+       query->pareto_epsilon=atof(&argv[arg][9])/100;
+      }
     else
-       print_usage(0,argv[arg],NULL);
+       return(arg);
    }
- profile->hills = hills; //zero means no optimization
 
  for(point=1;point<=NWAYPOINTS;point++)
-    if(point_used[point]==1 || point_used[point]==2)
-       print_usage(0,NULL,"All waypoints must have latitude and longitude.");
+    if(waypoints->point_used[point]==1 || waypoints->point_used[point]==2)
+       return(-1);
 
- /* Print one of the profiles if requested */
+ return(0);
+}
 
- if(help_profile)
-   {
-    PrintProfile(profile);
 
-    return(0);
-   }
- else if(help_profile_xml)
-   {
-    PrintProfilesXML();
+/*++++++++++++++++++++++++++++++++++++++
+  Calculate the route between the waypoints.
 
-    return(0);
-   }
- else if(help_profile_json)
-   {
-    PrintProfilesJSON();
+  const char *calculate_route Returns NULL if OK or an error message.
 
-    return(0);
-   }
- else if(help_profile_pl)
-   {
-    PrintProfilesPerl();
+  Query *query The query to calculate (the fake nodes and segments are replaced).
 
-    return(0);
-   }
+  Nodes *OSMNodes The set of nodes to use.
 
- /* Load in the translations */
+  Segments *OSMSegments The set of segments to use.
 
- if(option_html==0 && option_gpx_track==0 && option_gpx_route==0 && option_text==0 && option_text_all==0 && option_none==0)
-    option_html=option_gpx_track=option_gpx_route=option_text=option_text_all=1;
+  Ways *OSMWays The set of ways to use.
 
- if(option_html || option_gpx_route || option_gpx_track)
-   {
-    if(translations)
-      {
-       if(!ExistsFile(translations))
-         {
-          fprintf(stderr,"Error: The '--translations' option specifies a file that does not exist.\n");
-          return(1);
-         }
+  Relations *OSMRelations The set of relations to use.
+
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
+
+  Waypoints *waypoints The waypoints to route between.
+
+  Results **results Returns the results for each pair of waypoints.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static const char *calculate_route(Query *query,Nodes *OSMNodes,Segments *OSMSegments,Ways *OSMWays,Relations *OSMRelations,
+                                   Profile *profile,Waypoints *waypoints,Results **results)
+{
+ index_t start_node=NO_NODE,finish_node=NO_NODE;
+ index_t join_segment=NO_SEGMENT;
+ int     point;
+
+ ResetFakes(query);
+
+ query->nsettled=0;
+
+ /* Loop through all pairs of points */
+
+ for(point=1;point<=NWAYPOINTS;point++)
+   {
+    Results *begin,*end;
+    distance_t distmax=km_to_distance(MAXSEARCH);
+    distance_t distmin;
+    index_t segment=NO_SEGMENT;
+    index_t node1,node2;
+
+    if(waypoints->point_used[point]!=3)
+       continue;
+
+    /* Find the closest point */
+
+    start_node=finish_node;
+
+    if(waypoints->exactnodes)
+      {
+       finish_node=FindClosestNode(OSMNodes,OSMSegments,OSMWays,waypoints->point_lat[point],waypoints->point_lon[point],distmax,profile,&distmin);
+      }
+    else
+      {
+       distance_t dist1,dist2;
+
+       segment=FindClosestSegment(OSMNodes,OSMSegments,OSMWays,waypoints->point_lat[point],waypoints->point_lon[point],distmax,profile,&distmin,&node1,&node2,&dist1,&dist2);
+
+       if(segment!=NO_SEGMENT)
+          finish_node=CreateFakes(query,OSMNodes,OSMSegments,point,LookupSegment(OSMSegments,segment,1),node1,node2,dist1,dist2);
+       else
+          finish_node=NO_NODE;
+      }
+
+    if(finish_node==NO_NODE)
+      {
+       sprintf(query->error,"Cannot find node close to specified point %d.",point);
+       return(query->error);
+      }
+
+    if(!option_quiet)
+      {
+       double lat,lon;
+
+       if(IsFakeNode(finish_node))
+          GetFakeLatLong(query,finish_node,&lat,&lon);
+       else
+          GetLatLong(OSMNodes,finish_node,&lat,&lon);
+
+       if(IsFakeNode(finish_node))
+          printf("Point %d is segment %"Pindex_t" (node %"Pindex_t" -> %"Pindex_t"): %3.6f %4.6f = %2.3f km\n",point,segment,node1,node2,
+                 radians_to_degrees(lon),radians_to_degrees(lat),distance_to_km(distmin));
+       else
+          printf("Point %d is node %"Pindex_t": %3.6f %4.6f = %2.3f km\n",point,finish_node,
+                 radians_to_degrees(lon),radians_to_degrees(lat),distance_to_km(distmin));
+      }
+
+    if(start_node==NO_NODE)
+       continue;
+
+    if(start_node==finish_node)
+       continue;
+
+    if(waypoints->heading!=-999 && join_segment==NO_SEGMENT)
+       join_segment=FindClosestSegmentHeading(query,OSMNodes,OSMSegments,OSMWays,start_node,waypoints->heading,profile);
+
+    /* Calculate the beginning of the route */
+
+    begin=FindStartRoutes(query,OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,start_node,join_segment,finish_node);
+
+    if(begin)
+      {
+       /* Check if the end of the route was reached */
+
+       if(FindResult1(begin,finish_node))
+          results[point]=ExtendStartRoutes(query,OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,begin,finish_node);
+      }
+    else
+      {
+       if(join_segment!=NO_SEGMENT)
+         {
+          /* Try again but allow a U-turn at the start waypoint -
+             this solves the problem of facing a dead-end that contains no super-nodes. */
+
+          join_segment=NO_SEGMENT;
+
+          begin=FindStartRoutes(query,OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,start_node,join_segment,finish_node);
+         }
+
+       if(begin)
+         {
+          /* Check if the end of the route was reached */
+
+          if(FindResult1(begin,finish_node))
+             results[point]=ExtendStartRoutes(query,OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,begin,finish_node);
+         }
+       else
+         {
+          return("Cannot find initial section of route compatible with profile.");
+         }
+      }
+
+    /* Calculate the rest of the route */
+
+    if(!results[point])
+      {
+       Results *middle;
+
+       /* Calculate the end of the route */
+
+       end=FindFinishRoutes(query,OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,finish_node);
+
+       if(!end)
+         {
+          FreeResultsList(begin);
+
+          return("Cannot find final section of route compatible with profile.");
+         }
+
+       /* Calculate the middle of the route */
+
+       middle=FindMiddleRoute(query,OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,begin,end);
+
+       if(!middle && join_segment!=NO_SEGMENT)
+         {
+          /* Try again but allow a U-turn at the start waypoint -
+             this solves the problem of facing a dead-end that contains some super-nodes. */
+
+          FreeResultsList(begin);
+
+          begin=FindStartRoutes(query,OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,start_node,NO_SEGMENT,finish_node);
+
+          if(begin)
+             middle=FindMiddleRoute(query,OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,begin,end);
+         }
+
+       FreeResultsList(end);
+
+       if(!middle)
+         {
+          if(begin)
+             FreeResultsList(begin);
+
+          return("Cannot find super-route compatible with profile.");
+         }
+
+       results[point]=CombineRoutes(query,OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,begin,middle);
+
+       if(!results[point])
+         {
+          FreeResultsList(begin);
+
+          FreeResultsList(middle);
+
+          return("Cannot create combined route following super-route.");
+         }
+
+       FreeResultsList(begin);
+
+       FreeResultsList(middle);
+      }
+
+#if DEBUG
+    Result *r=FindResult(results[point],results[point]->start_node,results[point]->prev_segment);
+
+    printf("The final route is:\n");
+
+    while(r)
+      {
+       printf("  node=%"Pindex_t" segment=%"Pindex_t" score=%f\n",r->node,r->segment,r->score);
+
+       r=r->next;
+      }
+#endif
+
+    join_segment=results[point]->last_segment;
+   }
+
+ return(NULL);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Find the nodes that can be reached from the first waypoint within the limits.
+
+  const char *calculate_reachable Returns NULL if OK or an error message.
+
+  Query *query The query to calculate (holding the limits, the fake nodes and segments are replaced).
+
+  Nodes *OSMNodes The set of nodes to use.
+
+  Segments *OSMSegments The set of segments to use.
+
+  Ways *OSMWays The set of ways to use.
+
+  Relations *OSMRelations The set of relations to use.
+
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
+
+  Waypoints *waypoints The waypoints (only the first one is used).
+
+  Results **results Returns the reachable nodes.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static const char *calculate_reachable(Query *query,Nodes *OSMNodes,Segments *OSMSegments,Ways *OSMWays,Relations *OSMRelations,
+                                       Profile *profile,Waypoints *waypoints,Results **results)
+{
+ distance_t distmax=km_to_distance(MAXSEARCH);
+ distance_t distmin;
+ index_t start_node,join_segment=NO_SEGMENT;
+ int point;
+
+ ResetFakes(query);
+
+ for(point=1;point<=NWAYPOINTS;point++)
+    if(waypoints->point_used[point]==3)
+       break;
+
+ if(point>NWAYPOINTS)
+    return("A waypoint is needed to find the reachable nodes.");
+
+ /* Find the closest point */
+
+ if(waypoints->exactnodes)
+    start_node=FindClosestNode(OSMNodes,OSMSegments,OSMWays,waypoints->point_lat[point],waypoints->point_lon[point],distmax,profile,&distmin);
+ else
+   {
+    distance_t dist1,dist2;
+    index_t segment,node1,node2;
+
+    segment=FindClosestSegment(OSMNodes,OSMSegments,OSMWays,waypoints->point_lat[point],waypoints->point_lon[point],distmax,profile,&distmin,&node1,&node2,&dist1,&dist2);
+
+    if(segment!=NO_SEGMENT)
+       start_node=CreateFakes(query,OSMNodes,OSMSegments,point,LookupSegment(OSMSegments,segment,1),node1,node2,dist1,dist2);
+    else
+       start_node=NO_NODE;
+   }
+
+ if(start_node==NO_NODE)
+   {
+    sprintf(query->error,"Cannot find node close to specified point %d.",point);
+    return(query->error);
+   }
+
+ if(waypoints->heading!=-999)
+    join_segment=FindClosestSegmentHeading(query,OSMNodes,OSMSegments,OSMWays,start_node,waypoints->heading,profile);
+
+ /* Search outwards until the limits are reached */
+
+ *results=FindReachableNodes(query,OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,start_node,join_segment);
+
+ return(NULL);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Find the routes between the first two waypoints that trade off the duration against the ascent.
+
+  const char *calculate_pareto Returns NULL if OK or an error message.
+
+  Query *query The query to calculate (holding the epsilon factor, the fake nodes and segments are replaced).
+
+  Nodes *OSMNodes The set of nodes to use.
+
+  Segments *OSMSegments The set of segments to use.
+
+  Ways *OSMWays The set of ways to use.
+
+  Relations *OSMRelations The set of relations to use.
+
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
+
+  Waypoints *waypoints The waypoints (only the first two are used).
+
+  Results **routes Returns the routes (routes[1] to routes[n]).
+
+  int *nroutes Returns the number of routes.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static const char *calculate_pareto(Query *query,Nodes *OSMNodes,Segments *OSMSegments,Ways *OSMWays,Relations *OSMRelations,
+                                    Profile *profile,Waypoints *waypoints,Results **routes,int *nroutes)
+{
+ index_t nodes[2],join_segment=NO_SEGMENT;
+ int point,n=0;
+
+ ResetFakes(query);
+
+ query->nsettled=0;
+
+ *nroutes=0;
+
+ /* Find the closest point to each of the first two waypoints */
+
+ for(point=1;point<=NWAYPOINTS && n<2;point++)
+   {
+    distance_t distmax=km_to_distance(MAXSEARCH);
+    distance_t distmin;
+
+    if(waypoints->point_used[point]!=3)
+       continue;
+
+    if(waypoints->exactnodes)
+       nodes[n]=FindClosestNode(OSMNodes,OSMSegments,OSMWays,waypoints->point_lat[point],waypoints->point_lon[point],distmax,profile,&distmin);
+    else
+      {
+       distance_t dist1,dist2;
+       index_t segment,node1,node2;
+
+       segment=FindClosestSegment(OSMNodes,OSMSegments,OSMWays,waypoints->point_lat[point],waypoints->point_lon[point],distmax,profile,&distmin,&node1,&node2,&dist1,&dist2);
+
+       if(segment!=NO_SEGMENT)
+          nodes[n]=CreateFakes(query,OSMNodes,OSMSegments,point,LookupSegment(OSMSegments,segment,1),node1,node2,dist1,dist2);
+       else
+          nodes[n]=NO_NODE;
+      }
+
+    if(nodes[n]==NO_NODE)
+      {
+       sprintf(query->error,"Cannot find node close to specified point %d.",point);
+       return(query->error);
+      }
+
+    n++;
+   }
+
+ if(n<2)
+    return("Two waypoints are needed to find the Pareto routes.");
+
+ if(nodes[0]==nodes[1])
+    return("The first two waypoints are at the same place.");
+
+ if(waypoints->heading!=-999)
+    join_segment=FindClosestSegmentHeading(query,OSMNodes,OSMSegments,OSMWays,nodes[0],waypoints->heading,profile);
+
+ /* Search all of the routes at the same time */
+
+ *nroutes=FindParetoRoutes(query,OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,nodes[0],join_segment,nodes[1],routes,MAX_PARETO_ROUTES);
+
+ if(*nroutes==0)
+    return("Cannot find a route compatible with profile.");
+
+ return(NULL);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Run as a server; read route requests (the routing options as on the command line) one per line
+  from stdin and write the outputs to stdout.
+
+  int server Returns the exit status of the program.
+
+  Nodes *OSMNodes The set of nodes to use.
+
+  Segments *OSMSegments The set of segments to use.
+
+  Ways *OSMWays The set of ways to use.
+
+  Relations *OSMRelations The set of relations to use.
+
+  Landmarks *OSMLandmarks The set of landmarks to use (or NULL).
+
+  Hierarchy *OSMHierarchy The contraction hierarchy to use (or NULL).
+
+  Partition *OSMPartition The partition to use (or NULL), the scores for each profile are kept.
+
+  Profile *profile The profile selected by the command line (the default for the requests).
+
+  int exactnodes Set if only routing between nodes.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static int server(Nodes *OSMNodes,Segments *OSMSegments,Ways *OSMWays,Relations *OSMRelations,Landmarks *OSMLandmarks,Hierarchy *OSMHierarchy,Partition *OSMPartition,
+                  Profile *profile,int exactnodes)
+{
+ FILE  *reply;
+ char  *line=NULL;
+ size_t length=0;
+ Query  query;
+
+ /* The replies go to stdout and anything else printed to stderr */
+
+ fflush(stdout);
+
+ reply=fdopen(dup(STDOUT_FILENO),"w");
+
+ dup2(STDERR_FILENO,STDOUT_FILENO);
+
+ memset(&query,0,sizeof(Query));
+
+ query.translation=GetTranslation();
+
+ query.landmarks=OSMLandmarks;
+ query.hierarchy=OSMHierarchy;
+ query.partition=OSMPartition;
+
+ query.pool=NewResultsPool();
+
+ SetOutputMemory(&query,1);
+
+ while(getline(&line,&length,stdin)>=0)
+   {
+    char *argv[MAXARGS+1];
+    const char *error,*filename,*data;
+    size_t size;
+    int argc=1,n;
+
+    argv[0]="router";
+
+    for(argv[argc]=strtok(line," \t\r\n");argv[argc] && argc<MAXARGS;argv[argc]=strtok(NULL," \t\r\n"))
+       argc++;
+
+    if(argc==1)
+       continue;
+
+    error=server_request(&query,OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,exactnodes,argc,argv);
+
+    if(error)
+       fprintf(reply,"ERROR %s\n",error);
+    else
+      {
+       for(n=0;GetOutputMemory(&query,n,&filename,&data,&size);n++)
+          ;
+
+       fprintf(reply,"OK %d\n",n);
+
+       for(n=0;GetOutputMemory(&query,n,&filename,&data,&size);n++)
+         {
+          fprintf(reply,"%s %lu\n",filename,(unsigned long)size);
+          fwrite(data,1,size,reply);
+         }
+      }
+
+    fflush(reply);
+
+    FreeOutputMemory(&query);
+   }
+
+ free(line);
+
+ FreeResultsPool(query.pool);
+
+ fclose(reply);
+
+ return(0);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Calculate one route requested in server mode.
+
+  const char *server_request Returns NULL if OK or an error message.
+
+  Query *query The query to use for the request (the outputs are kept in memory in it).
+
+  Nodes *OSMNodes The set of nodes to use.
+
+  Segments *OSMSegments The set of segments to use.
+
+  Ways *OSMWays The set of ways to use.
+
+  Relations *OSMRelations The set of relations to use.
+
+  Profile *defprofile The profile to use unless the request selects another one.
+
+  int exactnodes Set if only routing between nodes.
+
+  int argc The number of options in the request.
+
+  char **argv The options in the request.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static const char *server_request(Query *query,Nodes *OSMNodes,Segments *OSMSegments,Ways *OSMWays,Relations *OSMRelations,
+                                  Profile *defprofile,int exactnodes,int argc,char **argv)
+{
+ Results  *results[NWAYPOINTS+1]={NULL};
+ Waypoints waypoints;
+ Profile   profile=*defprofile;
+ Transport transport=Transport_None;
+ char     *profilename=NULL;
+ const char *route_error;
+ int       option_none;
+ int       arg,point;
+
+ query->quickest=0;
+ query->bidirectional=0;
+
+ query->reach_distance=query->reach_duration=0;
+ query->reach_ascent=0;
+
+ query->pareto=0;
+ query->pareto_epsilon=0;
+
+ query->html=query->gpx_track=query->gpx_route=query->text=query->text_all=option_none=0;
+
+ /* Get the output options and the profile */
+
+ for(arg=1;arg<argc;arg++)
+   {
+    if(!strcmp(argv[arg],"--exact-nodes-only"))
+       exactnodes=1;
+    else if(!strcmp(argv[arg],"--output-html"))
+       query->html=1;
+    else if(!strcmp(argv[arg],"--output-gpx-track"))
+       query->gpx_track=1;
+    else if(!strcmp(argv[arg],"--output-gpx-route"))
+       query->gpx_route=1;
+    else if(!strcmp(argv[arg],"--output-text"))
+       query->text=1;
+    else if(!strcmp(argv[arg],"--output-text-all"))
+       query->text_all=1;
+    else if(!strcmp(argv[arg],"--output-none"))
+       option_none=1;
+    else if(!strncmp(argv[arg],"--profile=",10))
+       profilename=&argv[arg][10];
+    else if(!strncmp(argv[arg],"--transport=",12))
+      {
+       transport=TransportType(&argv[arg][12]);
+
+       if(transport==Transport_None)
+          break;
+      }
+    else
+       continue;
+
+    argv[arg]=NULL;
+   }
+
+ if(query->html==0 && query->gpx_track==0 && query->gpx_route==0 && query->text==0 && query->text_all==0 && option_none==0)
+    query->html=query->gpx_track=query->gpx_route=query->text=query->text_all=1;
+
+ if(arg==argc)
+   {
+    if(profilename)
+      {
+       Profile *selected=GetProfile(profilename);
+
+       if(!selected)
+          return("Cannot find the selected profile.");
+
+       profile=*selected;
+      }
+    else if(transport!=Transport_None)
+      {
+       Profile *selected=GetProfile(TransportName(transport));
+
+       if(selected)
+          profile=*selected;
+       else
+         {
+          memset(&profile,0,sizeof(Profile));
+          profile.transport=transport;
+         }
+      }
+
+    arg=parse_routing_options(argc,argv,query,&profile,&waypoints);
+   }
+
+ if(arg>0)
+   {
+    snprintf(query->error,sizeof(query->error),"Error with command line parameter: %s",argv[arg]);
+    return(query->error);
+   }
+ else if(arg<0)
+    return("All waypoints must have latitude and longitude.");
+
+ waypoints.exactnodes=exactnodes;
+
+ if(UpdateProfile(&profile,OSMWays))
+    return("Profile is invalid or not compatible with database.");
+
+ if(query->partition)
+    query->customisation=CustomisePartition(query->partition,OSMNodes,OSMSegments,OSMWays,&profile,query->quickest);
+
+ /* Calculate and print the route (or the reachable nodes or the Pareto routes) */
+
+ if(query->reach_duration || query->reach_distance)
+   {
+    route_error=calculate_reachable(query,OSMNodes,OSMSegments,OSMWays,OSMRelations,&profile,&waypoints,&results[0]);
+
+    if(!route_error && !option_none)
+       PrintReachable(query,results[0],OSMNodes);
+   }
+ else if(query->pareto)
+   {
+    int nroutes;
+
+    route_error=calculate_pareto(query,OSMNodes,OSMSegments,OSMWays,OSMRelations,&profile,&waypoints,results,&nroutes);
+
+    if(!route_error && !option_none)
+       PrintPareto(query,results,nroutes,OSMNodes,OSMSegments,OSMWays,&profile);
+   }
+ else
+   {
+    route_error=calculate_route(query,OSMNodes,OSMSegments,OSMWays,OSMRelations,&profile,&waypoints,results);
+
+    if(!route_error && !option_none)
+       PrintRoute(query,results,NWAYPOINTS,OSMNodes,OSMSegments,OSMWays,&profile);
+   }
+
+ for(point=0;point<=NWAYPOINTS;point++)
+    if(results[point])
+       FreeResultsList(results[point]);
+
+ ReleaseCustomisation(query->customisation);
+ query->customisation=NULL;
+
+ ReleaseProfile(&profile);
+
+ return(route_error);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Route between the waypoints on each line of a file using several threads and write one record
+  per line (distance, duration, ascent and descent) to stdout.
+
+  int batch Returns the exit status of the program.
+
+  Nodes *OSMNodes The set of nodes to use.
+
+  Segments *OSMSegments The set of segments to use.
+
+  Ways *OSMWays The set of ways to use.
+
+  Relations *OSMRelations The set of relations to use.
+
+  Profile *profile The profile to use (already updated).
+
+  Query *defquery The query holding the routing options from the command line.
+
+  int exactnodes Set if only routing between nodes.
+
+  const char *filename The name of the file containing the waypoints ("-" for stdin).
+
+  int nthreads The number of threads to use (or 0 for one per processor).
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static int batch(Nodes *OSMNodes,Segments *OSMSegments,Ways *OSMWays,Relations *OSMRelations,Profile *profile,
+                 Query *defquery,int exactnodes,const char *filename,int nthreads)
+{
+ Batch batch;
+ int   quiet=option_quiet;
+
+ batch.OSMNodes=OSMNodes;
+ batch.OSMSegments=OSMSegments;
+ batch.OSMWays=OSMWays;
+ batch.OSMRelations=OSMRelations;
+ batch.profile=profile;
+ batch.defquery=defquery;
+ batch.exactnodes=exactnodes;
+ batch.line=0;
+ batch.nsettled=0;
+
+ if(!strcmp(filename,"-"))
+    batch.input=stdin;
+ else if(!(batch.input=fopen(filename,"r")))
+   {
+    fprintf(stderr,"Error: Cannot open the batch file '%s' for reading.\n",filename);
+    return(1);
+   }
+
+ /* The records go to stdout and anything else printed to stderr */
+
+ fflush(stdout);
+
+ batch.output=fdopen(dup(STDOUT_FILENO),"w");
+
+ dup2(STDERR_FILENO,STDOUT_FILENO);
+
+ if(defquery->partition)
+    defquery->customisation=CustomisePartition(defquery->partition,OSMNodes,OSMSegments,OSMWays,profile,defquery->quickest);
+
+ option_quiet=1;
+
+ fprintf(batch.output,"#Line\tDistance\tDuration\tAscent\tDescent\tScore\n");
+ fprintf(batch.output,"#    \t(km)    \t(min)   \t(m)   \t(m)    \t(%s)\n",defquery->quickest?"min":"km");
+                     /* "%lu\t%.3f\t%.2f\t%.1f\t%.1f\t%.3f\n" */
+
+ if(nthreads<=0)
+    nthreads=(int)sysconf(_SC_NPROCESSORS_ONLN);
+
+#if !SLIM && defined(USE_PTHREADS) && USE_PTHREADS
+
+ if(nthreads>1)
+   {
+    pthread_t *threads=(pthread_t*)malloc(nthreads*sizeof(pthread_t));
+    int i;
+
+    pthread_mutex_init(&batch.mutex,NULL);
+
+    for(i=0;i<nthreads;i++)
+       pthread_create(&threads[i],NULL,(void* (*)(void*))batch_thread,&batch);
+
+    for(i=0;i<nthreads;i++)
+       pthread_join(threads[i],NULL);
+
+    pthread_mutex_destroy(&batch.mutex);
+
+    free(threads);
+   }
+ else
+
+#endif
+
+   {
+#if defined(USE_PTHREADS) && USE_PTHREADS
+    pthread_mutex_init(&batch.mutex,NULL);
+#endif
+
+    batch_thread(&batch);
+
+#if defined(USE_PTHREADS) && USE_PTHREADS
+    pthread_mutex_destroy(&batch.mutex);
+#endif
+   }
+
+ if(batch.input!=stdin)
+    fclose(batch.input);
+
+ fclose(batch.output);
+
+ if(!quiet)
+    fprintf(stderr,"Routed OK (%lu nodes settled)\n",batch.nsettled);
+
+ return(0);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  The main function of a batch routing thread, routes the lines from the input one at a time until
+  there are none left (each thread has its own query and results).
+
+  void *batch_thread Returns NULL.
+
+  Batch *batch The data shared by the threads.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static void *batch_thread(Batch *batch)
+{
+ Query *query=(Query*)malloc(sizeof(Query));
+ char  *line=NULL;
+ size_t length=0;
+ char   record[160];
+
+ *query=*batch->defquery;
+
+ query->pool=NewResultsPool();
+
+ while(1)
+   {
+    unsigned long number;
+    ssize_t nread;
+
+#if defined(USE_PTHREADS) && USE_PTHREADS
+    pthread_mutex_lock(&batch->mutex);
+#endif
+
+    nread=getline(&line,&length,batch->input);
+    number=++batch->line;
+
+#if defined(USE_PTHREADS) && USE_PTHREADS
+    pthread_mutex_unlock(&batch->mutex);
+#endif
+
+    if(nread<0)
+       break;
+
+    if(!batch_request(batch,query,line,number,record))
+       continue;
+
+#if defined(USE_PTHREADS) && USE_PTHREADS
+    pthread_mutex_lock(&batch->mutex);
+#endif
+
+    fputs(record,batch->output);
+
+    batch->nsettled+=query->nsettled;
+
+#if defined(USE_PTHREADS) && USE_PTHREADS
+    pthread_mutex_unlock(&batch->mutex);
+#endif
+   }
+
+ free(line);
+
+ FreeResultsPool(query->pool);
+
+ free(query);
+
+ return(NULL);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Route between the waypoints on one line of a batch file.
+
+  int batch_request Returns 1 if there is a record for the line or 0 if it is blank or a comment.
+
+  Batch *batch The data shared by the threads.
+
+  Query *query The query to use (owned by the thread).
+
+  char *line The line containing the waypoints as latitude and longitude pairs (in degrees).
+
+  unsigned long number The line number.
+
+  char *record Returns the record (at least 160 characters of space).
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static int batch_request(Batch *batch,Query *query,char *line,unsigned long number,char *record)
+{
+ Results  *results[NWAYPOINTS+1]={NULL};
+ Waypoints waypoints;
+ const char *error=NULL;
+ char     *token,*end,*saveptr;
+ int       npoints=0,ncoords=0,point;
+
+ while(isspace(*line))
+    line++;
+
+ if(!*line || *line=='#')
+    return(0);
+
+ /* Parse the waypoints */
+
+ for(point=0;point<=NWAYPOINTS;point++)
+    waypoints.point_used[point]=0;
+
+ waypoints.heading=-999;
+ waypoints.exactnodes=batch->exactnodes;
+
+ for(token=strtok_r(line," \t,\r\n",&saveptr);token;token=strtok_r(NULL," \t,\r\n",&saveptr))
+   {
+    double value=strtod(token,&end);
+
+    if(end==token || *end)
+      {
+       error="The line contains something that is not a number.";
+       break;
       }
-    else
+
+    if(ncoords%2==0)
       {
-       if(ExistsFile(FileName(dirname,prefix,"translations.xml")))
-          translations=FileName(dirname,prefix,"translations.xml");
-       else if(ExistsFile(FileName(DATADIR,NULL,"translations.xml")))
-          translations=FileName(DATADIR,NULL,"translations.xml");
-       else
+       if(npoints==NWAYPOINTS)
          {
-          fprintf(stderr,"Error: The '--translations' option was not used and the default 'translations.xml' does not exist.\n");
-          return(1);
+          error="Too many waypoints.";
+          break;
          }
-      }
 
-    if(ParseXMLTranslations(translations,language))
+       npoints++;
+
+       waypoints.point_lat[npoints]=degrees_to_radians(value);
+       waypoints.point_used[npoints]=2;
+      }
+    else
       {
-       fprintf(stderr,"Error: Cannot read the translations in the file '%s'.\n",translations);
-       return(1);
+       waypoints.point_lon[npoints]=degrees_to_radians(value);
+       waypoints.point_used[npoints]=3;
       }
+
+    ncoords++;
    }
 
- /* Load in the data - Note: No error checking because Load*List() will call exit() in case of an error. */
+ if(!error && (ncoords%2 || npoints<2))
+    error="At least two waypoints, each a latitude and a longitude, are needed.";
 
- OSMNodes=LoadNodeList(FileName(dirname,prefix,"nodes.mem"));
+ /* Calculate the route */
 
- OSMSegments=LoadSegmentList(FileName(dirname,prefix,"segments.mem"));
+ if(!error)
+    error=calculate_route(query,batch->OSMNodes,batch->OSMSegments,batch->OSMWays,batch->OSMRelations,
+                          batch->profile,&waypoints,results);
 
- OSMWays=LoadWayList(FileName(dirname,prefix,"ways.mem"));
+ if(error)
+    snprintf(record,160,"%lu\tERROR\t%s\n",number,error);
+ else
+   {
+    distance_t distance;
+    duration_t duration;
+    double ascent,descent;
+    score_t score=0;
 
- OSMRelations=LoadRelationList(FileName(dirname,prefix,"relations.mem"));
+    for(point=1;point<=NWAYPOINTS;point++)
+       if(results[point])
+          score+=FindResult(results[point],results[point]->finish_node,results[point]->last_segment)->score;
 
- if(UpdateProfile(profile,OSMWays))
+    SummariseRoute(query,results,NWAYPOINTS,batch->OSMSegments,batch->OSMWays,batch->profile,
+                   &distance,&duration,&ascent,&descent);
+
+    snprintf(record,160,"%lu\t%.3f\t%.2f\t%.1f\t%.1f\t%.3f\n",number,
+             distance_to_km(distance),duration_to_minutes(duration),ascent,descent,
+             query->quickest?duration_to_minutes(score):distance_to_km(score));
+   }
+
+ for(point=1;point<=NWAYPOINTS;point++)
+    if(results[point])
+       FreeResultsList(results[point]);
+
+ return(1);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Calculate the routes between every source and every target in a file and write the score,
+  distance, duration and ascent of each one to stdout.
+
+  int matrix Returns the exit status of the program.
+
+  Nodes *OSMNodes The set of nodes to use.
+
+  Segments *OSMSegments The set of segments to use.
+
+  Ways *OSMWays The set of ways to use.
+
+  Relations *OSMRelations The set of relations to use.
+
+  Profile *profile The profile to use (already updated).
+
+  Query *query The query holding the routing options from the command line.
+
+  int exactnodes Set if only routing between nodes.
+
+  const char *filename The name of the file containing the points ("-" for stdin).
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static int matrix(Nodes *OSMNodes,Segments *OSMSegments,Ways *OSMWays,Relations *OSMRelations,Profile *profile,
+                  Query *query,int exactnodes,const char *filename)
+{
+ FILE     *input,*output;
+ char     *line=NULL;
+ size_t    length=0;
+ unsigned long number=0;
+ int       nsources=0,ntargets=0;
+ double   *source_lat=NULL,*source_lon=NULL,*target_lat=NULL,*target_lon=NULL;
+ unsigned long *source_line=NULL,*target_line=NULL;
+ MatrixCell *cells;
+ int       s,t;
+
+ if(!strcmp(filename,"-"))
+    input=stdin;
+ else if(!(input=fopen(filename,"r")))
    {
-    fprintf(stderr,"Error: Profile is invalid or not compatible with database.\n");
+    fprintf(stderr,"Error: Cannot open the matrix file '%s' for reading.\n",filename);
     return(1);
    }
- 
- /* Loop through all pairs of points */
 
- for(point=1;point<=NWAYPOINTS;point++)
+ /* Read the points, one per line, "[S|T] latitude longitude" */
+
+ while(getline(&line,&length,input)>=0)
    {
-    Results *begin,*end;
-    distance_t distmax=km_to_distance(MAXSEARCH);
-    distance_t distmin;
-    index_t segment=NO_SEGMENT;
-    index_t node1,node2;
+    char   *token,*end,*saveptr;
+    double  value[2];
+    int     type=3,ncoords=0;
 
-    if(point_used[point]!=3)
-       continue;
+    number++;
 
-    /* Find the closest point */
+    for(token=strtok_r(line," \t,\r\n",&saveptr);token;token=strtok_r(NULL," \t,\r\n",&saveptr))
+      {
+       if(ncoords==0 && type==3 && *token=='#')
+          break;
+       else if(ncoords==0 && type==3 && (!strcmp(token,"S") || !strcmp(token,"s")))
+          type=1;
+       else if(ncoords==0 && type==3 && (!strcmp(token,"T") || !strcmp(token,"t")))
+          type=2;
+       else
+         {
+          if(ncoords<2)
+             value[ncoords]=strtod(token,&end);
 
-    start_node=finish_node;
+          if(ncoords==2 || end==token || *end)
+            {
+             ncoords=-1;
+             break;
+            }
+
+          ncoords++;
+         }
+      }
+
+    if(ncoords==0 && type==3)
+       continue;
 
-    if(exactnodes)
+    if(ncoords!=2)
       {
-       finish_node=FindClosestNode(OSMNodes,OSMSegments,OSMWays,point_lat[point],point_lon[point],distmax,profile,&distmin);
+       fprintf(stderr,"Error: Line %lu of the matrix file is not '[S|T] latitude longitude'.\n",number);
+       return(1);
       }
-    else
+
+    if(type&1)
       {
-       distance_t dist1,dist2;
+       source_lat =(double*)realloc(source_lat,(nsources+1)*sizeof(double));
+       source_lon =(double*)realloc(source_lon,(nsources+1)*sizeof(double));
+       source_line=(unsigned long*)realloc(source_line,(nsources+1)*sizeof(unsigned long));
 
-       segment=FindClosestSegment(OSMNodes,OSMSegments,OSMWays,point_lat[point],point_lon[point],distmax,profile,&distmin,&node1,&node2,&dist1,&dist2);
+       source_lat[nsources]=degrees_to_radians(value[0]);
+       source_lon[nsources]=degrees_to_radians(value[1]);
+       source_line[nsources]=number;
 
-       if(segment!=NO_SEGMENT)
-          finish_node=CreateFakes(OSMNodes,OSMSegments,point,LookupSegment(OSMSegments,segment,1),node1,node2,dist1,dist2);
-       else
-          finish_node=NO_NODE;
+       nsources++;
       }
 
-    if(finish_node==NO_NODE)
+    if(type&2)
       {
-       fprintf(stderr,"Error: Cannot find node close to specified point %d.\n",point);
-       return(1);
+       target_lat =(double*)realloc(target_lat,(ntargets+1)*sizeof(double));
+       target_lon =(double*)realloc(target_lon,(ntargets+1)*sizeof(double));
+       target_line=(unsigned long*)realloc(target_line,(ntargets+1)*sizeof(unsigned long));
+
+       target_lat[ntargets]=degrees_to_radians(value[0]);
+       target_lon[ntargets]=degrees_to_radians(value[1]);
+       target_line[ntargets]=number;
+
+       ntargets++;
       }
+   }
 
-    if(!option_quiet)
-      {
-       double lat,lon;
+ free(line);
 
-       if(IsFakeNode(finish_node))
-          GetFakeLatLong(finish_node,&lat,&lon);
-       else
-          GetLatLong(OSMNodes,finish_node,&lat,&lon);
+ if(input!=stdin)
+    fclose(input);
 
-       if(IsFakeNode(finish_node))
-          printf("Point %d is segment %"Pindex_t" (node %"Pindex_t" -> %"Pindex_t"): %3.6f %4.6f = %2.3f km\n",point,segment,node1,node2,
-                 radians_to_degrees(lon),radians_to_degrees(lat),distance_to_km(distmin));
+ /* The records go to stdout and anything else printed to stderr */
+
+ fflush(stdout);
+
+ output=fdopen(dup(STDOUT_FILENO),"w");
+
+ dup2(STDERR_FILENO,STDOUT_FILENO);
+
+ if(query->partition)
+    query->customisation=CustomisePartition(query->partition,OSMNodes,OSMSegments,OSMWays,profile,query->quickest);
+
+ option_quiet=1;
+
+ /* Calculate the routes */
+
+ cells=(MatrixCell*)malloc((nsources*ntargets+1)*sizeof(MatrixCell));
+
+ calculate_matrix(query,OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,exactnodes,
+                  nsources,source_lat,source_lon,ntargets,target_lat,target_lon,cells);
+
+ /* Write the records, the sources and targets are identified by their line numbers */
+
+ fprintf(output,"#Source\tTarget\tScore\tDistance\tDuration\tAscent\n");
+ fprintf(output,"#      \t      \t     \t(km)    \t(min)   \t(m)\n");
+              /* "%lu\t%lu\t%.3f\t%.3f\t%.2f\t%.1f\n" */
+
+ for(s=0;s<nsources;s++)
+    for(t=0;t<ntargets;t++)
+      {
+       MatrixCell *cell=&cells[s*ntargets+t];
+
+       if(cell->error[0])
+          fprintf(output,"%lu\t%lu\tERROR\t%s\n",source_line[s],target_line[t],cell->error);
        else
-          printf("Point %d is node %"Pindex_t": %3.6f %4.6f = %2.3f km\n",point,finish_node,
-                 radians_to_degrees(lon),radians_to_degrees(lat),distance_to_km(distmin));
+          fprintf(output,"%lu\t%lu\t%.3f\t%.3f\t%.2f\t%.1f\n",source_line[s],target_line[t],
+                  query->quickest?duration_to_minutes(cell->score):distance_to_km(cell->score),
+                  distance_to_km(cell->distance),duration_to_minutes(cell->duration),cell->ascent);
       }
 
-    if(start_node==NO_NODE)
-       continue;
+ fclose(output);
 
-    if(start_node==finish_node)
-       continue;
+ free(cells);
 
-    if(heading!=-999 && join_segment==NO_SEGMENT)
-       join_segment=FindClosestSegmentHeading(OSMNodes,OSMSegments,OSMWays,start_node,heading,profile);
+ free(source_lat);
+ free(source_lon);
+ free(source_line);
+ free(target_lat);
+ free(target_lon);
+ free(target_line);
 
-    /* Calculate the beginning of the route */
+ return(0);
+}
 
-    begin=FindStartRoutes(OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,start_node,join_segment,finish_node);
 
-    if(begin)
+/*++++++++++++++++++++++++++++++++++++++
+  Calculate the routes from each of a set of sources to each of a set of targets. The final
+  portion of the route to each target and the initial portion of the route from each source are
+  only calculated once and a single search across the super-nodes from each source finds the
+  routes to all of the targets (routes that might not pass through any super-nodes are calculated
+  separately).
+
+  Query *query The query to calculate (the fake nodes and segments are replaced).
+
+  Nodes *OSMNodes The set of nodes to use.
+
+  Segments *OSMSegments The set of segments to use.
+
+  Ways *OSMWays The set of ways to use.
+
+  Relations *OSMRelations The set of relations to use.
+
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
+
+  int exactnodes Set if only routing between nodes.
+
+  int nsources The number of sources.
+
+  double *source_lat The latitudes of the sources.
+
+  double *source_lon The longitudes of the sources.
+
+  int ntargets The number of targets.
+
+  double *target_lat The latitudes of the targets.
+
+  double *target_lon The longitudes of the targets.
+
+  MatrixCell *cells Returns the routes (nsources rows of ntargets cells).
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static void calculate_matrix(Query *query,Nodes *OSMNodes,Segments *OSMSegments,Ways *OSMWays,Relations *OSMRelations,
+                             Profile *profile,int exactnodes,
+                             int nsources,double *source_lat,double *source_lon,
+                             int ntargets,double *target_lat,double *target_lon,
+                             MatrixCell *cells)
+{
+ Query   *pairquery=(Query*)malloc(sizeof(Query));
+ Results *ends[NWAYPOINTS-1];
+ index_t  finish_nodes[NWAYPOINTS-1];
+ int      first,s,t;
+
+ *pairquery=*query;
+
+ /* The targets use the fake nodes 1 to NWAYPOINTS-1 (as many at a time as possible) and the source uses NWAYPOINTS */
+
+ for(first=0;first<ntargets;first+=NWAYPOINTS-1)
+   {
+    int nends=ntargets-first;
+
+    if(nends>NWAYPOINTS-1)
+       nends=NWAYPOINTS-1;
+
+    ResetFakes(query);
+
+    for(t=0;t<nends;t++)
       {
-       /* Check if the end of the route was reached */
+       finish_nodes[t]=matrix_point(query,OSMNodes,OSMSegments,OSMWays,profile,exactnodes,t+1,target_lat[first+t],target_lon[first+t]);
 
-       if(FindResult1(begin,finish_node))
-          results[point]=ExtendStartRoutes(OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,begin,finish_node);
+       if(finish_nodes[t]!=NO_NODE)
+          ends[t]=FindFinishRoutes(query,OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,finish_nodes[t]);
+       else
+          ends[t]=NULL;
       }
-    else
+
+    for(s=0;s<nsources;s++)
       {
-       if(join_segment!=NO_SEGMENT)
-         {
-          /* Try again but allow a U-turn at the start waypoint -
-             this solves the problem of facing a dead-end that contains no super-nodes. */
+       Results *begin=NULL,*middles=NULL;
+       index_t start_node;
 
-          join_segment=NO_SEGMENT;
+       start_node=matrix_point(query,OSMNodes,OSMSegments,OSMWays,profile,exactnodes,NWAYPOINTS,source_lat[s],source_lon[s]);
 
-          begin=FindStartRoutes(OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,start_node,join_segment,finish_node);
-         }
+       if(start_node!=NO_NODE)
+          begin=FindStartRoutes(query,OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,start_node,NO_SEGMENT,NO_NODE);
 
        if(begin)
-         {
-          /* Check if the end of the route was reached */
+          middles=FindMiddleRoutes(query,OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,begin,ends,nends);
 
-          if(FindResult1(begin,finish_node))
-             results[point]=ExtendStartRoutes(OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,begin,finish_node);
-         }
-       else
+       for(t=0;t<nends;t++)
          {
-          fprintf(stderr,"Error: Cannot find initial section of route compatible with profile.\n");
-          return(1);
+          MatrixCell *cell=&cells[s*ntargets+first+t];
+          Results *results[NWAYPOINTS+1]={NULL};
+          Query *resultquery=query;
+          const char *error=NULL;
+          int point;
+
+          cell->score=0;
+          cell->distance=0;
+          cell->duration=0;
+          cell->ascent=0;
+          cell->error[0]=0;
+
+          if(start_node==NO_NODE)
+             error="Cannot find node close to the source.";
+          else if(finish_nodes[t]==NO_NODE)
+             error="Cannot find node close to the target.";
+          else if(start_node==finish_nodes[t])
+             continue;
+          else if(begin && ends[t] && !matrix_local(query,OSMNodes,begin,ends[t]))
+            {
+             if(!FixMiddleRoute(OSMNodes,profile,middles,ends[t]))
+                error="Cannot find super-route compatible with profile.";
+             else if(!(results[1]=CombineRoutes(query,OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,begin,middles)))
+                error="Cannot create combined route following super-route.";
+            }
+          else
+            {
+             /* The route might not pass through any super-nodes - calculate it as a separate route */
+
+             Waypoints waypoints;
+
+             for(point=0;point<=NWAYPOINTS;point++)
+                waypoints.point_used[point]=0;
+
+             waypoints.point_lat[1]=source_lat[s];
+             waypoints.point_lon[1]=source_lon[s];
+             waypoints.point_used[1]=3;
+
+             waypoints.point_lat[2]=target_lat[first+t];
+             waypoints.point_lon[2]=target_lon[first+t];
+             waypoints.point_used[2]=3;
+
+             waypoints.heading=-999;
+             waypoints.exactnodes=exactnodes;
+
+             error=calculate_route(pairquery,OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,&waypoints,results);
+
+             resultquery=pairquery;
+            }
+
+          if(error)
+             strncpy(cell->error,error,sizeof(cell->error)-1);
+          else
+            {
+             Result *result;
+             double descent;
+
+             for(point=1;point<=NWAYPOINTS;point++)
+                if(results[point])
+                  {
+                   result=FindResult(results[point],results[point]->finish_node,results[point]->last_segment);
+
+                   cell->score+=result->score;
+                  }
+
+             SummariseRoute(resultquery,results,NWAYPOINTS,OSMSegments,OSMWays,profile,
+                            &cell->distance,&cell->duration,&cell->ascent,&descent);
+            }
+
+          for(point=1;point<=NWAYPOINTS;point++)
+             if(results[point])
+                FreeResultsList(results[point]);
          }
+
+       if(middles)
+          FreeResultsList(middles);
+
+       if(begin)
+          FreeResultsList(begin);
       }
 
-    /* Calculate the rest of the route */
+    for(t=0;t<nends;t++)
+       if(ends[t])
+          FreeResultsList(ends[t]);
+   }
 
-    if(!results[point])
-      {
-       Results *middle;
+ free(pairquery);
+}
 
-       /* Calculate the end of the route */
 
-       end=FindFinishRoutes(OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,finish_node);
+/*++++++++++++++++++++++++++++++++++++++
+  Find the node closest to one of the points of a matrix (creating the fake node if required).
 
-       if(!end)
-         {
-          fprintf(stderr,"Error: Cannot find final section of route compatible with profile.\n");
-          return(1);
-         }
+  index_t matrix_point Returns the node or NO_NODE if there is none close enough.
 
-       /* Calculate the middle of the route */
+  Query *query The query that the fake node belongs to.
 
-       middle=FindMiddleRoute(OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,begin,end);
+  Nodes *OSMNodes The set of nodes to use.
 
-       if(!middle && join_segment!=NO_SEGMENT)
-         {
-          /* Try again but allow a U-turn at the start waypoint -
-             this solves the problem of facing a dead-end that contains some super-nodes. */
+  Segments *OSMSegments The set of segments to use.
 
-          FreeResultsList(begin);
+  Ways *OSMWays The set of ways to use.
 
-          begin=FindStartRoutes(OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,start_node,NO_SEGMENT,finish_node);
+  Profile *profile The profile containing the transport type, speeds and allowed highways.
 
-          if(begin)
-             middle=FindMiddleRoute(OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,begin,end);
-         }
+  int exactnodes Set if only routing between nodes.
 
-       FreeResultsList(end);
+  int point The number of the fake node to use.
 
-       if(!middle)
-         {
-          fprintf(stderr,"Error: Cannot find super-route compatible with profile.\n");
-          return(1);
-         }
+  double lat The latitude of the point.
 
-       results[point]=CombineRoutes(OSMNodes,OSMSegments,OSMWays,OSMRelations,profile,begin,middle);
+  double lon The longitude of the point.
+  ++++++++++++++++++++++++++++++++++++++*/
 
-       if(!results[point])
-         {
-          fprintf(stderr,"Error: Cannot create combined route following super-route.\n");
-          return(1);
-         }
+static index_t matrix_point(Query *query,Nodes *OSMNodes,Segments *OSMSegments,Ways *OSMWays,Profile *profile,
+                            int exactnodes,int point,double lat,double lon)
+{
+ distance_t distmax=km_to_distance(MAXSEARCH);
+ distance_t distmin,dist1,dist2;
+ index_t segment,node1,node2;
 
-       FreeResultsList(begin);
+ if(exactnodes)
+    return(FindClosestNode(OSMNodes,OSMSegments,OSMWays,lat,lon,distmax,profile,&distmin));
 
-       FreeResultsList(middle);
-      }
+ segment=FindClosestSegment(OSMNodes,OSMSegments,OSMWays,lat,lon,distmax,profile,&distmin,&node1,&node2,&dist1,&dist2);
 
-#if DEBUG
-    Result *r=FindResult(results[point],results[point]->start_node,results[point]->prev_segment);
+ if(segment==NO_SEGMENT)
+    return(NO_NODE);
 
-    printf("The final route is:\n");
+ /* Each point is created on its own, never joined to the previous one if they share a segment */
 
-    while(r)
-      {
-       printf("  node=%"Pindex_t" segment=%"Pindex_t" score=%f\n",r->node,r->segment,r->score);
+ query->prevpoint=0;
 
-       r=r->next;
-      }
-#endif
+ return(CreateFakes(query,OSMNodes,OSMSegments,point,LookupSegment(OSMSegments,segment,1),node1,node2,dist1,dist2));
+}
 
-    join_segment=results[point]->last_segment;
-   }
 
- if(!option_quiet)
+/*++++++++++++++++++++++++++++++++++++++
+  Check if the route between a source and a target might not pass through any super-nodes.
+
+  int matrix_local Returns 1 if the route might not pass through a super-node.
+
+  Query *query The query that the fake nodes belong to.
+
+  Nodes *OSMNodes The set of nodes to use.
+
+  Results *begin The initial portion of the routes from the source.
+
+  Results *end The final portion of the routes to the target.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static int matrix_local(Query *query,Nodes *OSMNodes,Results *begin,Results *end)
+{
+ Result *result=FirstResult(end);
+
+ /* Two fake nodes on the same segment are joined directly */
+
+ if(IsFakeNode(begin->start_node) && IsFakeNode(end->finish_node))
    {
-    printf("Routed OK\n");
-    fflush(stdout);
+    index_t seg1=IndexFakeSegment(query,FirstFakeSegment(query,begin->start_node));
+    index_t seg2=IndexFakeSegment(query,FirstFakeSegment(query,end->finish_node));
+
+    if(IndexRealSegment(query,seg1)==IndexRealSegment(query,seg2))
+       return(1);
    }
 
- /* Print out the combined route */
+ /* A route that does not pass through a super-node only passes through nodes in both parts */
 
- if(!option_none)
-    PrintRoute(results,NWAYPOINTS,OSMNodes,OSMSegments,OSMWays,profile);
+ while(result)
+   {
+    if(IsFakeNode(result->node) || !IsSuperNode(LookupNode(OSMNodes,result->node,1)))
+       if(FindResult1(begin,result->node))
+          return(1);
+
+    result=NextResult(end,result);
+   }
 
  return(0);
 }
@@ -643,7 +2125,11 @@ static void print_usage(int detail,const char *argerr,const char *err)
          "                        --help-profile-json | --help-profile-perl ]\n"
          "              [--dir=<dirname>] [--prefix=<name>]\n"
          "              [--profiles=<filename>] [--translations=<filename>]\n"
-         "              [--exact-nodes-only]\n"
+         "              [--exact-nodes-only] [--no-landmarks] [--no-hierarchy]\n"
+         "              [--no-partition]\n"
+         "              [--server]\n"
+         "              [--batch=<filename> [--threads=<number>]]\n"
+         "              [--matrix=<filename>]\n"
          "              [--loggable | --quiet]\n"
          "              [--language=<lang>]\n"
          "              [--output-html]\n"
@@ -652,7 +2138,10 @@ static void print_usage(int detail,const char *argerr,const char *err)
          "              [--output-none]\n"
          "              [--profile=<name>]\n"
          "              [--transport=<transport>]\n"
-         "              [--shortest | --quickest]\n"
+         "              [--shortest | --quickest] [--bidirectional]\n"
+         "              [--reach-duration=<minutes> | --reach-distance=<km>\n"
+         "               [--reach-ascent=<metres>]]\n"
+         "              [--pareto[=<percent>]]\n"
          "              --lon1=<longitude> --lat1=<latitude>\n"
          "              --lon2=<longitude> --lon2=<latitude>\n"
          "              [ ... --lon99=<longitude> --lon99=<latitude>]\n"
@@ -661,7 +2150,8 @@ static void print_usage(int detail,const char *argerr,const char *err)
          "              [--property-<property>=<preference> ...]\n"
          "              [--oneway=(0|1)] [--turns=(0|1)]\n"
          "              [--weight=<weight>]\n"
-         "              [--height=<height>] [--width=<width>] [--length=<length>]\n");
+         "              [--height=<height>] [--width=<width>]\n"
+         "              [--hills=<speed>]\n");
 
  if(argerr)
     fprintf(stderr,
@@ -694,6 +2184,23 @@ static void print_usage(int detail,const char *argerr,const char *err)
             "                         '" DATADIR "').\n"
             "\n"
             "--exact-nodes-only      Only route between nodes (don't find closest segment).\n"
+            "--no-landmarks          Don't use the landmarks file (if planetsplitter made one).\n"
+            "--no-hierarchy          Don't use the contraction hierarchy file (if\n"
+            "                        planetsplitter made one).\n"
+            "--no-partition          Don't use the partition file (if planetsplitter made\n"
+            "                        one).\n"
+            "--server                Read route requests (routing options) from stdin, one\n"
+            "                        per line, and write the outputs to stdout.\n"
+            "--batch=<filename>      Read waypoints (latitude and longitude pairs) from the\n"
+            "                        file ('-' for stdin), one route per line, and write\n"
+            "                        the distance, duration, ascent and descent to stdout.\n"
+            "--threads=<number>      The number of threads for '--batch' (default one per\n"
+            "                        processor).\n"
+            "--matrix=<filename>     Read points (latitude and longitude, prefixed by 'S'\n"
+            "                        for a source or 'T' for a target) from the file ('-'\n"
+            "                        for stdin), one per line, and write the score,\n"
+            "                        distance, duration and ascent from every source to\n"
+            "                        every target to stdout.\n"
             "\n"
             "--loggable              Print progress messages suitable for logging to file.\n"
             "--quiet                 Don't print any screen output when running.\n"
@@ -713,12 +2220,25 @@ static void print_usage(int detail,const char *argerr,const char *err)
             "\n"
             "--shortest              Find the shortest route between the waypoints.\n"
             "--quickest              Find the quickest route between the waypoints.\n"
+            "--bidirectional         Search from both ends of each part of the route.\n"
             "\n"
             "--lon<n>=<longitude>    Specify the longitude of the n'th waypoint.\n"
             "--lat<n>=<latitude>     Specify the latitude of the n'th waypoint.\n"
             "\n"
             "--heading=<bearing>     Initial compass bearing at lowest numbered waypoint.\n"
             "\n"
+            "--reach-duration=<min>  Find everywhere that can be reached from the lowest\n"
+            "                        numbered waypoint within this duration (minutes)\n"
+            "                        instead of a route.\n"
+            "--reach-distance=<km>   Find everywhere that can be reached from the lowest\n"
+            "                        numbered waypoint within this distance (km).\n"
+            "--reach-ascent=<metres> The maximum total ascent for the reachable nodes.\n"
+            "\n"
+            "--pareto[=<percent>]    Find the routes between the first two waypoints that\n"
+            "                        trade off the duration against the total ascent\n"
+            "                        instead of one route, a route is only kept if it is\n"
+            "                        better than the others by this much (default 5%%).\n"
+            "\n"
             "                                   Routing preference options\n"
             "--highway-<highway>=<preference>   * preference for highway type (%%).\n"
             "--speed-<highway>=<speed>          * speed for highway type (km/h).\n"
@@ -728,7 +2248,11 @@ static void print_usage(int detail,const char *argerr,const char *err)
             "--weight=<weight>                  * maximum weight limit (tonnes).\n"
             "--height=<height>                  * maximum height limit (metres).\n"
             "--width=<width>                    * maximum width limit (metres).\n"
-            "--length=<length>                  * maximum length limit (metres).\n"
+            "--hills=<speed>                    * speed on a 10%% grade (km/h) with the speed\n"
+            "                                     changing linearly with the grade, 100 for\n"
+            "                                     fixed speeds on the steeper grades (quickest\n"
+            "                                     routes only, default 0 = no hills).\n"
+            "--length=<speed>                   * the same as --hills (sent by the web page).\n"
             "\n"
             "<transport> defaults to motorcar but can be set to:\n"
             "%s"
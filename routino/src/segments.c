@@ -84,6 +84,8 @@ Segments *LoadSegmentList(const char *filename)
 
   index_t FindClosestSegmentHeading Returns the closest heading segment index.
 
+  Query *query The query containing the fake nodes and segments (or NULL if there are none).
+
   Nodes *nodes The set of nodes to use.
 
   Segments *segments The set of segments to use.
@@ -97,14 +99,14 @@ Segments *LoadSegmentList(const char *filename)
   Profile *profile The profile of the mode of transport (or NULL).
   ++++++++++++++++++++++++++++++++++++++*/
 
-index_t FindClosestSegmentHeading(Nodes *nodes,Segments *segments,Ways *ways,index_t node1,double heading,Profile *profile)
+index_t FindClosestSegmentHeading(Query *query,Nodes *nodes,Segments *segments,Ways *ways,index_t node1,double heading,Profile *profile)
 {
  Segment *segmentp;
  index_t best_seg=NO_SEGMENT;
  double best_difference=360;
 
  if(IsFakeNode(node1))
-    segmentp=FirstFakeSegment(node1);
+    segmentp=FirstFakeSegment(query,node1);
  else
    {
     Node *nodep=LookupNode(nodes,node1,3);
@@ -127,7 +129,7 @@ index_t FindClosestSegmentHeading(Nodes *nodes,Segments *segments,Ways *ways,ind
        goto endloop;
 
     if(IsFakeNode(node1) || IsFakeNode(node2))
-       seg2=IndexFakeSegment(segmentp);
+       seg2=IndexFakeSegment(query,segmentp);
     else
        seg2=IndexSegment(segments,segmentp);
 
@@ -136,7 +138,7 @@ index_t FindClosestSegmentHeading(Nodes *nodes,Segments *segments,Ways *ways,ind
     if(!(wayp->allow&profile->allow))
        goto endloop;
 
-    bearing=BearingAngle(nodes,segmentp,node1);
+    bearing=BearingAngle(query,nodes,segmentp,node1);
 
     difference=(heading-bearing);
 
@@ -154,7 +156,7 @@ index_t FindClosestSegmentHeading(Nodes *nodes,Segments *segments,Ways *ways,ind
    endloop:
 
     if(IsFakeNode(node1))
-       segmentp=NextFakeSegment(segmentp,node1);
+       segmentp=NextFakeSegment(query,segmentp,node1);
     else if(IsFakeNode(node2))
        segmentp=NULL; /* cannot call NextSegment() with a fake segment */
     else
@@ -204,73 +206,40 @@ distance_t Distance(double lat1,double lon1,double lat2,double lon2)
 
 
 /*++++++++++++++++++++++++++++++++++++++
-  Calculate the duration of travel on a segment.
+  Calculate the duration of travel on a segment (slower uphill if the profile has hills).
 
   duration_t Duration Returns the duration of travel.
 
   Segment *segmentp The segment to traverse.
 
-  Way *wayp The way that the segment belongs to.
-
-  Profile *profile The profile of the transport being used.
+  Profile *profile The profile of the transport being used (already updated).
   ++++++++++++++++++++++++++++++++++++++*/
 
-duration_t Duration(Segment *segmentp,Way *wayp,Profile *profile)
+duration_t Duration(Segment *segmentp,Profile *profile)
 {
- speed_t    speed1=wayp->speed;
- speed_t    speed2=profile->speed[HIGHWAY(wayp->type)];
- int        final;
+ int        final=profile->way_speed[segmentp->way];
  distance_t distance=DISTANCE(segmentp->distance);
- 
- if(speed1==0)
-   {
-    if(speed2==0)
-       return(hours_to_duration(10));
-    else
-        final = speed2;
-   }
- else /* if(speed1!=0) */
+
+ if(final==0)
+    return(hours_to_duration(10));
+
+ /* the speed on the hill depends on the grade */
+ if(profile->hill_speed && SegmentGradeIndex(segmentp))
    {
-    if(speed2==0)
-       final = speed1;
-    else if(speed1<=speed2)
-       final = speed1;
-    else
-       final = speed2;
+    HillSpeed *hill=&profile->hill_speed[SegmentGradeIndex(segmentp)];
+    int flat=final;
+
+    final=hill->offset+hill->factor*flat;
+
+    if(final<hill->minimum)
+       final=hill->minimum;
+
+#if HILLS_TRACE
+    printf("hill: %0.1f speed %d final %d\n",SegmentGrade(segmentp),flat,final);
+#endif
    }
- 
- float hills = profile->hills;
- if(hills == 0 || segmentp->ascentOn == 0)
-   return distance_speed_to_duration(distance, final);
- 
- //hill's percentage
- float    percent = segmentp->ascent/segmentp->ascentOn*100;
- printf("hill: %0.2f speed %d ", percent, final);
-
- //special output for precomputed speeds
- if(hills >= 100){
-     if(percent > 2) final = 15;
-     if(percent > 4) final = 10;
-     if(percent > 7) final = 8;
-     if(percent > 9) final = 6;
-     if(percent > 15) final = 3;
- }
- else { //linear slowing ($hills = speed on 10% hill)
-     speed_t maxi = final;
-     final = -((maxi-hills)/10) * percent + maxi;
-     
-     if(final < 3) final = 3;
- }
- 
- 
- //printf("distance %d, proc %0.2f, ascent %0.1f on %0.1f ", distance, percent, segmentp->ascent, segmentp->ascentOn);
- //distance = percent * distance;
- 
-  printf("final %d\n", final);
-
-  
-  
- return distance_speed_to_duration(distance, final);
+
+ return(distance_speed_to_duration(distance,final));
 }
 
 
@@ -279,6 +248,8 @@ duration_t Duration(Segment *segmentp,Way *wayp,Profile *profile)
 
   double TurnAngle Returns a value in the range -180 to +180 indicating the angle to turn.
 
+  Query *query The query containing the fake nodes and segments (or NULL if there are none).
+
   Nodes *nodes The set of nodes to use.
 
   Segment *segment1p The current segment.
@@ -291,7 +262,7 @@ duration_t Duration(Segment *segmentp,Way *wayp,Profile *profile)
   Angles are calculated using flat Cartesian lat/long grid approximation (after scaling longitude due to latitude).
   ++++++++++++++++++++++++++++++++++++++*/
 
-double TurnAngle(Nodes *nodes,Segment *segment1p,Segment *segment2p,index_t node)
+double TurnAngle(Query *query,Nodes *nodes,Segment *segment1p,Segment *segment2p,index_t node)
 {
  double lat1,latm,lat2;
  double lon1,lonm,lon2;
@@ -302,17 +273,17 @@ double TurnAngle(Nodes *nodes,Segment *segment1p,Segment *segment2p,index_t node
  node2=OtherNode(segment2p,node);
 
  if(IsFakeNode(node1))
-    GetFakeLatLong(node1,&lat1,&lon1);
+    GetFakeLatLong(query,node1,&lat1,&lon1);
  else
     GetLatLong(nodes,node1,&lat1,&lon1);
 
  if(IsFakeNode(node))
-    GetFakeLatLong(node,&latm,&lonm);
+    GetFakeLatLong(query,node,&latm,&lonm);
  else
     GetLatLong(nodes,node,&latm,&lonm);
 
  if(IsFakeNode(node2))
-    GetFakeLatLong(node2,&lat2,&lon2);
+    GetFakeLatLong(query,node2,&lat2,&lon2);
  else
     GetLatLong(nodes,node2,&lat2,&lon2);
 
@@ -335,6 +306,8 @@ double TurnAngle(Nodes *nodes,Segment *segment1p,Segment *segment2p,index_t node
 
   double BearingAngle Returns a value in the range 0 to 359 indicating the bearing.
 
+  Query *query The query containing the fake nodes and segments (or NULL if there are none).
+
   Nodes *nodes The set of nodes to use.
 
   Segment *segmentp The segment.
@@ -344,7 +317,7 @@ double TurnAngle(Nodes *nodes,Segment *segment1p,Segment *segment2p,index_t node
   Angles are calculated using flat Cartesian lat/long grid approximation (after scaling longitude due to latitude).
   ++++++++++++++++++++++++++++++++++++++*/
 
-double BearingAngle(Nodes *nodes,Segment *segmentp,index_t node)
+double BearingAngle(Query *query,Nodes *nodes,Segment *segmentp,index_t node)
 {
  double lat1,lat2;
  double lon1,lon2;
@@ -355,12 +328,12 @@ double BearingAngle(Nodes *nodes,Segment *segmentp,index_t node)
  node2=OtherNode(segmentp,node);
 
  if(IsFakeNode(node1))
-    GetFakeLatLong(node1,&lat1,&lon1);
+    GetFakeLatLong(query,node1,&lat1,&lon1);
  else
     GetLatLong(nodes,node1,&lat1,&lon1);
 
  if(IsFakeNode(node2))
-    GetFakeLatLong(node2,&lat2,&lon2);
+    GetFakeLatLong(query,node2,&lat2,&lon2);
  else
     GetLatLong(nodes,node2,&lat2,&lon2);
 
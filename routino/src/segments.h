@@ -47,14 +47,25 @@ struct _Segment
  index_t    way;                /*+ The index of the way associated with the segment. +*/
 
  distance_t distance;           /*+ The distance between the nodes. +*/
- 
- float      ascent;
- float      descent;
- float      ascentOn;
- float      descentOn;
+
+ uint32_t   hills;              /*+ The grade, ascent and descent along the segment (see HillsToSegment). +*/
 };
 
 
+/*+ The number of bits of the grade in the hills of a segment (one for each of the profile's HILL_GRADES). +*/
+#define SEGMENT_GRADEBITS 10
+
+/*+ The grade of the ascending part in the hills of a segment (1/10 percent, the index into the profile's hill speeds). +*/
+#define SEGMENT_GRADE    ((uint32_t)((1<<SEGMENT_GRADEBITS)-1))
+
+/*+ The number of bits of the ascent and of the descent in the hills of a segment (after the grade). +*/
+#define SEGMENT_HILLBITS 11
+
+
+/*+ The Segment is written to the database and is mapped by every router, it must stay this size. +*/
+typedef char SegmentSizeCheck[sizeof(struct _Segment)==24?1:-1];
+
+
 /*+ A structure containing the header from the file. +*/
 typedef struct _SegmentsFile
 {
@@ -91,14 +102,14 @@ struct _Segments
 
 Segments *LoadSegmentList(const char *filename);
 
-index_t FindClosestSegmentHeading(Nodes *nodes,Segments *segments,Ways *ways,index_t node1,double heading,Profile *profile);
+index_t FindClosestSegmentHeading(Query *query,Nodes *nodes,Segments *segments,Ways *ways,index_t node1,double heading,Profile *profile);
 
 distance_t Distance(double lat1,double lon1,double lat2,double lon2);
 
-duration_t Duration(Segment *segmentp,Way *wayp,Profile *profile);
+duration_t Duration(Segment *segmentp,Profile *profile);
 
-double TurnAngle(Nodes *nodes,Segment *segment1p,Segment *segment2p,index_t node);
-double BearingAngle(Nodes *nodes,Segment *segmentp,index_t node);
+double TurnAngle(Query *query,Nodes *nodes,Segment *segment1p,Segment *segment2p,index_t node);
+double BearingAngle(Query *query,Nodes *nodes,Segment *segmentp,index_t node);
 
 
 static inline Segment *NextSegment(Segments *segments,Segment *segmentp,index_t node);
@@ -121,6 +132,57 @@ static inline Segment *NextSegment(Segments *segments,Segment *segmentp,index_t
 /*+ Return true if the segment is oneway from the specified node. +*/
 #define IsOnewayFrom(xxx,yyy)  ((xxx)->node2==(yyy)?((xxx)->distance&ONEWAY_2TO1):((xxx)->distance&ONEWAY_1TO2))
 
+/*+ Return the grade of the ascending part of the segment (the index into the profile's hill speeds). +*/
+#define SegmentGradeIndex(xxx) ((xxx)->hills&SEGMENT_GRADE)
+
+/*+ Return the grade of the ascending part of the segment in percent. +*/
+#define SegmentGrade(xxx)      ((float)SegmentGradeIndex(xxx)/10)
+
+/*+ Return the ascent of the segment in metres. +*/
+#define SegmentAscent(xxx)     SegmentToAscent(((xxx)->hills>>SEGMENT_GRADEBITS)&((1<<SEGMENT_HILLBITS)-1))
+
+/*+ Return the descent of the segment in metres. +*/
+#define SegmentDescent(xxx)    SegmentToAscent((xxx)->hills>>(SEGMENT_GRADEBITS+SEGMENT_HILLBITS))
+
+/*+ Return the ascent (or descent) in metres from the value stored in the segment (8 bit decimetres shifted by 3 bits). +*/
+#define SegmentToAscent(xx)    ((float)(((xx)&0xff)<<((xx)>>8))/10)
+
+/*+ Return the grade for the segment from the ascent and the ascending distance (any grade is kept non-zero). +*/
+#define GradeToSegment(xx,yy)  ((uint32_t)((xx)<=0||(yy)<=0?0:(xx)*1000/(yy)>SEGMENT_GRADE?SEGMENT_GRADE:(xx)*1000/(yy)<1?1:(xx)*1000/(yy)+0.5))
+
+/*+ Return the hills of the segment from the ascent, descent and the ascending distance. +*/
+#define HillsToSegment(aa,dd,oo) (GradeToSegment(aa,oo)|(AscentToSegment(aa)<<SEGMENT_GRADEBITS)|(AscentToSegment(dd)<<(SEGMENT_GRADEBITS+SEGMENT_HILLBITS)))
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Convert an ascent (or descent) to the value stored in the segment, exact to a decimetre
+  up to 25.5 metres and then within 0.4% (saturated at 3264 metres).
+
+  uint32_t AscentToSegment Returns the stored value.
+
+  double ascent The ascent in metres.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static inline uint32_t AscentToSegment(double ascent)
+{
+ double decimetres=ascent*10;
+ uint32_t shift=0;
+
+ if(decimetres<=0)
+    return(0);
+
+ while(decimetres>=255.5 && shift<7)
+   {
+    decimetres/=2;
+    shift++;
+   }
+
+ if(decimetres>=255.5)
+    return((7<<8)|255);
+
+ return((shift<<8)|(uint32_t)(decimetres+0.5));
+}
+
 /*+ Return the other node in the segment that is not the specified node. +*/
 #define OtherNode(xxx,yyy)     ((xxx)->node1==(yyy)?(xxx)->node2:(xxx)->node1)
 
@@ -24,6 +24,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(USE_PTHREADS) && USE_PTHREADS
+#include <pthread.h>
+#endif
+
 #include "types.h"
 #include "segments.h"
 #include "ways.h"
@@ -45,6 +49,17 @@
 /*+ The command line '--tmpdir' option or its default value. +*/
 extern char *option_tmpdirname;
 
+/*+ The number of threads to use for filesorting (and for measuring the segments). +*/
+extern int option_filesort_threads;
+
+/*+ The command line '--srtm-sort' option (measure the nodes and segments sorted by SRTM tile). +*/
+extern int option_srtm_sort;
+
+/* Constants */
+
+/*+ The number of segments that are measured at once (split between the threads). +*/
+#define MEASURE_CHUNK 65536
+
 /* Local variables */
 
 /*+ Temporary file-local variables for use by the sort functions. +*/
@@ -52,6 +67,53 @@ static NodesX *sortnodesx;
 static SegmentsX *sortsegmentsx;
 static WaysX *sortwaysx;
 
+/*+ Temporary file-local variables for use by the measuring functions. +*/
+static NodesX *measurenodesx;
+static SegmentX *measuresegmentx;
+static index_t *measurenodeindex=NULL;
+static struct _SegmentTileX *measuresegmenttile=NULL;
+static float *measureelevation;
+
+/*+ A node or segment sorted by the SRTM tile (block) where it starts. +*/
+typedef struct _TileSortX
+ {
+  uint32_t  tile;               /*+ The tile and block key. +*/
+  index_t   index;              /*+ The node index or the original position of the segment. +*/
+ }
+ TileSortX;
+
+/*+ A segment sorted by the SRTM tile (block) where it starts. +*/
+typedef struct _SegmentTileX
+ {
+  TileSortX key;                /*+ The sorting key (must be first). +*/
+  SegmentX  segmentx;           /*+ The segment. +*/
+ }
+ SegmentTileX;
+
+#if defined(USE_PTHREADS) && USE_PTHREADS && !SLIM
+
+/*+ A data type for holding data for a measuring thread. +*/
+typedef struct _measure_thread
+ {
+  pthread_t thread;             /*+ The thread identifier. +*/
+
+  index_t   start;              /*+ The first item for this thread. +*/
+  index_t   end;                /*+ The item after the last one for this thread. +*/
+ }
+ measure_thread;
+
+/* Thread variables */
+
+static pthread_mutex_t measure_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t measure_start_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t measure_done_cond = PTHREAD_COND_INITIALIZER;
+
+static measure_thread *measurethreads=NULL;
+static int measure_nthreads=0,measure_generation=0,measure_pending=0,measure_quit=0;
+static void (*measure_function)(index_t,index_t);
+
+#endif
+
 /* Local functions */
 
 static int sort_by_way_id(SegmentX *a,SegmentX *b);
@@ -66,6 +128,16 @@ static int deduplicate_super(SegmentX *segmentx,index_t index);
 
 static int geographically_index(SegmentX *segmentx,index_t index);
 
+static void measure_nodes(index_t start,index_t end);
+static void measure_segments(index_t start,index_t end);
+static void measure_nodes_by_tile(NodesX *nodesx);
+static void measure_segments_by_tile(char *filename,int fd,index_t number);
+static int sort_by_tile(TileSortX *a,TileSortX *b);
+static int sort_by_index(TileSortX *a,TileSortX *b);
+static void measure_parallel(void (*function)(index_t,index_t),index_t number);
+static void measure_threads_start(void);
+static void measure_threads_finish(void);
+
 static distance_t DistanceX(NodeX *nodex1,NodeX *nodex2);
 
 
@@ -667,9 +739,11 @@ void RemoveBadSegments(SegmentsX *segmentsx,NodesX *nodesx,WaysX *waysx,int keep
 
 void MeasureSegments(SegmentsX *segmentsx,NodesX *nodesx,WaysX *waysx)
 {
- index_t index=0;
- int fd;
- SegmentX segmentx;
+ index_t index=0,n;
+ int fd,fdtile=-1;
+ SegmentX *segmentx;
+ char *filename=NULL;
+ TSrtmStatistics stats;
 
  if(segmentsx->number==0)
     return;
@@ -692,6 +766,27 @@ void MeasureSegments(SegmentsX *segmentsx,NodesX *nodesx,WaysX *waysx)
 
  logassert(segmentsx->usedway,"Failed to allocate memory (try using slim mode?)"); /* Check AllocBitMask() worked */
 
+ /* Allocate the node elevations and the segments being measured */
+
+ measureelevation=(float*)malloc(nodesx->number*sizeof(float));
+
+ logassert(measureelevation,"Failed to allocate memory (try using slim mode?)"); /* Check malloc() worked */
+
+ measuresegmentx=(SegmentX*)malloc(MEASURE_CHUNK*sizeof(SegmentX));
+
+ logassert(measuresegmentx,"Failed to allocate memory (try using slim mode?)"); /* Check malloc() worked */
+
+ measurenodesx=nodesx;
+
+ measure_threads_start();
+
+ /* Look up the elevation of each node once */
+
+ if(option_srtm_sort)
+    measure_nodes_by_tile(nodesx);
+ else
+    measure_parallel(measure_nodes,nodesx->number);
+
  /* Re-open the file read-only and a new file writeable */
 
  segmentsx->fd=ReOpenFile(segmentsx->filename_tmp);
@@ -700,64 +795,111 @@ void MeasureSegments(SegmentsX *segmentsx,NodesX *nodesx,WaysX *waysx)
 
  fd=OpenFileNew(segmentsx->filename_tmp);
 
+ /* Open a file for the segments to be sorted by tile */
+
+ if(option_srtm_sort)
+   {
+    filename=(char*)malloc(strlen(option_tmpdirname)+40);
+
+    sprintf(filename,"%s/segmentsx.tiles.%p.tmp",option_tmpdirname,(void*)segmentsx);
+
+    fdtile=OpenFileNew(filename);
+
+    measuresegmenttile=(SegmentTileX*)malloc(MEASURE_CHUNK*sizeof(SegmentTileX));
+
+    logassert(measuresegmenttile,"Failed to allocate memory (try using slim mode?)"); /* Check malloc() worked */
+   }
+
  /* Modify the on-disk image */
 
- while(!ReadFile(segmentsx->fd,&segmentx,sizeof(SegmentX)))
+ do
    {
-    index_t node1=IndexNodeX(nodesx,segmentx.node1);
-    index_t node2=IndexNodeX(nodesx,segmentx.node2);
-    index_t way  =IndexWayX (waysx ,segmentx.way);
+    /* Read a chunk of segments */
 
-    NodeX *nodex1=LookupNodeX(nodesx,node1,1);
-    NodeX *nodex2=LookupNodeX(nodesx,node2,2);
-    
-    TSrtmAscentDescent ad;
+    for(n=0;n<MEASURE_CHUNK;n++)
+      {
+       index_t node1,node2,way;
+       NodeX *nodex1,*nodex2;
 
-    /* Replace the node and way ids with their indexes */
+       segmentx=&measuresegmentx[n];
 
-    segmentx.node1=node1;
-    segmentx.node2=node2;
-    segmentx.way  =way;
-    
-    SetBit(segmentsx->usedway,segmentx.way);
+       if(ReadFile(segmentsx->fd,segmentx,sizeof(SegmentX)))
+          break;
 
-    /* Set the distance but keep the other flags except for area */
+       node1=IndexNodeX(nodesx,segmentx->node1);
+       node2=IndexNodeX(nodesx,segmentx->node2);
+       way  =IndexWayX (waysx ,segmentx->way);
 
-    segmentx.distance=DISTANCE(DistanceX(nodex1,nodex2))|DISTFLAG(segmentx.distance);
-    segmentx.distance&=~SEGMENT_AREA;
-    
-    /* Compute the ascent descent */
-    
-    ad = srtmGetAscentDescent(
-            radians_to_degrees(latlong_to_radians(nodex1->latitude)), radians_to_degrees(latlong_to_radians(nodex1->longitude)),
-            radians_to_degrees(latlong_to_radians(nodex2->latitude)), radians_to_degrees(latlong_to_radians(nodex2->longitude)),
-            (int)DISTANCE(segmentx.distance));
-
-    segmentx.ascent = ad.ascent;
-    segmentx.descent = ad.descent;
-    segmentx.ascentOn = ad.ascentOn;
-    segmentx.descentOn = ad.descentOn;
-    
-    //fprintf(stderr, "measure%d: ", index);
-    ////fprintf(stderr, "node(%u,%u) ", node1, node2);
-    ////fprintf(stderr, "node(%0.5f,%0.5f) (%0.5f,%0.5f) ", radians_to_degrees(latlong_to_radians(nodex1->latitude)), radians_to_degrees(latlong_to_radians(nodex1->longitude)),        radians_to_degrees(latlong_to_radians(nodex2->latitude)), radians_to_degrees(latlong_to_radians(nodex2->longitude)));
+       nodex1=LookupNodeX(nodesx,node1,1);
+       nodex2=LookupNodeX(nodesx,node2,2);
 
-    //fprintf(stderr, "dist(%d) ", DISTANCE(segmentx.distance));
-    //fprintf(stderr, "ad(%.1f,%.1f)\n", ad.ascent, ad.descent);
-    //fprintf(stderr, "adon(%.1f,%.1f)\n", ad.ascentOn, ad.descentOn);
-    
-                
-    
-    /* Write the modified segment */
+       /* Replace the node and way ids with their indexes */
 
-    WriteFile(fd,&segmentx,sizeof(SegmentX));
+       segmentx->node1=node1;
+       segmentx->node2=node2;
+       segmentx->way  =way;
 
-    index++;
+       SetBit(segmentsx->usedway,segmentx->way);
 
-    if(!(index%10000))
-       printf_middle("Measuring Segments: Segments=%"Pindex_t,index);
+       /* Set the distance but keep the other flags except for area */
+
+       segmentx->distance=DISTANCE(DistanceX(nodex1,nodex2))|DISTFLAG(segmentx->distance);
+       segmentx->distance&=~SEGMENT_AREA;
+      }
+
+    if(option_srtm_sort)
+      {
+       /* Write the segments with their tile for sorting */
+
+       index_t i;
+
+       for(i=0;i<n;i++)
+         {
+          NodeX *nodex1=LookupNodeX(nodesx,measuresegmentx[i].node1,1);
+
+          measuresegmenttile[i].key.tile=srtmTileKey(radians_to_degrees(latlong_to_radians(nodex1->latitude)),
+                                                     radians_to_degrees(latlong_to_radians(nodex1->longitude)));
+          measuresegmenttile[i].key.index=index+i;
+          measuresegmenttile[i].segmentx=measuresegmentx[i];
+         }
+
+       if(n)
+          WriteFile(fdtile,measuresegmenttile,n*sizeof(SegmentTileX));
+      }
+    else
+      {
+       /* Compute the ascent descent (in the threads) */
+
+       measure_parallel(measure_segments,n);
+
+       /* Write the modified segments */
+
+       if(n)
+          WriteFile(fd,measuresegmentx,n*sizeof(SegmentX));
+      }
+
+    index+=n;
+
+    printf_middle("Measuring Segments: Segments=%"Pindex_t,index);
+   }
+ while(n==MEASURE_CHUNK);
+
+ /* Measure the segments sorted by tile and write them in the original order */
+
+ if(option_srtm_sort)
+   {
+    CloseFile(fdtile);
+
+    measure_segments_by_tile(filename,fd,index);
+
+    free(measuresegmenttile);
+    measuresegmenttile=NULL;
+
+    free(filename);
    }
 
+ measure_threads_finish();
+
  /* Close the files */
 
  segmentsx->fd=CloseFile(segmentsx->fd);
@@ -779,9 +921,459 @@ void MeasureSegments(SegmentsX *segmentsx,NodesX *nodesx,WaysX *waysx)
  nodesx->fd=CloseFile(nodesx->fd);
 #endif
 
+ /* Release the elevations */
+
+ free(measureelevation);
+ free(measuresegmentx);
+
+ srtmClose();
+
+ srtmGetStatistics(&stats);
+
  /* Print the final message */
 
- printf_last("Measured Segments: Segments=%"Pindex_t,segmentsx->number);
+ printf_last("Measured Segments: Segments=%"Pindex_t" Node-Elevations=%"Pindex_t" Elevation-Tiles: Hits=%lu Misses=%lu Missing=%lu Voids=%lu Flat-Segments=%lu",
+             segmentsx->number,nodesx->number,stats.hits,stats.misses,stats.missingTiles,stats.voids,stats.flatSegments);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Look up the elevation of a range of nodes.
+
+  index_t start The first node.
+
+  index_t end The node after the last one.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static void measure_nodes(index_t start,index_t end)
+{
+ index_t i;
+
+ for(i=start;i<end;i++)
+   {
+    index_t node=measurenodeindex?measurenodeindex[i]:i;
+    NodeX *nodex=LookupNodeX(measurenodesx,node,1);
+
+    measureelevation[node]=srtmGetElevation(radians_to_degrees(latlong_to_radians(nodex->latitude)),
+                                         radians_to_degrees(latlong_to_radians(nodex->longitude)));
+   }
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Compute the ascent and descent of a range of the segments being measured.
+
+  index_t start The first segment.
+
+  index_t end The segment after the last one.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static void measure_segments(index_t start,index_t end)
+{
+ index_t i;
+
+ for(i=start;i<end;i++)
+   {
+    SegmentX *segmentx=&measuresegmentx[i];
+    NodeX *nodex1=LookupNodeX(measurenodesx,segmentx->node1,1);
+    NodeX *nodex2=LookupNodeX(measurenodesx,segmentx->node2,2);
+    TSrtmAscentDescent ad;
+
+    ad = srtmGetAscentDescentNodes(radians_to_degrees(latlong_to_radians(nodex1->latitude)),
+                                   radians_to_degrees(latlong_to_radians(nodex1->longitude)),
+                                   measureelevation[segmentx->node1],
+                                   radians_to_degrees(latlong_to_radians(nodex2->latitude)),
+                                   radians_to_degrees(latlong_to_radians(nodex2->longitude)),
+                                   measureelevation[segmentx->node2],
+                                   (int)DISTANCE(segmentx->distance));
+
+    segmentx->ascent = ad.ascent;
+    segmentx->descent = ad.descent;
+    segmentx->ascentOn = ad.ascentOn;
+    segmentx->descentOn = ad.descentOn;
+   }
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Look up the elevation of the nodes in the order of the SRTM tiles (and blocks) that they are in.
+
+  NodesX *nodesx The set of nodes to use.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static void measure_nodes_by_tile(NodesX *nodesx)
+{
+ index_t i,n,index;
+ int fd,fdsorted;
+ TileSortX *tilesort;
+ char *filename;
+
+ filename=(char*)malloc(strlen(option_tmpdirname)+40);
+
+ sprintf(filename,"%s/nodesx.tiles.%p.tmp",option_tmpdirname,(void*)nodesx);
+
+ tilesort=(TileSortX*)malloc(MEASURE_CHUNK*sizeof(TileSortX));
+
+ logassert(tilesort,"Failed to allocate memory (try using slim mode?)"); /* Check malloc() worked */
+
+ /* Write the node indexes with their tile */
+
+ fd=OpenFileNew(filename);
+
+ for(index=0;index<nodesx->number;index+=n)
+   {
+    n=nodesx->number-index;
+    if(n>MEASURE_CHUNK)
+       n=MEASURE_CHUNK;
+
+    for(i=0;i<n;i++)
+      {
+       NodeX *nodex=LookupNodeX(nodesx,index+i,1);
+
+       tilesort[i].tile=srtmTileKey(radians_to_degrees(latlong_to_radians(nodex->latitude)),
+                                    radians_to_degrees(latlong_to_radians(nodex->longitude)));
+       tilesort[i].index=index+i;
+      }
+
+    WriteFile(fd,tilesort,n*sizeof(TileSortX));
+   }
+
+ CloseFile(fd);
+
+ /* Sort by tile */
+
+ fd=ReOpenFile(filename);
+
+ DeleteFile(filename);
+
+ fdsorted=OpenFileNew(filename);
+
+ filesort_fixed(fd,fdsorted,sizeof(TileSortX),NULL,
+                                              (int (*)(const void*,const void*))sort_by_tile,
+                                              NULL);
+
+ CloseFile(fd);
+ CloseFile(fdsorted);
+
+ /* Look up the elevations in chunks */
+
+ fd=ReOpenFile(filename);
+
+ DeleteFile(filename);
+
+ measurenodeindex=(index_t*)malloc(MEASURE_CHUNK*sizeof(index_t));
+
+ logassert(measurenodeindex,"Failed to allocate memory (try using slim mode?)"); /* Check malloc() worked */
+
+ for(index=0;index<nodesx->number;index+=n)
+   {
+    n=nodesx->number-index;
+    if(n>MEASURE_CHUNK)
+       n=MEASURE_CHUNK;
+
+    ReadFile(fd,tilesort,n*sizeof(TileSortX));
+
+    for(i=0;i<n;i++)
+       measurenodeindex[i]=tilesort[i].index;
+
+    measure_parallel(measure_nodes,n);
+   }
+
+ CloseFile(fd);
+
+ free(measurenodeindex);
+ measurenodeindex=NULL;
+
+ free(tilesort);
+ free(filename);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Measure the segments in the order of the SRTM tiles (and blocks) that they start in and write them
+  out in their original order.
+
+  char *filename The name of the file containing the segments with their tile.
+
+  int fd The file to write the measured segments to.
+
+  index_t number The number of segments in the file.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static void measure_segments_by_tile(char *filename,int fd,index_t number)
+{
+ index_t i,n,index;
+ int fdin,fdout;
+
+ /* Sort by tile */
+
+ fdin=ReOpenFile(filename);
+
+ DeleteFile(filename);
+
+ fdout=OpenFileNew(filename);
+
+ filesort_fixed(fdin,fdout,sizeof(SegmentTileX),NULL,
+                                                (int (*)(const void*,const void*))sort_by_tile,
+                                                NULL);
+
+ CloseFile(fdin);
+ CloseFile(fdout);
+
+ /* Measure the segments in chunks */
+
+ fdin=ReOpenFile(filename);
+
+ DeleteFile(filename);
+
+ fdout=OpenFileNew(filename);
+
+ for(index=0;index<number;index+=n)
+   {
+    n=number-index;
+    if(n>MEASURE_CHUNK)
+       n=MEASURE_CHUNK;
+
+    ReadFile(fdin,measuresegmenttile,n*sizeof(SegmentTileX));
+
+    for(i=0;i<n;i++)
+       measuresegmentx[i]=measuresegmenttile[i].segmentx;
+
+    measure_parallel(measure_segments,n);
+
+    for(i=0;i<n;i++)
+       measuresegmenttile[i].segmentx=measuresegmentx[i];
+
+    WriteFile(fdout,measuresegmenttile,n*sizeof(SegmentTileX));
+   }
+
+ CloseFile(fdin);
+ CloseFile(fdout);
+
+ /* Sort back to the original order */
+
+ fdin=ReOpenFile(filename);
+
+ DeleteFile(filename);
+
+ fdout=OpenFileNew(filename);
+
+ filesort_fixed(fdin,fdout,sizeof(SegmentTileX),NULL,
+                                                (int (*)(const void*,const void*))sort_by_index,
+                                                NULL);
+
+ CloseFile(fdin);
+ CloseFile(fdout);
+
+ /* Write out the segments */
+
+ fdin=ReOpenFile(filename);
+
+ DeleteFile(filename);
+
+ for(index=0;index<number;index+=n)
+   {
+    n=number-index;
+    if(n>MEASURE_CHUNK)
+       n=MEASURE_CHUNK;
+
+    ReadFile(fdin,measuresegmenttile,n*sizeof(SegmentTileX));
+
+    for(i=0;i<n;i++)
+       measuresegmentx[i]=measuresegmenttile[i].segmentx;
+
+    WriteFile(fd,measuresegmentx,n*sizeof(SegmentX));
+   }
+
+ CloseFile(fdin);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Sort the nodes or segments into SRTM tile order (then by index for a stable order).
+
+  int sort_by_tile Returns the comparison of the tile and index fields.
+
+  TileSortX *a The first node or segment.
+
+  TileSortX *b The second node or segment.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static int sort_by_tile(TileSortX *a,TileSortX *b)
+{
+ if(a->tile<b->tile)
+    return(-1);
+ else if(a->tile>b->tile)
+    return(1);
+
+ return(sort_by_index(a,b));
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Sort the nodes or segments back into their original order.
+
+  int sort_by_index Returns the comparison of the index fields.
+
+  TileSortX *a The first node or segment.
+
+  TileSortX *b The second node or segment.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static int sort_by_index(TileSortX *a,TileSortX *b)
+{
+ if(a->index<b->index)
+    return(-1);
+ else if(a->index>b->index)
+    return(1);
+
+ return(0);
+}
+
+
+#if defined(USE_PTHREADS) && USE_PTHREADS && !SLIM
+
+/*++++++++++++++++++++++++++++++++++++++
+  The main function of a measuring thread, runs the measuring function on its part of the items each
+  time that there is a new job.
+
+  measure_thread *thread The data for this thread.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static void *measure_thread_main(measure_thread *thread)
+{
+ int generation=0;
+
+ while(1)
+   {
+    pthread_mutex_lock(&measure_mutex);
+
+    while(measure_generation==generation && !measure_quit)
+       pthread_cond_wait(&measure_start_cond,&measure_mutex);
+
+    if(measure_quit)
+      {
+       pthread_mutex_unlock(&measure_mutex);
+       break;
+      }
+
+    generation=measure_generation;
+
+    pthread_mutex_unlock(&measure_mutex);
+
+    measure_function(thread->start,thread->end);
+
+    pthread_mutex_lock(&measure_mutex);
+
+    if(--measure_pending==0)
+       pthread_cond_signal(&measure_done_cond);
+
+    pthread_mutex_unlock(&measure_mutex);
+   }
+
+ /* Release the elevation tiles of this thread */
+
+ srtmClose();
+
+ return(NULL);
+}
+
+#endif
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Start the measuring threads (if multi-threading is enabled; not in slim mode since the cached
+  nodes are not thread-safe).
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static void measure_threads_start(void)
+{
+#if defined(USE_PTHREADS) && USE_PTHREADS && !SLIM
+ int i;
+
+ if(option_filesort_threads<=1)
+    return;
+
+ measure_nthreads=option_filesort_threads;
+ measure_quit=0;
+
+ measurethreads=(measure_thread*)malloc(measure_nthreads*sizeof(measure_thread));
+
+ for(i=0;i<measure_nthreads;i++)
+    pthread_create(&measurethreads[i].thread,NULL,(void* (*)(void*))measure_thread_main,&measurethreads[i]);
+#endif
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Stop the measuring threads.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static void measure_threads_finish(void)
+{
+#if defined(USE_PTHREADS) && USE_PTHREADS && !SLIM
+ int i;
+
+ if(!measurethreads)
+    return;
+
+ pthread_mutex_lock(&measure_mutex);
+
+ measure_quit=1;
+
+ pthread_cond_broadcast(&measure_start_cond);
+
+ pthread_mutex_unlock(&measure_mutex);
+
+ for(i=0;i<measure_nthreads;i++)
+    pthread_join(measurethreads[i].thread,NULL);
+
+ free(measurethreads);
+ measurethreads=NULL;
+#endif
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Run a measuring function on a range of items, split between the threads (if there are any). The
+  results do not depend on the number of threads since each item is processed independently.
+
+  void (*function)(index_t,index_t) The function to call with the first item and the item after the last one.
+
+  index_t number The number of items.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static void measure_parallel(void (*function)(index_t,index_t),index_t number)
+{
+#if defined(USE_PTHREADS) && USE_PTHREADS && !SLIM
+ int i;
+
+ if(measurethreads)
+   {
+    pthread_mutex_lock(&measure_mutex);
+
+    for(i=0;i<measure_nthreads;i++)
+      {
+       measurethreads[i].start=(index_t)(((uint64_t)number*i)/measure_nthreads);
+       measurethreads[i].end  =(index_t)(((uint64_t)number*(i+1))/measure_nthreads);
+      }
+
+    measure_function=function;
+    measure_pending=measure_nthreads;
+    measure_generation++;
+
+    pthread_cond_broadcast(&measure_start_cond);
+
+    while(measure_pending)
+       pthread_cond_wait(&measure_done_cond,&measure_mutex);
+
+    pthread_mutex_unlock(&measure_mutex);
+
+    return;
+   }
+#endif
+
+ function(0,number);
 }
 
 
@@ -1206,10 +1798,7 @@ void SaveSegmentList(SegmentsX *segmentsx,const char *filename)
     segment.next2   =segmentx.next2;
     segment.way     =segmentx.way;
     segment.distance=segmentx.distance;
-    segment.ascent  =segmentx.ascent;
-    segment.descent =segmentx.descent;
-    segment.ascentOn=segmentx.ascentOn;
-    segment.descentOn=segmentx.descentOn;
+    segment.hills   =HillsToSegment(segmentx.ascent,segmentx.descent,segmentx.ascentOn);
 
     if(IsSuperSegment(&segment))
        super_number++;
@@ -4,115 +4,754 @@
  *
  * Created on April 28, 2013, 12:01 AM
  */
-//#define SRTMSLIM 1
+//SRTMSLIM (set for the -slim programs) reads the samples from the file instead of whole tiles
+
+//mmap the tiles read-only (shared page cache) instead of reading them to heap
+#ifndef SRTMMMAP
+#define SRTMMMAP 1
+#endif
 
 #include <stdio.h> 
 #include <stdlib.h> //exit
 #include <stdint.h> //int16_t
+#include <string.h> //memcpy
 #include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
-#include "srtmHgtReader.h" //fmod
+#if defined(USE_PTHREADS) && USE_PTHREADS
+#include <pthread.h>
+#endif
 
+//AVX2 is compiled in on x86 (for srtmBlendAvx2() only) and used if the processor has it
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SRTM_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "srtmHgtReader.h" //fmod
 
 
-//const int secondsPerPx = 1;  //arc seconds per pixel (3 equals cca 90m)
-//const int totalPx = 3601;
-//const char* folder = "aster";
 
-const int secondsPerPx = 3;  //arc seconds per pixel (3 equals cca 90m)
-const int totalPx = 1201;
+//SRTM3 has 3 arc seconds per pixel (cca 90m), SRTM1/ASTER 1 arc second,
+//the resolution of each tile is found out from its file size
 const char* folder = "srtm";
 
-FILE* srtmFd = NULL;
-int srtmLat = 255; //default never valid
-int srtmLon = 255;
-unsigned char * srtmTile = NULL;
+/** Header of the converted .rte tile, followed by the blocks of samples */
+typedef struct {
+    int32_t magic;          //SRTM_RTE_MAGIC in native byte order
+    int32_t totalPx;        //1201 or 3601 pixels per row
+    int32_t secondsPerPx;
+    int32_t blocksPerRow;   //blocks of SRTM_RTE_BLOCK x SRTM_RTE_BLOCK samples
+} TSrtmRteHeader;
 
-/** Prepares corresponding file if not opened */
-void srtmLoadTile(int latDec, int lonDec){
-    if(srtmLat != latDec || srtmLon != lonDec) {
-        srtmLat = latDec;
-        srtmLon = lonDec;
+/** Plain HGT tile with the voids filled, shared by the caches of all threads
+ *  so that its voids are filled only once while any thread keeps the tile */
+typedef struct _TSrtmFilled {
+    int idx;                //(lat + 90) * 360 + (lon + 180)
+    unsigned char * data;   //the samples (big endian) with the voids filled
+    long voids;             //number of the filled voids
+    int users;              //cache slots using the data
+    struct _TSrtmFilled * next;
+} TSrtmFilled;
+
+/** One tile held in the cache */
+typedef struct {
+    int lat;                //tile coordinates, 255 = empty slot
+    int lon;
+    int totalPx;            //1201 or 3601 pixels per row
+    int secondsPerPx;       //3 or 1 arc seconds per pixel
+    int blocksPerRow;       //0 = plain HGT, otherwise converted .rte tile
+    int missing;            //tile not available, all heights are 0
+    FILE* fd;               //open file (only SRTMSLIM)
+    unsigned char * data;   //whole tile (in SRTMSLIM only the filled copy of a tile with voids)
+    TSrtmFilled * filled;   //shared copy with the voids filled (data points into it)
+    int16_t * samples;      //blocks of the .rte tile (inside data)
+    size_t size;            //size of the data
+    unsigned long lastUsed; //LRU stamp
+} TSrtmTile;
+
+//each thread has its own cache (mapped tiles share the page cache anyway)
+#if defined(USE_PTHREADS) && USE_PTHREADS
+#define SRTM_THREAD __thread
+pthread_mutex_t srtmStatisticsMutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t srtmFilledMutex = PTHREAD_MUTEX_INITIALIZER;
+#else
+#define SRTM_THREAD
+#endif
+
+int srtmCacheSize = SRTM_CACHE_DEFAULT;
+SRTM_THREAD TSrtmTile * srtmCache = NULL;
+SRTM_THREAD TSrtmTile * srtmTile = NULL; //tile used by srtmReadPx()
+
+SRTM_THREAD unsigned long srtmCacheClock = 0;
+SRTM_THREAD unsigned long srtmCacheHits = 0;
+SRTM_THREAD unsigned long srtmCacheMisses = 0;
+SRTM_THREAD unsigned long srtmFlatSegments = 0;
+
+//set by srtmReadPx() when a missing tile was used
+SRTM_THREAD int srtmMissing = 0;
+
+//counters of the threads that already closed their cache
+unsigned long srtmClosedHits = 0;
+unsigned long srtmClosedMisses = 0;
+unsigned long srtmClosedFlat = 0;
+
+//tiles loaded by any thread, each one is reported only once
+#define SRTM_LOADED 1       //tile counted in the statistics
+#define SRTM_BAD_RTE 2      //bad .rte tile reported
+unsigned char srtmLoaded[180 * 360];
+unsigned long srtmMissingTiles = 0;
+unsigned long srtmFilledVoids = 0;
+
+//plain HGT tiles with the voids filled (in use) and the ones without voids
+TSrtmFilled * srtmFilled = NULL;
+unsigned char srtmNoVoids[180 * 360];
+
+//resolution of the tiles for srtmTileKey() (0 = not known yet)
+unsigned short srtmKeyPx[180 * 360];
+
+//room for the blocks of one tile in the keys (57 x 57 blocks of SRTM1)
+#define SRTM_KEY_BLOCKS (((3601 + SRTM_RTE_BLOCK - 1) / SRTM_RTE_BLOCK) * ((3601 + SRTM_RTE_BLOCK - 1) / SRTM_RTE_BLOCK))
+
+/** The last cell read by srtmReadCell() - consecutive segments of a way
+ *  meet in the cell of their common node */
+SRTM_THREAD long srtmCellX = 0, srtmCellY = 0;
+SRTM_THREAD int srtmCellPx = 0; //0 = nothing cached
+SRTM_THREAD float srtmCellH[4];
+
+static void srtmReleaseFilled(TSrtmFilled * filled);
+
+/** Releases the data of one cache slot */
+static void srtmFreeTile(TSrtmTile * tile){
+    if(tile->fd != NULL){
+        fclose(tile->fd);
+        tile->fd = NULL;
+    }
+    
+    if(tile->filled != NULL){
+        srtmReleaseFilled(tile->filled);
+        tile->filled = NULL;
+    }
+    else if(tile->data != NULL){
+#if SRTMMMAP
+        munmap(tile->data, tile->size);
+#else
+        free(tile->data);
+#endif
+    }
+    
+    tile->data = NULL;
+    
+    tile->missing = 0;
+}
+
+/** Builds the tile name, eg. N50E014.hgt or S01W001.rte */
+static void srtmTileName(char* filename, size_t length, int latDec, int lonDec, const char* ext){
+    snprintf(filename, length, "%s/%c%02d%c%03d.%s", folder,
+            latDec >= 0 ? 'N' : 'S', abs(latDec),
+            lonDec >= 0 ? 'E' : 'W', abs(lonDec), ext);
+}
+
+/** Finds out the resolution of a HGT file from its size, returns 0 if unknown */
+static int srtmHgtTotalPx(off_t size){
+    if(size == 2 * 1201 * 1201){
+        return 1201;
+    }
+    else if(size == 2 * 3601 * 3601){
+        return 3601;
+    }
+    return 0;
+}
+
+/** Size of the samples in the blocks of .rte tile (after the header) */
+static inline long srtmRteSize(int blocksPerRow){
+    return (long)blocksPerRow * blocksPerRow * SRTM_RTE_BLOCK * SRTM_RTE_BLOCK * sizeof(int16_t);
+}
+
+/** Checks the header of .rte tile and that the file holds all the blocks it
+ *  indexes, returns NULL if the tile is valid or the reason why not */
+static const char* srtmCheckRte(int fd, TSrtmRteHeader* header){
+    struct stat buf;
+    
+    if(fstat(fd, &buf) || pread(fd, header, sizeof(*header), 0) != sizeof(*header)){
+        return "can not read the header";
+    }
+    
+    //the magic holds the format version too
+    if(header->magic != SRTM_RTE_MAGIC){
+        return "wrong format, version or byte order";
+    }
+    
+    if((header->totalPx != 1201 && header->totalPx != 3601) ||
+       header->secondsPerPx != 3600 / (header->totalPx - 1) ||
+       header->blocksPerRow != (header->totalPx + SRTM_RTE_BLOCK - 1) / SRTM_RTE_BLOCK){
+        return "wrong header";
+    }
+    
+    if(buf.st_size < (off_t)(sizeof(*header) + srtmRteSize(header->blocksPerRow))){
+        return "truncated";
+    }
+    
+    return NULL;
+}
+
+/** Index of the sample in the blocks of .rte tile */
+static inline long srtmRteIndex(int blocksPerRow, int y, int x){
+    long block = (long)(y / SRTM_RTE_BLOCK) * blocksPerRow + (x / SRTM_RTE_BLOCK);
+    
+    return block * SRTM_RTE_BLOCK * SRTM_RTE_BLOCK + (y % SRTM_RTE_BLOCK) * SRTM_RTE_BLOCK + (x % SRTM_RTE_BLOCK);
+}
+
+/** Fills the voids (-32768) from the valid neighbours, growing inwards from
+ *  the void edge one ring per pass (the values filled in a pass are used only
+ *  by the next one, so the result does not depend on the scan order),
+ *  returns number of the filled voids */
+static long srtmFillVoids(int16_t* hgt, int totalPx){
+    long n = (long)totalPx * totalPx, i, k, voids = 0;
+    
+    for(i=0; i<n; ++i){
+        if(hgt[i] == -32768) voids++;
+    }
+    
+    if(voids == 0){
+        return 0;
+    }
+    
+    //only the voids are walked through again and again
+    long * list = (long*) malloc(sizeof(long) * voids);
+    int16_t * value = (int16_t*) malloc(sizeof(int16_t) * voids);
+    long remaining = 0;
+    
+    for(i=0; i<n; ++i){
+        if(hgt[i] == -32768) list[remaining++] = i;
+    }
+    
+    while(remaining > 0){
+        long kept = 0, filled = 0;
         
-        if(srtmFd != NULL){
-            fclose(srtmFd);
+        //the values of this ring, from the pixels valid before the pass
+        for(k=0; k<remaining; ++k){
+            i = list[k];
+            
+            int y = i / totalPx, x = i % totalPx;
+            int sum = 0, cnt = 0;
+            
+            if(y > 0         && hgt[i - totalPx] != -32768) { sum += hgt[i - totalPx]; cnt++; }
+            if(y < totalPx-1 && hgt[i + totalPx] != -32768) { sum += hgt[i + totalPx]; cnt++; }
+            if(x > 0         && hgt[i - 1] != -32768)       { sum += hgt[i - 1]; cnt++; }
+            if(x < totalPx-1 && hgt[i + 1] != -32768)       { sum += hgt[i + 1]; cnt++; }
+            
+            //an average of valid heights is never -32768
+            value[k] = cnt > 0 ? sum / cnt : -32768;
         }
         
-        char filename[20];
-        sprintf(filename, "%s/N%dE0%d.hgt", folder, latDec, lonDec);
-        printf("Opening %s\n", filename);
+        //then the ring is filled and the rest is kept for the next pass
+        for(k=0; k<remaining; ++k){
+            if(value[k] != -32768){
+                hgt[list[k]] = value[k];
+                filled++;
+            }
+            else{
+                list[kept++] = list[k];
+            }
+        }
         
-        srtmFd = fopen(filename, "r");
+        //whole tile is void -> sea level
+        if(filled == 0){
+            for(k=0; k<remaining; ++k){
+                hgt[list[k]] = 0;
+            }
+            break;
+        }
         
-        if(srtmFd == NULL) {
-            printf("Error opening %s\n",  filename);
-            exit(1);
+        remaining = kept;
+    }
+    
+    free(value);
+    free(list);
+    
+    return voids;
+}
+
+/** Fills the voids of plain HGT tile (big endian) into a private copy of it,
+ *  the tile itself is read-only. Returns the copy or NULL if there are no voids. */
+static unsigned char* srtmFillHgtVoids(const unsigned char* tile, int totalPx, long* voids){
+    long n = (long)totalPx * totalPx, i;
+    
+    *voids = 0;
+    
+    for(i=0; i<n; ++i){
+        if(tile[2*i] == 0x80 && tile[2*i+1] == 0x00) (*voids)++;
+    }
+    
+    if(*voids == 0){
+        return NULL;
+    }
+    
+    unsigned char * data = (unsigned char*) malloc(2 * n);
+    int16_t * hgt = (int16_t*) malloc(sizeof(int16_t) * n);
+    
+    memcpy(data, tile, 2 * n);
+    
+    for(i=0; i<n; ++i){
+        hgt[i] = 0 | (data[2*i] << 8) | (data[2*i+1] << 0);
+    }
+    
+    srtmFillVoids(hgt, totalPx);
+    
+    for(i=0; i<n; ++i){
+        if(data[2*i] == 0x80 && data[2*i+1] == 0x00){
+            data[2*i] = (hgt[i] >> 8) & 0xFF;
+            data[2*i+1] = hgt[i] & 0xFF;
+        }
+    }
+    
+    free(hgt);
+    
+    return data;
+}
+
+/** Returns the plain HGT tile with the voids filled, filled by the first
+ *  thread that needs it and shared until no cache keeps it, NULL if the tile
+ *  has no voids */
+static TSrtmFilled* srtmGetFilled(int latDec, int lonDec, const unsigned char* tile, int totalPx){
+    int idx = (latDec + 90) * 360 + (lonDec + 180);
+    TSrtmFilled * filled;
+    unsigned char * data;
+    long voids;
+    
+#if defined(USE_PTHREADS) && USE_PTHREADS
+    pthread_mutex_lock(&srtmFilledMutex);
+#endif
+    //lat 90 or lon 180 are past the tiles (and have no file anyway)
+    if(idx < 0 || idx >= 180 * 360 || srtmNoVoids[idx]){
+        filled = NULL;
+    }
+    else{
+        for(filled = srtmFilled; filled != NULL; filled = filled->next){
+            if(filled->idx == idx) break;
         }
         
-#if !SRTMSLIM
-        if(srtmTile == NULL){
-            srtmTile = (unsigned char*) malloc(totalPx * totalPx * 2); //allocate only once
+        if(filled != NULL){
+            filled->users++;
+        }
+        else if((data = srtmFillHgtVoids(tile, totalPx, &voids)) == NULL){
+            srtmNoVoids[idx] = 1;
         }
+        else{
+            filled = (TSrtmFilled*) malloc(sizeof(TSrtmFilled));
+            filled->idx = idx;
+            filled->data = data;
+            filled->voids = voids;
+            filled->users = 1;
+            filled->next = srtmFilled;
+            srtmFilled = filled;
+        }
+    }
+#if defined(USE_PTHREADS) && USE_PTHREADS
+    pthread_mutex_unlock(&srtmFilledMutex);
+#endif
+    
+    return filled;
+}
+
+/** Stops using the shared tile with the voids filled, freed by the last user */
+static void srtmReleaseFilled(TSrtmFilled * filled){
+    TSrtmFilled ** prev;
+    
+#if defined(USE_PTHREADS) && USE_PTHREADS
+    pthread_mutex_lock(&srtmFilledMutex);
+#endif
+    if(--filled->users == 0){
+        for(prev = &srtmFilled; *prev != filled; prev = &(*prev)->next);
         
-        //read the whole tile
-        fread(srtmTile, 1, (2 * totalPx * totalPx), srtmFd);
+        *prev = filled->next;
+        free(filled->data);
+        free(filled);
+    }
+#if defined(USE_PTHREADS) && USE_PTHREADS
+    pthread_mutex_unlock(&srtmFilledMutex);
 #endif
+}
+
+/** Counts the tile when it is loaded first time (by any thread),
+ *  returns 1 in that case */
+static int srtmCountTile(int latDec, int lonDec, long voids, int missing){
+    int idx = (latDec + 90) * 360 + (lonDec + 180);
+    int first = 0;
+    
+#if defined(USE_PTHREADS) && USE_PTHREADS
+    pthread_mutex_lock(&srtmStatisticsMutex);
+#endif
+    if(idx >= 0 && idx < 180 * 360 && !(srtmLoaded[idx] & SRTM_LOADED)){
+        srtmLoaded[idx] |= SRTM_LOADED;
+        srtmFilledVoids += voids;
+        srtmMissingTiles += missing;
+        first = 1;
     }
+#if defined(USE_PTHREADS) && USE_PTHREADS
+    pthread_mutex_unlock(&srtmStatisticsMutex);
+#endif
+    
+    return first;
 }
 
-void srtmClose(){
-    if(srtmFd != NULL){
-        fclose(srtmFd);
+/** Returns 1 if the bad .rte tile is found first time (by any thread) */
+static int srtmFirstBadRte(int latDec, int lonDec){
+    int idx = (latDec + 90) * 360 + (lonDec + 180);
+    int first = 0;
+    
+#if defined(USE_PTHREADS) && USE_PTHREADS
+    pthread_mutex_lock(&srtmStatisticsMutex);
+#endif
+    if(idx >= 0 && idx < 180 * 360 && !(srtmLoaded[idx] & SRTM_BAD_RTE)){
+        srtmLoaded[idx] |= SRTM_BAD_RTE;
+        first = 1;
     }
+#if defined(USE_PTHREADS) && USE_PTHREADS
+    pthread_mutex_unlock(&srtmStatisticsMutex);
+#endif
     
+    return first;
+}
+
+/** Keeps the tile in the cache as missing - its heights are 0 and the
+ *  segments over it are flat */
+static void srtmSetMissing(const char* filename, const char* reason){
+    srtmTile->missing = 1;
+    srtmTile->totalPx = 1201;
+    srtmTile->secondsPerPx = 3;
+    srtmTile->blocksPerRow = 0;
+    
+    if(srtmCountTile(srtmTile->lat, srtmTile->lon, 0, 1)){
+        printf("Missing %s (%s), segments on it are flat\n", filename, reason);
+    }
+}
+
+/** Sets the number of tiles kept resident, must be called before first lookup */
+void srtmSetCacheSize(int tiles){
+    if(srtmCache != NULL){
+        srtmClose();
+    }
+    
+    srtmCacheSize = tiles < 1 ? 1 : tiles;
+}
+
+/** Prepares corresponding tile - from the cache or by evicting the least recently used one */
+void srtmLoadTile(int latDec, int lonDec){
+    int i;
+    TSrtmTile * victim;
+    
+    srtmCacheClock++;
+    
+    //most lookups hit the tile used last time, the hits and misses are
+    //counted only when the tile changes (to tell how well the cache works)
+    if(srtmTile != NULL && srtmTile->lat == latDec && srtmTile->lon == lonDec) {
+        srtmTile->lastUsed = srtmCacheClock;
+        return;
+    }
+    
+    if(srtmCache == NULL){
+        srtmCache = (TSrtmTile*) calloc(srtmCacheSize, sizeof(TSrtmTile));
+        
+        for(i=0; i<srtmCacheSize; ++i){
+            srtmCache[i].lat = 255; //default never valid
+            srtmCache[i].lon = 255;
+        }
+    }
+    
+    victim = &srtmCache[0];
+    
+    for(i=0; i<srtmCacheSize; ++i){
+        if(srtmCache[i].lat == latDec && srtmCache[i].lon == lonDec) {
+            srtmTile = &srtmCache[i];
+            srtmTile->lastUsed = srtmCacheClock;
+            srtmCacheHits++;
+            return;
+        }
+        
+        if(srtmCache[i].lastUsed < victim->lastUsed){
+            victim = &srtmCache[i];
+        }
+    }
+    
+    //not resident -> replace the least recently used tile
+    srtmCacheMisses++;
+    
+    srtmTile = victim;
+    srtmTile->lat = latDec;
+    srtmTile->lon = lonDec;
+    srtmTile->lastUsed = srtmCacheClock;
+    
+    srtmFreeTile(srtmTile);
+    
+    char filename[256];
+    struct stat buf;
+    TSrtmRteHeader header;
+    
+    //prefer the converted tile (see srtmconvert)
+    srtmTileName(filename, sizeof(filename), latDec, lonDec, "rte");
+    
+    int fd = open(filename, O_RDONLY);
+    
+    srtmTile->blocksPerRow = 0;
+    
+    //a bad .rte is not mapped (it would fault), the .hgt is used instead if there is one
+    if(fd >= 0) {
+        const char* reason = srtmCheckRte(fd, &header);
+        
+        if(reason == NULL) {
+            srtmTile->totalPx = header.totalPx;
+            srtmTile->secondsPerPx = header.secondsPerPx;
+            srtmTile->blocksPerRow = header.blocksPerRow;
+        }
+        else {
+            if(srtmFirstBadRte(latDec, lonDec)){
+                printf("Ignoring %s (%s)\n", filename, reason);
+            }
+            close(fd);
+            fd = -1;
+        }
+    }
+    
+    if(fd < 0) {
+        srtmTileName(filename, sizeof(filename), latDec, lonDec, "hgt");
+        fd = open(filename, O_RDONLY);
+    }
+    
+    if(fd < 0 || fstat(fd, &buf)) {
+        if(fd >= 0) close(fd);
+        srtmSetMissing(filename, "can not open");
+        return;
+    }
+
+    srtmTile->size = buf.st_size;
+    
+    //resolution of plain HGT from the file size (which must be exact)
+    if(!srtmTile->blocksPerRow) {
+        srtmTile->totalPx = srtmHgtTotalPx(buf.st_size);
+        
+        if(!srtmTile->totalPx){
+            close(fd);
+            srtmSetMissing(filename, "unknown resolution");
+            return;
+        }
+        
+        srtmTile->secondsPerPx = 3600 / (srtmTile->totalPx - 1);
+    }
+    
+#if SRTMSLIM
+    srtmTile->fd = fdopen(fd, "r");
+#elif SRTMMMAP
+    //samples are read straight from the read-only mapping (shared page cache)
+    srtmTile->data = (unsigned char*) mmap(NULL, srtmTile->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    
+    if(srtmTile->data == MAP_FAILED) {
+        srtmTile->data = NULL;
+        srtmSetMissing(filename, "can not map");
+        return;
+    }
+#else
+    srtmTile->data = (unsigned char*) malloc(srtmTile->size);
+    
+    //read the whole tile
+    if(read(fd, srtmTile->data, srtmTile->size) != (ssize_t)srtmTile->size) {
+        close(fd);
+        free(srtmTile->data);
+        srtmTile->data = NULL;
+        srtmSetMissing(filename, "can not read");
+        return;
+    }
+    
+    close(fd);
+#endif
+
 #if !SRTMSLIM
-    if(srtmTile != NULL){
-        free(srtmTile);
+    if(srtmTile->blocksPerRow) {
+        srtmTile->samples = (int16_t*)(srtmTile->data + sizeof(TSrtmRteHeader));
+        srtmCountTile(latDec, lonDec, 0, 0);
+    }
+    else {
+        //the voids are filled once for all threads (.rte tiles have them filled by srtmconvert)
+        TSrtmFilled * filled = srtmGetFilled(latDec, lonDec, srtmTile->data, srtmTile->totalPx);
+        long voids = 0;
+        
+        if(filled != NULL){
+#if SRTMMMAP
+            munmap(srtmTile->data, srtmTile->size);
+#else
+            free(srtmTile->data);
+#endif
+            srtmTile->data = filled->data;
+            srtmTile->filled = filled;
+            voids = filled->voids;
+        }
+        
+        if(srtmCountTile(latDec, lonDec, voids, 0) && voids > 0){
+            printf("Filled %ld voids in %s\n", voids, filename);
+        }
     }
 #endif
 }
 
-/** Pixel idx from left bottom corner (0-1200) */
-void srtmReadPx(int y, int x, int* height){
-    int row = (totalPx-1) - y;
-    int col = x;
-    int pos = (row * totalPx + col) * 2;
+void srtmClose(void){
+    int i;
+    
+    srtmCellPx = 0;
+    
+#if defined(USE_PTHREADS) && USE_PTHREADS
+    pthread_mutex_lock(&srtmStatisticsMutex);
+#endif
+    srtmClosedHits += srtmCacheHits;
+    srtmClosedMisses += srtmCacheMisses;
+    srtmClosedFlat += srtmFlatSegments;
+    srtmCacheHits = srtmCacheMisses = srtmFlatSegments = 0;
+#if defined(USE_PTHREADS) && USE_PTHREADS
+    pthread_mutex_unlock(&srtmStatisticsMutex);
+#endif
+    
+    if(srtmCache == NULL){
+        return;
+    }
+    
+    for(i=0; i<srtmCacheSize; ++i){
+        srtmFreeTile(&srtmCache[i]);
+    }
     
+    free(srtmCache);
+    srtmCache = NULL;
+    srtmTile = NULL;
+}
+
+/** Returns the statistics so far, of this thread and of all threads that
+ *  closed their cache */
+void srtmGetStatistics(TSrtmStatistics* stats){
+#if defined(USE_PTHREADS) && USE_PTHREADS
+    pthread_mutex_lock(&srtmStatisticsMutex);
+#endif
+    stats->hits = srtmClosedHits + srtmCacheHits;
+    stats->misses = srtmClosedMisses + srtmCacheMisses;
+    stats->missingTiles = srtmMissingTiles;
+    stats->voids = srtmFilledVoids;
+    stats->flatSegments = srtmClosedFlat + srtmFlatSegments;
+#if defined(USE_PTHREADS) && USE_PTHREADS
+    pthread_mutex_unlock(&srtmStatisticsMutex);
+#endif
+}
+
 #if SRTMSLIM
+/** Reads one sample of plain HGT tile (big endian) */
+static int16_t srtmReadHgt(int y, int x){
+    int row = (srtmTile->totalPx-1) - y;
+    int col = x;
+    long pos = ((long)row * srtmTile->totalPx + col) * 2;
     
     //seek and read 2 bytes short
     unsigned char buff[2];// = {0xFF, 0xFB}; //-5 (bigendian)
-    fseek(srtmFd, pos, SEEK_SET);
-    fread(&buff, 2, 1, srtmFd);
+    fseek(srtmTile->fd, pos, SEEK_SET);
+    fread(&buff, 2, 1, srtmTile->fd);
     
+    //solve endianity (using int16_t)
+    return 0 | (buff[0] << 8) | (buff[1] << 0);
+}
+
+/** Fills the voids of the plain HGT tile when the first one is read, the
+ *  tile is not read whole in SRTMSLIM until then. The voids are filled the
+ *  same way as in the non-slim build (and the copy is shared the same way). */
+static void srtmFillSlimTile(void){
+    long size = 2L * srtmTile->totalPx * srtmTile->totalPx;
+    unsigned char * tile = (unsigned char*) malloc(size);
+    char filename[256];
+    
+    fseek(srtmTile->fd, 0, SEEK_SET);
+    
+    if(fread(tile, 1, size, srtmTile->fd) == (size_t)size){
+        srtmTile->filled = srtmGetFilled(srtmTile->lat, srtmTile->lon, tile, srtmTile->totalPx);
+    }
+    
+    free(tile);
+    
+    if(srtmTile->filled == NULL){
+        return;
+    }
+    
+    srtmTile->data = srtmTile->filled->data;
+    
+    if(srtmCountTile(srtmTile->lat, srtmTile->lon, srtmTile->filled->voids, 0)){
+        srtmTileName(filename, sizeof(filename), srtmTile->lat, srtmTile->lon, "hgt");
+        printf("Filled %ld voids in %s\n", srtmTile->filled->voids, filename);
+    }
+}
+#endif
+
+/** Pixel idx from left bottom corner (0-1200 or 0-3600) */
+void srtmReadPx(int y, int x, int* height){
+    if(srtmTile->missing) {
+        *height = 0;
+        srtmMissing = 1;
+        return;
+    }
+    
+    if(srtmTile->blocksPerRow) {
+        //converted tile - native endian, voids already filled
+        long idx = srtmRteIndex(srtmTile->blocksPerRow, y, x);
+#if SRTMSLIM
+        int16_t hgt;
+        fseek(srtmTile->fd, sizeof(TSrtmRteHeader) + idx * 2, SEEK_SET);
+        fread(&hgt, 2, 1, srtmTile->fd);
+        *height = hgt;
 #else
+        *height = srtmTile->samples[idx];
+#endif
+        return;
+    }
     
-    //set correct buff pointer
-    unsigned char * buff = & srtmTile[pos];
+#if SRTMSLIM
+    
+    //the samples are read from the file until a void is found
+    if(srtmTile->data == NULL) {
+        int16_t hgt = srtmReadHgt(y, x);
+        
+        if(hgt != -32768) {
+            *height = (int) hgt;
+            return;
+        }
+        
+        srtmFillSlimTile();
+        
+        if(srtmTile->data == NULL) {
+            *height = 0;
+            return;
+        }
+    }
     
 #endif
     
+    int row = (srtmTile->totalPx-1) - y;
+    int col = x;
+    long pos = ((long)row * srtmTile->totalPx + col) * 2;
+    
+    //set correct buff pointer, voids were filled at load
+    unsigned char * buff = & srtmTile->data[pos];
+    
     //solve endianity (using int16_t)
     int16_t hgt = 0 | (buff[0] << 8) | (buff[1] << 0);
     
-    if(hgt == -32768) {
-        printf("ERROR: Void pixel found on xy(%d,%d) in latlon(%d,%d) tile.\n", x,y, srtmLat, srtmLon);
-        exit(1);
-    }
-    
     *height = (int) hgt;
 }       
-
-/** Returns interpolated height from four nearest points */
-float srtmGetElevation(float lat, float lon){
-    int latDec = (int)lat;
-    int lonDec = (int)lon;
-
+/** Finds the pixel (y,x) of the tile below and left of the point and the ratio
+ *  where the point lays between it and the next ones */
+static inline void srtmFindPx(float lat, float lon, int latDec, int lonDec, int secondsPerPx, int totalPx,
+                              int* y, int* x, float* dy, float* dx){
     float secondsLat = (lat-latDec) * 60 * 60;
     float secondsLon = (lon-lonDec) * 60 * 60;
     
-    srtmLoadTile(latDec, lonDec);
-
     //X coresponds to x/y values,
     //everything easter/norhter (< S) is rounded to X.
     //
@@ -124,8 +763,35 @@ float srtmGetElevation(float lat, float lon){
     // (sec)    0        3   x  (lon)
     
     //both values are 0-1199 (1200 reserved for interpolating)
-    int y = secondsLat/secondsPerPx;
-    int x = secondsLon/secondsPerPx;
+    *y = secondsLat/secondsPerPx;
+    *x = secondsLon/secondsPerPx;
+    
+    //float rounding may reach the last row/column
+    if(*y > totalPx-2) *y = totalPx-2;
+    if(*x > totalPx-2) *x = totalPx-2;
+    
+    //ratio where X lays, the same as fmod(seconds, secondsPerPx) but without
+    //the libm call (x/y may be off by one from the float division above)
+    double modLat = secondsLat - (double)*y * secondsPerPx;
+    double modLon = secondsLon - (double)*x * secondsPerPx;
+    
+    if(modLat < 0) modLat += secondsPerPx; else if(modLat >= secondsPerPx) modLat -= secondsPerPx;
+    if(modLon < 0) modLon += secondsPerPx; else if(modLon >= secondsPerPx) modLon -= secondsPerPx;
+    
+    *dy = modLat / secondsPerPx;
+    *dx = modLon / secondsPerPx;
+}
+
+/** Finds the four nearest points and the ratio where the point lays between them */
+static void srtmGatherPx(float lat, float lon, float* h0, float* h1, float* h2, float* h3, float* dy, float* dx){
+    //floor so that south/west tiles are found too (S01 covers -1..0)
+    int latDec = (int)floorf(lat);
+    int lonDec = (int)floorf(lon);
+    int y, x;
+    
+    srtmLoadTile(latDec, lonDec);
+    
+    srtmFindPx(lat, lon, latDec, lonDec, srtmTile->secondsPerPx, srtmTile->totalPx, &y, &x, dy, dx);
     
     //get norther and easter points
     int height[4];
@@ -133,10 +799,18 @@ float srtmGetElevation(float lat, float lon){
     srtmReadPx(y+1, x, &height[0]);
     srtmReadPx(y,   x+1, &height[3]);
     srtmReadPx(y+1, x+1, &height[1]);
+    
+    *h0 = height[0];
+    *h1 = height[1];
+    *h2 = height[2];
+    *h3 = height[3];
+}
 
-    //ratio where X lays
-    float dy = fmod(secondsLat, secondsPerPx) / secondsPerPx;
-    float dx = fmod(secondsLon, secondsPerPx) / secondsPerPx;
+/** Returns interpolated height from four nearest points */
+float srtmGetElevation(float lat, float lon){
+    float h0, h1, h2, h3, dy, dx;
+    
+    srtmGatherPx(lat, lon, &h0, &h1, &h2, &h3, &dy, &dx);
     
     // Bilinear interpolation
     // h0------------h1
@@ -146,24 +820,196 @@ float srtmGetElevation(float lat, float lon){
     // |      dy
     // |       |
     // h2------------h3   
-    return  height[0] * dy * (1 - dx) +
-            height[1] * dy * (dx) +
-            height[2] * (1 - dy) * (1 - dx) +
-            height[3] * (1 - dy) * dx;
+    return  h0 * dy * (1 - dx) +
+            h1 * dy * (dx) +
+            h2 * (1 - dy) * (1 - dx) +
+            h3 * (1 - dy) * dx;
+}
+
+#if SRTM_AVX2
+/** Bilinear interpolation of the gathered points 8 at once, compiled for
+ *  AVX2 whatever the CFLAGS are, so it must be called only if the processor
+ *  has AVX2. Returns the number of points done (a multiple of 8). */
+__attribute__((target("avx2")))
+static int srtmBlendAvx2(const float* h0, const float* h1, const float* h2, const float* h3,
+                         const float* dy, const float* dx, float* height, int n){
+    __m256 one8 = _mm256_set1_ps(1);
+    int i;
+    
+    for(i=0; i+8<=n; i+=8){
+        __m256 vdy = _mm256_loadu_ps(dy+i), vdx = _mm256_loadu_ps(dx+i);
+        __m256 ndy = _mm256_sub_ps(one8, vdy), ndx = _mm256_sub_ps(one8, vdx);
+        
+        __m256 r = _mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(h0+i), vdy), ndx);
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(h1+i), vdy), vdx));
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(h2+i), ndy), ndx));
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(h3+i), ndy), vdx));
+        
+        _mm256_storeu_ps(height+i, r);
+    }
+    
+    return i;
+}
+#endif
+
+/** Bilinear interpolation of n gathered points, the same operations
+ *  (and so the same results) as srtmGetElevation() */
+static void srtmBlend(const float* h0, const float* h1, const float* h2, const float* h3,
+                      const float* dy, const float* dx, float* height, int n){
+    int i = 0;
+    
+#if SRTM_AVX2
+    //cpuid, checked by the compiler runtime once at startup
+    if(__builtin_cpu_supports("avx2")){
+        i = srtmBlendAvx2(h0, h1, h2, h3, dy, dx, height, n);
+    }
+#endif
+    
+#if defined(__SSE2__)
+    __m128 one4 = _mm_set1_ps(1);
+    
+    for(; i+4<=n; i+=4){
+        __m128 vdy = _mm_loadu_ps(dy+i), vdx = _mm_loadu_ps(dx+i);
+        __m128 ndy = _mm_sub_ps(one4, vdy), ndx = _mm_sub_ps(one4, vdx);
+        
+        __m128 r = _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(h0+i), vdy), ndx);
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(h1+i), vdy), vdx));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(h2+i), ndy), ndx));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(h3+i), ndy), vdx));
+        
+        _mm_storeu_ps(height+i, r);
+    }
+#endif
+    
+    //scalar fallback and the rest
+    for(; i<n; ++i){
+        height[i] = h0[i] * dy[i] * (1 - dx[i]) +
+                    h1[i] * dy[i] * (dx[i]) +
+                    h2[i] * (1 - dy[i]) * (1 - dx[i]) +
+                    h3[i] * (1 - dy[i]) * dx[i];
+    }
+}
+
+/** Reads big endian sample of plain HGT tile */
+static inline float srtmHgtSample(const unsigned char* buff){
+    return (int16_t)(0 | (buff[0] << 8) | (buff[1] << 0));
+}
+
+/** Returns interpolated heights of n points at once - the tile is looked up
+ *  only when the points move to another one and the samples are read from
+ *  the tile in memory straight away (the same heights as srtmGetElevation()) */
+void srtmGetElevations(const float* lat, const float* lon, float* height, int n){
+    float h0[SRTM_BATCH], h1[SRTM_BATCH], h2[SRTM_BATCH], h3[SRTM_BATCH];
+    float dy[SRTM_BATCH], dx[SRTM_BATCH];
+    int i, j;
+    
+    //the tile of the last point
+    int tileLat = 0, tileLon = 0, loaded = 0;
+    int secondsPerPx = 0, totalPx = 0, blocksPerRow = 0;
+    const unsigned char* data = NULL;
+    const int16_t* samples = NULL;
+    
+    for(i=0; i<n; i+=SRTM_BATCH){
+        int count = n-i < SRTM_BATCH ? n-i : SRTM_BATCH;
+        
+        for(j=0; j<count; ++j){
+            int latDec = (int)floorf(lat[i+j]);
+            int lonDec = (int)floorf(lon[i+j]);
+            int y, x;
+            
+            if(!loaded || latDec != tileLat || lonDec != tileLon){
+                srtmLoadTile(latDec, lonDec);
+                
+                tileLat = latDec;
+                tileLon = lonDec;
+                loaded = 1;
+                
+                secondsPerPx = srtmTile->secondsPerPx;
+                totalPx = srtmTile->totalPx;
+                blocksPerRow = srtmTile->blocksPerRow;
+                
+                //samples in memory (else read by srtmReadPx(), e.g. missing tile or SRTMSLIM)
+                data = NULL;
+                samples = NULL;
+                
+                if(!srtmTile->missing){
+#if SRTMSLIM
+                    if(!blocksPerRow) data = srtmTile->data;
+#else
+                    if(blocksPerRow) samples = srtmTile->samples;
+                    else data = srtmTile->data;
+#endif
+                }
+            }
+            
+            srtmFindPx(lat[i+j], lon[i+j], latDec, lonDec, secondsPerPx, totalPx, &y, &x, &dy[j], &dx[j]);
+            
+            if(data){
+                //the rows are from the north, y is from the south
+                const unsigned char* buff = &data[((long)(totalPx-1 - y) * totalPx + x) * 2];
+                
+                h2[j] = srtmHgtSample(buff);
+                h3[j] = srtmHgtSample(buff + 2);
+                h0[j] = srtmHgtSample(buff - 2 * totalPx);
+                h1[j] = srtmHgtSample(buff - 2 * totalPx + 2);
+            }
+            else if(samples){
+                h2[j] = samples[srtmRteIndex(blocksPerRow, y,   x)];
+                h3[j] = samples[srtmRteIndex(blocksPerRow, y,   x+1)];
+                h0[j] = samples[srtmRteIndex(blocksPerRow, y+1, x)];
+                h1[j] = samples[srtmRteIndex(blocksPerRow, y+1, x+1)];
+            }
+            else{
+                int height[4];
+                srtmReadPx(y,   x, &height[2]);
+                srtmReadPx(y+1, x, &height[0]);
+                srtmReadPx(y,   x+1, &height[3]);
+                srtmReadPx(y+1, x+1, &height[1]);
+                
+                h0[j] = height[0];
+                h1[j] = height[1];
+                h2[j] = height[2];
+                h3[j] = height[3];
+                
+                //SRTMSLIM reads the whole tile at the first void
+                if(srtmTile->data != data) loaded = 0;
+            }
+        }
+        
+        srtmBlend(h0, h1, h2, h3, dy, dx, &height[i], count);
+    }
 }
 
 
+/** Segment over a missing tile is flat - all of it counted as descent by 0 m
+ *  (the same as a segment with equal heights) */
+static void srtmCheckFlat(TSrtmAscentDescent* ret, float dist){
+    if(!srtmMissing){
+        return;
+    }
+    
+    ret->ascent = ret->descent = ret->ascentOn = 0;
+    ret->descentOn = dist;
+    srtmFlatSegments++;
+}
+
 /** Returns amount of ascent and descent between points */
 TSrtmAscentDescent srtmGetAscentDescent(float lat1, float lon1, float lat2, float lon2, float dist){
     TSrtmAscentDescent ret = {0};
     
+    srtmMissing = 0;
+    
     //segment we need to devide in "pixels"
     double latDiff = lat2 - lat1;
     double lonDiff = lon2 - lon1;
     
+    //resolution of the tile where the segment starts
+    srtmLoadTile((int)floorf(lat1), (int)floorf(lon1));
+    int pxPerDegree = 3600 / srtmTile->secondsPerPx;
+    
     //how many pixels there are both in y and x axis
-    double latSteps = latDiff * (3600 / 3); // 1/pixelDistance = cca 0.00083
-    double lonSteps = lonDiff * (3600 / 3);
+    double latSteps = latDiff * pxPerDegree; // 1/pixelDistance = cca 0.00083
+    double lonSteps = lonDiff * pxPerDegree;
     
     //we use the max of both
     int steps = fmax(fabs(latSteps), fabs(lonSteps));
@@ -178,35 +1024,368 @@ TSrtmAscentDescent srtmGetAscentDescent(float lat1, float lon1, float lat2, floa
     double distStep = dist/steps;
       //printf("steps %d: %f %f %f\n", steps, latStep, lonStep, distStep);
     
-    int i;
+    int i, j;
     double lat = lat1, lon = lon1;
+    float lats[SRTM_BATCH], lons[SRTM_BATCH], heights[SRTM_BATCH];
     float height, lastHeight, eleDiff;
 
     //get first elevation -> we need eleDiff then
     height = srtmGetElevation(lat, lon);
       //printf("first: %f %f hgt:%f\n", lat, lon, height);
     
-    for(i=0; i<steps; ++i){
-        lat += latStep;
-        lon += lonStep;
-        lastHeight = height;
+    for(i=0; i<steps; i+=SRTM_BATCH){
+        int count = steps-i < SRTM_BATCH ? steps-i : SRTM_BATCH;
+        
+        //the points of the steps are interpolated at once
+        for(j=0; j<count; ++j){
+            lat += latStep;
+            lon += lonStep;
+            lats[j] = lat;
+            lons[j] = lon;
+        }
+        
+        srtmGetElevations(lats, lons, heights, count);
+        
+        for(j=0; j<count; ++j){
+            lastHeight = height;
+            
+            height = heights[j];
+            eleDiff = height - lastHeight;
+            
+            if(eleDiff > 0){
+                ret.ascent += eleDiff;
+                ret.ascentOn += distStep;
+            }
+            else{
+                ret.descent += -eleDiff;
+                ret.descentOn += distStep;
+            }
+            
+            //printf("LL(%d): %f %f hgt: %0.1f, diff %0.1f\n", i+j, lats[j], lons[j], height, eleDiff);
+        }
+    }
+    
+    // printf("last: %f %f\n", i, lat, lon); ==   printf("ll2: %f %f\n", i, lat2, lon2);
+    
+    srtmCheckFlat(&ret, dist);
+    
+    return ret;
+}
+
+
+/** Finds out the resolution of the tile without loading it (1201 if there is
+ *  no usable tile), remembered for the following keys */
+static int srtmKeyTotalPx(int latDec, int lonDec){
+    int idx = (latDec + 90) * 360 + (lonDec + 180);
+    int totalPx;
+    
+    //lat 90 or lon 180 are past the tiles (and have no file anyway)
+    if(idx < 0 || idx >= 180 * 360){
+        return 1201;
+    }
+    
+#if defined(USE_PTHREADS) && USE_PTHREADS
+    pthread_mutex_lock(&srtmStatisticsMutex);
+#endif
+    totalPx = srtmKeyPx[idx];
+    
+    if(!totalPx){
+        char filename[256];
+        struct stat buf;
+        TSrtmRteHeader header;
+        
+        srtmTileName(filename, sizeof(filename), latDec, lonDec, "rte");
+        
+        int fd = open(filename, O_RDONLY);
+        
+        if(fd >= 0 && !srtmCheckRte(fd, &header)){
+            totalPx = header.totalPx;
+        }
         
-        height = srtmGetElevation(lat, lon);
-        eleDiff = height - lastHeight;
+        if(fd >= 0) close(fd);
         
-        if(eleDiff > 0){
-            ret.ascent += eleDiff;
-            ret.ascentOn += distStep;
+        if(!totalPx){
+            srtmTileName(filename, sizeof(filename), latDec, lonDec, "hgt");
+            
+            if(!stat(filename, &buf)){
+                totalPx = srtmHgtTotalPx(buf.st_size);
+            }
+        }
+        
+        if(!totalPx) totalPx = 1201;
+        
+        srtmKeyPx[idx] = totalPx;
+    }
+#if defined(USE_PTHREADS) && USE_PTHREADS
+    pthread_mutex_unlock(&srtmStatisticsMutex);
+#endif
+    
+    return totalPx;
+}
+
+/** Returns key of the tile and its SRTM_RTE_BLOCK block where the point lays,
+ *  points sorted by the key are looked up tile by tile (and block by block) */
+unsigned int srtmTileKey(float lat, float lon){
+    int latDec = (int)floorf(lat);
+    int lonDec = (int)floorf(lon);
+    int totalPx = srtmKeyTotalPx(latDec, lonDec);
+    
+    //blocks of this tile in a row, each tile has room for the blocks of SRTM1
+    int blocks = (totalPx + SRTM_RTE_BLOCK - 1) / SRTM_RTE_BLOCK;
+    int by = (int)((lat - latDec) * (totalPx - 1)) / SRTM_RTE_BLOCK;
+    int bx = (int)((lon - lonDec) * (totalPx - 1)) / SRTM_RTE_BLOCK;
+    
+    if(by >= blocks) by = blocks - 1;
+    if(bx >= blocks) bx = blocks - 1;
+    
+    return ((unsigned int)(latDec + 90) * 360 + (lonDec + 180)) * SRTM_KEY_BLOCKS + by * blocks + bx;
+}
+
+/** Reads the corners of grid cell (cx,cy), counted in pixels from 0N 0E,
+ *  returns 0 if the tile has other resolution than pxPerDegree */
+static int srtmReadCell(long cx, long cy, int pxPerDegree, float* h00, float* h10, float* h01, float* h11){
+    if(srtmCellPx == pxPerDegree && srtmCellX == cx && srtmCellY == cy){
+        *h00 = srtmCellH[0];
+        *h10 = srtmCellH[1];
+        *h01 = srtmCellH[2];
+        *h11 = srtmCellH[3];
+        return 1;
+    }
+    
+    int latDec = (int)floor((double)cy / pxPerDegree);
+    int lonDec = (int)floor((double)cx / pxPerDegree);
+    
+    srtmLoadTile(latDec, lonDec);
+    
+    if(srtmTile->totalPx - 1 != pxPerDegree){
+        return 0;
+    }
+    
+    //both 0-1199, the cell of the last row/column is in the next tile
+    int y = cy - (long)latDec * pxPerDegree;
+    int x = cx - (long)lonDec * pxPerDegree;
+    
+    int height[4];
+    srtmReadPx(y,   x,   &height[0]);
+    srtmReadPx(y,   x+1, &height[1]);
+    srtmReadPx(y+1, x,   &height[2]);
+    srtmReadPx(y+1, x+1, &height[3]);
+    
+    *h00 = srtmCellH[0] = height[0];
+    *h10 = srtmCellH[1] = height[1];
+    *h01 = srtmCellH[2] = height[2];
+    *h11 = srtmCellH[3] = height[3];
+    
+    //missing tile is not cached, so that each segment over it is found flat
+    if(srtmTile->missing){
+        return 1;
+    }
+    
+    srtmCellX = cx;
+    srtmCellY = cy;
+    srtmCellPx = pxPerDegree;
+    
+    return 1;
+}
+
+/** Adds monotonic piece of the segment to the ascent or descent */
+static void srtmAddPiece(TSrtmAscentDescent* ret, double eleDiff, double distance){
+    if(eleDiff > 0){
+        ret->ascent += eleDiff;
+        ret->ascentOn += distance;
+    }
+    else{
+        ret->descent += -eleDiff;
+        ret->descentOn += distance;
+    }
+}
+
+/** Returns amount of ascent and descent between points, exactly for the
+ *  bilinear surface - the segment is walked cell by cell through the grid
+ *  (Amanatides & Woo traversal). Inside a cell the height along the segment
+ *  is quadratic, so it is evaluated only where the segment enters and leaves
+ *  the cell and in its extremum (if any). */
+TSrtmAscentDescent srtmGetAscentDescentGrid(float lat1, float lon1, float lat2, float lon2, float dist){
+    return srtmGetAscentDescentNodes(lat1, lon1, NAN, lat2, lon2, NAN, dist);
+}
+
+/** The same as srtmGetAscentDescentGrid() with known heights of the end
+ *  points (eg. computed once per node), NAN if not known */
+TSrtmAscentDescent srtmGetAscentDescentNodes(float lat1, float lon1, float height1, float lat2, float lon2, float height2, float dist){
+    TSrtmAscentDescent ret = {0};
+    
+    srtmMissing = 0;
+    
+    //resolution of the tile where the segment starts
+    srtmLoadTile((int)floorf(lat1), (int)floorf(lon1));
+    int pxPerDegree = srtmTile->totalPx - 1;
+    
+    //segment in pixels from 0N 0E, parametrized by t = 0..1
+    double gx = (double)lon1 * pxPerDegree;
+    double gy = (double)lat1 * pxPerDegree;
+    double a = (double)lon2 * pxPerDegree - gx;
+    double b = (double)lat2 * pxPerDegree - gy;
+    
+    long cx = (long)floor(gx);
+    long cy = (long)floor(gy);
+    
+    int stepX = a > 0 ? 1 : -1;
+    int stepY = b > 0 ? 1 : -1;
+    
+    //t of the next cell edge crossing and t between two crossings
+    double tMaxX = a > 0 ? (cx + 1 - gx) / a : a < 0 ? (cx - gx) / a : INFINITY;
+    double tMaxY = b > 0 ? (cy + 1 - gy) / b : b < 0 ? (cy - gy) / b : INFINITY;
+    double tDeltaX = a != 0 ? stepX / a : INFINITY;
+    double tDeltaY = b != 0 ? stepY / b : INFINITY;
+    
+    double t = 0;
+    
+    do{
+        double tNext = fmin(fmin(tMaxX, tMaxY), 1);
+        double len = tNext - t;
+        float h00, h10, h01, h11;
+        
+        if(srtmReadCell(cx, cy, pxPerDegree, &h00, &h10, &h01, &h11)){
+            // h(u,v) = h00 + p*u + q*v + r*u*v  inside the cell (u,v = 0..1)
+            double p = h10 - h00;
+            double q = h01 - h00;
+            double r = h00 - h10 - h01 + h11;
+            double u0 = gx + a * t - cx;
+            double v0 = gy + b * t - cy;
+            
+            // h(s) = A + B*s + C*s^2  along the piece (s = 0..len)
+            double A = h00 + p * u0 + q * v0 + r * u0 * v0;
+            double B = p * a + q * b + r * (u0 * b + v0 * a);
+            double C = r * a * b;
+            double hStart = A;
+            double hEnd = A + B * len + C * len * len;
+            
+            //the same heights of the nodes for all their segments
+            if(t == 0 && !isnan(height1)) hStart = height1;
+            if(tNext == 1 && !isnan(height2)) hEnd = height2;
+            
+            double sExt = C != 0 ? -B / (2 * C) : -1;
+            
+            if(sExt > 0 && sExt < len){
+                double hExt = A + B * sExt + C * sExt * sExt;
+                
+                srtmAddPiece(&ret, hExt - hStart, dist * sExt);
+                srtmAddPiece(&ret, hEnd - hExt, dist * (len - sExt));
+            }
+            else{
+                srtmAddPiece(&ret, hEnd - hStart, dist * len);
+            }
         }
         else{
-            ret.descent += -eleDiff;
-            ret.descentOn += distStep;
+            //tile of other resolution - just the heights on the edges
+            double lat = lat1 + (lat2 - lat1) * t, latNext = lat1 + (lat2 - lat1) * tNext;
+            double lon = lon1 + (lon2 - lon1) * t, lonNext = lon1 + (lon2 - lon1) * tNext;
+            
+            double hStart = (t == 0 && !isnan(height1)) ? height1 : srtmGetElevation(lat, lon);
+            double hEnd = (tNext == 1 && !isnan(height2)) ? height2 : srtmGetElevation(latNext, lonNext);
+            
+            srtmAddPiece(&ret, hEnd - hStart, dist * len);
         }
         
-        //printf("LL(%d): %f %f hgt: %0.1f, diff %0.1f\n", i, lat, lon, height, eleDiff);
+        t = tNext;
+        
+        if(tMaxX < tMaxY){
+            cx += stepX;
+            tMaxX += tDeltaX;
+        }
+        else{
+            cy += stepY;
+            tMaxY += tDeltaY;
+        }
     }
+    while(t < 1);
     
-    // printf("last: %f %f\n", i, lat, lon); ==   printf("ll2: %f %f\n", i, lat2, lon2);
+    srtmCheckFlat(&ret, dist);
     
     return ret;
 }
+
+
+/** Converts HGT tile to the native endian blocked .rte tile with voids filled,
+ *  returns number of filled voids or -1 on error */
+int srtmConvertTile(const char* hgtFilename, const char* rteFilename){
+    FILE* in = fopen(hgtFilename, "r");
+    struct stat buf;
+    
+    if(in == NULL || fstat(fileno(in), &buf)) {
+        printf("Error opening %s\n", hgtFilename);
+        return -1;
+    }
+    
+    int totalPx = srtmHgtTotalPx(buf.st_size);
+    
+    if(!totalPx) {
+        printf("Error unknown resolution of %s (%ld bytes)\n", hgtFilename, (long)buf.st_size);
+        fclose(in);
+        return -1;
+    }
+    
+    //read the samples bottom row first (the same y as srtmReadPx)
+    int16_t * hgt = (int16_t*) malloc(sizeof(int16_t) * totalPx * totalPx);
+    unsigned char * row = (unsigned char*) malloc(2 * totalPx);
+    int x, y, voids = 0;
+    
+    for(y=totalPx-1; y>=0; --y){
+        if(fread(row, 2, totalPx, in) != (size_t)totalPx) {
+            printf("Error reading %s\n", hgtFilename);
+            fclose(in);
+            free(hgt);
+            free(row);
+            return -1;
+        }
+        
+        for(x=0; x<totalPx; ++x){
+            hgt[y * totalPx + x] = 0 | (row[2*x] << 8) | (row[2*x+1] << 0);
+            
+            if(hgt[y * totalPx + x] == -32768) voids++;
+        }
+    }
+    
+    fclose(in);
+    free(row);
+    
+    srtmFillVoids(hgt, totalPx);
+    
+    //split to the blocks, samples out of the tile repeat the last row/column
+    TSrtmRteHeader header;
+    header.magic = SRTM_RTE_MAGIC;
+    header.totalPx = totalPx;
+    header.secondsPerPx = 3600 / (totalPx - 1);
+    header.blocksPerRow = (totalPx + SRTM_RTE_BLOCK - 1) / SRTM_RTE_BLOCK;
+    
+    long nsamples = (long)header.blocksPerRow * header.blocksPerRow * SRTM_RTE_BLOCK * SRTM_RTE_BLOCK;
+    int16_t * blocks = (int16_t*) malloc(sizeof(int16_t) * nsamples);
+    int size = header.blocksPerRow * SRTM_RTE_BLOCK;
+    
+    for(y=0; y<size; ++y){
+        for(x=0; x<size; ++x){
+            int yy = y < totalPx ? y : totalPx-1;
+            int xx = x < totalPx ? x : totalPx-1;
+            
+            blocks[srtmRteIndex(header.blocksPerRow, y, x)] = hgt[yy * totalPx + xx];
+        }
+    }
+    
+    free(hgt);
+    
+    FILE* out = fopen(rteFilename, "w");
+    
+    if(out == NULL ||
+       fwrite(&header, sizeof(header), 1, out) != 1 ||
+       fwrite(blocks, sizeof(int16_t), nsamples, out) != (size_t)nsamples) {
+        printf("Error writing %s\n", rteFilename);
+        if(out != NULL) fclose(out);
+        free(blocks);
+        return -1;
+    }
+    
+    fclose(out);
+    free(blocks);
+    
+    return voids;
+}
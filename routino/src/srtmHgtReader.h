@@ -8,13 +8,39 @@
 #ifndef SRTMHGTREADER_H
 #define	SRTMHGTREADER_H
 
+/** Number of tiles kept in memory unless set otherwise */
+#define SRTM_CACHE_DEFAULT 8
+
+/** Converted .rte tiles - "RTE1" and size of the square block of samples */
+#define SRTM_RTE_MAGIC 0x31455452
+#define SRTM_RTE_BLOCK 64
+
+/** Number of points interpolated at once by srtmGetElevations() */
+#define SRTM_BATCH 64
+
+/** Counters reported after the lookups */
+typedef struct {
+    unsigned long hits;         //other tile than the last one found in the cache
+    unsigned long misses;       //tile read from disk
+    unsigned long missingTiles; //tiles not available (their heights are 0)
+    unsigned long voids;        //void pixels filled from the neighbours
+    unsigned long flatSegments; //segments made flat because of missing tile
+} TSrtmStatistics;
+
+void srtmSetCacheSize(int tiles);
+void srtmGetStatistics(TSrtmStatistics* stats);
+
 void srtmLoadTile(int latDec, int lonDec);
 void srtmReadPx(int y, int x, int* height);
 
 
 float srtmGetElevation(float lat, float lon);
+void srtmGetElevations(const float* lat, const float* lon, float* height, int n);
+unsigned int srtmTileKey(float lat, float lon);
+
+void srtmClose(void);
 
-void srtmClose();
+int srtmConvertTile(const char* hgtFilename, const char* rteFilename);
 
 
 
@@ -29,6 +55,8 @@ typedef struct _SrtmAscentDescent TSrtmAscentDescent;
 
 
 TSrtmAscentDescent srtmGetAscentDescent(float lat1, float lon1, float lat2, float lon2, float dist);
+TSrtmAscentDescent srtmGetAscentDescentGrid(float lat1, float lon1, float lat2, float lon2, float dist);
+TSrtmAscentDescent srtmGetAscentDescentNodes(float lat1, float lon1, float height1, float lat2, float lon2, float height2, float dist);
 
 
 #endif	/* SRTMHGTREADER_H */
@@ -0,0 +1,68 @@
+/* 
+ * File:   srtmconvert.c
+ * Author: Routino contributors, for the srtmHgtReader by Pavel Zbytovský
+ *
+ * Converts SRTM HGT tiles to the routino elevation tiles (.rte) which are
+ * preferred by srtmHgtReader - native endian, split into square blocks
+ * and with the voids already filled.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "srtmHgtReader.h"
+
+
+static void print_usage(void);
+
+
+int main(int argc, char** argv){
+    int arg, failed = 0;
+    
+    if(argc < 2){
+        print_usage();
+    }
+    
+    for(arg=1; arg<argc; ++arg){
+        if(!strcmp(argv[arg], "--help")){
+            print_usage();
+        }
+        
+        size_t length = strlen(argv[arg]);
+        
+        if(length < 4 || strcmp(&argv[arg][length-4], ".hgt")){
+            fprintf(stderr, "Not a .hgt file: %s\n", argv[arg]);
+            failed = 1;
+            continue;
+        }
+        
+        //N50E014.hgt -> N50E014.rte next to it
+        char* rteFilename = strdup(argv[arg]);
+        strcpy(&rteFilename[length-4], ".rte");
+        
+        int voids = srtmConvertTile(argv[arg], rteFilename);
+        
+        if(voids < 0){
+            failed = 1;
+        }
+        else{
+            printf("Converted %s -> %s (%d voids filled)\n", argv[arg], rteFilename, voids);
+        }
+        
+        free(rteFilename);
+    }
+    
+    return failed;
+}
+
+
+static void print_usage(void){
+    fprintf(stderr,
+            "Usage: srtmconvert [--help] <tile.hgt> ...\n"
+            "\n"
+            "Writes <tile.rte> next to each HGT tile; planetsplitter then reads the\n"
+            "elevations from the converted tile instead of the HGT one.\n");
+    
+    exit(1);
+}
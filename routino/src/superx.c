@@ -467,9 +467,9 @@ static Results *FindSuperRoutes(NodesX *nodesx,SegmentsX *segmentsx,WaysX *waysx
 
  /* Insert the first node into the queue */
 
- results=NewResultsList(64);
+ results=NewResultsList(NULL,64);
 
- queue=NewQueueList();
+ queue=NewQueueList(NULL);
 
  result1=InsertResult(results,start,NO_SEGMENT);
 
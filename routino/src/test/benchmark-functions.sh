@@ -0,0 +1,111 @@
+# Functions for the benchmark scripts, sourced by each of them (they run in
+# the test directory).
+
+
+# Write a 200x200 grid of streets 250 m apart to a file (first argument), the
+# type of grid (second argument) is one of:
+#   residential - only residential streets,
+#   primary     - residential streets with a primary road every 10th street,
+#   river       - as primary but the streets crossing the middle row are broken
+#                 except for two of them (a "river" with only two bridges).
+
+grid_osm ()
+{
+    perl -e '
+      $grid=$ARGV[0]; $n=200; $r=($grid eq "river")?100:-1; $w=0;
+      print "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<osm version=\"0.6\">\n";
+      for($y=0;$y<$n;$y++) {
+        for($x=0;$x<$n;$x++) {
+          printf "<node id=\"%d\" lat=\"%.6f\" lon=\"%.6f\" version=\"1\"/>\n",$y*$n+$x+1,-0.9+$y*0.0025,-0.9+$x*0.0025;
+        }
+      }
+      for($i=0;$i<$n;$i++) {
+        $type=($grid ne "residential" && !($i%10))?"primary":"residential";
+        if($i!=$r) {
+          print "<way id=\"".(++$w)."\" version=\"1\">";
+          for($x=0;$x<$n;$x++) { print "<nd ref=\"".($i*$n+$x+1)."\"/>"; }
+          print "<tag k=\"highway\" v=\"$type\"/></way>\n";
+        }
+        if($r<0 || $i==15 || $i==185) {
+          print "<way id=\"".(++$w)."\" version=\"1\">";
+          for($y=0;$y<$n;$y++) { print "<nd ref=\"".($y*$n+$i+1)."\"/>"; }
+          print "<tag k=\"highway\" v=\"$type\"/></way>\n";
+        } else {
+          print "<way id=\"".(++$w)."\" version=\"1\">";
+          for($y=0;$y<$r;$y++) { print "<nd ref=\"".($y*$n+$i+1)."\"/>"; }
+          print "<tag k=\"highway\" v=\"$type\"/></way>\n";
+          print "<way id=\"".(++$w)."\" version=\"1\">";
+          for($y=$r+1;$y<$n;$y++) { print "<nd ref=\"".($y*$n+$i+1)."\"/>"; }
+          print "<tag k=\"highway\" v=\"$type\"/></way>\n";
+        }
+      }
+      print "</osm>\n";' $2 > $1
+}
+
+
+# Write an SRTM tile of hills that covers the grid (the planetsplitter reads it
+# as S01W001.hgt from the 'srtm' directory) to a file.
+
+hills_hgt ()
+{
+    perl -e '
+      binmode STDOUT;
+      for($y=0;$y<1201;$y++) {
+        for($x=0;$x<1201;$x++) {
+          print pack("n",int(300+200*sin($x/40)*cos($y/55)));
+        }
+      }' > $1
+}
+
+
+# Write a number of routes (second argument) between pairs of random points on
+# the grid to a batch file (first argument), with the points on opposite sides
+# of the river if the third argument is "river".
+
+random_routes ()
+{
+    perl -e '
+      srand(1);
+      for($i=0;$i<$ARGV[0];$i++) {
+        if($ARGV[1] eq "river") {
+          printf "%.5f %.5f %.5f %.5f\n",-0.89+rand(0.22),-0.89+rand(0.48),-0.63+rand(0.22),-0.89+rand(0.48);
+        } else {
+          printf "%.5f %.5f %.5f %.5f\n",-0.89+rand(0.48),-0.89+rand(0.48),-0.89+rand(0.48),-0.89+rand(0.48);
+        }
+      }' $2 $3 > $1
+}
+
+
+# Print the time now and the time since then (in seconds):
+#   start=`now` ; ... ; time=`since $start`
+
+now ()
+{
+    perl -MTime::HiRes=time -e 'printf "%.3f\n",time'
+}
+
+since ()
+{
+    perl -MTime::HiRes=time -e 'printf "%.3f\n",time-$ARGV[0]' $1
+}
+
+
+# Print the number of nodes settled from the router messages in a log file.
+
+settled ()
+{
+    sed -n 's/.*(\([0-9]*\) nodes settled).*/\1/p' $1
+}
+
+
+# Check that the routes in two batch outputs have the same score (the last
+# column), two routes with the same score (to within the rounding of the sums)
+# can have different distances.
+
+same_scores ()
+{
+    perl -e '
+      open(A,"<$ARGV[0]"); while(<A>) { next if(m/^#/); @f=split(/\t/); $score{$f[0]}=$f[5]; $n++; }
+      open(B,"<$ARGV[1]"); while(<B>) { next if(m/^#/); @f=split(/\t/); exit 1 if(!exists $score{$f[0]} || abs($f[5]-$score{$f[0]})>0.002); $n--; }
+      exit 1 if($n);' $1 $2
+}
@@ -0,0 +1,74 @@
+#!/bin/sh
+
+# Benchmark of the router searching from both ends of the route (--bidirectional)
+# against the normal search on a synthetic grid of residential streets (where
+# every junction is a super-node).
+
+# Exit on error
+
+set -e
+
+# Common functions
+
+. ./benchmark-functions.sh
+
+# Create the output directory
+
+dir="bidirectional"
+
+[ -d $dir ] || mkdir $dir
+
+# Program options
+
+option_planetsplitter="--loggable --tagging=../../xml/routino-tagging.xml --dir=$dir --prefix=grid"
+option_router="--transport=motorcar --profiles=../../xml/routino-profiles.xml --dir=$dir --prefix=grid --quickest --threads=1"
+
+# Create the data, a 200x200 grid of residential streets
+
+if [ ! -f $dir/grid-nodes.mem ]; then
+
+    echo "Creating the grid"
+
+    grid_osm $dir/grid.osm residential
+
+    echo "Running planetsplitter"
+
+    ../planetsplitter $option_planetsplitter $dir/grid.osm > $dir/planetsplitter.log
+fi
+
+# The routes, 100 pairs of random points
+
+random_routes $dir/batch.txt 100
+
+# Run the router both ways
+
+echo "Running router (one direction)"
+
+start=`now`
+../router $option_router --batch=$dir/batch.txt > $dir/normal.out 2> $dir/normal.log
+normal=`since $start`
+
+echo "Running router (both directions)"
+
+start=`now`
+../router $option_router --bidirectional --batch=$dir/batch.txt > $dir/bidirectional.out 2> $dir/bidirectional.log
+bidirectional=`since $start`
+
+# Check that the durations are the same (the routes may differ where two have the same duration)
+
+grep -v '^#' $dir/normal.out        | cut -f1,3 > $dir/normal.dur
+grep -v '^#' $dir/bidirectional.out | cut -f1,3 > $dir/bidirectional.dur
+
+if cmp -s $dir/normal.dur $dir/bidirectional.dur; then
+    echo "Durations match"
+else
+    echo "Durations are different"
+    exit 1
+fi
+
+normal_settled=`settled $dir/normal.log`
+bidirectional_settled=`settled $dir/bidirectional.log`
+
+echo "One direction:   $normal s, $normal_settled nodes settled"
+echo "Both directions: $bidirectional s, $bidirectional_settled nodes settled"
+perl -e "printf \"Speedup:         %.1fx (%.1fx fewer nodes)\n\",$normal/$bidirectional,$normal_settled/$bidirectional_settled"
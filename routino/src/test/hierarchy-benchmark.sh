@@ -0,0 +1,87 @@
+#!/bin/sh
+
+# Benchmark of the router using a contraction hierarchy (planetsplitter
+# --hierarchy) against the normal search on a synthetic grid of streets that
+# is split into two halves by a "river" with only two bridges.
+
+# Exit on error
+
+set -e
+
+# Common functions
+
+. ./benchmark-functions.sh
+
+# Create the output directory
+
+dir="hierarchy"
+
+[ -d $dir ] || mkdir $dir
+
+# Program options
+
+option_planetsplitter="--loggable --tagging=../../xml/routino-tagging.xml --dir=$dir --prefix=grid --hierarchy=motorcar --profiles=../../xml/routino-profiles.xml"
+option_router="--transport=motorcar --profiles=../../xml/routino-profiles.xml --dir=$dir --prefix=grid --shortest --threads=1"
+
+# Create the data, a 200x200 grid of residential streets with a primary road every 10th street,
+# the streets crossing the middle row are broken except for two of them.
+
+if [ ! -f $dir/grid-nodes.mem ]; then
+
+    echo "Creating the grid"
+
+    grid_osm $dir/grid.osm river
+
+    echo "Running planetsplitter"
+
+    ../planetsplitter $option_planetsplitter $dir/grid.osm > $dir/planetsplitter.log
+fi
+
+# The routes, 100 pairs of random points on opposite sides of the river
+
+random_routes $dir/batch.txt 100 river
+
+# Run the router both ways
+
+echo "Running router (no hierarchy)"
+
+start=`now`
+../router $option_router --no-hierarchy --batch=$dir/batch.txt > $dir/normal.out 2> $dir/normal.log
+normal=`since $start`
+
+echo "Running router (hierarchy)"
+
+start=`now`
+../router $option_router --batch=$dir/batch.txt > $dir/hierarchy.out 2> $dir/hierarchy.log
+hierarchy=`since $start`
+
+# Compare the scores, the score is the distance divided by the highway preference so two routes
+# with the same score (to within the rounding of the sums) can have different distances.
+
+status=true
+
+if same_scores $dir/normal.out $dir/hierarchy.out; then
+    echo "Scores match"
+else
+    echo "Scores are different - FAILED"
+    status=false
+fi
+
+grep -v '^#' $dir/normal.out    | cut -f1,2 > $dir/normal.dist
+grep -v '^#' $dir/hierarchy.out | cut -f1,2 > $dir/hierarchy.dist
+
+if cmp -s $dir/normal.dist $dir/hierarchy.dist; then
+    echo "Distances match"
+else
+    ndiff=`diff $dir/normal.dist $dir/hierarchy.dist | grep -c '^<' || true`
+    echo "Distances are different for $ndiff routes (with the same score)"
+fi
+
+normal_settled=`settled $dir/normal.log`
+hierarchy_settled=`settled $dir/hierarchy.log`
+
+echo "No hierarchy: $normal s, $normal_settled nodes settled"
+echo "Hierarchy:    $hierarchy s, $hierarchy_settled nodes settled"
+perl -e "printf \"Speedup:      %.1fx (%.1fx fewer nodes)\n\",$normal/$hierarchy,$normal_settled/$hierarchy_settled"
+
+$status
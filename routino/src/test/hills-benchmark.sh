@@ -0,0 +1,92 @@
+#!/bin/sh
+
+# Benchmark of the router finding the quickest bicycle routes with hills (router
+# --hills) on a synthetic grid of streets on hills. The speeds on the hills come
+# from a table in the profile so the routes should take about as long to calculate
+# as without hills. Each route must be no quicker than the one without hills.
+
+# Exit on error
+
+set -e
+
+# Common functions
+
+. ./benchmark-functions.sh
+
+# Create the output directory
+
+dir="hills"
+
+[ -d $dir ] || mkdir $dir
+
+# Program options
+
+option_planetsplitter="--loggable --tagging=../../../xml/routino-tagging.xml --dir=. --prefix=grid"
+option_router="--transport=bicycle --profiles=../../xml/routino-profiles.xml --dir=$dir --prefix=grid --quickest --threads=1"
+
+# Create the data, a 200x200 grid of residential streets with a primary road every 10th street
+# and an SRTM tile of hills (the planetsplitter reads the tile from the 'srtm' directory).
+
+if [ ! -f $dir/grid-nodes.mem ]; then
+
+    echo "Creating the grid"
+
+    grid_osm $dir/grid.osm primary
+
+    [ -d $dir/srtm ] || mkdir $dir/srtm
+
+    hills_hgt $dir/srtm/S01W001.hgt
+
+    echo "Running planetsplitter"
+
+    (cd $dir && ../../planetsplitter $option_planetsplitter grid.osm > planetsplitter.log)
+fi
+
+# The routes, 50 pairs of random points
+
+random_routes $dir/batch.txt 50
+
+# The quickest routes without hills, with the linear model (8 km/hr on a 10% grade)
+# and with the fixed speeds for each grade
+
+status=true
+
+for hills in 0 8 100; do
+
+    echo "Running router (hills=$hills)"
+
+    start=`now`
+
+    ../router $option_router --hills=$hills --batch=$dir/batch.txt > $dir/hills-$hills.out 2> $dir/hills-$hills.log
+
+    time=`since $start`
+
+    # Nothing must be printed for each hill (unless the router is compiled with HILLS_TRACE)
+
+    if grep -q '^hill' $dir/hills-$hills.log; then
+        echo "Speeds on the hills were printed - FAILED"
+        status=false
+    fi
+
+    # The routes must be no quicker than without hills
+
+    if [ $hills != 0 ]; then
+
+        if perl -e '
+            open(F,"<$ARGV[0]"); while(<F>) { next if(m/^#/); @f=split; $flat{$f[0]}=$f[2]; }
+            open(H,"<$ARGV[1]"); while(<H>) { next if(m/^#/); @f=split; exit 1 if($f[2]<$flat{$f[0]}-0.01); }' \
+            $dir/hills-0.out $dir/hills-$hills.out; then
+            echo "Routes match"
+        else
+            echo "Routes are quicker than without hills - FAILED"
+            status=false
+        fi
+    fi
+
+    duration=`awk '!/^#/ {n+=$3} END {printf "%.1f",n}' $dir/hills-$hills.out`
+
+    echo "Hills $hills: $time s, total duration $duration min"
+
+done
+
+$status
@@ -0,0 +1,75 @@
+#!/bin/sh
+
+# Benchmark of the router using the landmark distances (planetsplitter
+# --landmarks) against the normal search on a synthetic grid of streets that
+# is split into two halves by a "river" with only two bridges.
+
+# Exit on error
+
+set -e
+
+# Common functions
+
+. ./benchmark-functions.sh
+
+# Create the output directory
+
+dir="landmarks"
+
+[ -d $dir ] || mkdir $dir
+
+# Program options
+
+option_planetsplitter="--loggable --tagging=../../xml/routino-tagging.xml --dir=$dir --prefix=grid --landmarks=16"
+option_router="--transport=motorcar --profiles=../../xml/routino-profiles.xml --dir=$dir --prefix=grid --shortest --threads=1"
+
+# Create the data, a 200x200 grid of residential streets with a primary road every 10th street,
+# the streets crossing the middle row are broken except for two of them.
+
+if [ ! -f $dir/grid-nodes.mem ]; then
+
+    echo "Creating the grid"
+
+    grid_osm $dir/grid.osm river
+
+    echo "Running planetsplitter"
+
+    ../planetsplitter $option_planetsplitter $dir/grid.osm > $dir/planetsplitter.log
+fi
+
+# The routes, 100 pairs of random points on opposite sides of the river
+
+random_routes $dir/batch.txt 100 river
+
+# Run the router both ways
+
+echo "Running router (no landmarks)"
+
+start=`now`
+../router $option_router --no-landmarks --batch=$dir/batch.txt > $dir/normal.out 2> $dir/normal.log
+normal=`since $start`
+
+echo "Running router (landmarks)"
+
+start=`now`
+../router $option_router --batch=$dir/batch.txt > $dir/landmarks.out 2> $dir/landmarks.log
+landmarks=`since $start`
+
+# Check that the distances are the same (the routes may differ where two have the same distance)
+
+grep -v '^#' $dir/normal.out    | cut -f1,2 > $dir/normal.dist
+grep -v '^#' $dir/landmarks.out | cut -f1,2 > $dir/landmarks.dist
+
+if cmp -s $dir/normal.dist $dir/landmarks.dist; then
+    echo "Distances match"
+else
+    echo "Distances are different - FAILED"
+    exit 1
+fi
+
+normal_settled=`settled $dir/normal.log`
+landmarks_settled=`settled $dir/landmarks.log`
+
+echo "No landmarks: $normal s, $normal_settled nodes settled"
+echo "Landmarks:    $landmarks s, $landmarks_settled nodes settled"
+perl -e "printf \"Speedup:      %.1fx (%.1fx fewer nodes)\n\",$normal/$landmarks,$normal_settled/$landmarks_settled"
@@ -0,0 +1,78 @@
+#!/bin/sh
+
+# Benchmark of the router matrix mode against routing each pair of points
+# separately (batch mode with one thread) on a synthetic grid of streets.
+
+# Exit on error
+
+set -e
+
+# Common functions
+
+. ./benchmark-functions.sh
+
+# Create the output directory
+
+dir="matrix"
+
+[ -d $dir ] || mkdir $dir
+
+# Program options
+
+option_planetsplitter="--loggable --tagging=../../xml/routino-tagging.xml --dir=$dir --prefix=grid"
+option_router="--quiet --transport=motorcar --profiles=../../xml/routino-profiles.xml --dir=$dir --prefix=grid --shortest"
+
+# Create the data, a 200x200 grid of residential streets with a primary road every 10th street
+
+if [ ! -f $dir/grid-nodes.mem ]; then
+
+    echo "Creating the grid"
+
+    grid_osm $dir/grid.osm primary
+
+    echo "Running planetsplitter"
+
+    ../planetsplitter $option_planetsplitter $dir/grid.osm > $dir/planetsplitter.log
+fi
+
+# The points, 20 sources and 20 targets
+
+perl -e '
+  srand(1);
+  for($i=0;$i<40;$i++) {
+    printf "%s %.5f %.5f\n",($i<20?"S":"T"),-0.89+rand(0.48),-0.89+rand(0.48);
+  }' > $dir/matrix.txt
+
+perl -e '
+  while(<>) { @p=split; push(@s,"$p[1] $p[2]") if($p[0] eq "S"); push(@t,"$p[1] $p[2]") if($p[0] eq "T"); }
+  foreach $s (@s) { foreach $t (@t) { print "$s $t\n"; } }' < $dir/matrix.txt > $dir/batch.txt
+
+# Run the router both ways
+
+echo "Running router (matrix, 20x20)"
+
+start=`now`
+../router $option_router --matrix=$dir/matrix.txt > $dir/matrix.out 2> $dir/matrix.log
+matrix=`since $start`
+
+echo "Running router (pairwise, 400 routes)"
+
+start=`now`
+../router $option_router --batch=$dir/batch.txt --threads=1 > $dir/batch.out 2> $dir/batch.log
+batch=`since $start`
+
+# Check that the distances are the same
+
+grep -v '^#' $dir/matrix.out | cut -f4 > $dir/matrix.dist
+grep -v '^#' $dir/batch.out  | cut -f2 > $dir/batch.dist
+
+if cmp -s $dir/matrix.dist $dir/batch.dist; then
+    echo "Distances match"
+else
+    echo "Distances are different - FAILED"
+    exit 1
+fi
+
+echo "Matrix:   $matrix s"
+echo "Pairwise: $batch s"
+perl -e "printf \"Speedup:  %.1fx\n\",$batch/$matrix"
@@ -0,0 +1,117 @@
+#!/bin/sh
+
+# Benchmark of the router finding the Pareto routes (router --pareto) that trade
+# off the duration against the ascent on a synthetic grid of streets on hills.
+# The quickest of them must be within the factor of the quickest route and each
+# of the others must be slower and flatter than the one before.
+
+# Exit on error
+
+set -e
+
+# Common functions
+
+. ./benchmark-functions.sh
+
+# Create the output directory
+
+dir="pareto"
+
+[ -d $dir ] || mkdir $dir
+
+# Program options (all highways have the same preference so that the quickest
+# route has the shortest duration)
+
+option_planetsplitter="--loggable --tagging=../../../xml/routino-tagging.xml --dir=. --prefix=grid"
+option_router="--transport=motorcar --profiles=../../xml/routino-profiles.xml --dir=$dir --prefix=grid --highway-primary=100 --highway-residential=100"
+
+# Create the data, a 200x200 grid of residential streets with a primary road every 10th street
+# and an SRTM tile of hills (the planetsplitter reads the tile from the 'srtm' directory).
+
+if [ ! -f $dir/grid-nodes.mem ]; then
+
+    echo "Creating the grid"
+
+    grid_osm $dir/grid.osm primary
+
+    [ -d $dir/srtm ] || mkdir $dir/srtm
+
+    hills_hgt $dir/srtm/S01W001.hgt
+
+    echo "Running planetsplitter"
+
+    (cd $dir && ../../planetsplitter $option_planetsplitter grid.osm > planetsplitter.log)
+fi
+
+# The routes, 10 pairs of random points up to 15 km apart
+
+perl -e '
+  srand(1);
+  for($i=0;$i<10;$i++) {
+    $lat=-0.85+rand(0.3); $lon=-0.85+rand(0.3);
+    printf "%.5f %.5f %.5f %.5f\n",$lat,$lon,$lat+0.05+rand(0.08),$lon+0.05+rand(0.08);
+  }' > $dir/points.txt
+
+# The quickest routes
+
+echo "Running router (quickest)"
+
+../router $option_router --quickest --batch=$dir/points.txt > $dir/quickest.out 2> $dir/quickest.log
+
+# The Pareto routes with different factors
+
+status=true
+
+for epsilon in 2 5 10; do
+
+    echo "Running router (Pareto routes within $epsilon%)"
+
+    rm -f $dir/pareto-$epsilon.out $dir/pareto-$epsilon.log
+
+    start=`now`
+
+    line=0
+
+    while read lat1 lon1 lat2 lon2; do
+
+        line=`expr $line + 1`
+
+        ../router $option_router --pareto=$epsilon --output-text --quiet --lat1=$lat1 --lon1=$lon1 --lat2=$lat2 --lon2=$lon2
+
+        grep -v '^#' pareto.txt | sed "s/^/$line\t/" >> $dir/pareto-$epsilon.out
+
+        ../router $option_router --pareto=$epsilon --output-none --lat1=$lat1 --lon1=$lon1 --lat2=$lat2 --lon2=$lon2 | \
+            sed -n 's/.*(\([0-9]*\) routes, \([0-9]*\) labels settled).*/\1 \2/p' >> $dir/pareto-$epsilon.log
+
+    done < $dir/points.txt
+
+    rm -f pareto.txt
+
+    elapsed=`since $start`
+    time=`perl -e "printf '%.3f',$elapsed/2"`
+
+    # Check the quickest Pareto route against the quickest route and that each of the others is slower and flatter
+
+    if perl -e '
+        $epsilon=$ARGV[2];
+        open(Q,"<$ARGV[0]"); while(<Q>) { next if(m/^#/); @f=split; $quickest{$f[0]}=$f[2]; }
+        open(P,"<$ARGV[1]"); while(<P>) {
+          @f=split;
+          if($f[1]==1) { exit 1 if($f[3]<$quickest{$f[0]}-0.01 || $f[3]>$quickest{$f[0]}*(1+$epsilon/100)+0.01); }
+          else         { exit 1 if($f[3]<$duration || $f[4]>=$ascent); }
+          ($duration,$ascent)=($f[3],$f[4]);
+        }' $dir/quickest.out $dir/pareto-$epsilon.out $epsilon; then
+        echo "Routes match"
+    else
+        echo "Routes are wrong - FAILED"
+        status=false
+    fi
+
+    routes=`awk '{n+=$1} END {print n}' $dir/pareto-$epsilon.log`
+    settled=`awk '{n+=$2} END {print n}' $dir/pareto-$epsilon.log`
+
+    echo "Pareto routes within $epsilon%: $time s, $routes routes, $settled labels settled"
+
+done
+
+$status
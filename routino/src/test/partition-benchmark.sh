@@ -0,0 +1,92 @@
+#!/bin/sh
+
+# Benchmark of the router using a partition of the super-nodes (planetsplitter
+# --partition) against the normal search on a synthetic grid of streets that
+# is split into two halves by a "river" with only two bridges.  The partition
+# does not depend on the profile so both shortest and quickest routes are tested.
+
+# Exit on error
+
+set -e
+
+# Common functions
+
+. ./benchmark-functions.sh
+
+# Create the output directory
+
+dir="partition"
+
+[ -d $dir ] || mkdir $dir
+
+# Program options
+
+option_planetsplitter="--loggable --tagging=../../xml/routino-tagging.xml --dir=$dir --prefix=grid --partition=200"
+option_router="--transport=motorcar --profiles=../../xml/routino-profiles.xml --dir=$dir --prefix=grid --threads=1"
+
+# Create the data, a 200x200 grid of residential streets with a primary road every 10th street,
+# the streets crossing the middle row are broken except for two of them.
+
+if [ ! -f $dir/grid-nodes.mem ]; then
+
+    echo "Creating the grid"
+
+    grid_osm $dir/grid.osm river
+
+    echo "Running planetsplitter"
+
+    ../planetsplitter $option_planetsplitter $dir/grid.osm > $dir/planetsplitter.log
+fi
+
+# The routes, 100 pairs of random points on opposite sides of the river
+
+random_routes $dir/batch.txt 100 river
+
+# Run the router both ways for each type of route
+
+status=true
+
+for type in shortest quickest; do
+
+    echo "Running router (no partition, $type)"
+
+    start=`now`
+    ../router $option_router --$type --no-partition --batch=$dir/batch.txt > $dir/normal-$type.out 2> $dir/normal-$type.log
+    normal=`since $start`
+
+    echo "Running router (partition, $type)"
+
+    start=`now`
+    ../router $option_router --$type --batch=$dir/batch.txt > $dir/partition-$type.out 2> $dir/partition-$type.log
+    partition=`since $start`
+
+    # Compare the scores, two routes with the same score (to within the rounding of the sums)
+    # can have different distances.
+
+    if same_scores $dir/normal-$type.out $dir/partition-$type.out; then
+        echo "Scores match"
+    else
+        echo "Scores are different - FAILED"
+        status=false
+    fi
+
+    grep -v '^#' $dir/normal-$type.out    | cut -f1,2 > $dir/normal-$type.dist
+    grep -v '^#' $dir/partition-$type.out | cut -f1,2 > $dir/partition-$type.dist
+
+    if cmp -s $dir/normal-$type.dist $dir/partition-$type.dist; then
+        echo "Distances match"
+    else
+        ndiff=`diff $dir/normal-$type.dist $dir/partition-$type.dist | grep -c '^<' || true`
+        echo "Distances are different for $ndiff routes (with the same score)"
+    fi
+
+    normal_settled=`settled $dir/normal-$type.log`
+    partition_settled=`settled $dir/partition-$type.log`
+
+    echo "No partition: $normal s, $normal_settled nodes settled"
+    echo "Partition:    $partition s (including the scores for the profile), $partition_settled nodes settled"
+    perl -e "printf \"Speedup:      %.1fx (%.1fx fewer nodes)\n\",$normal/$partition,$normal_settled/$partition_settled"
+
+done
+
+$status
@@ -0,0 +1,274 @@
+/***************************************
+ Queue benchmark, replays a trace of the queue operations from the router.
+
+ Part of the Routino routing software.
+ ******************/ /******************
+ This file Copyright 2026 Routino contributors
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Affero General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Affero General Public License for more details.
+
+ You should have received a copy of the GNU Affero General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ***************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "results.h"
+
+
+/*+ The number of times that the trace is replayed. +*/
+#define ROUNDS 10
+
+
+/*+ An operation from the trace. +*/
+typedef struct _Operation
+{
+ char     op;                   /*+ The operation ('N'ew, 'F'ree, 'I'nsert or 'P'op). +*/
+ char     reset;                /*+ Set if the result was left in a queue that has been freed. +*/
+ int      queue;                /*+ The queue number. +*/
+ int      result;               /*+ The result number. +*/
+ score_t  sortby;               /*+ The sortby value. +*/
+}
+ Operation;
+
+/*+ A result pointer from the trace and the number that it was given. +*/
+typedef struct _Pointer
+{
+ void    *pointer;              /*+ The pointer from the trace. +*/
+ int      result;               /*+ The result number. +*/
+ int      queue;                /*+ The queue that it was last inserted into. +*/
+}
+ Pointer;
+
+
+/* Local functions */
+
+static int find_pointer(void *pointer);
+
+
+/* Local variables */
+
+/*+ The hash table of result pointers. +*/
+static Pointer *pointers=NULL;
+
+/*+ The size of the hash table of result pointers (a power of 2). +*/
+static int npointers=0;
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  The main program for the queue benchmark.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+int main(int argc,char** argv)
+{
+ FILE *file;
+ char line[128];
+ Operation *operations=NULL;
+ int noperations=0,nallocated=0;
+ void **queuepointers=NULL;
+ char *queuealive=NULL;
+ int nqueues=0,nresults=0,nused=0;
+ Queue **queues;
+ Result *results;
+ struct timeval start,finish;
+ double elapsed;
+ long differ=0;
+ int i,r;
+
+ if(argc!=2)
+   {
+    fprintf(stderr,"Usage: queue-benchmark <trace-file>\n");
+    return(1);
+   }
+
+ file=fopen(argv[1],"r");
+
+ if(!file)
+   {
+    fprintf(stderr,"Cannot open the trace file '%s'.\n",argv[1]);
+    return(1);
+   }
+
+ npointers=1024;
+ pointers=(Pointer*)calloc(npointers,sizeof(Pointer));
+
+ /* Read in the trace, giving each queue and result a number */
+
+ while(fgets(line,sizeof(line),file))
+   {
+    void *queue,*result;
+    double sortby=0;
+    Operation *operation;
+    int q;
+
+    if(noperations==nallocated)
+      {
+       nallocated+=1024*1024;
+       operations=(Operation*)realloc(operations,nallocated*sizeof(Operation));
+      }
+
+    operation=&operations[noperations];
+
+    if(sscanf(line,"%c %p %p %lf",&operation->op,&queue,&result,&sortby)<2)
+       continue;
+
+    if(operation->op=='N')
+      {
+       queuepointers=(void**)realloc(queuepointers,(nqueues+1)*sizeof(void*));
+       queuealive=(char*)realloc(queuealive,(nqueues+1)*sizeof(char));
+
+       queuepointers[nqueues]=queue;
+       queuealive[nqueues]=1;
+
+       operation->queue=nqueues++;
+       noperations++;
+       continue;
+      }
+
+    for(q=nqueues-1;q>=0;q--)
+       if(queuealive[q] && queuepointers[q]==queue)
+          break;
+
+    if(q<0)
+       continue;
+
+    operation->queue=q;
+
+    if(operation->op=='F')
+       queuealive[q]=0;
+    else
+      {
+       int p=find_pointer(result);
+
+       if(!pointers[p].pointer)
+         {
+          pointers[p].pointer=result;
+          pointers[p].result=nresults++;
+          pointers[p].queue=q;
+
+          nused++;
+         }
+
+       /* A result that was left in a queue that has been freed has been re-used by the router */
+
+       operation->reset=(operation->op=='I' && pointers[p].queue!=q && !queuealive[pointers[p].queue]);
+
+       if(operation->op=='I')
+          pointers[p].queue=q;
+
+       operation->result=pointers[p].result;
+       operation->sortby=(score_t)sortby;
+
+       if(nused>npointers/2)
+         {
+          Pointer *oldpointers=pointers;
+          int j,noldpointers=npointers;
+
+          npointers*=2;
+          pointers=(Pointer*)calloc(npointers,sizeof(Pointer));
+
+          for(j=0;j<noldpointers;j++)
+             if(oldpointers[j].pointer)
+                pointers[find_pointer(oldpointers[j].pointer)]=oldpointers[j];
+
+          free(oldpointers);
+         }
+      }
+
+    noperations++;
+   }
+
+ fclose(file);
+
+ printf("Trace: %d operations, %d queues, %d results\n",noperations,nqueues,nresults);
+
+ queues=(Queue**)calloc(nqueues,sizeof(Queue*));
+ results=(Result*)malloc(nresults*sizeof(Result));
+
+ /* Replay the trace */
+
+ elapsed=0;
+
+ for(r=0;r<ROUNDS;r++)
+   {
+    memset(results,0,nresults*sizeof(Result));
+
+    gettimeofday(&start,NULL);
+
+    for(i=0;i<noperations;i++)
+      {
+       Operation *operation=&operations[i];
+       Result *result;
+
+       switch(operation->op)
+         {
+         case 'N':
+          queues[operation->queue]=NewQueueList(NULL);
+          break;
+
+         case 'F':
+          FreeQueueList(queues[operation->queue]);
+          break;
+
+         case 'I':
+          result=&results[operation->result];
+          if(operation->reset)
+             result->queued=NOT_QUEUED;
+          result->sortby=operation->sortby;
+          InsertInQueue(queues[operation->queue],result);
+          break;
+
+         case 'P':
+          result=PopFromQueue(queues[operation->queue]);
+          if(result!=&results[operation->result])
+             differ++;
+          break;
+         }
+      }
+
+    gettimeofday(&finish,NULL);
+
+    elapsed+=(finish.tv_sec-start.tv_sec)+(finish.tv_usec-start.tv_usec)/1E6;
+   }
+
+ printf("Replay: %.3f ms per round, %.1f Mops/s\n",1000*elapsed/ROUNDS,(double)ROUNDS*noperations/elapsed/1E6);
+ printf("Different results popped: %ld\n",differ/ROUNDS);
+
+ return(0);
+}
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Find the place for a pointer in the hash table.
+
+  int find_pointer Returns the index of the pointer or the empty entry where it should go.
+
+  void *pointer The pointer to find.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+static int find_pointer(void *pointer)
+{
+ unsigned long hash=(unsigned long)pointer;
+ int p;
+
+ hash=(hash>>4)*2654435761UL;
+
+ p=(int)(hash&(npointers-1));
+
+ while(pointers[p].pointer && pointers[p].pointer!=pointer)
+    p=(p+1)&(npointers-1);
+
+ return(p);
+}
@@ -0,0 +1,90 @@
+#!/bin/sh
+
+# Benchmark of the queue (the 4-ary heap against the original binary heap) by
+# replaying a trace of the queue operations made by the router on a synthetic
+# grid of streets that is split into two halves by a "river" with only two bridges.
+
+# Exit on error
+
+set -e
+
+# Common functions
+
+. ./benchmark-functions.sh
+
+# Create the output directory
+
+dir="queue"
+
+[ -d $dir ] || mkdir $dir
+
+# Program options
+
+option_planetsplitter="--loggable --tagging=../../xml/routino-tagging.xml --dir=$dir --prefix=grid"
+option_router="--transport=motorcar --profiles=../../../xml/routino-profiles.xml --dir=. --prefix=grid --threads=1"
+
+# Create the data, a 200x200 grid of residential streets with a primary road every 10th street,
+# the streets crossing the middle row are broken except for two of them.
+
+if [ ! -f $dir/grid-nodes.mem ]; then
+
+    echo "Creating the grid"
+
+    grid_osm $dir/grid.osm river
+
+    echo "Running planetsplitter"
+
+    ../planetsplitter $option_planetsplitter $dir/grid.osm > $dir/planetsplitter.log
+fi
+
+# The routes, 25 pairs of random points on opposite sides of the river
+
+random_routes $dir/batch.txt 25 river
+
+# Record the queue operations made by the router (it writes them to 'queue.trace'
+# in the current directory), the shortest and quickest routes and a reach search.
+
+echo "Running router-trace"
+
+rm -f $dir/trace.txt
+
+for option in --shortest --quickest; do
+
+    (cd $dir && ../../router-trace $option_router $option --batch=batch.txt > /dev/null 2> router-trace.log)
+
+    cat $dir/queue.trace >> $dir/trace.txt
+done
+
+(cd $dir && ../../router-trace $option_router --quickest --reach-duration=60 --lat1=-0.65 --lon1=-0.65 --output-none > /dev/null 2> router-trace.log)
+
+cat $dir/queue.trace >> $dir/trace.txt
+
+rm -f $dir/queue.trace
+
+# Replay the trace with both queues
+
+echo "Replaying the trace (binary heap)"
+
+./queue-benchmark-binary $dir/trace.txt | tee $dir/binary.log
+
+echo "Replaying the trace (4-ary heap)"
+
+./queue-benchmark $dir/trace.txt | tee $dir/4-ary.log
+
+# The trace is a few hundred MB, it is made again each time
+
+rm -f $dir/trace.txt
+
+# The trace was made with the 4-ary heap so replaying it must pop the same results
+
+if grep -q 'Different results popped: 0$' $dir/4-ary.log; then
+    echo "Replay matches"
+else
+    echo "Replay does not match the trace - FAILED"
+    exit 1
+fi
+
+binary=`sed -n 's/Replay: \([0-9.]*\) ms.*/\1/p' $dir/binary.log`
+fourary=`sed -n 's/Replay: \([0-9.]*\) ms.*/\1/p' $dir/4-ary.log`
+
+perl -e "printf \"Speedup:      %.2fx\n\",$binary/$fourary"
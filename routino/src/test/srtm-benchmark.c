@@ -0,0 +1,104 @@
+/* 
+ * File:   srtm-benchmark.c
+ * Author: Routino contributors, for the srtmHgtReader by Pavel Zbytovský
+ *
+ * Micro-benchmark of srtmGetElevation() against the batched
+ * srtmGetElevations() on a synthetic tile srtm/N00E000.hgt.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include "srtmHgtReader.h"
+
+
+#define POINTS 1000000
+#define ROUNDS 10
+
+
+/** Writes a 1201x1201 tile with some hills, if there is none */
+static void createTile(void){
+    struct stat buf;
+    int x, y;
+    
+    if(!stat("srtm/N00E000.hgt", &buf)){
+        return;
+    }
+    
+    mkdir("srtm", 0755);
+    
+    FILE* fd = fopen("srtm/N00E000.hgt", "w");
+    
+    for(y=0; y<1201; ++y){
+        for(x=0; x<1201; ++x){
+            int16_t hgt = 200 + (x * 7 + y * 13) % 300;
+            unsigned char buff[2] = {(hgt >> 8) & 0xFF, hgt & 0xFF};
+            fwrite(buff, 2, 1, fd);
+        }
+    }
+    
+    fclose(fd);
+}
+
+static double elapsed(struct timeval* start){
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    
+    return (now.tv_sec - start->tv_sec) + (now.tv_usec - start->tv_usec) / 1e6;
+}
+
+
+int main(int argc, char** argv){
+    float* lat = (float*) malloc(sizeof(float) * POINTS);
+    float* lon = (float*) malloc(sizeof(float) * POINTS);
+    float* scalar = (float*) malloc(sizeof(float) * POINTS);
+    float* batch = (float*) malloc(sizeof(float) * POINTS);
+    struct timeval start;
+    int i, r, differ = 0;
+    
+    createTile();
+    
+    //points along short segments like in MeasureSegments
+    srand(1);
+    for(i=0; i<POINTS; ++i){
+        if(i % 100 == 0){
+            lat[i] = (rand() % 100000) / 100001.0f;
+            lon[i] = (rand() % 100000) / 100001.0f;
+        }
+        else{
+            lat[i] = lat[i-1] + 0.0001f * ((i % 7) / 7.0f);
+            lon[i] = lon[i-1] + 0.0001f * ((i % 5) / 5.0f);
+            
+            if(lat[i] >= 1) lat[i] = 0.5f;
+            if(lon[i] >= 1) lon[i] = 0.5f;
+        }
+    }
+    
+    srtmGetElevation(0.5f, 0.5f); //load the tile
+    
+    gettimeofday(&start, NULL);
+    for(r=0; r<ROUNDS; ++r)
+        for(i=0; i<POINTS; ++i)
+            scalar[i] = srtmGetElevation(lat[i], lon[i]);
+    double tscalar = elapsed(&start);
+    
+    gettimeofday(&start, NULL);
+    for(r=0; r<ROUNDS; ++r)
+        srtmGetElevations(lat, lon, batch, POINTS);
+    double tbatch = elapsed(&start);
+    
+    for(i=0; i<POINTS; ++i)
+        if(scalar[i] != batch[i])
+            differ++;
+    
+    printf("srtmGetElevation:  %.1f Mpoints/s\n", ROUNDS * POINTS / tscalar / 1e6);
+    printf("srtmGetElevations: %.1f Mpoints/s (%.2fx)\n", ROUNDS * POINTS / tbatch / 1e6, tscalar / tbatch);
+    printf("Different results: %d\n", differ);
+    
+    srtmClose();
+    
+    return differ != 0;
+}
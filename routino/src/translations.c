@@ -29,49 +29,51 @@
 #include "xmlparse.h"
 
 
-/* Global variables - default English values - Must not require any UTF-8 encoding */
+/* Local variables - default English values - Must not require any UTF-8 encoding */
 
-char *translate_raw_copyright_creator[2]={"Creator","Routino - http://www.routino.org/"};
-char *translate_raw_copyright_source[2] ={NULL,NULL};
-char *translate_raw_copyright_license[2]={NULL,NULL};
-
-char *translate_xml_copyright_creator[2]={"Creator","Routino - http://www.routino.org/"};
-char *translate_xml_copyright_source[2] ={NULL,NULL};
-char *translate_xml_copyright_license[2]={NULL,NULL};
+/*+ The translations that are loaded (or the default ones). +*/
+static Translation translation=
+{
+ .raw_copyright_creator={"Creator","Routino - http://www.routino.org/"},
+ .raw_copyright_source ={NULL,NULL},
+ .raw_copyright_license={NULL,NULL},
 
-char *translate_xml_heading[9] ={"South","South-West","West","North-West","North","North-East","East","South-East","South"};
-char *translate_xml_turn[9]    ={"Very sharp left","Sharp left","Left","Slight left","Straight on","Slight right","Right","Sharp right","Very sharp right"};
-char *translate_xml_ordinal[10]={"First","Second","Third","Fourth","Fifth","Sixth","Seventh","Eighth","Ninth","Tenth"};
+ .xml_copyright_creator={"Creator","Routino - http://www.routino.org/"},
+ .xml_copyright_source ={NULL,NULL},
+ .xml_copyright_license={NULL,NULL},
 
-char *translate_raw_highway[Highway_Count]={"","motorway","trunk road","primary road","secondary road","tertiary road","unclassified road","residential road","service road","track","cycleway","path","steps","ferry"};
+ .xml_heading ={"South","South-West","West","North-West","North","North-East","East","South-East","South"},
+ .xml_turn    ={"Very sharp left","Sharp left","Left","Slight left","Straight on","Slight right","Right","Sharp right","Very sharp right"},
+ .xml_ordinal ={"First","Second","Third","Fourth","Fifth","Sixth","Seventh","Eighth","Ninth","Tenth"},
 
-char *translate_xml_route_shortest="Shortest";
-char *translate_xml_route_quickest="Quickest";
+ .raw_highway={"","motorway","trunk road","primary road","secondary road","tertiary road","unclassified road","residential road","service road","track","cycleway","path","steps","ferry"},
 
-char *translate_html_waypoint  ="<span class='w'>Waypoint</span>";
-char *translate_html_junction  ="Junction";
-char *translate_html_roundabout="Roundabout";
+ .xml_route_shortest="Shortest",
+ .xml_route_quickest="Quickest",
 
-char *translate_html_title     ="%s Route";
-char *translate_html_start[2]  ={"Start","At %s, head %s"};
-char *translate_html_segment[2]={"Follow","%s for %.3f km, %.1f min"};
-char *translate_html_node[2]   ={"At","%s, go %s heading %s"};
-char *translate_html_rbnode[2] ={"Leave","%s, take the %s exit heading %s"};
-char *translate_html_stop[2]   ={"Stop","At %s"};
-char *translate_html_total[2]  ={"Total","%.1f km, %.0f minutes"};
+ .html_waypoint  ="<span class='w'>Waypoint</span>",
+ .html_junction  ="Junction",
+ .html_roundabout="Roundabout",
 
-char *translate_gpx_desc ="%s between 'start' and 'finish' waypoints";
-char *translate_gpx_name ="%s Route";
-char *translate_gpx_step ="%s on '%s' for %.3f km, %.1 min";
-char *translate_gpx_final="Total Journey %.1f km, %d minutes";
+ .html_title     ="%s Route",
+ .html_start  ={"Start","At %s, head %s"},
+ .html_segment={"Follow","%s for %.3f km, %.1f min"},
+ .html_node   ={"At","%s, go %s heading %s"},
+ .html_rbnode ={"Leave","%s, take the %s exit heading %s"},
+ .html_stop   ={"Stop","At %s"},
+ .html_total  ={"Total","%.1f km, %.0f minutes"},
 
-char *translate_gpx_start ="START";
-char *translate_gpx_inter ="INTER";
-char *translate_gpx_trip  ="TRIP";
-char *translate_gpx_finish="FINISH";
+ .gpx_desc ="%s between 'start' and 'finish' waypoints",
+ .gpx_name ="%s Route",
+ .gpx_step ="%s on '%s' for %.3f km, %.1 min",
+ .gpx_final="Total Journey %.1f km, %d minutes",
 
+ .gpx_start ="START",
+ .gpx_inter ="INTER",
+ .gpx_trip  ="TRIP",
+ .gpx_finish="FINISH"
+};
 
-/* Local variables */
 
 /*+ The language that is to be stored. +*/
 static const char *store_lang=NULL;
@@ -466,7 +468,7 @@ static int TurnType_function(const char *_tag_,int _type_,const char *direction,
 
     xmlstring=ParseXML_Encode_Safe_XML(string);
 
-    translate_xml_turn[d]=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
+    translation.xml_turn[d]=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
    }
 
  return(0);
@@ -504,7 +506,7 @@ static int HeadingType_function(const char *_tag_,int _type_,const char *directi
 
     xmlstring=ParseXML_Encode_Safe_XML(string);
 
-    translate_xml_heading[d]=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
+    translation.xml_heading[d]=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
    }
 
  return(0);
@@ -540,7 +542,7 @@ static int OrdinalType_function(const char *_tag_,int _type_,const char *number,
 
     xmlstring=ParseXML_Encode_Safe_XML(string);
 
-    translate_xml_ordinal[n-1]=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
+    translation.xml_ordinal[n-1]=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
    }
 
  return(0);
@@ -575,7 +577,7 @@ static int HighwayType_function(const char *_tag_,int _type_,const char *type,co
     if(highway==Highway_None)
        XMLPARSE_INVALID(_tag_,type);
 
-    translate_raw_highway[highway]=strcpy(malloc(strlen(string)+1),string);
+    translation.raw_highway[highway]=strcpy(malloc(strlen(string)+1),string);
    }
 
  return(0);
@@ -608,9 +610,9 @@ static int RouteType_function(const char *_tag_,int _type_,const char *type,cons
     xmlstring=ParseXML_Encode_Safe_XML(string);
 
     if(!strcmp(type,"shortest"))
-       translate_xml_route_shortest=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
+       translation.xml_route_shortest=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
     else if(!strcmp(type,"quickest"))
-       translate_xml_route_quickest=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
+       translation.xml_route_quickest=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
     else
        XMLPARSE_INVALID(_tag_,type);
    }
@@ -674,14 +676,14 @@ static int CopyrightCreatorType_function(const char *_tag_,int _type_,const char
     XMLPARSE_ASSERT_STRING(_tag_,string);
     XMLPARSE_ASSERT_STRING(_tag_,text);
 
-    translate_raw_copyright_creator[0]=strcpy(malloc(strlen(string)+1),string);
-    translate_raw_copyright_creator[1]=strcpy(malloc(strlen(text)+1)  ,text);
+    translation.raw_copyright_creator[0]=strcpy(malloc(strlen(string)+1),string);
+    translation.raw_copyright_creator[1]=strcpy(malloc(strlen(text)+1)  ,text);
 
     xmlstring=ParseXML_Encode_Safe_XML(string);
     xmltext  =ParseXML_Encode_Safe_XML(text);
 
-    translate_xml_copyright_creator[0]=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
-    translate_xml_copyright_creator[1]=strcpy(malloc(strlen(xmltext)+1)  ,xmltext);
+    translation.xml_copyright_creator[0]=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
+    translation.xml_copyright_creator[1]=strcpy(malloc(strlen(xmltext)+1)  ,xmltext);
    }
 
  return(0);
@@ -711,14 +713,14 @@ static int CopyrightSourceType_function(const char *_tag_,int _type_,const char
     XMLPARSE_ASSERT_STRING(_tag_,string);
     XMLPARSE_ASSERT_STRING(_tag_,text);
 
-    translate_raw_copyright_source[0]=strcpy(malloc(strlen(string)+1),string);
-    translate_raw_copyright_source[1]=strcpy(malloc(strlen(text)+1)  ,text);
+    translation.raw_copyright_source[0]=strcpy(malloc(strlen(string)+1),string);
+    translation.raw_copyright_source[1]=strcpy(malloc(strlen(text)+1)  ,text);
 
     xmlstring=ParseXML_Encode_Safe_XML(string);
     xmltext  =ParseXML_Encode_Safe_XML(text);
 
-    translate_xml_copyright_source[0]=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
-    translate_xml_copyright_source[1]=strcpy(malloc(strlen(xmltext)+1)  ,xmltext);
+    translation.xml_copyright_source[0]=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
+    translation.xml_copyright_source[1]=strcpy(malloc(strlen(xmltext)+1)  ,xmltext);
    }
 
  return(0);
@@ -748,14 +750,14 @@ static int CopyrightLicenseType_function(const char *_tag_,int _type_,const char
     XMLPARSE_ASSERT_STRING(_tag_,string);
     XMLPARSE_ASSERT_STRING(_tag_,text);
 
-    translate_raw_copyright_license[0]=strcpy(malloc(strlen(string)+1),string);
-    translate_raw_copyright_license[1]=strcpy(malloc(strlen(text)+1)  ,text);
+    translation.raw_copyright_license[0]=strcpy(malloc(strlen(string)+1),string);
+    translation.raw_copyright_license[1]=strcpy(malloc(strlen(text)+1)  ,text);
 
     xmlstring=ParseXML_Encode_Safe_XML(string);
     xmltext  =ParseXML_Encode_Safe_XML(text);
 
-    translate_xml_copyright_license[0]=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
-    translate_xml_copyright_license[1]=strcpy(malloc(strlen(xmltext)+1)  ,xmltext);
+    translation.xml_copyright_license[0]=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
+    translation.xml_copyright_license[1]=strcpy(malloc(strlen(xmltext)+1)  ,xmltext);
    }
 
  return(0);
@@ -789,13 +791,13 @@ static int HTMLWaypointType_function(const char *_tag_,int _type_,const char *ty
 
     if(!strcmp(type,"waypoint"))
       {
-       translate_html_waypoint=malloc(strlen(xmlstring)+1+sizeof("<span class='w'>")+sizeof("</span>"));
-       sprintf(translate_html_waypoint,"<span class='w'>%s</span>",xmlstring);
+       translation.html_waypoint=malloc(strlen(xmlstring)+1+sizeof("<span class='w'>")+sizeof("</span>"));
+       sprintf(translation.html_waypoint,"<span class='w'>%s</span>",xmlstring);
       }
     else if(!strcmp(type,"junction"))
-       translate_html_junction=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
+       translation.html_junction=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
     else if(!strcmp(type,"roundabout"))
-       translate_html_roundabout=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
+       translation.html_roundabout=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
     else
        XMLPARSE_INVALID(_tag_,type);
    }
@@ -826,7 +828,7 @@ static int HTMLTitleType_function(const char *_tag_,int _type_,const char *text)
 
     xmltext=ParseXML_Encode_Safe_XML(text);
 
-    translate_html_title=strcpy(malloc(strlen(xmltext)+1),xmltext);
+    translation.html_title=strcpy(malloc(strlen(xmltext)+1),xmltext);
    }
 
  return(0);
@@ -859,9 +861,9 @@ static int HTMLStartType_function(const char *_tag_,int _type_,const char *strin
     xmlstring=ParseXML_Encode_Safe_XML(string);
     xmltext  =ParseXML_Encode_Safe_XML(text);
 
-    translate_html_start[0]=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
-    translate_html_start[1]=malloc(strlen(xmltext)+1+sizeof("<span class='b'>")+sizeof("</span>"));
-    sprintf(translate_html_start[1],xmltext,"%s","<span class='b'>%s</span>");
+    translation.html_start[0]=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
+    translation.html_start[1]=malloc(strlen(xmltext)+1+sizeof("<span class='b'>")+sizeof("</span>"));
+    sprintf(translation.html_start[1],xmltext,"%s","<span class='b'>%s</span>");
    }
 
  return(0);
@@ -894,9 +896,9 @@ static int HTMLNodeType_function(const char *_tag_,int _type_,const char *string
     xmlstring=ParseXML_Encode_Safe_XML(string);
     xmltext  =ParseXML_Encode_Safe_XML(text);
 
-    translate_html_node[0]=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
-    translate_html_node[1]=malloc(strlen(xmltext)+1+2*sizeof("<span class='b'>")+2*sizeof("</span>"));
-    sprintf(translate_html_node[1],xmltext,"%s","<span class='t'>%s</span>","<span class='b'>%s</span>");
+    translation.html_node[0]=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
+    translation.html_node[1]=malloc(strlen(xmltext)+1+2*sizeof("<span class='b'>")+2*sizeof("</span>"));
+    sprintf(translation.html_node[1],xmltext,"%s","<span class='t'>%s</span>","<span class='b'>%s</span>");
    }
 
  return(0);
@@ -929,9 +931,9 @@ static int HTMLRBNodeType_function(const char *_tag_,int _type_,const char *stri
     xmlstring=ParseXML_Encode_Safe_XML(string);
     xmltext  =ParseXML_Encode_Safe_XML(text);
 
-    translate_html_rbnode[0]=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
-    translate_html_rbnode[1]=malloc(strlen(xmltext)+1+2*sizeof("<span class='b'>")+2*sizeof("</span>"));
-    sprintf(translate_html_rbnode[1],xmltext,"%s","<span class='t'>%s</span>","<span class='b'>%s</span>");
+    translation.html_rbnode[0]=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
+    translation.html_rbnode[1]=malloc(strlen(xmltext)+1+2*sizeof("<span class='b'>")+2*sizeof("</span>"));
+    sprintf(translation.html_rbnode[1],xmltext,"%s","<span class='t'>%s</span>","<span class='b'>%s</span>");
    }
 
  return(0);
@@ -966,11 +968,11 @@ static int HTMLSegmentType_function(const char *_tag_,int _type_,const char *str
     xmlstring=ParseXML_Encode_Safe_XML(string);
     xmltext  =ParseXML_Encode_Safe_XML(text);
 
-    translate_html_segment[0]=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
-    translate_html_segment[1]=malloc(strlen(xmltext)+1+2*sizeof("<span class='b'>")+2*sizeof("</span>"));
+    translation.html_segment[0]=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
+    translation.html_segment[1]=malloc(strlen(xmltext)+1+2*sizeof("<span class='b'>")+2*sizeof("</span>"));
 
     p=xmltext;
-    q=translate_html_segment[1];
+    q=translation.html_segment[1];
 
     while(*p!='%' && *(p+1)!='s')
        *q++=*p++;
@@ -1017,8 +1019,8 @@ static int HTMLStopType_function(const char *_tag_,int _type_,const char *string
     xmlstring=ParseXML_Encode_Safe_XML(string);
     xmltext  =ParseXML_Encode_Safe_XML(text);
 
-    translate_html_stop[0]=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
-    translate_html_stop[1]=strcpy(malloc(strlen(xmltext)+1)  ,xmltext);
+    translation.html_stop[0]=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
+    translation.html_stop[1]=strcpy(malloc(strlen(xmltext)+1)  ,xmltext);
    }
 
  return(0);
@@ -1051,8 +1053,8 @@ static int HTMLTotalType_function(const char *_tag_,int _type_,const char *strin
     xmlstring=ParseXML_Encode_Safe_XML(string);
     xmltext  =ParseXML_Encode_Safe_XML(text);
 
-    translate_html_total[0]=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
-    translate_html_total[1]=strcpy(malloc(strlen(xmltext)+1)  ,xmltext);
+    translation.html_total[0]=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
+    translation.html_total[1]=strcpy(malloc(strlen(xmltext)+1)  ,xmltext);
    }
 
  return(0);
@@ -1085,13 +1087,13 @@ static int GPXWaypointType_function(const char *_tag_,int _type_,const char *typ
     xmlstring=ParseXML_Encode_Safe_XML(string);
 
     if(!strcmp(type,"start"))
-       translate_gpx_start=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
+       translation.gpx_start=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
     else if(!strcmp(type,"inter"))
-       translate_gpx_inter=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
+       translation.gpx_inter=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
     else if(!strcmp(type,"trip"))
-       translate_gpx_trip=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
+       translation.gpx_trip=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
     else if(!strcmp(type,"finish"))
-       translate_gpx_finish=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
+       translation.gpx_finish=strcpy(malloc(strlen(xmlstring)+1),xmlstring);
     else
        XMLPARSE_INVALID(_tag_,type);
    }
@@ -1122,7 +1124,7 @@ static int GPXDescType_function(const char *_tag_,int _type_,const char *text)
 
     xmltext=ParseXML_Encode_Safe_XML(text);
 
-    translate_gpx_desc=strcpy(malloc(strlen(xmltext)+1),xmltext);
+    translation.gpx_desc=strcpy(malloc(strlen(xmltext)+1),xmltext);
    }
 
  return(0);
@@ -1151,7 +1153,7 @@ static int GPXNameType_function(const char *_tag_,int _type_,const char *text)
 
     xmltext=ParseXML_Encode_Safe_XML(text);
 
-    translate_gpx_name=strcpy(malloc(strlen(xmltext)+1),xmltext);
+    translation.gpx_name=strcpy(malloc(strlen(xmltext)+1),xmltext);
    }
 
  return(0);
@@ -1180,7 +1182,7 @@ static int GPXStepType_function(const char *_tag_,int _type_,const char *text)
 
     xmltext=ParseXML_Encode_Safe_XML(text);
 
-    translate_gpx_step=strcpy(malloc(strlen(xmltext)+1),xmltext);
+    translation.gpx_step=strcpy(malloc(strlen(xmltext)+1),xmltext);
    }
 
  return(0);
@@ -1209,7 +1211,7 @@ static int GPXFinalType_function(const char *_tag_,int _type_,const char *text)
 
     xmltext=ParseXML_Encode_Safe_XML(text);
 
-    translate_gpx_final=strcpy(malloc(strlen(xmltext)+1),xmltext);
+    translation.gpx_final=strcpy(malloc(strlen(xmltext)+1),xmltext);
    }
 
  return(0);
@@ -1253,3 +1255,15 @@ int ParseXMLTranslations(const char *filename,const char *language)
 
  return(0);
 }
+
+
+/*++++++++++++++++++++++++++++++++++++++
+  Get the translations that have been loaded (or the default English ones).
+
+  const Translation *GetTranslation Returns the translated strings, these must not be modified.
+  ++++++++++++++++++++++++++++++++++++++*/
+
+const Translation *GetTranslation(void)
+{
+ return(&translation);
+}
@@ -26,51 +26,58 @@
 #include "types.h"
 
 
-/* Global variable declarations */
+/* Data structures */
 
-extern char *translate_raw_copyright_creator[2];
-extern char *translate_raw_copyright_source[2];
-extern char *translate_raw_copyright_license[2];
+/*+ The translated strings used to create the outputs. +*/
+typedef struct _Translation
+{
+ char *raw_copyright_creator[2];
+ char *raw_copyright_source[2];
+ char *raw_copyright_license[2];
 
-extern char *translate_xml_copyright_creator[2];
-extern char *translate_xml_copyright_source[2];
-extern char *translate_xml_copyright_license[2];
+ char *xml_copyright_creator[2];
+ char *xml_copyright_source[2];
+ char *xml_copyright_license[2];
 
-extern char *translate_xml_heading[9];
-extern char *translate_xml_turn[9];
-extern char *translate_xml_ordinal[10];
+ char *xml_heading[9];
+ char *xml_turn[9];
+ char *xml_ordinal[10];
 
-extern char *translate_raw_highway[Highway_Count];
+ char *raw_highway[Highway_Count];
 
-extern char *translate_xml_route_shortest;
-extern char *translate_xml_route_quickest;
+ char *xml_route_shortest;
+ char *xml_route_quickest;
 
-extern char *translate_html_waypoint;
-extern char *translate_html_junction;
-extern char *translate_html_roundabout;
+ char *html_waypoint;
+ char *html_junction;
+ char *html_roundabout;
 
-extern char *translate_html_title;
-extern char *translate_html_start[2];
-extern char *translate_html_segment[2];
-extern char *translate_html_node[2];
-extern char *translate_html_rbnode[2];
-extern char *translate_html_stop[2];
-extern char *translate_html_total[2];
+ char *html_title;
+ char *html_start[2];
+ char *html_segment[2];
+ char *html_node[2];
+ char *html_rbnode[2];
+ char *html_stop[2];
+ char *html_total[2];
 
-extern char *translate_gpx_desc;
-extern char *translate_gpx_name;
-extern char *translate_gpx_step;
-extern char *translate_gpx_final;
+ char *gpx_desc;
+ char *gpx_name;
+ char *gpx_step;
+ char *gpx_final;
 
-extern char *translate_gpx_start;
-extern char *translate_gpx_inter;
-extern char *translate_gpx_trip;
-extern char *translate_gpx_finish;
+ char *gpx_start;
+ char *gpx_inter;
+ char *gpx_trip;
+ char *gpx_finish;
+}
+ Translation;
 
 
 /* Functions in translations.c */
 
 int ParseXMLTranslations(const char *filename,const char *language);
 
+const Translation *GetTranslation(void);
+
 
 #endif /* TRANSLATIONS_H */
@@ -198,6 +198,9 @@ typedef float score_t;
 /*+ Conversion from duration_t to minutes. +*/
 #define duration_to_minutes(xx) ((double)(xx)/600.0)
 
+/*+ Conversion from minutes to duration_t. +*/
+#define minutes_to_duration(xx) ((duration_t)((double)(xx)*600.0))
+
 /*+ Conversion from duration_t to hours. +*/
 #define duration_to_hours(xx)   ((double)(xx)/36000.0)
 
@@ -423,6 +426,16 @@ typedef struct _TurnRelation TurnRelation;
 
 typedef struct _Relations Relations;
 
+typedef struct _Landmarks Landmarks;
+
+typedef struct _Hierarchy Hierarchy;
+
+typedef struct _Partition Partition;
+
+typedef struct _Customisation Customisation;
+
+typedef struct _Query Query;
+
 
 /* Functions in types.c */
 